@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#include "cbf.h"
+
+#include <math.h>
+
+bloom_hashval bloom_calc_hash64(const void *buffer, int len);
+
+#define LN2 (0.693147180559945)
+
+bloom_hashval CBF_Hash(const void *data, size_t len) { return bloom_calc_hash64(data, len); }
+
+// Bits per item of a Bloom filter with an 'error' rate
+static double _CBF_BitsPerEntry(double error) { return -log(error) / (LN2 * LN2); }
+
+CountingBloom *CBF_Create(uint64_t entries, double error) {
+    if (entries < 1 || !(error > 0 && error < 1)) {
+        return NULL;
+    }
+    // rounded up to a power of two, as in bloom_init
+    const double bpe = _CBF_BitsPerEntry(error);
+    const double bn2 = logb(entries * bpe);
+    if (bn2 + 1 > CBF_MAX_N2) {
+        return NULL;
+    }
+    CountingBloom *cbf = CBF_CALLOC(1, sizeof *cbf);
+    cbf->n2 = bn2 + 1;
+    cbf->error = error;
+    cbf->hashes = ceil(LN2 * bpe);
+    // the extra counters of the rounding hold more items
+    const uint64_t counters = (uint64_t)1 << cbf->n2;
+    cbf->entries = entries + (uint64_t)((counters - entries * bpe) / bpe);
+    cbf->counters = CBF_TRYCALLOC(CBF_Bytes(cbf), 1);
+    if (!cbf->counters) {
+        CBF_FREE(cbf);
+        return NULL;
+    }
+    return cbf;
+}
+
+void CBF_Destroy(CountingBloom *cbf) {
+    if (!cbf) {
+        return;
+    }
+    if (cbf->counters) {
+        CBF_FREE(cbf->counters);
+    }
+    CBF_FREE(cbf);
+}
+
+size_t CBF_Bytes(const CountingBloom *cbf) {
+    const uint64_t counters = (uint64_t)1 << cbf->n2;
+    const uint64_t words = (counters + CBF_COUNTERS_PER_WORD - 1) / CBF_COUNTERS_PER_WORD;
+    return words * sizeof *cbf->counters;
+}
+
+// The word and the shift within it of the counter of the i-th hash, as in bloom_check_h
+#define CBF_COUNTER(cbf, h, i, word, shift)                                                        \
+    const uint64_t x_ = ((h).a + (i) * (h).b) & (((uint64_t)1 << (cbf)->n2) - 1);                  \
+    uint64_t *word = (cbf)->counters + x_ / CBF_COUNTERS_PER_WORD;                                 \
+    const unsigned shift = x_ % CBF_COUNTERS_PER_WORD * CBF_COUNTER_BITS
+
+/*  The counters are updated within their word without branches: the increment or decrement is
+    shifted to the counter, and is zero for those it would overflow. Two hashes of an item may
+    share a counter, which is then updated twice. */
+int CBF_Add(CountingBloom *cbf, bloom_hashval h) {
+    int found_unset = 0;
+    for (uint64_t i = 0; i < cbf->hashes; i++) {
+        CBF_COUNTER(cbf, h, i, word, shift);
+        const uint64_t c = *word >> shift & CBF_COUNTER_MAX;
+        found_unset |= c == 0;
+        *word += (uint64_t)(c != CBF_COUNTER_MAX) << shift;
+    }
+    cbf->size++;
+    return found_unset;
+}
+
+int CBF_Check(const CountingBloom *cbf, bloom_hashval h) {
+    for (uint64_t i = 0; i < cbf->hashes; i++) {
+        CBF_COUNTER(cbf, h, i, word, shift);
+        if (!(*word >> shift & CBF_COUNTER_MAX)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int CBF_Delete(CountingBloom *cbf, bloom_hashval h) {
+    if (!CBF_Check(cbf, h)) {
+        return 0;
+    }
+    for (uint64_t i = 0; i < cbf->hashes; i++) {
+        CBF_COUNTER(cbf, h, i, word, shift);
+        const uint64_t c = *word >> shift & CBF_COUNTER_MAX;
+        // neither saturated nor emptied by a shared counter of a false positive
+        *word -= (uint64_t)(c - 1 < CBF_COUNTER_MAX - 1) << shift;
+    }
+    if (cbf->size) {
+        cbf->size--;
+    }
+    return 1;
+}
+
+int CBF_ValidateLayout(const CountingBloom *cbf, size_t bytes) {
+    if (cbf->n2 > CBF_MAX_N2 || cbf->hashes < 1 || !(cbf->error > 0 && cbf->error < 1)) {
+        return 1;
+    }
+    return CBF_Bytes(cbf) != bytes;
+}
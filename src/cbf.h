@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#pragma once
+
+#include "bloom/bloom.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef REDIS_MODULE_TARGET
+#include "redismodule.h"
+#define CBF_TRYCALLOC(...)                                                                         \
+    RedisModule_TryCalloc ? RedisModule_TryCalloc(__VA_ARGS__) : RedisModule_Calloc(__VA_ARGS__)
+#define CBF_CALLOC(count, size) RedisModule_Calloc(count, size)
+#define CBF_FREE(ptr) RedisModule_Free(ptr)
+#endif
+
+#define CBF_COUNTER_BITS 4
+#define CBF_COUNTER_MAX 15
+#define CBF_COUNTERS_PER_WORD 16
+#define CBF_MAX_N2 40
+
+/*  A counting Bloom filter: a Bloom filter sized like those of deps/bloom, with 2^n2 counters
+    of 4 bits instead of bits, so that items can be deleted. Counters are packed 16 to a 64-bit
+    word and saturate at 15: a saturated counter is never decremented again, which keeps it from
+    causing false negatives. */
+typedef struct CountingBloom {
+    uint64_t entries; //  capacity at the error rate
+    double error;
+    uint32_t hashes;
+    uint8_t n2;
+    uint64_t size; //  items added and not deleted
+    uint64_t *counters;
+} CountingBloom;
+
+/*  Returns the hash of an item, the same as that of the Bloom filters.
+    Complexity - O(len) */
+bloom_hashval CBF_Hash(const void *data, size_t len);
+
+/*  Returns a new empty filter of at least 'entries' items at an 'error' rate, or NULL if the
+    parameters are invalid or out of memory.
+    Complexity - O(counters) */
+CountingBloom *CBF_Create(uint64_t entries, double error);
+
+/*  Releases resources of a filter.
+    Complexity - O(1) */
+void CBF_Destroy(CountingBloom *cbf);
+
+/*  Returns the size of the counters in bytes.
+    Complexity - O(1) */
+size_t CBF_Bytes(const CountingBloom *cbf);
+
+/*  Adds an item by incrementing its counters.
+    Returns 1 if the item was not in the filter before, 0 otherwise.
+    Complexity - O(hashes) */
+int CBF_Add(CountingBloom *cbf, bloom_hashval h);
+
+/*  Returns 1 if the item may be in the filter, 0 if it is not.
+    Complexity - O(hashes) */
+int CBF_Check(const CountingBloom *cbf, bloom_hashval h);
+
+/*  Deletes an item by decrementing its counters, unless it is not in the filter, in which case
+    the filter is left as it was.
+    Returns 1 if the item was deleted, 0 otherwise.
+    Complexity - O(hashes) */
+int CBF_Delete(CountingBloom *cbf, bloom_hashval h);
+
+/*  Checks the parameters of 'cbf', as read from a dump.
+    Returns 0 if they are consistent with counters of 'bytes', nonzero otherwise.
+    Complexity - O(1) */
+int CBF_ValidateLayout(const CountingBloom *cbf, size_t bytes);
@@ -101,6 +101,66 @@ static const RedisModuleCommandInfo BF_EXISTS_INFO = {
     .args = (RedisModuleCommandArg *)BF_EXISTS_ARGS,
 };
 
+// ===============================
+// BF.FREEZE key [RIBBON [ERROR error]] <ITEMS item [item ...] | HASHES hash [hash ...]>
+// ===============================
+static const RedisModuleCommandKeySpec BF_FREEZE_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RW,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg BF_FREEZE_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "ribbon",
+     .type = REDISMODULE_ARG_TYPE_BLOCK,
+     .flags = REDISMODULE_CMD_ARG_OPTIONAL,
+     .subargs =
+         (RedisModuleCommandArg[]){
+             {.name = "ribbon", .type = REDISMODULE_ARG_TYPE_PURE_TOKEN, .token = "RIBBON"},
+             {.name = "error",
+              .type = REDISMODULE_ARG_TYPE_BLOCK,
+              .flags = REDISMODULE_CMD_ARG_OPTIONAL,
+              .token = "ERROR",
+              .subargs = (RedisModuleCommandArg[]){{.name = "error",
+                                                    .type = REDISMODULE_ARG_TYPE_DOUBLE},
+                                                   {0}}},
+             {0},
+         }},
+    {.name = "source",
+     .type = REDISMODULE_ARG_TYPE_ONEOF,
+     .subargs =
+         (RedisModuleCommandArg[]){
+             {.name = "items",
+              .type = REDISMODULE_ARG_TYPE_BLOCK,
+              .token = "ITEMS",
+              .subargs = (RedisModuleCommandArg[]){{.name = "item",
+                                                    .type = REDISMODULE_ARG_TYPE_STRING,
+                                                    .flags = REDISMODULE_CMD_ARG_MULTIPLE},
+                                                   {0}}},
+             {.name = "hashes",
+              .type = REDISMODULE_ARG_TYPE_BLOCK,
+              .token = "HASHES",
+              .subargs = (RedisModuleCommandArg[]){{.name = "hash",
+                                                    .type = REDISMODULE_ARG_TYPE_INTEGER,
+                                                    .flags = REDISMODULE_CMD_ARG_MULTIPLE},
+                                                   {0}}},
+             {0},
+         }},
+    {0}};
+
+static const RedisModuleCommandInfo BF_FREEZE_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Replaces a Bloom Filter with an immutable filter of all its items",
+    .complexity = "O(n log n), where n is the number of items",
+    .since = "8.6.0",
+    .arity = -4,
+    .key_specs = (RedisModuleCommandKeySpec *)BF_FREEZE_KEYSPECS,
+    .args = (RedisModuleCommandArg *)BF_FREEZE_ARGS,
+};
+
 // ===============================
 // BF.INFO key [CAPACITY | SIZE | FILTERS | ITEMS | EXPANSION]
 // ===============================
@@ -141,7 +201,7 @@ static const RedisModuleCommandInfo BF_INFO_INFO = {
 
 // ===============================
 // BF.INSERT key [CAPACITY capacity] [ERROR error] [EXPANSION expansion] [NOCREATE] [NONSCALING]
-// ITEMS item [item ...]
+// [AT timestamp] ITEMS item [item ...]
 // ===============================
 static const RedisModuleCommandKeySpec BF_INSERT_KEYSPECS[] = {
     {.flags = REDISMODULE_CMD_KEY_RW,
@@ -185,6 +245,11 @@ static const RedisModuleCommandArg BF_INSERT_ARGS[] = {
         .flags = REDISMODULE_CMD_ARG_OPTIONAL,
         .token = "NONSCALING",
     },
+    {.name = "timestamp",
+     .type = REDISMODULE_ARG_TYPE_INTEGER,
+     .token = "AT",
+     .flags = REDISMODULE_CMD_ARG_OPTIONAL,
+     .since = "8.6.0"},
     {.name = "items", .type = REDISMODULE_ARG_TYPE_PURE_TOKEN, .token = "ITEMS"},
     {.name = "item", .type = REDISMODULE_ARG_TYPE_STRING, .flags = REDISMODULE_CMD_ARG_MULTIPLE},
     {0}};
@@ -281,6 +346,7 @@ static const RedisModuleCommandInfo BF_MEXISTS_INFO = {
 
 // ===============================
 // BF.RESERVE key error_rate capacity [EXPANSION expansion] [NONSCALING]
+//            [WINDOW duration SLICES n]
 // ===============================
 static const RedisModuleCommandKeySpec BF_RESERVE_KEYSPECS[] = {
     {.flags = REDISMODULE_CMD_KEY_RW,
@@ -305,6 +371,18 @@ static const RedisModuleCommandArg BF_RESERVE_ARGS[] = {
      .type = REDISMODULE_ARG_TYPE_PURE_TOKEN,
      .flags = REDISMODULE_CMD_ARG_OPTIONAL,
      .token = "NONSCALING"},
+    {.name = "window_block",
+     .type = REDISMODULE_ARG_TYPE_BLOCK,
+     .flags = REDISMODULE_CMD_ARG_OPTIONAL,
+     .since = "8.6.0",
+     .subargs =
+         (RedisModuleCommandArg[]){
+             {.name = "window_token", .type = REDISMODULE_ARG_TYPE_PURE_TOKEN, .token = "WINDOW"},
+             {.name = "duration", .type = REDISMODULE_ARG_TYPE_INTEGER},
+             {.name = "slices_token", .type = REDISMODULE_ARG_TYPE_PURE_TOKEN, .token = "SLICES"},
+             {.name = "slices", .type = REDISMODULE_ARG_TYPE_INTEGER},
+             {0},
+         }},
     {0}};
 static const RedisModuleCommandInfo BF_RESERVE_INFO = {
     .version = REDISMODULE_COMMAND_INFO_VERSION,
@@ -372,6 +450,13 @@ int RegisterBFCommandInfos(RedisModuleCtx *ctx) {
         return REDISMODULE_ERR;
     }
 
+    RedisModuleCommand *cmd_freeze = RedisModule_GetCommand(ctx, "bf.freeze");
+    if (!cmd_freeze)
+        return REDISMODULE_ERR;
+    if (RedisModule_SetCommandInfo(cmd_freeze, &BF_FREEZE_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
     RedisModuleCommand *cmd_info = RedisModule_GetCommand(ctx, "bf.info");
     if (!cmd_info)
         return REDISMODULE_ERR;
@@ -0,0 +1,244 @@
+#include "redismodule.h"
+
+// ===============================
+// CBF.ADD key item
+// ===============================
+static const RedisModuleCommandKeySpec CBF_ADD_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RW,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg CBF_ADD_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "item", .type = REDISMODULE_ARG_TYPE_STRING},
+    {0}};
+
+static const RedisModuleCommandInfo CBF_ADD_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Adds an item to a Counting Bloom Filter",
+    .complexity = "O(k), where k is the number of hash functions",
+    .since = "8.6.0",
+    .arity = 3,
+    .key_specs = (RedisModuleCommandKeySpec *)CBF_ADD_KEYSPECS,
+    .args = (RedisModuleCommandArg *)CBF_ADD_ARGS,
+};
+
+// ===============================
+// CBF.DEL key item
+// ===============================
+static const RedisModuleCommandKeySpec CBF_DEL_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RW,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg CBF_DEL_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "item", .type = REDISMODULE_ARG_TYPE_STRING},
+    {0}};
+
+static const RedisModuleCommandInfo CBF_DEL_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Deletes an item from a Counting Bloom Filter",
+    .complexity = "O(k), where k is the number of hash functions",
+    .since = "8.6.0",
+    .arity = 3,
+    .key_specs = (RedisModuleCommandKeySpec *)CBF_DEL_KEYSPECS,
+    .args = (RedisModuleCommandArg *)CBF_DEL_ARGS,
+};
+
+// ===============================
+// CBF.EXISTS key item
+// ===============================
+static const RedisModuleCommandKeySpec CBF_EXISTS_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg CBF_EXISTS_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "item", .type = REDISMODULE_ARG_TYPE_STRING},
+    {0}};
+
+static const RedisModuleCommandInfo CBF_EXISTS_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Checks whether an item exists in a Counting Bloom Filter",
+    .complexity = "O(k), where k is the number of hash functions",
+    .since = "8.6.0",
+    .arity = 3,
+    .key_specs = (RedisModuleCommandKeySpec *)CBF_EXISTS_KEYSPECS,
+    .args = (RedisModuleCommandArg *)CBF_EXISTS_ARGS,
+};
+
+// ===============================
+// CBF.INFO key
+// ===============================
+static const RedisModuleCommandKeySpec CBF_INFO_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg CBF_INFO_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {0}};
+
+static const RedisModuleCommandInfo CBF_INFO_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Returns information about a Counting Bloom Filter",
+    .complexity = "O(1)",
+    .since = "8.6.0",
+    .tips = "dont_cache",
+    .arity = 2,
+    .key_specs = (RedisModuleCommandKeySpec *)CBF_INFO_KEYSPECS,
+    .args = (RedisModuleCommandArg *)CBF_INFO_ARGS,
+};
+
+// ===============================
+// CBF.MADD key item [item ...]
+// ===============================
+static const RedisModuleCommandKeySpec CBF_MADD_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RW,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg CBF_MADD_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "item", .type = REDISMODULE_ARG_TYPE_STRING, .flags = REDISMODULE_CMD_ARG_MULTIPLE},
+    {0}};
+
+static const RedisModuleCommandInfo CBF_MADD_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Adds one or more items to a Counting Bloom Filter",
+    .complexity = "O(k * n), where k is the number of hash functions and n is the number of items",
+    .since = "8.6.0",
+    .arity = -3,
+    .key_specs = (RedisModuleCommandKeySpec *)CBF_MADD_KEYSPECS,
+    .args = (RedisModuleCommandArg *)CBF_MADD_ARGS,
+};
+
+// ===============================
+// CBF.MEXISTS key item [item ...]
+// ===============================
+static const RedisModuleCommandKeySpec CBF_MEXISTS_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg CBF_MEXISTS_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "item", .type = REDISMODULE_ARG_TYPE_STRING, .flags = REDISMODULE_CMD_ARG_MULTIPLE},
+    {0}};
+
+static const RedisModuleCommandInfo CBF_MEXISTS_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Checks whether one or more items exist in a Counting Bloom Filter",
+    .complexity = "O(k * n), where k is the number of hash functions and n is the number of items",
+    .since = "8.6.0",
+    .arity = -3,
+    .key_specs = (RedisModuleCommandKeySpec *)CBF_MEXISTS_KEYSPECS,
+    .args = (RedisModuleCommandArg *)CBF_MEXISTS_ARGS,
+};
+
+// ===============================
+// CBF.RESERVE key error_rate capacity
+// ===============================
+static const RedisModuleCommandKeySpec CBF_RESERVE_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RW,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg CBF_RESERVE_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "error_rate", .type = REDISMODULE_ARG_TYPE_DOUBLE},
+    {.name = "capacity", .type = REDISMODULE_ARG_TYPE_INTEGER},
+    {0}};
+
+static const RedisModuleCommandInfo CBF_RESERVE_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Creates a new Counting Bloom Filter",
+    .complexity = "O(1)",
+    .since = "8.6.0",
+    .arity = 4,
+    .key_specs = (RedisModuleCommandKeySpec *)CBF_RESERVE_KEYSPECS,
+    .args = (RedisModuleCommandArg *)CBF_RESERVE_ARGS,
+};
+
+int RegisterCBFCommandInfos(RedisModuleCtx *ctx) {
+    RedisModuleCommand *cmd_add = RedisModule_GetCommand(ctx, "cbf.add");
+    if (!cmd_add) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_add, &CBF_ADD_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_del = RedisModule_GetCommand(ctx, "cbf.del");
+    if (!cmd_del) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_del, &CBF_DEL_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_exists = RedisModule_GetCommand(ctx, "cbf.exists");
+    if (!cmd_exists) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_exists, &CBF_EXISTS_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_info = RedisModule_GetCommand(ctx, "cbf.info");
+    if (!cmd_info) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_info, &CBF_INFO_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_madd = RedisModule_GetCommand(ctx, "cbf.madd");
+    if (!cmd_madd) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_madd, &CBF_MADD_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_mexists = RedisModule_GetCommand(ctx, "cbf.mexists");
+    if (!cmd_mexists) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_mexists, &CBF_MEXISTS_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_reserve = RedisModule_GetCommand(ctx, "cbf.reserve");
+    if (!cmd_reserve) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_reserve, &CBF_RESERVE_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    return REDISMODULE_OK;
+}
@@ -8,3 +8,9 @@ int RegisterBFCommandInfos(RedisModuleCtx *ctx);
 int RegisterCMSCommandInfos(RedisModuleCtx *ctx);
 int RegisterTopKCommandInfos(RedisModuleCtx *ctx);
 int RegisterTDigestCommandInfos(RedisModuleCtx *ctx);
+int RegisterDDSketchCommandInfos(RedisModuleCtx *ctx);
+int RegisterHDRCommandInfos(RedisModuleCtx *ctx);
+int RegisterCBFCommandInfos(RedisModuleCtx *ctx);
+int RegisterRFCommandInfos(RedisModuleCtx *ctx);
+int RegisterMHCommandInfos(RedisModuleCtx *ctx);
+int RegisterThetaCommandInfos(RedisModuleCtx *ctx);
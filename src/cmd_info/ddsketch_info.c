@@ -0,0 +1,247 @@
+#include "redismodule.h"
+
+// ===============================
+// DDSKETCH.ADD key value [value ...]
+// ===============================
+static const RedisModuleCommandKeySpec DDSKETCH_ADD_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RW,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg DDSKETCH_ADD_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "value", .type = REDISMODULE_ARG_TYPE_DOUBLE, .flags = REDISMODULE_CMD_ARG_MULTIPLE},
+    {0}};
+
+static const RedisModuleCommandInfo DDSKETCH_ADD_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Adds one or more observations to a DDSketch",
+    .complexity = "O(N), where N is the number of values to add",
+    .since = "8.6.0",
+    .arity = -3,
+    .key_specs = (RedisModuleCommandKeySpec *)DDSKETCH_ADD_KEYSPECS,
+    .args = (RedisModuleCommandArg *)DDSKETCH_ADD_ARGS,
+};
+
+// ===============================
+// DDSKETCH.CDF key value [value ...]
+// ===============================
+static const RedisModuleCommandKeySpec DDSKETCH_CDF_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg DDSKETCH_CDF_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "value", .type = REDISMODULE_ARG_TYPE_DOUBLE, .flags = REDISMODULE_CMD_ARG_MULTIPLE},
+    {0}};
+
+static const RedisModuleCommandInfo DDSKETCH_CDF_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Returns, for each input value, an estimation of the fraction of observations "
+               "smaller than or equal to it",
+    .complexity = "O(N*B) where N is the number of values and B the number of bins",
+    .since = "8.6.0",
+    .arity = -3,
+    .key_specs = (RedisModuleCommandKeySpec *)DDSKETCH_CDF_KEYSPECS,
+    .args = (RedisModuleCommandArg *)DDSKETCH_CDF_ARGS,
+};
+
+// ===============================
+// DDSKETCH.CREATE key [ACCURACY accuracy] [MAXBINS maxbins]
+// ===============================
+static const RedisModuleCommandKeySpec DDSKETCH_CREATE_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RW,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg DDSKETCH_CREATE_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "accuracy_block",
+     .type = REDISMODULE_ARG_TYPE_BLOCK,
+     .flags = REDISMODULE_CMD_ARG_OPTIONAL,
+     .subargs =
+         (RedisModuleCommandArg[]){
+             {.name = "accuracy_token",
+              .type = REDISMODULE_ARG_TYPE_PURE_TOKEN,
+              .token = "ACCURACY"},
+             {.name = "accuracy", .type = REDISMODULE_ARG_TYPE_DOUBLE},
+             {0},
+         }},
+    {.name = "maxbins_block",
+     .type = REDISMODULE_ARG_TYPE_BLOCK,
+     .flags = REDISMODULE_CMD_ARG_OPTIONAL,
+     .subargs =
+         (RedisModuleCommandArg[]){
+             {.name = "maxbins_token",
+              .type = REDISMODULE_ARG_TYPE_PURE_TOKEN,
+              .token = "MAXBINS"},
+             {.name = "maxbins", .type = REDISMODULE_ARG_TYPE_INTEGER},
+             {0},
+         }},
+    {0}};
+
+static const RedisModuleCommandInfo DDSKETCH_CREATE_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Allocates memory and initializes a new DDSketch",
+    .complexity = "O(1)",
+    .since = "8.6.0",
+    .arity = -2,
+    .key_specs = (RedisModuleCommandKeySpec *)DDSKETCH_CREATE_KEYSPECS,
+    .args = (RedisModuleCommandArg *)DDSKETCH_CREATE_ARGS,
+};
+
+// ===============================
+// DDSKETCH.INFO key
+// ===============================
+static const RedisModuleCommandKeySpec DDSKETCH_INFO_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg DDSKETCH_INFO_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {0}};
+
+static const RedisModuleCommandInfo DDSKETCH_INFO_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Returns information and statistics about a DDSketch",
+    .complexity = "O(1)",
+    .since = "8.6.0",
+    .tips = "dont_cache",
+    .arity = 2,
+    .key_specs = (RedisModuleCommandKeySpec *)DDSKETCH_INFO_KEYSPECS,
+    .args = (RedisModuleCommandArg *)DDSKETCH_INFO_ARGS,
+};
+
+// ===============================
+// DDSKETCH.MERGE destination-key numkeys source-key [source-key ...] [OVERRIDE]
+// ===============================
+static const RedisModuleCommandKeySpec DDSKETCH_MERGE_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RW,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 2},
+     .find_keys_type = REDISMODULE_KSPEC_FK_KEYNUM,
+     .fk.keynum = {.keynumidx = 0, .firstkey = 1, .keystep = 1}},
+    {0}};
+
+static const RedisModuleCommandArg DDSKETCH_MERGE_ARGS[] = {
+    {.name = "destination-key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "numkeys", .type = REDISMODULE_ARG_TYPE_INTEGER},
+    {.name = "source-key",
+     .type = REDISMODULE_ARG_TYPE_KEY,
+     .key_spec_index = 1,
+     .flags = REDISMODULE_CMD_ARG_MULTIPLE},
+    {.name = "override",
+     .type = REDISMODULE_ARG_TYPE_PURE_TOKEN,
+     .flags = REDISMODULE_CMD_ARG_OPTIONAL,
+     .token = "OVERRIDE"},
+    {0}};
+
+static const RedisModuleCommandInfo DDSKETCH_MERGE_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Merges multiple DDSketches into a single sketch by adding up their bins",
+    .complexity = "O(B*K), where B is the number of bins and K the number of input sketches",
+    .since = "8.6.0",
+    .arity = -4,
+    .key_specs = (RedisModuleCommandKeySpec *)DDSKETCH_MERGE_KEYSPECS,
+    .args = (RedisModuleCommandArg *)DDSKETCH_MERGE_ARGS,
+};
+
+// ===============================
+// DDSKETCH.QUANTILE key quantile [quantile ...]
+// ===============================
+static const RedisModuleCommandKeySpec DDSKETCH_QUANTILE_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg DDSKETCH_QUANTILE_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "quantile",
+     .type = REDISMODULE_ARG_TYPE_DOUBLE,
+     .flags = REDISMODULE_CMD_ARG_MULTIPLE},
+    {0}};
+
+static const RedisModuleCommandInfo DDSKETCH_QUANTILE_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Returns, for each input fraction, an estimation of the value at that quantile, "
+               "within the relative accuracy of the sketch",
+    .complexity = "O(N*B) where N is the number of quantiles and B the number of bins",
+    .since = "8.6.0",
+    .arity = -3,
+    .key_specs = (RedisModuleCommandKeySpec *)DDSKETCH_QUANTILE_KEYSPECS,
+    .args = (RedisModuleCommandArg *)DDSKETCH_QUANTILE_ARGS,
+};
+
+int RegisterDDSketchCommandInfos(RedisModuleCtx *ctx) {
+    RedisModuleCommand *cmd_add = RedisModule_GetCommand(ctx, "ddsketch.add");
+    if (!cmd_add) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_add, &DDSKETCH_ADD_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_cdf = RedisModule_GetCommand(ctx, "ddsketch.cdf");
+    if (!cmd_cdf) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_cdf, &DDSKETCH_CDF_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_create = RedisModule_GetCommand(ctx, "ddsketch.create");
+    if (!cmd_create) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_create, &DDSKETCH_CREATE_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_info = RedisModule_GetCommand(ctx, "ddsketch.info");
+    if (!cmd_info) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_info, &DDSKETCH_INFO_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_merge = RedisModule_GetCommand(ctx, "ddsketch.merge");
+    if (!cmd_merge) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_merge, &DDSKETCH_MERGE_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_quantile = RedisModule_GetCommand(ctx, "ddsketch.quantile");
+    if (!cmd_quantile) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_quantile, &DDSKETCH_QUANTILE_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    return REDISMODULE_OK;
+}
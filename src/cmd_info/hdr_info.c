@@ -0,0 +1,384 @@
+#include "redismodule.h"
+
+// ===============================
+// HDR.ADD key value [value ...]
+// ===============================
+static const RedisModuleCommandKeySpec HDR_ADD_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RW,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg HDR_ADD_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "value", .type = REDISMODULE_ARG_TYPE_INTEGER, .flags = REDISMODULE_CMD_ARG_MULTIPLE},
+    {0}};
+
+static const RedisModuleCommandInfo HDR_ADD_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Adds one or more integer observations to an HDR histogram",
+    .complexity = "O(N), where N is the number of values to add",
+    .since = "8.6.0",
+    .arity = -3,
+    .key_specs = (RedisModuleCommandKeySpec *)HDR_ADD_KEYSPECS,
+    .args = (RedisModuleCommandArg *)HDR_ADD_ARGS,
+};
+
+// ===============================
+// HDR.BUCKETS key [WITHCOUNTS]
+// ===============================
+static const RedisModuleCommandKeySpec HDR_BUCKETS_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg HDR_BUCKETS_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "withcounts",
+     .type = REDISMODULE_ARG_TYPE_PURE_TOKEN,
+     .flags = REDISMODULE_CMD_ARG_OPTIONAL,
+     .token = "WITHCOUNTS"},
+    {0}};
+
+static const RedisModuleCommandInfo HDR_BUCKETS_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Returns the highest value of each non-empty counter of an HDR histogram, "
+               "optionally with its count",
+    .complexity = "O(C) where C is the number of counters",
+    .since = "8.6.0",
+    .arity = -2,
+    .key_specs = (RedisModuleCommandKeySpec *)HDR_BUCKETS_KEYSPECS,
+    .args = (RedisModuleCommandArg *)HDR_BUCKETS_ARGS,
+};
+
+// ===============================
+// HDR.CDF key value [value ...]
+// ===============================
+static const RedisModuleCommandKeySpec HDR_CDF_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg HDR_CDF_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "value", .type = REDISMODULE_ARG_TYPE_DOUBLE, .flags = REDISMODULE_CMD_ARG_MULTIPLE},
+    {0}};
+
+static const RedisModuleCommandInfo HDR_CDF_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Returns, for each input value, the fraction of observations counted up to "
+               "the counter of that value",
+    .complexity = "O(N*C) where N is the number of values and C the number of counters",
+    .since = "8.6.0",
+    .arity = -3,
+    .key_specs = (RedisModuleCommandKeySpec *)HDR_CDF_KEYSPECS,
+    .args = (RedisModuleCommandArg *)HDR_CDF_ARGS,
+};
+
+// ===============================
+// HDR.CREATE key [HIGHEST highest] [SIGFIGS sigfigs]
+// ===============================
+static const RedisModuleCommandKeySpec HDR_CREATE_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RW,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg HDR_CREATE_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "highest_block",
+     .type = REDISMODULE_ARG_TYPE_BLOCK,
+     .flags = REDISMODULE_CMD_ARG_OPTIONAL,
+     .subargs =
+         (RedisModuleCommandArg[]){
+             {.name = "highest_token",
+              .type = REDISMODULE_ARG_TYPE_PURE_TOKEN,
+              .token = "HIGHEST"},
+             {.name = "highest", .type = REDISMODULE_ARG_TYPE_INTEGER},
+             {0},
+         }},
+    {.name = "sigfigs_block",
+     .type = REDISMODULE_ARG_TYPE_BLOCK,
+     .flags = REDISMODULE_CMD_ARG_OPTIONAL,
+     .subargs =
+         (RedisModuleCommandArg[]){
+             {.name = "sigfigs_token",
+              .type = REDISMODULE_ARG_TYPE_PURE_TOKEN,
+              .token = "SIGFIGS"},
+             {.name = "sigfigs", .type = REDISMODULE_ARG_TYPE_INTEGER},
+             {0},
+         }},
+    {0}};
+
+static const RedisModuleCommandInfo HDR_CREATE_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Allocates memory and initializes a new HDR histogram",
+    .complexity = "O(C) where C is the number of counters",
+    .since = "8.6.0",
+    .arity = -2,
+    .key_specs = (RedisModuleCommandKeySpec *)HDR_CREATE_KEYSPECS,
+    .args = (RedisModuleCommandArg *)HDR_CREATE_ARGS,
+};
+
+// ===============================
+// HDR.INFO key
+// ===============================
+static const RedisModuleCommandKeySpec HDR_INFO_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg HDR_INFO_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {0}};
+
+static const RedisModuleCommandInfo HDR_INFO_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Returns information and statistics about an HDR histogram",
+    .complexity = "O(1)",
+    .since = "8.6.0",
+    .tips = "dont_cache",
+    .arity = 2,
+    .key_specs = (RedisModuleCommandKeySpec *)HDR_INFO_KEYSPECS,
+    .args = (RedisModuleCommandArg *)HDR_INFO_ARGS,
+};
+
+// ===============================
+// HDR.MAX key
+// ===============================
+static const RedisModuleCommandKeySpec HDR_MAX_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg HDR_MAX_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {0}};
+
+static const RedisModuleCommandInfo HDR_MAX_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Returns the maximum observation value of an HDR histogram",
+    .complexity = "O(1)",
+    .since = "8.6.0",
+    .arity = 2,
+    .key_specs = (RedisModuleCommandKeySpec *)HDR_MAX_KEYSPECS,
+    .args = (RedisModuleCommandArg *)HDR_MAX_ARGS,
+};
+
+// ===============================
+// HDR.MERGE destination-key numkeys source-key [source-key ...] [OVERRIDE]
+// ===============================
+static const RedisModuleCommandKeySpec HDR_MERGE_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RW,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 2},
+     .find_keys_type = REDISMODULE_KSPEC_FK_KEYNUM,
+     .fk.keynum = {.keynumidx = 0, .firstkey = 1, .keystep = 1}},
+    {0}};
+
+static const RedisModuleCommandArg HDR_MERGE_ARGS[] = {
+    {.name = "destination-key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "numkeys", .type = REDISMODULE_ARG_TYPE_INTEGER},
+    {.name = "source-key",
+     .type = REDISMODULE_ARG_TYPE_KEY,
+     .key_spec_index = 1,
+     .flags = REDISMODULE_CMD_ARG_MULTIPLE},
+    {.name = "override",
+     .type = REDISMODULE_ARG_TYPE_PURE_TOKEN,
+     .flags = REDISMODULE_CMD_ARG_OPTIONAL,
+     .token = "OVERRIDE"},
+    {0}};
+
+static const RedisModuleCommandInfo HDR_MERGE_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Merges multiple HDR histograms into a single histogram by adding up their counters",
+    .complexity = "O(C*K), where C is the number of counters and K the number of input histograms",
+    .since = "8.6.0",
+    .arity = -4,
+    .key_specs = (RedisModuleCommandKeySpec *)HDR_MERGE_KEYSPECS,
+    .args = (RedisModuleCommandArg *)HDR_MERGE_ARGS,
+};
+
+// ===============================
+// HDR.MIN key
+// ===============================
+static const RedisModuleCommandKeySpec HDR_MIN_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg HDR_MIN_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {0}};
+
+static const RedisModuleCommandInfo HDR_MIN_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Returns the minimum observation value of an HDR histogram",
+    .complexity = "O(1)",
+    .since = "8.6.0",
+    .arity = 2,
+    .key_specs = (RedisModuleCommandKeySpec *)HDR_MIN_KEYSPECS,
+    .args = (RedisModuleCommandArg *)HDR_MIN_ARGS,
+};
+
+// ===============================
+// HDR.QUANTILE key quantile [quantile ...]
+// ===============================
+static const RedisModuleCommandKeySpec HDR_QUANTILE_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg HDR_QUANTILE_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "quantile",
+     .type = REDISMODULE_ARG_TYPE_DOUBLE,
+     .flags = REDISMODULE_CMD_ARG_MULTIPLE},
+    {0}};
+
+static const RedisModuleCommandInfo HDR_QUANTILE_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Returns, for each input fraction, the value at that quantile, within the "
+               "significant figures of the histogram",
+    .complexity = "O(N*C) where N is the number of quantiles and C the number of counters",
+    .since = "8.6.0",
+    .arity = -3,
+    .key_specs = (RedisModuleCommandKeySpec *)HDR_QUANTILE_KEYSPECS,
+    .args = (RedisModuleCommandArg *)HDR_QUANTILE_ARGS,
+};
+
+// ===============================
+// HDR.RESET key
+// ===============================
+static const RedisModuleCommandKeySpec HDR_RESET_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RW,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg HDR_RESET_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {0}};
+
+static const RedisModuleCommandInfo HDR_RESET_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Resets an HDR histogram to empty, keeping its parameters",
+    .complexity = "O(C) where C is the number of counters",
+    .since = "8.6.0",
+    .arity = 2,
+    .key_specs = (RedisModuleCommandKeySpec *)HDR_RESET_KEYSPECS,
+    .args = (RedisModuleCommandArg *)HDR_RESET_ARGS,
+};
+
+int RegisterHDRCommandInfos(RedisModuleCtx *ctx) {
+    RedisModuleCommand *cmd_add = RedisModule_GetCommand(ctx, "hdr.add");
+    if (!cmd_add) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_add, &HDR_ADD_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_buckets = RedisModule_GetCommand(ctx, "hdr.buckets");
+    if (!cmd_buckets) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_buckets, &HDR_BUCKETS_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_cdf = RedisModule_GetCommand(ctx, "hdr.cdf");
+    if (!cmd_cdf) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_cdf, &HDR_CDF_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_create = RedisModule_GetCommand(ctx, "hdr.create");
+    if (!cmd_create) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_create, &HDR_CREATE_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_info = RedisModule_GetCommand(ctx, "hdr.info");
+    if (!cmd_info) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_info, &HDR_INFO_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_max = RedisModule_GetCommand(ctx, "hdr.max");
+    if (!cmd_max) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_max, &HDR_MAX_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_merge = RedisModule_GetCommand(ctx, "hdr.merge");
+    if (!cmd_merge) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_merge, &HDR_MERGE_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_min = RedisModule_GetCommand(ctx, "hdr.min");
+    if (!cmd_min) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_min, &HDR_MIN_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_quantile = RedisModule_GetCommand(ctx, "hdr.quantile");
+    if (!cmd_quantile) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_quantile, &HDR_QUANTILE_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_reset = RedisModule_GetCommand(ctx, "hdr.reset");
+    if (!cmd_reset) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_reset, &HDR_RESET_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    return REDISMODULE_OK;
+}
@@ -0,0 +1,111 @@
+#include "redismodule.h"
+
+// ===============================
+// MH.ADD key item [item ...]
+// ===============================
+static const RedisModuleCommandKeySpec MH_ADD_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RW,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg MH_ADD_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "item", .type = REDISMODULE_ARG_TYPE_STRING, .flags = REDISMODULE_CMD_ARG_MULTIPLE},
+    {0}};
+
+static const RedisModuleCommandInfo MH_ADD_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Adds one or more items to a MinHash sketch",
+    .complexity = "O(n * k), where n is the number of items and k is the number of lanes",
+    .since = "8.6.0",
+    .arity = -3,
+    .key_specs = (RedisModuleCommandKeySpec *)MH_ADD_KEYSPECS,
+    .args = (RedisModuleCommandArg *)MH_ADD_ARGS,
+};
+
+// ===============================
+// MH.INFO key
+// ===============================
+static const RedisModuleCommandKeySpec MH_INFO_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg MH_INFO_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {0}};
+
+static const RedisModuleCommandInfo MH_INFO_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Returns information about a MinHash sketch",
+    .complexity = "O(1)",
+    .since = "8.6.0",
+    .tips = "dont_cache",
+    .arity = 2,
+    .key_specs = (RedisModuleCommandKeySpec *)MH_INFO_KEYSPECS,
+    .args = (RedisModuleCommandArg *)MH_INFO_ARGS,
+};
+
+// ===============================
+// MH.SIMILARITY key other [other ...]
+// ===============================
+static const RedisModuleCommandKeySpec MH_SIMILARITY_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = -1, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg MH_SIMILARITY_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "other",
+     .type = REDISMODULE_ARG_TYPE_KEY,
+     .key_spec_index = 0,
+     .flags = REDISMODULE_CMD_ARG_MULTIPLE},
+    {0}};
+
+static const RedisModuleCommandInfo MH_SIMILARITY_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary =
+        "Returns the estimated Jaccard similarity of a MinHash sketch with one or more sketches",
+    .complexity = "O(n * k), where n is the number of other sketches and k is the number of lanes",
+    .since = "8.6.0",
+    .arity = -3,
+    .key_specs = (RedisModuleCommandKeySpec *)MH_SIMILARITY_KEYSPECS,
+    .args = (RedisModuleCommandArg *)MH_SIMILARITY_ARGS,
+};
+
+int RegisterMHCommandInfos(RedisModuleCtx *ctx) {
+    RedisModuleCommand *cmd_add = RedisModule_GetCommand(ctx, "mh.add");
+    if (!cmd_add) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_add, &MH_ADD_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_info = RedisModule_GetCommand(ctx, "mh.info");
+    if (!cmd_info) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_info, &MH_INFO_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_similarity = RedisModule_GetCommand(ctx, "mh.similarity");
+    if (!cmd_similarity) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_similarity, &MH_SIMILARITY_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    return REDISMODULE_OK;
+}
@@ -0,0 +1,257 @@
+#include "redismodule.h"
+
+// ===============================
+// RF.ADD key value [value ...]
+// ===============================
+static const RedisModuleCommandKeySpec RF_ADD_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RW,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg RF_ADD_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "value", .type = REDISMODULE_ARG_TYPE_INTEGER, .flags = REDISMODULE_CMD_ARG_MULTIPLE},
+    {0}};
+
+static const RedisModuleCommandInfo RF_ADD_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Adds one or more integer keys to a range filter",
+    .complexity = "O(n * l), where n is the number of keys and l is the number of levels",
+    .since = "8.6.0",
+    .arity = -3,
+    .key_specs = (RedisModuleCommandKeySpec *)RF_ADD_KEYSPECS,
+    .args = (RedisModuleCommandArg *)RF_ADD_ARGS,
+};
+
+// ===============================
+// RF.EXISTS key value
+// ===============================
+static const RedisModuleCommandKeySpec RF_EXISTS_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg RF_EXISTS_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "value", .type = REDISMODULE_ARG_TYPE_INTEGER},
+    {0}};
+
+static const RedisModuleCommandInfo RF_EXISTS_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Checks whether an integer key may exist in a range filter",
+    .complexity = "O(k), where k is the number of hash functions",
+    .since = "8.6.0",
+    .arity = 3,
+    .key_specs = (RedisModuleCommandKeySpec *)RF_EXISTS_KEYSPECS,
+    .args = (RedisModuleCommandArg *)RF_EXISTS_ARGS,
+};
+
+// ===============================
+// RF.INFO key
+// ===============================
+static const RedisModuleCommandKeySpec RF_INFO_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg RF_INFO_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {0}};
+
+static const RedisModuleCommandInfo RF_INFO_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Returns information about a range filter",
+    .complexity = "O(1)",
+    .since = "8.6.0",
+    .tips = "dont_cache",
+    .arity = 2,
+    .key_specs = (RedisModuleCommandKeySpec *)RF_INFO_KEYSPECS,
+    .args = (RedisModuleCommandArg *)RF_INFO_ARGS,
+};
+
+// ===============================
+// RF.LOADCHUNK key iterator data
+// ===============================
+static const RedisModuleCommandKeySpec RF_LOADCHUNK_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RW,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg RF_LOADCHUNK_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "iterator", .type = REDISMODULE_ARG_TYPE_INTEGER},
+    {.name = "data", .type = REDISMODULE_ARG_TYPE_STRING},
+    {0}};
+
+static const RedisModuleCommandInfo RF_LOADCHUNK_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Restores a range filter previously saved using RF.SCANDUMP",
+    .complexity = "O(n), where n is the capacity",
+    .since = "8.6.0",
+    .arity = 4,
+    .key_specs = (RedisModuleCommandKeySpec *)RF_LOADCHUNK_KEYSPECS,
+    .args = (RedisModuleCommandArg *)RF_LOADCHUNK_ARGS,
+};
+
+// ===============================
+// RF.RANGE key lo hi
+// ===============================
+static const RedisModuleCommandKeySpec RF_RANGE_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg RF_RANGE_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "lo", .type = REDISMODULE_ARG_TYPE_INTEGER},
+    {.name = "hi", .type = REDISMODULE_ARG_TYPE_INTEGER},
+    {0}};
+
+static const RedisModuleCommandInfo RF_RANGE_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Checks whether any integer key in a range may exist in a range filter",
+    .complexity = "O(l * k), where l is the number of levels and k is the number of hash functions",
+    .since = "8.6.0",
+    .arity = 4,
+    .key_specs = (RedisModuleCommandKeySpec *)RF_RANGE_KEYSPECS,
+    .args = (RedisModuleCommandArg *)RF_RANGE_ARGS,
+};
+
+// ===============================
+// RF.RESERVE key error_rate capacity [LEVELS levels]
+// ===============================
+static const RedisModuleCommandKeySpec RF_RESERVE_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RW,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg RF_RESERVE_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "error_rate", .type = REDISMODULE_ARG_TYPE_DOUBLE},
+    {.name = "capacity", .type = REDISMODULE_ARG_TYPE_INTEGER},
+    {.name = "levels_block",
+     .type = REDISMODULE_ARG_TYPE_BLOCK,
+     .flags = REDISMODULE_CMD_ARG_OPTIONAL,
+     .subargs =
+         (RedisModuleCommandArg[]){
+             {.name = "levels_token",
+              .type = REDISMODULE_ARG_TYPE_PURE_TOKEN,
+              .token = "LEVELS"},
+             {.name = "levels", .type = REDISMODULE_ARG_TYPE_INTEGER},
+             {0},
+         }},
+    {0}};
+
+static const RedisModuleCommandInfo RF_RESERVE_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Creates a new range filter",
+    .complexity = "O(n * l), where n is the capacity and l is the number of levels",
+    .since = "8.6.0",
+    .arity = -4,
+    .key_specs = (RedisModuleCommandKeySpec *)RF_RESERVE_KEYSPECS,
+    .args = (RedisModuleCommandArg *)RF_RESERVE_ARGS,
+};
+
+// ===============================
+// RF.SCANDUMP key iterator
+// ===============================
+static const RedisModuleCommandKeySpec RF_SCANDUMP_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg RF_SCANDUMP_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "iterator", .type = REDISMODULE_ARG_TYPE_INTEGER},
+    {0}};
+
+static const RedisModuleCommandInfo RF_SCANDUMP_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Begins an incremental save of a range filter",
+    .complexity = "O(n), where n is the capacity",
+    .since = "8.6.0",
+    .arity = 3,
+    .key_specs = (RedisModuleCommandKeySpec *)RF_SCANDUMP_KEYSPECS,
+    .args = (RedisModuleCommandArg *)RF_SCANDUMP_ARGS,
+};
+
+int RegisterRFCommandInfos(RedisModuleCtx *ctx) {
+    RedisModuleCommand *cmd_add = RedisModule_GetCommand(ctx, "rf.add");
+    if (!cmd_add) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_add, &RF_ADD_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_exists = RedisModule_GetCommand(ctx, "rf.exists");
+    if (!cmd_exists) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_exists, &RF_EXISTS_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_info = RedisModule_GetCommand(ctx, "rf.info");
+    if (!cmd_info) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_info, &RF_INFO_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_loadchunk = RedisModule_GetCommand(ctx, "rf.loadchunk");
+    if (!cmd_loadchunk) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_loadchunk, &RF_LOADCHUNK_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_range = RedisModule_GetCommand(ctx, "rf.range");
+    if (!cmd_range) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_range, &RF_RANGE_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_reserve = RedisModule_GetCommand(ctx, "rf.reserve");
+    if (!cmd_reserve) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_reserve, &RF_RESERVE_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_scandump = RedisModule_GetCommand(ctx, "rf.scandump");
+    if (!cmd_scandump) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_scandump, &RF_SCANDUMP_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    return REDISMODULE_OK;
+}
@@ -1,7 +1,7 @@
 #include "redismodule.h"
 
 // ===============================
-// TDIGEST.ADD key value [value ...]
+// TDIGEST.ADD key value [value ...] [AT timestamp]
 // ===============================
 static const RedisModuleCommandKeySpec TDIGEST_ADD_KEYSPECS[] = {
     {.flags = REDISMODULE_CMD_KEY_RW,
@@ -14,6 +14,11 @@ static const RedisModuleCommandKeySpec TDIGEST_ADD_KEYSPECS[] = {
 static const RedisModuleCommandArg TDIGEST_ADD_ARGS[] = {
     {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
     {.name = "value", .type = REDISMODULE_ARG_TYPE_DOUBLE, .flags = REDISMODULE_CMD_ARG_MULTIPLE},
+    {.name = "timestamp",
+     .type = REDISMODULE_ARG_TYPE_INTEGER,
+     .token = "AT",
+     .flags = REDISMODULE_CMD_ARG_OPTIONAL,
+     .since = "8.6.0"},
     {0}};
 
 static const RedisModuleCommandInfo TDIGEST_ADD_INFO = {
@@ -26,6 +31,54 @@ static const RedisModuleCommandInfo TDIGEST_ADD_INFO = {
     .args = (RedisModuleCommandArg *)TDIGEST_ADD_ARGS,
 };
 
+// ===============================
+// TDIGEST.ADDWEIGHTED key <value weight [value weight ...] | PACKED payload> [AT timestamp]
+// ===============================
+static const RedisModuleCommandKeySpec TDIGEST_ADDWEIGHTED_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RW,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg TDIGEST_ADDWEIGHTED_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "samples",
+     .type = REDISMODULE_ARG_TYPE_ONEOF,
+     .subargs =
+         (RedisModuleCommandArg[]){
+             {.name = "sample",
+              .type = REDISMODULE_ARG_TYPE_BLOCK,
+              .flags = REDISMODULE_CMD_ARG_MULTIPLE,
+              .subargs =
+                  (RedisModuleCommandArg[]){
+                      {.name = "value", .type = REDISMODULE_ARG_TYPE_DOUBLE},
+                      {.name = "weight", .type = REDISMODULE_ARG_TYPE_INTEGER},
+                      {0},
+                  }},
+             {.name = "payload",
+              .type = REDISMODULE_ARG_TYPE_STRING,
+              .token = "PACKED"},
+             {0},
+         }},
+    {.name = "timestamp",
+     .type = REDISMODULE_ARG_TYPE_INTEGER,
+     .token = "AT",
+     .flags = REDISMODULE_CMD_ARG_OPTIONAL,
+     .since = "8.6.0"},
+    {0}};
+
+static const RedisModuleCommandInfo TDIGEST_ADDWEIGHTED_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Adds one or more weighted observations to a t-digest sketch",
+    .complexity = "O(N), where N is the number of samples to add",
+    .since = "8.6.0",
+    .arity = -4,
+    .key_specs = (RedisModuleCommandKeySpec *)TDIGEST_ADDWEIGHTED_KEYSPECS,
+    .args = (RedisModuleCommandArg *)TDIGEST_ADDWEIGHTED_ARGS,
+};
+
 // ===============================
 // TDIGEST.BYRANK key rank [rank ...]
 // ===============================
@@ -111,7 +164,7 @@ static const RedisModuleCommandInfo TDIGEST_CDF_INFO = {
 };
 
 // ===============================
-// TDIGEST.CREATE key [COMPRESSION compression]
+// TDIGEST.CREATE key [COMPRESSION compression] [WINDOW duration BUCKETS n]
 // ===============================
 static const RedisModuleCommandKeySpec TDIGEST_CREATE_KEYSPECS[] = {
     {.flags = REDISMODULE_CMD_KEY_RW,
@@ -134,6 +187,20 @@ static const RedisModuleCommandArg TDIGEST_CREATE_ARGS[] = {
              {.name = "compression", .type = REDISMODULE_ARG_TYPE_INTEGER},
              {0},
          }},
+    {.name = "window_block",
+     .type = REDISMODULE_ARG_TYPE_BLOCK,
+     .flags = REDISMODULE_CMD_ARG_OPTIONAL,
+     .since = "8.6.0",
+     .subargs =
+         (RedisModuleCommandArg[]){
+             {.name = "window_token", .type = REDISMODULE_ARG_TYPE_PURE_TOKEN, .token = "WINDOW"},
+             {.name = "duration", .type = REDISMODULE_ARG_TYPE_INTEGER},
+             {.name = "buckets_token",
+              .type = REDISMODULE_ARG_TYPE_PURE_TOKEN,
+              .token = "BUCKETS"},
+             {.name = "buckets", .type = REDISMODULE_ARG_TYPE_INTEGER},
+             {0},
+         }},
     {0}};
 
 static const RedisModuleCommandInfo TDIGEST_CREATE_INFO = {
@@ -195,6 +262,40 @@ static const RedisModuleCommandInfo TDIGEST_MAX_INFO = {
     .args = (RedisModuleCommandArg *)TDIGEST_MAX_ARGS,
 };
 
+// ===============================
+// TDIGEST.MCDF numkeys key [key ...] VALUES value [value ...]
+// ===============================
+static const RedisModuleCommandKeySpec TDIGEST_MCDF_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_KEYNUM,
+     .fk.keynum = {.keynumidx = 0, .firstkey = 1, .keystep = 1}},
+    {0}};
+
+static const RedisModuleCommandArg TDIGEST_MCDF_ARGS[] = {
+    {.name = "numkeys", .type = REDISMODULE_ARG_TYPE_INTEGER},
+    {.name = "key",
+     .type = REDISMODULE_ARG_TYPE_KEY,
+     .key_spec_index = 0,
+     .flags = REDISMODULE_CMD_ARG_MULTIPLE},
+    {.name = "values_token", .type = REDISMODULE_ARG_TYPE_PURE_TOKEN, .token = "VALUES"},
+    {.name = "value", .type = REDISMODULE_ARG_TYPE_DOUBLE, .flags = REDISMODULE_CMD_ARG_MULTIPLE},
+    {0}};
+
+static const RedisModuleCommandInfo TDIGEST_MCDF_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Returns, for each input value, an estimation of the floating-point fraction of "
+               "(observations smaller than the given value + half the observations equal to the "
+               "given value) over the union of multiple sketches, without storing their merge",
+    .complexity = "O(N*K), where N is the number of centroids and K being the number of input "
+                  "sketches",
+    .since = "8.6.0",
+    .arity = -5,
+    .key_specs = (RedisModuleCommandKeySpec *)TDIGEST_MCDF_KEYSPECS,
+    .args = (RedisModuleCommandArg *)TDIGEST_MCDF_ARGS,
+};
+
 // ===============================
 // TDIGEST.MERGE destination-key numkeys source-key [source-key ...] [COMPRESSION compression]
 // [OVERRIDE]
@@ -271,6 +372,42 @@ static const RedisModuleCommandInfo TDIGEST_MIN_INFO = {
     .args = (RedisModuleCommandArg *)TDIGEST_MIN_ARGS,
 };
 
+// ===============================
+// TDIGEST.MQUANTILE numkeys key [key ...] QUANTILES quantile [quantile ...]
+// ===============================
+static const RedisModuleCommandKeySpec TDIGEST_MQUANTILE_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_KEYNUM,
+     .fk.keynum = {.keynumidx = 0, .firstkey = 1, .keystep = 1}},
+    {0}};
+
+static const RedisModuleCommandArg TDIGEST_MQUANTILE_ARGS[] = {
+    {.name = "numkeys", .type = REDISMODULE_ARG_TYPE_INTEGER},
+    {.name = "key",
+     .type = REDISMODULE_ARG_TYPE_KEY,
+     .key_spec_index = 0,
+     .flags = REDISMODULE_CMD_ARG_MULTIPLE},
+    {.name = "quantiles_token", .type = REDISMODULE_ARG_TYPE_PURE_TOKEN, .token = "QUANTILES"},
+    {.name = "quantile",
+     .type = REDISMODULE_ARG_TYPE_DOUBLE,
+     .flags = REDISMODULE_CMD_ARG_MULTIPLE},
+    {0}};
+
+static const RedisModuleCommandInfo TDIGEST_MQUANTILE_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Returns, for each input fraction, an estimation of the value (floating point) "
+               "that is smaller than the given fraction of observations over the union of "
+               "multiple sketches, without storing their merge",
+    .complexity = "O(N*K), where N is the number of centroids and K being the number of input "
+                  "sketches",
+    .since = "8.6.0",
+    .arity = -5,
+    .key_specs = (RedisModuleCommandKeySpec *)TDIGEST_MQUANTILE_KEYSPECS,
+    .args = (RedisModuleCommandArg *)TDIGEST_MQUANTILE_ARGS,
+};
+
 // ===============================
 // TDIGEST.QUANTILE key quantile [quantile ...]
 // ===============================
@@ -417,6 +554,15 @@ int RegisterTDigestCommandInfos(RedisModuleCtx *ctx) {
         return REDISMODULE_ERR;
     }
 
+    RedisModuleCommand *cmd_addweighted = RedisModule_GetCommand(ctx, "tdigest.addweighted");
+    if (!cmd_addweighted) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_addweighted, &TDIGEST_ADDWEIGHTED_INFO) ==
+        REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
     RedisModuleCommand *cmd_byrank = RedisModule_GetCommand(ctx, "tdigest.byrank");
     if (!cmd_byrank) {
         return REDISMODULE_ERR;
@@ -465,6 +611,14 @@ int RegisterTDigestCommandInfos(RedisModuleCtx *ctx) {
         return REDISMODULE_ERR;
     }
 
+    RedisModuleCommand *cmd_mcdf = RedisModule_GetCommand(ctx, "tdigest.mcdf");
+    if (!cmd_mcdf) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_mcdf, &TDIGEST_MCDF_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
     RedisModuleCommand *cmd_merge = RedisModule_GetCommand(ctx, "tdigest.merge");
     if (!cmd_merge) {
         return REDISMODULE_ERR;
@@ -481,6 +635,14 @@ int RegisterTDigestCommandInfos(RedisModuleCtx *ctx) {
         return REDISMODULE_ERR;
     }
 
+    RedisModuleCommand *cmd_mquantile = RedisModule_GetCommand(ctx, "tdigest.mquantile");
+    if (!cmd_mquantile) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_mquantile, &TDIGEST_MQUANTILE_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
     RedisModuleCommand *cmd_quantile = RedisModule_GetCommand(ctx, "tdigest.quantile");
     if (!cmd_quantile) {
         return REDISMODULE_ERR;
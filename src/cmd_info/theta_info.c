@@ -0,0 +1,276 @@
+#include "redismodule.h"
+
+// ===============================
+// THETA.ADD key item [item ...]
+// ===============================
+static const RedisModuleCommandKeySpec THETA_ADD_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RW,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg THETA_ADD_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "item", .type = REDISMODULE_ARG_TYPE_STRING, .flags = REDISMODULE_CMD_ARG_MULTIPLE},
+    {0}};
+
+static const RedisModuleCommandInfo THETA_ADD_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Adds one or more items to a Theta sketch",
+    .complexity = "O(n), where n is the number of items",
+    .since = "8.6.0",
+    .arity = -3,
+    .key_specs = (RedisModuleCommandKeySpec *)THETA_ADD_KEYSPECS,
+    .args = (RedisModuleCommandArg *)THETA_ADD_ARGS,
+};
+
+// ===============================
+// THETA.ANOTB destination a b
+// ===============================
+static const RedisModuleCommandKeySpec THETA_ANOTB_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RW,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 2},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 1, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg THETA_ANOTB_ARGS[] = {
+    {.name = "destination", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "a", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 1},
+    {.name = "b", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 1},
+    {0}};
+
+static const RedisModuleCommandInfo THETA_ANOTB_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Stores a Theta sketch of the items of a sketch that are not in another",
+    .complexity = "O(k * log(k)), where k is the number of nominal entries",
+    .since = "8.6.0",
+    .arity = 4,
+    .key_specs = (RedisModuleCommandKeySpec *)THETA_ANOTB_KEYSPECS,
+    .args = (RedisModuleCommandArg *)THETA_ANOTB_ARGS,
+};
+
+// ===============================
+// THETA.CREATE key [K k]
+// ===============================
+static const RedisModuleCommandKeySpec THETA_CREATE_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RW,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg THETA_CREATE_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "k_block",
+     .type = REDISMODULE_ARG_TYPE_BLOCK,
+     .flags = REDISMODULE_CMD_ARG_OPTIONAL,
+     .subargs =
+         (RedisModuleCommandArg[]){
+             {.name = "k_token",
+              .type = REDISMODULE_ARG_TYPE_PURE_TOKEN,
+              .token = "K"},
+             {.name = "k", .type = REDISMODULE_ARG_TYPE_INTEGER},
+             {0},
+         }},
+    {0}};
+
+static const RedisModuleCommandInfo THETA_CREATE_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Creates a new Theta sketch",
+    .complexity = "O(k), where k is the number of nominal entries",
+    .since = "8.6.0",
+    .arity = -2,
+    .key_specs = (RedisModuleCommandKeySpec *)THETA_CREATE_KEYSPECS,
+    .args = (RedisModuleCommandArg *)THETA_CREATE_ARGS,
+};
+
+// ===============================
+// THETA.ESTIMATE key
+// ===============================
+static const RedisModuleCommandKeySpec THETA_ESTIMATE_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg THETA_ESTIMATE_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {0}};
+
+static const RedisModuleCommandInfo THETA_ESTIMATE_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Returns the estimated number of distinct items added to a Theta sketch",
+    .complexity = "O(1)",
+    .since = "8.6.0",
+    .arity = 2,
+    .key_specs = (RedisModuleCommandKeySpec *)THETA_ESTIMATE_KEYSPECS,
+    .args = (RedisModuleCommandArg *)THETA_ESTIMATE_ARGS,
+};
+
+// ===============================
+// THETA.INFO key
+// ===============================
+static const RedisModuleCommandKeySpec THETA_INFO_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {0}};
+
+static const RedisModuleCommandArg THETA_INFO_ARGS[] = {
+    {.name = "key", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {0}};
+
+static const RedisModuleCommandInfo THETA_INFO_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Returns information about a Theta sketch",
+    .complexity = "O(1)",
+    .since = "8.6.0",
+    .tips = "dont_cache",
+    .arity = 2,
+    .key_specs = (RedisModuleCommandKeySpec *)THETA_INFO_KEYSPECS,
+    .args = (RedisModuleCommandArg *)THETA_INFO_ARGS,
+};
+
+// ===============================
+// THETA.INTERSECT destination numkeys source [source ...]
+// ===============================
+static const RedisModuleCommandKeySpec THETA_INTERSECT_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RW,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 2},
+     .find_keys_type = REDISMODULE_KSPEC_FK_KEYNUM,
+     .fk.keynum = {.keynumidx = 0, .firstkey = 1, .keystep = 1}},
+    {0}};
+
+static const RedisModuleCommandArg THETA_INTERSECT_ARGS[] = {
+    {.name = "destination", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "numkeys", .type = REDISMODULE_ARG_TYPE_INTEGER},
+    {.name = "source",
+     .type = REDISMODULE_ARG_TYPE_KEY,
+     .key_spec_index = 1,
+     .flags = REDISMODULE_CMD_ARG_MULTIPLE},
+    {0}};
+
+static const RedisModuleCommandInfo THETA_INTERSECT_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Stores a Theta sketch of the intersection of one or more sketches",
+    .complexity = "O(n * k * log(k)), where n is the number of sources and k is their largest k",
+    .since = "8.6.0",
+    .arity = -4,
+    .key_specs = (RedisModuleCommandKeySpec *)THETA_INTERSECT_KEYSPECS,
+    .args = (RedisModuleCommandArg *)THETA_INTERSECT_ARGS,
+};
+
+// ===============================
+// THETA.UNION destination numkeys source [source ...]
+// ===============================
+static const RedisModuleCommandKeySpec THETA_UNION_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RW,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 2},
+     .find_keys_type = REDISMODULE_KSPEC_FK_KEYNUM,
+     .fk.keynum = {.keynumidx = 0, .firstkey = 1, .keystep = 1}},
+    {0}};
+
+static const RedisModuleCommandArg THETA_UNION_ARGS[] = {
+    {.name = "destination", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "numkeys", .type = REDISMODULE_ARG_TYPE_INTEGER},
+    {.name = "source",
+     .type = REDISMODULE_ARG_TYPE_KEY,
+     .key_spec_index = 1,
+     .flags = REDISMODULE_CMD_ARG_MULTIPLE},
+    {0}};
+
+static const RedisModuleCommandInfo THETA_UNION_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Stores a Theta sketch of the union of one or more sketches",
+    .complexity = "O(n * k * log(k)), where n is the number of sources and k is their largest k",
+    .since = "8.6.0",
+    .arity = -4,
+    .key_specs = (RedisModuleCommandKeySpec *)THETA_UNION_KEYSPECS,
+    .args = (RedisModuleCommandArg *)THETA_UNION_ARGS,
+};
+
+int RegisterThetaCommandInfos(RedisModuleCtx *ctx) {
+    RedisModuleCommand *cmd_add = RedisModule_GetCommand(ctx, "theta.add");
+    if (!cmd_add) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_add, &THETA_ADD_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_anotb = RedisModule_GetCommand(ctx, "theta.anotb");
+    if (!cmd_anotb) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_anotb, &THETA_ANOTB_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_create = RedisModule_GetCommand(ctx, "theta.create");
+    if (!cmd_create) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_create, &THETA_CREATE_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_estimate = RedisModule_GetCommand(ctx, "theta.estimate");
+    if (!cmd_estimate) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_estimate, &THETA_ESTIMATE_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_info = RedisModule_GetCommand(ctx, "theta.info");
+    if (!cmd_info) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_info, &THETA_INFO_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_intersect = RedisModule_GetCommand(ctx, "theta.intersect");
+    if (!cmd_intersect) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_intersect, &THETA_INTERSECT_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    RedisModuleCommand *cmd_union = RedisModule_GetCommand(ctx, "theta.union");
+    if (!cmd_union) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_union, &THETA_UNION_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
+    return REDISMODULE_OK;
+}
@@ -145,6 +145,54 @@ static const RedisModuleCommandInfo TOPK_LIST_INFO = {
     .args = (RedisModuleCommandArg *)TOPK_LIST_ARGS,
 };
 
+// ===============================
+// TOPK.MERGE destination numkeys source [source ...] [WEIGHTS weight [weight ...]]
+// ===============================
+static const RedisModuleCommandKeySpec TOPK_MERGE_KEYSPECS[] = {
+    {.flags = REDISMODULE_CMD_KEY_RW,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 1},
+     .find_keys_type = REDISMODULE_KSPEC_FK_RANGE,
+     .fk.range = {.lastkey = 0, .keystep = 1, .limit = 0}},
+    {.flags = REDISMODULE_CMD_KEY_RO,
+     .begin_search_type = REDISMODULE_KSPEC_BS_INDEX,
+     .bs.index = {.pos = 2},
+     .find_keys_type = REDISMODULE_KSPEC_FK_KEYNUM,
+     .fk.keynum = {.keynumidx = 0, .firstkey = 1, .keystep = 1}},
+    {0}};
+
+static const RedisModuleCommandArg TOPK_MERGE_ARGS[] = {
+    {.name = "destination", .type = REDISMODULE_ARG_TYPE_KEY, .key_spec_index = 0},
+    {.name = "numkeys", .type = REDISMODULE_ARG_TYPE_INTEGER},
+    {.name = "source",
+     .type = REDISMODULE_ARG_TYPE_KEY,
+     .key_spec_index = 1,
+     .flags = REDISMODULE_CMD_ARG_MULTIPLE},
+    {
+        .name = "weights",
+        .type = REDISMODULE_ARG_TYPE_BLOCK,
+        .flags = REDISMODULE_CMD_ARG_OPTIONAL,
+        .subargs =
+            (RedisModuleCommandArg[]){
+                {.name = "weights", .type = REDISMODULE_ARG_TYPE_PURE_TOKEN, .token = "WEIGHTS"},
+                {.name = "weight",
+                 .type = REDISMODULE_ARG_TYPE_INTEGER,
+                 .flags = REDISMODULE_CMD_ARG_MULTIPLE},
+                {0}},
+    },
+    {0}};
+
+static const RedisModuleCommandInfo TOPK_MERGE_INFO = {
+    .version = REDISMODULE_COMMAND_INFO_VERSION,
+    .summary = "Merges several Top-k sketches with the same parameters into one sketch",
+    .complexity = "O(n * (w * d + k * log(n * k))) where n is the number of sketches, w is the "
+                  "width, d is the depth and k is the value of top-k",
+    .since = "8.6.0",
+    .arity = -4,
+    .key_specs = (RedisModuleCommandKeySpec *)TOPK_MERGE_KEYSPECS,
+    .args = (RedisModuleCommandArg *)TOPK_MERGE_ARGS,
+};
+
 // ===============================
 // TOPK.QUERY key item [item ...]
 // ===============================
@@ -172,7 +220,7 @@ static const RedisModuleCommandInfo TOPK_QUERY_INFO = {
 };
 
 // ===============================
-// TOPK.RESERVE key topk [width depth decay]
+// TOPK.RESERVE key topk [width depth decay] [COMPACT] [ALGO HEAVYKEEPER | SPACESAVING]
 // ===============================
 static const RedisModuleCommandKeySpec TOPK_RESERVE_KEYSPECS[] = {
     {.flags = REDISMODULE_CMD_KEY_RW,
@@ -192,6 +240,24 @@ static const RedisModuleCommandArg TOPK_RESERVE_ARGS[] = {
                                           {.name = "depth", .type = REDISMODULE_ARG_TYPE_INTEGER},
                                           {.name = "decay", .type = REDISMODULE_ARG_TYPE_DOUBLE},
                                           {0}}},
+    {.name = "compact",
+     .type = REDISMODULE_ARG_TYPE_PURE_TOKEN,
+     .flags = REDISMODULE_CMD_ARG_OPTIONAL,
+     .token = "COMPACT"},
+    {.name = "algo",
+     .type = REDISMODULE_ARG_TYPE_ONEOF,
+     .token = "ALGO",
+     .flags = REDISMODULE_CMD_ARG_OPTIONAL,
+     .subargs =
+         (RedisModuleCommandArg[]){
+             {.name = "heavykeeper",
+              .type = REDISMODULE_ARG_TYPE_PURE_TOKEN,
+              .token = "HEAVYKEEPER"},
+             {.name = "spacesaving",
+              .type = REDISMODULE_ARG_TYPE_PURE_TOKEN,
+              .token = "SPACESAVING"},
+             {0},
+         }},
     {0}};
 
 static const RedisModuleCommandInfo TOPK_RESERVE_INFO = {
@@ -199,6 +265,9 @@ static const RedisModuleCommandInfo TOPK_RESERVE_INFO = {
     .summary = "Initializes a Top-K sketch with specified parameters",
     .complexity = "O(1)",
     .since = "2.0.0",
+    .history = (RedisModuleCommandHistoryEntry[]){{"8.6.0", "Added the COMPACT option"},
+                                                   {"8.6.0", "Added the ALGO option"},
+                                                   {0}},
     .arity = -3,
     .key_specs = (RedisModuleCommandKeySpec *)TOPK_RESERVE_KEYSPECS,
     .args = (RedisModuleCommandArg *)TOPK_RESERVE_ARGS,
@@ -245,6 +314,14 @@ int RegisterTopKCommandInfos(RedisModuleCtx *ctx) {
         return REDISMODULE_ERR;
     }
 
+    RedisModuleCommand *cmd_merge = RedisModule_GetCommand(ctx, "TOPK.MERGE");
+    if (!cmd_merge) {
+        return REDISMODULE_ERR;
+    }
+    if (RedisModule_SetCommandInfo(cmd_merge, &TOPK_MERGE_INFO) == REDISMODULE_ERR) {
+        return REDISMODULE_ERR;
+    }
+
     RedisModuleCommand *cmd_query = RedisModule_GetCommand(ctx, "TOPK.QUERY");
     if (!cmd_query) {
         return REDISMODULE_ERR;
@@ -61,6 +61,12 @@ RM_Config rm_config = {
             .min = 1,
             .max = 65536,
         },
+    .tdigest_cache_max_nodes =
+        {
+            .value = 8192,
+            .min = 0,
+            .max = 1LL << 24,
+        },
 };
 
 static int setFloatValue(const char *name, RedisModuleString *value, void *privdata,
@@ -156,6 +162,7 @@ int RM_RegisterConfigs(RedisModuleCtx *ctx) {
     registerConfigVar(cf_max_iterations);
     registerConfigVar(cf_expansion_factor);
     registerConfigVar(cf_max_expansions);
+    registerConfigVar(tdigest_cache_max_nodes);
     RedisModule_Log(ctx, "notice", "]");
 
     return REDISMODULE_OK;
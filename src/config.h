@@ -28,6 +28,7 @@ typedef enum {
     cf_max_iterations,
     cf_expansion_factor,
     cf_max_expansions,
+    tdigest_cache_max_nodes,
 
     RM_CONFIG_COUNT,
 } RM_ConfigOption;
@@ -42,6 +43,7 @@ static const char *RM_ConfigOptionToString(RM_ConfigOption option) {
         [cf_max_iterations] = "cf-max-iterations",
         [cf_expansion_factor] = "cf-expansion-factor",
         [cf_max_expansions] = "cf-max-expansions",
+        [tdigest_cache_max_nodes] = "tdigest-cache-max-nodes",
     };
     if (0 <= option && option < RM_CONFIG_COUNT) {
         return RM_ConfigOptionStrings[option];
@@ -104,6 +106,12 @@ typedef struct {
     RM_ConfigInteger cf_expansion_factor;
     // Maximum expansions.
     RM_ConfigInteger cf_max_expansions;
+
+    /*********************************
+     * T-DIGEST CONFIG OPTIONS:      *
+     *********************************/
+    // Largest number of merged centroids for which query caches are kept. 0 disables them.
+    RM_ConfigInteger tdigest_cache_max_nodes;
 } RM_Config;
 
 extern RM_Config rm_config;
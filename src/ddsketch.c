@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#include "ddsketch.h"
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+// Values closer to zero than the smallest normal double are counted as zero.
+static inline bool _DDS_IsZero(double value) { return fabs(value) < DBL_MIN; }
+
+// The bin of index i holds the absolute values in (gamma^(i-1), gamma^i].
+static inline int32_t _DDS_Index(const DDSketch *dds, double absval) {
+    return (int32_t)ceil(log(absval) / dds->logGamma);
+}
+
+// The point of bin 'index' within a relative distance 'accuracy' of all its values.
+static inline double _DDS_Value(const DDSketch *dds, int32_t index) {
+    return 2 * exp(index * dds->logGamma) / (1 + dds->gamma);
+}
+
+static inline uint64_t _DDStore_Bin(const DDStore *store, int32_t index) {
+    if (!store->count || index < store->minIndex || index > store->maxIndex) {
+        return 0;
+    }
+    return store->bins[index - store->base];
+}
+
+/*  Makes 'store' cover the indexes in [low, high], which span at most 'maxBins', and folds the
+    bins in use below 'low' into it. The free bins are left on the side the store grows towards,
+    so that runs of increasing or decreasing values do not move the bins on every add. */
+static int _DDStore_Extend(DDStore *store, int32_t low, int32_t high, uint32_t maxBins) {
+    const uint32_t span = (uint32_t)((int64_t)high - low + 1);
+    uint64_t folded = 0;
+    // bins in use that are kept, empty if from > to
+    int32_t from = low, to = low - 1;
+    if (store->count) {
+        for (int32_t i = store->minIndex; i < low && i <= store->maxIndex; i++) {
+            folded += store->bins[i - store->base];
+        }
+        from = store->minIndex > low ? store->minIndex : low;
+        to = store->maxIndex;
+    }
+
+    uint64_t *bins = store->bins;
+    uint32_t cap = store->cap;
+    if (span > cap) {
+        cap = cap * 2 > span ? cap * 2 : span;
+        cap = cap < maxBins ? cap : maxBins;
+        bins = DDS_TRYCALLOC(cap, sizeof *bins);
+        if (!bins) {
+            return -2;
+        }
+    }
+    const int32_t base = store->bins && low < store->base ? high - (int32_t)cap + 1 : low;
+    const size_t kept = to >= from ? (size_t)(to - from + 1) : 0;
+    if (bins == store->bins) {
+        memmove(bins + (from - base), store->bins + (from - store->base), kept * sizeof *bins);
+        memset(bins, 0, (from - base) * sizeof *bins);
+        memset(bins + (from - base) + kept, 0, (cap - (from - base) - kept) * sizeof *bins);
+    } else if (store->bins) {
+        memcpy(bins + (from - base), store->bins + (from - store->base), kept * sizeof *bins);
+        DDS_FREE(store->bins);
+    }
+    store->bins = bins;
+    store->base = base;
+    store->cap = cap;
+    if (store->count) {
+        bins[low - base] += folded;
+        if (store->minIndex < low) {
+            store->minIndex = low;
+        }
+    }
+    return 0;
+}
+
+/*  Returns the indexes 'store' has to cover to hold 'index' as well, collapsing the lowest ones
+    so that they span at most 'maxBins'. */
+static void _DDStore_Range(const DDStore *store, int32_t index, uint32_t maxBins, int32_t *low,
+                           int32_t *high) {
+    *low = index;
+    *high = index;
+    if (store->count) {
+        *low = store->minIndex < index ? store->minIndex : index;
+        *high = store->maxIndex > index ? store->maxIndex : index;
+    }
+    if ((int64_t)*high - *low + 1 > maxBins) {
+        *low = *high - (int32_t)maxBins + 1;
+    }
+}
+
+static int _DDStore_Reserve(DDStore *store, int32_t low, int32_t high, uint32_t maxBins) {
+    if (!store->bins || low < store->base || high >= (int64_t)store->base + store->cap ||
+        (store->count && store->minIndex < low)) {
+        return _DDStore_Extend(store, low, high, maxBins);
+    }
+    return 0;
+}
+
+static int _DDStore_Add(DDStore *store, int32_t index, uint64_t weight, uint32_t maxBins) {
+    int32_t low, high;
+    _DDStore_Range(store, index, maxBins, &low, &high);
+    if (_DDStore_Reserve(store, low, high, maxBins) != 0) {
+        return -2;
+    }
+    // collapsed into the lowest bin
+    if (index < low) {
+        index = low;
+    }
+    store->bins[index - store->base] += weight;
+    if (!store->count || index < store->minIndex) {
+        store->minIndex = index;
+    }
+    if (!store->count || index > store->maxIndex) {
+        store->maxIndex = index;
+    }
+    store->count += weight;
+    return 0;
+}
+
+DDSketch *DDSketch_Create(double accuracy, uint32_t maxBins) {
+    DDSketch *dds = DDS_TRYCALLOC(1, sizeof *dds);
+    if (!dds) {
+        return NULL;
+    }
+    dds->accuracy = accuracy;
+    dds->gamma = (1 + accuracy) / (1 - accuracy);
+    dds->logGamma = log(dds->gamma);
+    dds->maxBins = maxBins;
+    dds->min = INFINITY;
+    dds->max = -INFINITY;
+    return dds;
+}
+
+void DDSketch_Destroy(DDSketch *dds) {
+    if (dds->positive.bins) {
+        DDS_FREE(dds->positive.bins);
+    }
+    if (dds->negative.bins) {
+        DDS_FREE(dds->negative.bins);
+    }
+    DDS_FREE(dds);
+}
+
+static void _DDStore_Reset(DDStore *store) {
+    if (store->bins) {
+        memset(store->bins, 0, store->cap * sizeof *store->bins);
+    }
+    store->count = 0;
+}
+
+void DDSketch_Reset(DDSketch *dds) {
+    _DDStore_Reset(&dds->positive);
+    _DDStore_Reset(&dds->negative);
+    dds->zeroCount = 0;
+    dds->count = 0;
+    dds->min = INFINITY;
+    dds->max = -INFINITY;
+}
+
+int DDSketch_Add(DDSketch *dds, double value, uint64_t weight) {
+    if (dds->count > UINT64_MAX - weight) {
+        return -1;
+    }
+    if (_DDS_IsZero(value)) {
+        dds->zeroCount += weight;
+    } else {
+        DDStore *store = value > 0 ? &dds->positive : &dds->negative;
+        if (_DDStore_Add(store, _DDS_Index(dds, fabs(value)), weight, dds->maxBins) != 0) {
+            return -2;
+        }
+    }
+    dds->count += weight;
+    dds->min = fmin(dds->min, value);
+    dds->max = fmax(dds->max, value);
+    return 0;
+}
+
+// Makes 'dest' cover the union of its range and the one of 'src', collapsed to 'maxBins'.
+static int _DDStore_ReserveMerge(DDStore *dest, const DDStore *src, uint32_t maxBins) {
+    if (!src->count) {
+        return 0;
+    }
+    int32_t low, high, srcLow, srcHigh;
+    _DDStore_Range(dest, src->minIndex, maxBins, &low, &high);
+    _DDStore_Range(dest, src->maxIndex, maxBins, &srcLow, &srcHigh);
+    low = low < srcLow ? low : srcLow;
+    high = high > srcHigh ? high : srcHigh;
+    if ((int64_t)high - low + 1 > maxBins) {
+        low = high - (int32_t)maxBins + 1;
+    }
+    return _DDStore_Reserve(dest, low, high, maxBins);
+}
+
+/*  Adds the bins of 'src' to the reserved 'dest', which then needs no allocation. Going down from
+    the highest bin makes the first add reach the top of the union, so the bins below it collapse
+    the same way they would have been reserved. 'src' may be 'dest', whose range does not change
+    while its bins are added to themselves. */
+static void _DDStore_Merge(DDStore *dest, const DDStore *src, uint32_t maxBins) {
+    if (!src->count) {
+        return;
+    }
+    const int32_t minIndex = src->minIndex, maxIndex = src->maxIndex;
+    for (int32_t i = maxIndex; i >= minIndex; i--) {
+        const uint64_t count = src->bins[i - src->base];
+        if (count) {
+            _DDStore_Add(dest, i, count, maxBins);
+        }
+    }
+}
+
+int DDSketch_Merge(DDSketch *dest, const DDSketch *src) {
+    if (dest->count > UINT64_MAX - src->count) {
+        return -1;
+    }
+    // both stores are reserved before anything is added, so a failure leaves 'dest' untouched
+    if (_DDStore_ReserveMerge(&dest->positive, &src->positive, dest->maxBins) != 0 ||
+        _DDStore_ReserveMerge(&dest->negative, &src->negative, dest->maxBins) != 0) {
+        return -2;
+    }
+    const uint64_t count = src->count, zeroCount = src->zeroCount;
+    _DDStore_Merge(&dest->positive, &src->positive, dest->maxBins);
+    _DDStore_Merge(&dest->negative, &src->negative, dest->maxBins);
+    dest->zeroCount += zeroCount;
+    dest->count += count;
+    dest->min = fmin(dest->min, src->min);
+    dest->max = fmax(dest->max, src->max);
+    return 0;
+}
+
+double DDSketch_Quantile(const DDSketch *dds, double q) {
+    if (!dds->count) {
+        return NAN;
+    }
+    if (q <= 0) {
+        return dds->min;
+    }
+    if (q >= 1) {
+        return dds->max;
+    }
+    // the value of rank q * (count - 1), going up from the most negative values
+    const double rank = q * (double)(dds->count - 1);
+    double seen = 0;
+    double value = dds->max;
+    const DDStore *neg = &dds->negative, *pos = &dds->positive;
+    if (neg->count) {
+        for (int32_t i = neg->maxIndex; i >= neg->minIndex; i--) {
+            seen += neg->bins[i - neg->base];
+            if (seen > rank) {
+                value = -_DDS_Value(dds, i);
+                goto found;
+            }
+        }
+    }
+    seen += dds->zeroCount;
+    if (seen > rank) {
+        value = 0;
+        goto found;
+    }
+    if (pos->count) {
+        for (int32_t i = pos->minIndex; i <= pos->maxIndex; i++) {
+            seen += pos->bins[i - pos->base];
+            if (seen > rank) {
+                value = _DDS_Value(dds, i);
+                goto found;
+            }
+        }
+    }
+found:
+    return fmin(fmax(value, dds->min), dds->max);
+}
+
+double DDSketch_Cdf(const DDSketch *dds, double value) {
+    if (!dds->count) {
+        return NAN;
+    }
+    if (value < dds->min) {
+        return 0;
+    }
+    if (value > dds->max) {
+        return 1;
+    }
+    const DDStore *neg = &dds->negative, *pos = &dds->positive;
+    double below = 0, at = 0;
+    if (_DDS_IsZero(value)) {
+        below = neg->count;
+        at = dds->zeroCount;
+    } else if (value < 0) {
+        const int32_t index = _DDS_Index(dds, -value);
+        for (int32_t i = neg->maxIndex; neg->count && i > index && i >= neg->minIndex; i--) {
+            below += neg->bins[i - neg->base];
+        }
+        at = _DDStore_Bin(neg, index);
+    } else {
+        const int32_t index = _DDS_Index(dds, value);
+        below = neg->count + dds->zeroCount;
+        for (int32_t i = pos->minIndex; pos->count && i < index && i <= pos->maxIndex; i++) {
+            below += pos->bins[i - pos->base];
+        }
+        at = _DDStore_Bin(pos, index);
+    }
+    return (below + at / 2) / dds->count;
+}
+
+size_t DDSketch_Capacity(const DDSketch *dds) {
+    return (size_t)dds->positive.cap + dds->negative.cap;
+}
+
+size_t DDSketch_BinsUsed(const DDSketch *dds) {
+    size_t used = 0;
+    if (dds->positive.count) {
+        used += dds->positive.maxIndex - dds->positive.minIndex + 1;
+    }
+    if (dds->negative.count) {
+        used += dds->negative.maxIndex - dds->negative.minIndex + 1;
+    }
+    return used;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef REDIS_MODULE_TARGET
+#include "redismodule.h"
+#define DDS_CALLOC(count, size) RedisModule_Calloc(count, size)
+#define DDS_TRYCALLOC(...)                                                                         \
+    RedisModule_TryCalloc ? RedisModule_TryCalloc(__VA_ARGS__) : RedisModule_Calloc(__VA_ARGS__)
+#define DDS_FREE(ptr) RedisModule_Free(ptr)
+#else
+// #define DDS_CALLOC(count, size) calloc(count, size)
+// #define DDS_FREE(ptr) free(ptr)
+#endif
+
+#define DDS_DEFAULT_ACCURACY 0.01
+#define DDS_DEFAULT_MAX_BINS 2048
+#define DDS_MIN_ACCURACY 0.0001
+#define DDS_MAX_ACCURACY 0.5
+#define DDS_MIN_MAX_BINS 16
+#define DDS_MAX_MAX_BINS 65536
+
+/*  Counts of the values whose logarithmic index falls in [base, base + cap). Only the indexes
+    in [minIndex, maxIndex] are in use, and only once 'count' is non-zero. Once the indexes in
+    use would span more than 'maxBins', the lowest ones are collapsed into the lowest bin kept. */
+typedef struct DDStore {
+    uint64_t *bins;
+    int32_t base;
+    uint32_t cap;
+    int32_t minIndex;
+    int32_t maxIndex;
+    uint64_t count;
+} DDStore;
+
+typedef struct DDSketch {
+    double accuracy;
+    double gamma;
+    double logGamma; //  ln(gamma), the width of a bin on a logarithmic scale
+    uint32_t maxBins;
+    DDStore positive;
+    DDStore negative; //  indexed by the absolute value
+    uint64_t zeroCount; //  values too close to zero to be indexed
+    uint64_t count;
+    double min;
+    double max;
+} DDSketch;
+
+/*  Returns a new DDSketch answering quantiles with a relative error of 'accuracy', keeping up
+    to 'maxBins' bins for each sign, or NULL if out of memory.
+    Complexity - O(1) */
+DDSketch *DDSketch_Create(double accuracy, uint32_t maxBins);
+
+/*  Releases resources of a DDSketch.
+    Complexity - O(1) */
+void DDSketch_Destroy(DDSketch *dds);
+
+/*  Empties 'dds', keeping its parameters and allocated bins.
+    Complexity - O(maxBins) */
+void DDSketch_Reset(DDSketch *dds);
+
+/*  Adds 'weight' occurrences of the finite 'value' to 'dds'.
+    Returns 0 on success, -1 on counter overflow and -2 on allocation failure, in which cases
+    'dds' is not modified.
+    Complexity - O(1) amortized */
+int DDSketch_Add(DDSketch *dds, double value, uint64_t weight);
+
+/*  Adds the counts of 'src' to 'dest'. Both must have the same accuracy, and 'dest' may be
+    'src'. Returns 0 on success, -1 on counter overflow and -2 on allocation failure, in which
+    cases 'dest' is not modified.
+    Complexity - O(maxBins) */
+int DDSketch_Merge(DDSketch *dest, const DDSketch *src);
+
+/*  Returns the estimated value at quantile 'q' in [0, 1], or NAN if 'dds' is empty.
+    Complexity - O(maxBins) */
+double DDSketch_Quantile(const DDSketch *dds, double q);
+
+/*  Returns the estimated fraction of values smaller than or equal to 'value', counting half of
+    the bin 'value' falls in, or NAN if 'dds' is empty.
+    Complexity - O(maxBins) */
+double DDSketch_Cdf(const DDSketch *dds, double value);
+
+/*  Returns the number of allocated bins of 'dds'. */
+size_t DDSketch_Capacity(const DDSketch *dds);
+
+/*  Returns the number of bins of 'dds' in use. */
+size_t DDSketch_BinsUsed(const DDSketch *dds);
@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#include "fuse.h"
+
+#include "redismodule.h"
+#include "murmur2/murmurhash2.h"
+
+#define FUSE_TRYCALLOC(...)                                                                        \
+    RedisModule_TryCalloc ? RedisModule_TryCalloc(__VA_ARGS__) : RedisModule_Calloc(__VA_ARGS__)
+#define FUSE_FREE RedisModule_Free
+
+#include <math.h>
+#include <string.h>
+
+// The seed of the first hash of bloom_calc_hash64
+#define FUSE_HASH_SEED 0xc6a4a7935bd1e995ULL
+#define FUSE_MAX_SEGMENT_LENGTH (1 << 18)
+#define FUSE_MAX_KEYS (UINT32_MAX / 2)
+#define FUSE_MAX_ATTEMPTS 100
+
+uint64_t FuseFilter_Hash(const void *data, size_t len) {
+    return MurmurHash64A_Bloom(data, len, FUSE_HASH_SEED);
+}
+
+static inline uint64_t _Fuse_Mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// The seeds tried in turn, the same for every build so that replicas build the same filter.
+static inline uint64_t _Fuse_NextSeed(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static inline uint8_t _Fuse_Fingerprint(uint64_t hash) { return (uint8_t)(hash ^ (hash >> 32)); }
+
+// The position of 'hash' in the segment 'index' past its first one, for index in [0, 2].
+static inline uint32_t _Fuse_Position(const FuseFilter *ff, uint64_t hash, int index) {
+    uint64_t pos = (uint64_t)(((__uint128_t)hash * ff->segmentCountLength) >> 64);
+    pos += (uint64_t)index * ff->segmentLength;
+    // distinct bits of the hash pick the offset within the next two segments
+    pos ^= ((hash & ((1ULL << 36) - 1)) >> (36 - 18 * index)) & ff->segmentLengthMask;
+    return (uint32_t)pos;
+}
+
+static void _Fuse_SetLayout(FuseFilter *ff, uint32_t segmentLength, uint32_t segmentCount) {
+    ff->segmentLength = segmentLength;
+    ff->segmentLengthMask = segmentLength - 1;
+    ff->segmentCount = segmentCount;
+    ff->segmentCountLength = segmentCount * segmentLength;
+    ff->arrayLength = (segmentCount + 2) * segmentLength;
+}
+
+// Sizes the filter for 'size' keys, with the segment length and the overhead of 3-wise
+// binary fuse filters, both growing slowly with the size.
+static void _Fuse_Layout(FuseFilter *ff, uint32_t size) {
+    uint32_t segmentLength = 1U << (int)floor(log((double)(size ? size : 1)) / log(3.33) + 2.25);
+    if (segmentLength > FUSE_MAX_SEGMENT_LENGTH) {
+        segmentLength = FUSE_MAX_SEGMENT_LENGTH;
+    }
+    const double factor = size <= 1 ? 0 : fmax(1.125, 0.875 + 0.25 * log(1e6) / log(size));
+    const uint32_t capacity = (uint32_t)round(size * factor);
+    uint32_t segmentCount = (capacity + segmentLength - 1) / segmentLength;
+    segmentCount = segmentCount > 2 ? segmentCount - 2 : 1;
+    _Fuse_SetLayout(ff, segmentLength, segmentCount);
+}
+
+static int _Fuse_CompareKeys(const void *a, const void *b) {
+    const uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+/*  Peels the keys off the 3-hypergraph of their positions: a position that a single key maps to
+    can be assigned last to satisfy that key, which is then removed. Returns the number of keys
+    peeled, whose hashes and positions are pushed on the stacks in peeling order. */
+static size_t _Fuse_Peel(const FuseFilter *ff, const uint64_t *keys, size_t n, uint32_t *counts,
+                         uint64_t *xors, uint32_t *queue, uint64_t *stackHashes,
+                         uint32_t *stackPositions) {
+    memset(counts, 0, ff->arrayLength * sizeof *counts);
+    memset(xors, 0, ff->arrayLength * sizeof *xors);
+    for (size_t i = 0; i < n; i++) {
+        const uint64_t hash = _Fuse_Mix(keys[i] + ff->seed);
+        for (int j = 0; j < 3; j++) {
+            const uint32_t pos = _Fuse_Position(ff, hash, j);
+            counts[pos]++;
+            xors[pos] ^= hash;
+        }
+    }
+
+    size_t queued = 0, peeled = 0;
+    for (uint32_t pos = 0; pos < ff->arrayLength; pos++) {
+        if (counts[pos] == 1) {
+            queue[queued++] = pos;
+        }
+    }
+    while (queued > 0) {
+        const uint32_t pos = queue[--queued];
+        if (counts[pos] != 1) {
+            continue;
+        }
+        // the only hash left at a position is the xor of the hashes mapped to it
+        const uint64_t hash = xors[pos];
+        stackHashes[peeled] = hash;
+        stackPositions[peeled] = pos;
+        peeled++;
+        for (int j = 0; j < 3; j++) {
+            const uint32_t other = _Fuse_Position(ff, hash, j);
+            counts[other]--;
+            xors[other] ^= hash;
+            if (counts[other] == 1) {
+                queue[queued++] = other;
+            }
+        }
+    }
+    return peeled;
+}
+
+FuseFilter *FuseFilter_Build(uint64_t *keys, size_t n, int *err) {
+    *err = FUSE_SUCCESS;
+    if (n > FUSE_MAX_KEYS) {
+        *err = FUSE_FAILED;
+        return NULL;
+    }
+    // the positions of a key must not cancel out, which only happens for duplicates since the
+    // mix of the key is a bijection
+    qsort(keys, n, sizeof *keys, _Fuse_CompareKeys);
+    size_t distinct = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (i == 0 || keys[i] != keys[distinct - 1]) {
+            keys[distinct++] = keys[i];
+        }
+    }
+    n = distinct;
+
+    FuseFilter *ff = FUSE_TRYCALLOC(1, sizeof *ff);
+    if (!ff) {
+        *err = FUSE_OOM;
+        return NULL;
+    }
+    ff->size = n;
+    _Fuse_Layout(ff, n);
+    ff->fingerprints = FUSE_TRYCALLOC(ff->arrayLength, sizeof *ff->fingerprints);
+    uint32_t *counts = FUSE_TRYCALLOC(ff->arrayLength, sizeof *counts);
+    uint64_t *xors = FUSE_TRYCALLOC(ff->arrayLength, sizeof *xors);
+    uint32_t *queue = FUSE_TRYCALLOC(ff->arrayLength, sizeof *queue);
+    uint64_t *stackHashes = FUSE_TRYCALLOC(n ? n : 1, sizeof *stackHashes);
+    uint32_t *stackPositions = FUSE_TRYCALLOC(n ? n : 1, sizeof *stackPositions);
+    if (!ff->fingerprints || !counts || !xors || !queue || !stackHashes || !stackPositions) {
+        *err = FUSE_OOM;
+        goto done;
+    }
+
+    uint64_t state = 0;
+    *err = FUSE_FAILED;
+    for (int attempt = 0; attempt < FUSE_MAX_ATTEMPTS; attempt++) {
+        ff->seed = _Fuse_NextSeed(&state);
+        if (_Fuse_Peel(ff, keys, n, counts, xors, queue, stackHashes, stackPositions) == n) {
+            *err = FUSE_SUCCESS;
+            break;
+        }
+    }
+    if (*err != FUSE_SUCCESS) {
+        goto done;
+    }
+    // in reverse peeling order, the position of each key is the last of its three to be set
+    for (size_t i = n; i-- > 0;) {
+        const uint64_t hash = stackHashes[i];
+        uint8_t fingerprint = _Fuse_Fingerprint(hash);
+        for (int j = 0; j < 3; j++) {
+            fingerprint ^= ff->fingerprints[_Fuse_Position(ff, hash, j)];
+        }
+        ff->fingerprints[stackPositions[i]] = fingerprint;
+    }
+
+done:
+    if (counts) {
+        FUSE_FREE(counts);
+    }
+    if (xors) {
+        FUSE_FREE(xors);
+    }
+    if (queue) {
+        FUSE_FREE(queue);
+    }
+    if (stackHashes) {
+        FUSE_FREE(stackHashes);
+    }
+    if (stackPositions) {
+        FUSE_FREE(stackPositions);
+    }
+    if (*err != FUSE_SUCCESS) {
+        FuseFilter_Free(ff);
+        return NULL;
+    }
+    return ff;
+}
+
+void FuseFilter_Free(FuseFilter *ff) {
+    if (!ff) {
+        return;
+    }
+    if (ff->fingerprints) {
+        FUSE_FREE(ff->fingerprints);
+    }
+    FUSE_FREE(ff);
+}
+
+int FuseFilter_Contains(const FuseFilter *ff, uint64_t key) {
+    const uint64_t hash = _Fuse_Mix(key + ff->seed);
+    const uint8_t fingerprint = ff->fingerprints[_Fuse_Position(ff, hash, 0)] ^
+                                ff->fingerprints[_Fuse_Position(ff, hash, 1)] ^
+                                ff->fingerprints[_Fuse_Position(ff, hash, 2)];
+    return fingerprint == _Fuse_Fingerprint(hash);
+}
+
+int FuseFilter_ValidateLayout(FuseFilter *ff) {
+    const uint32_t segmentLength = ff->segmentLength, segmentCount = ff->segmentCount;
+    const uint64_t arrayLength = ff->arrayLength;
+    if (segmentLength < 4 || segmentLength > FUSE_MAX_SEGMENT_LENGTH ||
+        (segmentLength & (segmentLength - 1)) || segmentCount == 0 ||
+        ((uint64_t)segmentCount + 2) * segmentLength != arrayLength || ff->size > arrayLength) {
+        return 1;
+    }
+    _Fuse_SetLayout(ff, segmentLength, segmentCount);
+    return 0;
+}
+
+typedef struct __attribute__((packed)) {
+    uint64_t size;
+    uint64_t seed;
+    uint32_t segmentLength;
+    uint32_t segmentCount;
+    uint32_t arrayLength;
+    uint8_t fingerprintBits;
+} dumpedFuseHeader;
+
+char *FuseFilter_GetEncodedHeader(const FuseFilter *ff, size_t *hdrlen) {
+    *hdrlen = sizeof(dumpedFuseHeader);
+    dumpedFuseHeader *hdr = RedisModule_Calloc(1, *hdrlen);
+    hdr->size = ff->size;
+    hdr->seed = ff->seed;
+    hdr->segmentLength = ff->segmentLength;
+    hdr->segmentCount = ff->segmentCount;
+    hdr->arrayLength = ff->arrayLength;
+    hdr->fingerprintBits = 8;
+    return (char *)hdr;
+}
+
+void FuseFilter_FreeEncodedHeader(char *s) { RedisModule_Free(s); }
+
+int FuseFilter_IsEncodedHeader(size_t bufLen) { return bufLen == sizeof(dumpedFuseHeader); }
+
+const char *FuseFilter_GetEncodedChunk(const FuseFilter *ff, long long *curIter, size_t *len,
+                                       size_t maxChunkSize) {
+    if (*curIter < 1 || *curIter - 1 >= ff->arrayLength) {
+        *curIter = 0;
+        return NULL;
+    }
+    const size_t offset = *curIter - 1;
+    *len = ff->arrayLength - offset;
+    if (*len > maxChunkSize) {
+        *len = maxChunkSize;
+    }
+    *curIter += *len;
+    return (const char *)(ff->fingerprints + offset);
+}
+
+FuseFilter *FuseFilter_NewFromHeader(const char *buf, size_t bufLen, const char **errmsg) {
+    const dumpedFuseHeader *header = (const void *)buf;
+    if (!FuseFilter_IsEncodedHeader(bufLen) || header->fingerprintBits != 8) {
+        *errmsg = "ERR received bad data";
+        return NULL;
+    }
+    FuseFilter *ff = RedisModule_Calloc(1, sizeof(*ff));
+    ff->size = header->size;
+    ff->seed = header->seed;
+    ff->segmentLength = header->segmentLength;
+    ff->segmentCount = header->segmentCount;
+    ff->arrayLength = header->arrayLength;
+    if (FuseFilter_ValidateLayout(ff) != 0) {
+        FuseFilter_Free(ff);
+        *errmsg = "ERR received bad data";
+        return NULL;
+    }
+    ff->fingerprints = FUSE_TRYCALLOC(ff->arrayLength, sizeof *ff->fingerprints);
+    if (!ff->fingerprints) {
+        FuseFilter_Free(ff);
+        *errmsg = "ERR Insufficient memory to create filter";
+        return NULL;
+    }
+    return ff;
+}
+
+int FuseFilter_LoadEncodedChunk(FuseFilter *ff, long long iter, const char *buf, size_t bufLen,
+                                const char **errmsg) {
+    if (!buf || iter <= 0 || iter <= bufLen) {
+        *errmsg = "ERR received bad data";
+        return -1;
+    }
+    const size_t offset = iter - bufLen - 1;
+    if (offset > ff->arrayLength || bufLen > ff->arrayLength - offset) {
+        *errmsg = "ERR invalid chunk - Too big for current filter";
+        return -1;
+    }
+    memcpy(ff->fingerprints + offset, buf, bufLen);
+    return 0;
+}
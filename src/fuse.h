@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * An immutable binary fuse filter with 8-bit fingerprints: about 9 bits per item, a false
+ * positive rate of 1/256 and three memory accesses per lookup.
+ *
+ * The fingerprints are split into segments of 'segmentLength'. Each key is mapped to one
+ * fingerprint in each of three consecutive segments, whose xor is the fingerprint of the key.
+ */
+typedef struct FuseFilter {
+    uint64_t size; //< Number of distinct keys
+    uint64_t seed;
+    uint32_t segmentLength;
+    uint32_t segmentLengthMask;
+    uint32_t segmentCount;
+    uint32_t segmentCountLength;
+    uint32_t arrayLength;
+    uint8_t *fingerprints;
+} FuseFilter;
+
+enum fuse_rc {
+    FUSE_SUCCESS = 0,
+    FUSE_OOM = -1,
+    FUSE_FAILED = -2,
+};
+
+/**
+ * Returns the key of an item, which is the first 64-bit hash the Bloom filters compute for it.
+ */
+uint64_t FuseFilter_Hash(const void *data, size_t len);
+
+/**
+ * Builds a filter of the 'n' keys, which are sorted and deduplicated in place. The filter of
+ * a set of keys is always the same.
+ *
+ * Returns NULL and sets 'err' if out of memory, or if no seed lets the filter be built, which
+ * does not happen in practice.
+ */
+FuseFilter *FuseFilter_Build(uint64_t *keys, size_t n, int *err);
+
+/** Free a created filter */
+void FuseFilter_Free(FuseFilter *ff);
+
+/**
+ * Check if a key may have been in the set the filter was built from
+ * Return 0 if the key was not, nonzero otherwise
+ */
+int FuseFilter_Contains(const FuseFilter *ff, uint64_t key);
+
+/**
+ * Get an encoded header, the first step to serializing a filter, and the counterpart of
+ * SBChain_GetEncodedHeader. Its length is written to hdrlen, and it is shorter than any chain
+ * header so that the two can be told apart.
+ *
+ * The header should be freed with FuseFilter_FreeEncodedHeader.
+ */
+char *FuseFilter_GetEncodedHeader(const FuseFilter *ff, size_t *hdrlen);
+void FuseFilter_FreeEncodedHeader(char *s);
+
+/** Returns whether 'bufLen' is the length of a header from FuseFilter_GetEncodedHeader. */
+int FuseFilter_IsEncodedHeader(size_t bufLen);
+
+/**
+ * Get an encoded chunk of the fingerprints, with the same iterator protocol as
+ * SBChain_GetEncodedChunk.
+ */
+const char *FuseFilter_GetEncodedChunk(const FuseFilter *ff, long long *curIter, size_t *len,
+                                       size_t maxChunkSize);
+
+/**
+ * Creates a new filter, with zeroed fingerprints, from a header returned by
+ * FuseFilter_GetEncodedHeader. Returns NULL and sets errmsg if the header is corrupt.
+ */
+FuseFilter *FuseFilter_NewFromHeader(const char *buf, size_t bufLen, const char **errmsg);
+
+/**
+ * Loads a chunk returned from FuseFilter_GetEncodedChunk.
+ * Returns 0 on success, and nonzero on failure - in which case errmsg is populated.
+ */
+int FuseFilter_LoadEncodedChunk(FuseFilter *ff, long long iter, const char *buf, size_t bufLen,
+                                const char **errmsg);
+
+/**
+ * Sets the layout of 'ff' from its segment length and count, as read from a dump.
+ * Returns 0 if they are consistent with 'arrayLength' and 'size', nonzero otherwise.
+ */
+int FuseFilter_ValidateLayout(FuseFilter *ff);
+
+#ifdef __cplusplus
+}
+#endif
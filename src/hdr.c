@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#include "hdr.h"
+
+#include <math.h>
+#include <string.h>
+
+// The magnitude of half the counters of a bucket, which keeps 'sigfigs' significant figures.
+static uint32_t _HDR_SubBucketHalfCountMagnitude(uint32_t sigfigs) {
+    uint64_t largest_single_unit = 2;
+    for (uint32_t i = 0; i < sigfigs; i++) {
+        largest_single_unit *= 10;
+    }
+    uint32_t magnitude = 0;
+    while ((1ULL << magnitude) < largest_single_unit) {
+        magnitude++;
+    }
+    return (magnitude > 1 ? magnitude : 1) - 1;
+}
+
+// The number of buckets of doubling width needed for the values up to 'highest'.
+static uint32_t _HDR_BucketsNeeded(int64_t highest, uint64_t sub_bucket_count) {
+    uint64_t smallest_untrackable = sub_bucket_count;
+    uint32_t buckets = 1;
+    while (smallest_untrackable <= (uint64_t)highest) {
+        if (smallest_untrackable > INT64_MAX / 2) {
+            return buckets + 1;
+        }
+        smallest_untrackable <<= 1;
+        buckets++;
+    }
+    return buckets;
+}
+
+size_t HDR_CountersNeeded(int64_t highest, uint32_t sigfigs) {
+    if (highest < 2 || sigfigs < HDR_MIN_SIGFIGS || sigfigs > HDR_MAX_SIGFIGS) {
+        return 0;
+    }
+    const uint32_t half_magnitude = _HDR_SubBucketHalfCountMagnitude(sigfigs);
+    const uint64_t sub_bucket_count = 1ULL << (half_magnitude + 1);
+    const size_t counters =
+        (size_t)(_HDR_BucketsNeeded(highest, sub_bucket_count) + 1) * (sub_bucket_count / 2);
+    return counters <= HDR_MAX_COUNTERS ? counters : 0;
+}
+
+static inline uint32_t _HDR_BucketIndex(const HDRHistogram *h, int64_t value) {
+    // the position of the highest bit set, beyond those addressing the sub-buckets
+    const uint32_t pow2ceiling = 64 - __builtin_clzll((uint64_t)value | h->subBucketMask);
+    return pow2ceiling - (h->subBucketHalfCountMagnitude + 1);
+}
+
+static inline uint32_t _HDR_CountsIndex(const HDRHistogram *h, int64_t value) {
+    const uint32_t bucket = _HDR_BucketIndex(h, value);
+    const uint32_t sub_bucket = (uint32_t)(value >> bucket);
+    return ((bucket + 1) << h->subBucketHalfCountMagnitude) + (sub_bucket - h->subBucketHalfCount);
+}
+
+int64_t HDR_ValueAtIndex(const HDRHistogram *h, uint32_t index) {
+    int32_t bucket = (int32_t)(index >> h->subBucketHalfCountMagnitude) - 1;
+    uint64_t sub_bucket = (index & (h->subBucketHalfCount - 1)) + h->subBucketHalfCount;
+    if (bucket < 0) {
+        sub_bucket -= h->subBucketHalfCount;
+        bucket = 0;
+    }
+    return (int64_t)(sub_bucket << bucket);
+}
+
+int64_t HDR_HighestEquivalentValue(const HDRHistogram *h, int64_t value) {
+    const uint32_t bucket = _HDR_BucketIndex(h, value);
+    const uint64_t lowest = ((uint64_t)value >> bucket) << bucket;
+    return (int64_t)(lowest + (1ULL << bucket) - 1);
+}
+
+HDRHistogram *HDR_Create(int64_t highest, uint32_t sigfigs) {
+    const size_t counters = HDR_CountersNeeded(highest, sigfigs);
+    if (!counters) {
+        return NULL;
+    }
+    HDRHistogram *h = HDR_TRYCALLOC(1, sizeof *h);
+    if (!h) {
+        return NULL;
+    }
+    h->counts = HDR_TRYCALLOC(counters, sizeof *h->counts);
+    if (!h->counts) {
+        HDR_FREE(h);
+        return NULL;
+    }
+    h->highest = highest;
+    h->sigfigs = sigfigs;
+    h->subBucketHalfCountMagnitude = _HDR_SubBucketHalfCountMagnitude(sigfigs);
+    h->subBucketHalfCount = 1U << h->subBucketHalfCountMagnitude;
+    h->subBucketMask = (2ULL << h->subBucketHalfCountMagnitude) - 1;
+    h->bucketCount = _HDR_BucketsNeeded(highest, 2ULL << h->subBucketHalfCountMagnitude);
+    h->countsLen = counters;
+    h->min = UINT64_MAX;
+    return h;
+}
+
+void HDR_Destroy(HDRHistogram *h) {
+    HDR_FREE(h->counts);
+    HDR_FREE(h);
+}
+
+void HDR_Reset(HDRHistogram *h) {
+    memset(h->counts, 0, h->countsLen * sizeof *h->counts);
+    h->totalCount = 0;
+    h->min = UINT64_MAX;
+    h->max = 0;
+}
+
+int HDR_Add(HDRHistogram *h, int64_t value, uint64_t count) {
+    if (value < 0 || value > h->highest) {
+        return -2;
+    }
+    if (h->totalCount > UINT64_MAX - count) {
+        return -1;
+    }
+    h->counts[_HDR_CountsIndex(h, value)] += count;
+    h->totalCount += count;
+    if ((uint64_t)value < h->min) {
+        h->min = value;
+    }
+    if ((uint64_t)value > h->max) {
+        h->max = value;
+    }
+    return 0;
+}
+
+// A plain loop over distinct arrays, which the compiler turns into vector additions.
+static void _HDR_AddCounts(uint64_t *restrict dest, const uint64_t *restrict src, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        dest[i] += src[i];
+    }
+}
+
+int HDR_Merge(HDRHistogram *dest, const HDRHistogram *src) {
+    if (!src->totalCount) {
+        return 0;
+    }
+    if (dest->totalCount > UINT64_MAX - src->totalCount) {
+        return -1;
+    }
+    if (src->max > (uint64_t)dest->highest) {
+        return -2;
+    }
+    const uint32_t first = _HDR_CountsIndex(src, src->min);
+    const uint32_t last = _HDR_CountsIndex(src, src->max);
+    if (src->sigfigs == dest->sigfigs) {
+        // the counters of a value only depend on the significant figures, so they line up
+        _HDR_AddCounts(dest->counts + first, src->counts + first, last - first + 1);
+    } else {
+        for (uint32_t i = first; i <= last; i++) {
+            if (src->counts[i]) {
+                dest->counts[_HDR_CountsIndex(dest, HDR_ValueAtIndex(src, i))] += src->counts[i];
+            }
+        }
+    }
+    dest->totalCount += src->totalCount;
+    if (src->min < dest->min) {
+        dest->min = src->min;
+    }
+    if (src->max > dest->max) {
+        dest->max = src->max;
+    }
+    return 0;
+}
+
+double HDR_Quantile(const HDRHistogram *h, double q) {
+    if (!h->totalCount) {
+        return NAN;
+    }
+    if (q <= 0) {
+        return h->min;
+    }
+    if (q >= 1) {
+        return h->max;
+    }
+    // the counter reaching the rounded rank of q, counting from 1
+    uint64_t target = (uint64_t)(q * (double)h->totalCount + 0.5);
+    if (target < 1) {
+        target = 1;
+    }
+    const uint32_t last = _HDR_CountsIndex(h, h->max);
+    uint64_t seen = 0;
+    int64_t value = h->max;
+    for (uint32_t i = _HDR_CountsIndex(h, h->min); i <= last; i++) {
+        seen += h->counts[i];
+        if (seen >= target) {
+            value = HDR_HighestEquivalentValue(h, HDR_ValueAtIndex(h, i));
+            break;
+        }
+    }
+    if ((uint64_t)value < h->min) {
+        return h->min;
+    }
+    return (uint64_t)value > h->max ? h->max : value;
+}
+
+double HDR_Cdf(const HDRHistogram *h, double value) {
+    if (!h->totalCount) {
+        return NAN;
+    }
+    if (value < h->min) {
+        return 0;
+    }
+    if (value >= h->max) {
+        return 1;
+    }
+    const uint32_t index = _HDR_CountsIndex(h, (int64_t)floor(value));
+    uint64_t below = 0;
+    for (uint32_t i = _HDR_CountsIndex(h, h->min); i <= index; i++) {
+        below += h->counts[i];
+    }
+    return (double)below / h->totalCount;
+}
+
+size_t HDR_CountersUsed(const HDRHistogram *h) {
+    size_t used = 0;
+    for (uint32_t i = 0; i < h->countsLen; i++) {
+        used += h->counts[i] != 0;
+    }
+    return used;
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef REDIS_MODULE_TARGET
+#include "redismodule.h"
+#define HDR_CALLOC(count, size) RedisModule_Calloc(count, size)
+#define HDR_TRYCALLOC(...)                                                                         \
+    RedisModule_TryCalloc ? RedisModule_TryCalloc(__VA_ARGS__) : RedisModule_Calloc(__VA_ARGS__)
+#define HDR_FREE(ptr) RedisModule_Free(ptr)
+#else
+// #define HDR_CALLOC(count, size) calloc(count, size)
+// #define HDR_FREE(ptr) free(ptr)
+#endif
+
+#define HDR_DEFAULT_HIGHEST 3600000000LL // an hour in microseconds
+#define HDR_DEFAULT_SIGFIGS 2
+#define HDR_MIN_SIGFIGS 1
+#define HDR_MAX_SIGFIGS 5
+#define HDR_MAX_COUNTERS (1 << 22)
+
+/*  Counts of integer values in [0, highest], in buckets of doubling width which each hold
+    'subBucketHalfCount' counters, so that a value is counted with 'sigfigs' significant decimal
+    digits. The first bucket also holds the lower half of its sub-buckets, where every value
+    from 0 has its own counter. */
+typedef struct HDRHistogram {
+    int64_t highest;
+    uint32_t sigfigs;
+    uint32_t subBucketHalfCountMagnitude;
+    uint32_t subBucketHalfCount;
+    uint64_t subBucketMask;
+    uint32_t bucketCount;
+    uint32_t countsLen;
+    uint64_t *counts;
+    uint64_t totalCount;
+    uint64_t min; //  the exact extremes, valid once totalCount is non-zero
+    uint64_t max;
+} HDRHistogram;
+
+/*  Returns the number of counters of a histogram of values up to 'highest' with 'sigfigs'
+    significant figures, or 0 if the parameters are invalid.
+    Complexity - O(1) */
+size_t HDR_CountersNeeded(int64_t highest, uint32_t sigfigs);
+
+/*  Returns a new empty histogram of values in [0, 'highest'] with 'sigfigs' significant
+    figures, or NULL if the parameters are invalid or out of memory.
+    Complexity - O(countsLen) */
+HDRHistogram *HDR_Create(int64_t highest, uint32_t sigfigs);
+
+/*  Releases resources of a histogram.
+    Complexity - O(1) */
+void HDR_Destroy(HDRHistogram *h);
+
+/*  Empties 'h', keeping its parameters.
+    Complexity - O(countsLen) */
+void HDR_Reset(HDRHistogram *h);
+
+/*  Counts 'count' occurrences of 'value'.
+    Returns 0 on success, -1 on counter overflow and -2 if 'value' is not in [0, highest], in
+    which cases 'h' is not modified.
+    Complexity - O(1) */
+int HDR_Add(HDRHistogram *h, int64_t value, uint64_t count);
+
+/*  Adds the counts of 'src' to 'dest', which must be distinct. When both have the same
+    significant figures the counters are added one to one, otherwise each non-empty counter of
+    'src' is recorded again in 'dest'.
+    Returns 0 on success, -1 on counter overflow and -2 if the values of 'src' exceed the highest
+    trackable value of 'dest', in which cases 'dest' is not modified.
+    Complexity - O(countsLen) */
+int HDR_Merge(HDRHistogram *dest, const HDRHistogram *src);
+
+/*  Returns the value at quantile 'q' in [0, 1], the highest value equivalent to the counter
+    reaching that quantile bounded by the exact extremes, or NAN if 'h' is empty.
+    Complexity - O(countsLen) */
+double HDR_Quantile(const HDRHistogram *h, double q);
+
+/*  Returns the fraction of the values counted in the counters up to the one of 'value', or NAN
+    if 'h' is empty.
+    Complexity - O(countsLen) */
+double HDR_Cdf(const HDRHistogram *h, double value);
+
+/*  Returns the lowest value counted by the counter at 'index'.
+    Complexity - O(1) */
+int64_t HDR_ValueAtIndex(const HDRHistogram *h, uint32_t index);
+
+/*  Returns the highest value counted by the same counter as 'value'.
+    Complexity - O(1) */
+int64_t HDR_HighestEquivalentValue(const HDRHistogram *h, int64_t value);
+
+/*  Returns the number of non-empty counters of 'h'.
+    Complexity - O(countsLen) */
+size_t HDR_CountersUsed(const HDRHistogram *h);
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#include "minhash.h"
+#include "murmur2/murmurhash2.h"
+
+#include <stdbool.h>
+
+#define MH_HASH_SEED 0x4d696e48617368ULL
+
+// The multipliers, which are odd, and the increments of the hashes of the lanes
+static uint64_t mh_mul[MH_LANES];
+static uint64_t mh_add[MH_LANES];
+static bool mh_params_ready = false;
+
+static uint64_t _MH_SplitMix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// The constants are generated from a fixed seed, and never change once a sketch is saved
+static void _MH_InitParams(void) {
+    uint64_t state = MH_HASH_SEED;
+    for (size_t i = 0; i < MH_LANES; i++) {
+        mh_mul[i] = _MH_SplitMix64(&state) | 1;
+        mh_add[i] = _MH_SplitMix64(&state);
+    }
+    mh_params_ready = true;
+}
+
+uint64_t MH_Hash(const void *data, size_t len) {
+    return MurmurHash64A_Bloom(data, len, MH_HASH_SEED);
+}
+
+MinHash *MH_New(void) {
+    if (!mh_params_ready) {
+        _MH_InitParams();
+    }
+    MinHash *mh = MH_CALLOC(1, sizeof *mh);
+    for (size_t i = 0; i < MH_LANES; i++) {
+        mh->signature[i] = UINT32_MAX;
+    }
+    return mh;
+}
+
+void MH_Free(MinHash *mh) { MH_FREE(mh); }
+
+void MH_Add(MinHash *mh, uint64_t h) {
+    uint32_t *restrict signature = mh->signature;
+    for (size_t i = 0; i < MH_LANES; i++) {
+        const uint32_t v = (h * mh_mul[i] + mh_add[i]) >> 32;
+        signature[i] = v < signature[i] ? v : signature[i];
+    }
+    mh->size++;
+}
+
+double MH_Similarity(const MinHash *a, const MinHash *b) {
+    if (!a->size || !b->size) {
+        return 0;
+    }
+    uint32_t equal = 0;
+    for (size_t i = 0; i < MH_LANES; i++) {
+        equal += a->signature[i] == b->signature[i];
+    }
+    return (double)equal / MH_LANES;
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef REDIS_MODULE_TARGET
+#include "redismodule.h"
+#define MH_CALLOC(count, size) RedisModule_Calloc(count, size)
+#define MH_FREE(ptr) RedisModule_Free(ptr)
+#endif
+
+#define MH_LANES 256
+
+/*  A MinHash sketch of a set: each of its lanes holds the minimum of the items under a hash
+    function of its own. Two sets agree on a lane with a probability of their Jaccard similarity,
+    which is estimated with a standard error of at most 1 / (2 * sqrt(lanes)), 0.031.
+
+    The hash of lane i is a multiply-shift of the 64-bit hash of the item, with constants that
+    are the same for all sketches, so that they can be compared. The lanes are 32-bit and updated
+    without branches, so that an item costs a few vector instructions once compiled. */
+typedef struct MinHash {
+    uint64_t size; //  items added
+    uint32_t signature[MH_LANES];
+} MinHash;
+
+/*  Returns the hash of an item.
+    Complexity - O(len) */
+uint64_t MH_Hash(const void *data, size_t len);
+
+/*  Returns a new empty sketch.
+    Complexity - O(lanes) */
+MinHash *MH_New(void);
+
+/*  Releases resources of a sketch.
+    Complexity - O(1) */
+void MH_Free(MinHash *mh);
+
+/*  Adds an item of hash 'h'.
+    Complexity - O(lanes) */
+void MH_Add(MinHash *mh, uint64_t h);
+
+/*  Returns the estimated Jaccard similarity of the sets of two sketches, and 0 if one is empty.
+    Complexity - O(lanes) */
+double MH_Similarity(const MinHash *a, const MinHash *b);
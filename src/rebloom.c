@@ -11,10 +11,19 @@
 #include "redismodule.h"
 
 #include "sb.h"
+#include "sbwindow.h"
+#include "fuse.h"
+#include "ribbon.h"
 #include "cf.h"
 #include "rm_cms.h"
 #include "rm_topk.h"
 #include "rm_tdigest.h"
+#include "rm_ddsketch.h"
+#include "rm_hdr.h"
+#include "rm_cbf.h"
+#include "rm_rf.h"
+#include "rm_minhash.h"
+#include "rm_theta.h"
 #include "load_io_error.h"
 #include "version.h"
 #include "common.h"
@@ -27,7 +36,9 @@
 #include <strings.h> // strncasecmp
 #include <string.h>
 #include <ctype.h>
+#include <errno.h>
 #include <inttypes.h>
+#include <pthread.h>
 
 #ifndef REDISBLOOM_GIT_SHA
 #define REDISBLOOM_GIT_SHA "unknown"
@@ -43,6 +54,9 @@
 ////////////////////////////////////////////////////////////////////////////////
 static RedisModuleType *BFType;
 static RedisModuleType *CFType;
+static RedisModuleType *FuseType;
+static RedisModuleType *RibbonType;
+static RedisModuleType *BFWindowType;
 static int rsStrcasecmp(const RedisModuleString *rs1, const char *s2);
 
 typedef enum { SB_OK = 0, SB_MISSING, SB_EMPTY, SB_MISMATCH } lookupStatus;
@@ -55,6 +69,7 @@ typedef struct {
     int is_multi;
     long long expansion;
     long long nonScaling;
+    long long now; // Unix time of the items in milliseconds, -1 for the current time
 } BFInsertOptions;
 
 static int getValue(RedisModuleKey *key, RedisModuleType *expType, void **sbout) {
@@ -82,6 +97,24 @@ static int cfGetFilter(RedisModuleKey *key, CuckooFilter **cfout) {
     return getValue(key, CFType, (void **)cfout);
 }
 
+static int fuseGetFilter(RedisModuleKey *key, FuseFilter **ffout) {
+    return getValue(key, FuseType, (void **)ffout);
+}
+
+static int ribbonGetFilter(RedisModuleKey *key, RibbonFilter **rbout) {
+    return getValue(key, RibbonType, (void **)rbout);
+}
+
+static int bfGetWindow(RedisModuleKey *key, SBWindow **wout) {
+    return getValue(key, BFWindowType, (void **)wout);
+}
+
+// Frozen filters are the immutable filters that BF.FREEZE replaces Bloom filters with
+static int isFrozen(RedisModuleKey *key) {
+    RedisModuleType *type = RedisModule_ModuleTypeGetType(key);
+    return type == FuseType || type == RibbonType;
+}
+
 static const char *statusStrerror(int status) {
     switch (status) {
     case SB_MISSING:
@@ -111,6 +144,21 @@ static SBChain *bfCreateChain(RedisModuleKey *key, double error_rate, size_t cap
     return sb;
 }
 
+/**
+ * Creates a sliding window filter of 'nslices' chains, each expected to hold its share of the
+ * items added during the window.
+ */
+static SBWindow *bfCreateWindow(RedisModuleKey *key, double error_rate, size_t capacity,
+                                unsigned expansion, unsigned scaling, long long window,
+                                long long nslices, int *err) {
+    SBWindow *w = SBWindow_New(window, nslices, (capacity + nslices - 1) / nslices, error_rate,
+                               BLOOM_OPT_FORCE64 | scaling | BLOOM_OPT_NOROUND, expansion, err);
+    if (w != NULL) {
+        RedisModule_ModuleTypeSetValue(key, BFWindowType, w);
+    }
+    return w;
+}
+
 static CuckooFilter *cfCreate(RedisModuleKey *key, size_t capacity, uint16_t bucketSize,
                               uint16_t maxIterations, uint16_t expansion, int *err) {
     *err = CUCKOO_OK;
@@ -134,11 +182,15 @@ static CuckooFilter *cfCreate(RedisModuleKey *key, size_t capacity, uint16_t buc
 /**
  * Reserves a new empty filter with custom parameters:
  * BF.RESERVE <KEY> <ERROR_RATE (double)> <INITIAL_CAPACITY (int)> [NONSCALING]
+ *            [WINDOW <DURATION (ms)> SLICES <N>]
+ *
+ * With WINDOW the filter only holds the items added during the last DURATION milliseconds,
+ * in N slices that expire one at a time.
  */
 static int BFReserve_RedisCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
     RedisModule_AutoMemory(ctx);
 
-    if (argc < 4 || argc > 7) {
+    if (argc < 4 || argc > 11) {
         return RedisModule_WrongArity(ctx);
     }
 
@@ -190,6 +242,31 @@ static int BFReserve_RedisCommand(RedisModuleCtx *ctx, RedisModuleString **argv,
         }
     }
 
+    long long window = 0;
+    ex_loc = RMUtil_ArgIndex("WINDOW", argv, argc);
+    if (ex_loc != -1 &&
+        (ex_loc + 1 == argc ||
+         RedisModule_StringToLongLong(argv[ex_loc + 1], &window) != REDISMODULE_OK ||
+         window <= 0)) {
+        return RedisModule_ReplyWithError(ctx, "ERR window needs to be a positive integer");
+    }
+    long long nslices = 0;
+    ex_loc = RMUtil_ArgIndex("SLICES", argv, argc);
+    if (ex_loc != -1 &&
+        (ex_loc + 1 == argc ||
+         RedisModule_StringToLongLong(argv[ex_loc + 1], &nslices) != REDISMODULE_OK ||
+         nslices <= 0 || nslices > SBWINDOW_MAX_SLICES)) {
+        return RedisModule_ReplyWithErrorFormat(ctx, "ERR slices must be in the range [1, %d]",
+                                                SBWINDOW_MAX_SLICES);
+    }
+    if ((window == 0) != (nslices == 0)) {
+        return RedisModule_ReplyWithError(ctx, "ERR WINDOW requires SLICES");
+    }
+    if (window < nslices) {
+        return RedisModule_ReplyWithError(
+            ctx, "ERR window needs to be at least one millisecond per slice");
+    }
+
     RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ | REDISMODULE_WRITE);
     SBChain *sb;
     int status = bfGetChain(key, &sb);
@@ -198,7 +275,14 @@ static int BFReserve_RedisCommand(RedisModuleCtx *ctx, RedisModuleString **argv,
     }
 
     int err = SB_SUCCESS;
-    if (bfCreateChain(key, error_rate, capacity, expansion, nonScaling, &err) == NULL) {
+    int created;
+    if (window) {
+        created = bfCreateWindow(key, error_rate, capacity, expansion, nonScaling, window, nslices,
+                                 &err) != NULL;
+    } else {
+        created = bfCreateChain(key, error_rate, capacity, expansion, nonScaling, &err) != NULL;
+    }
+    if (!created) {
         if (err == SB_OOM) {
             RedisModule_ReplyWithError(ctx, "ERR Insufficient memory to create filter");
         } else {
@@ -233,7 +317,17 @@ static int BFCheck_RedisCommand(RedisModuleCtx *ctx, RedisModuleString **argv, i
 
     RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
     SBChain *sb;
+    FuseFilter *ff = NULL;
+    RibbonFilter *rb = NULL;
+    SBWindow *w = NULL;
     int status = bfGetChain(key, &sb);
+    if (status == SB_MISMATCH && isFrozen(key)) {
+        // frozen filters answer the same queries
+        status = fuseGetFilter(key, &ff) == SB_OK ? SB_OK : ribbonGetFilter(key, &rb);
+    } else if (status == SB_MISMATCH) {
+        status = bfGetWindow(key, &w);
+    }
+    const long long now = RedisModule_Milliseconds();
 
     int is_empty = 0;
     if (status != SB_OK) {
@@ -252,7 +346,16 @@ static int BFCheck_RedisCommand(RedisModuleCtx *ctx, RedisModuleString **argv, i
         } else {
             size_t n;
             const char *s = RedisModule_StringPtrLen(argv[ii], &n);
-            int exists = SBChain_Check(sb, s, n);
+            int exists;
+            if (ff) {
+                exists = FuseFilter_Contains(ff, FuseFilter_Hash(s, n));
+            } else if (rb) {
+                exists = RibbonFilter_Contains(rb, FuseFilter_Hash(s, n));
+            } else if (w) {
+                exists = SBWindow_Check(w, now, s, n);
+            } else {
+                exists = SBChain_Check(sb, s, n);
+            }
             reply = !!exists;
         }
         if (_is_resp3(ctx)) {
@@ -269,7 +372,9 @@ static int bfInsertCommon(RedisModuleCtx *ctx, RedisModuleString *keystr, RedisM
                           size_t nitems, const BFInsertOptions *options) {
     RedisModuleKey *key = RedisModule_OpenKey(ctx, keystr, REDISMODULE_READ | REDISMODULE_WRITE);
     SBChain *sb;
+    SBWindow *w = NULL;
     const int status = bfGetChain(key, &sb);
+    const long long now = options->now >= 0 ? options->now : RedisModule_Milliseconds();
 
     if (status == SB_EMPTY && options->autocreate) {
         int err = SB_SUCCESS;
@@ -283,10 +388,27 @@ static int bfInsertCommon(RedisModuleCtx *ctx, RedisModuleString *keystr, RedisM
             }
             return REDISMODULE_OK;
         }
+    } else if (status == SB_MISMATCH && isFrozen(key)) {
+        return RedisModule_ReplyWithError(ctx, "ERR filter is frozen");
+    } else if (status == SB_MISMATCH && bfGetWindow(key, &w) == SB_OK) {
+        // items go to the slice of the current time slot
     } else if (status != SB_OK) {
         return RedisModule_ReplyWithError(ctx, statusStrerror(status));
     }
 
+    if (w) {
+        // a client may not claim slices ahead of time, which would drop the writes made until then
+        const int replayed = RedisModule_GetContextFlags(ctx) &
+                             (REDISMODULE_CTX_FLAGS_REPLICATED | REDISMODULE_CTX_FLAGS_LOADING);
+        if (!replayed &&
+            SBWindow_Slot(w, now) > SBWindow_Slot(w, RedisModule_Milliseconds()) + 1) {
+            return RedisModule_ReplyWithError(ctx, "ERR timestamp is too far in the future");
+        }
+        if (SBWindow_IsStale(w, now)) {
+            return RedisModule_ReplyWithError(ctx, "ERR timestamp is older than the window");
+        }
+    }
+
     if (options->is_multi) {
         RedisModule_ReplyWithArray(ctx, REDISMODULE_POSTPONED_ARRAY_LEN);
     }
@@ -296,10 +418,10 @@ static int bfInsertCommon(RedisModuleCtx *ctx, RedisModuleString *keystr, RedisM
     for (size_t ii = 0; ii < nitems && rv != -2; ++ii) {
         size_t n;
         const char *s = RedisModule_StringPtrLen(items[ii], &n);
-        rv = SBChain_Add(sb, s, n);
+        rv = w ? SBWindow_Add(w, now, s, n) : SBChain_Add(sb, s, n);
         if (rv == -2) { // decide if to make into an error
             RedisModule_ReplyWithError(ctx, "ERR non scaling filter is full");
-        } else if (rv == -1) {
+        } else if (rv < 0) {
             RedisModule_ReplyWithError(ctx, "ERR problem inserting into filter");
         } else {
             if (_is_resp3(ctx)) {
@@ -314,7 +436,13 @@ static int bfInsertCommon(RedisModuleCtx *ctx, RedisModuleString *keystr, RedisM
     if (options->is_multi) {
         RedisModule_ReplySetArrayLength(ctx, array_len);
     }
-    RedisModule_ReplicateVerbatim(ctx);
+    if (w) {
+        // like EXPIRE is with PEXPIREAT, so that replicas and the AOF add to the same slices
+        RedisModule_Replicate(ctx, "BF.INSERT", "sclcv", keystr, "AT", now, "ITEMS", items,
+                              nitems);
+    } else {
+        RedisModule_ReplicateVerbatim(ctx);
+    }
     return REDISMODULE_OK;
 }
 
@@ -332,6 +460,7 @@ static int BFAdd_RedisCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int
         .autocreate = 1,
         .expansion = rm_config.bf_expansion_factor.value,
         .nonScaling = rm_config.bf_expansion_factor.value == 0 ? BLOOM_OPT_NO_SCALING : 0,
+        .now = -1,
     };
     options.is_multi = isMulti(argv[0]);
 
@@ -343,9 +472,12 @@ static int BFAdd_RedisCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int
 
 /**
  * BF.INSERT {filter} [ERROR {rate} CAPACITY {cap} EXPANSION {expansion}]
- *                    [NOCREATE] [NONSCALING] ITEMS {item} {item}
+ *                    [NOCREATE] [NONSCALING] [AT {timestamp}] ITEMS {item} {item}
  * ..
  * -> (Array) (or error )
+ *
+ * AT adds the items to a sliding window filter as if at that Unix time, in milliseconds, which may
+ * be at most one slice ahead of the current time.
  */
 static int BFInsert_RedisCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
     RedisModule_AutoMemory(ctx);
@@ -356,6 +488,7 @@ static int BFInsert_RedisCommand(RedisModuleCtx *ctx, RedisModuleString **argv,
         .is_multi = 1,
         .expansion = rm_config.bf_expansion_factor.value,
         .nonScaling = rm_config.bf_expansion_factor.value == 0 ? BLOOM_OPT_NO_SCALING : 0,
+        .now = -1,
     };
     int items_index = -1;
 
@@ -408,6 +541,16 @@ static int BFInsert_RedisCommand(RedisModuleCtx *ctx, RedisModuleString **argv,
             }
             break;
 
+        case 'a':
+            if (++cur_pos == argc) {
+                return RedisModule_WrongArity(ctx);
+            }
+            if (RedisModule_StringToLongLong(argv[cur_pos++], &options.now) != REDISMODULE_OK ||
+                options.now < 0) {
+                return RedisModule_ReplyWithError(ctx, "Bad timestamp");
+            }
+            break;
+
         case 'n':
             if (tolower(*(argstr + 2)) == 'c') {
                 options.autocreate = 0;
@@ -433,6 +576,337 @@ static int BFInsert_RedisCommand(RedisModuleCtx *ctx, RedisModuleString **argv,
     return bfInsertCommon(ctx, argv[1], argv + items_index, argc - items_index, &options);
 }
 
+static int parseHash(RedisModuleString *rs, uint64_t *hash) {
+    size_t n;
+    const char *s = RedisModule_StringPtrLen(rs, &n);
+    if (n == 0 || !isdigit(*s)) {
+        return REDISMODULE_ERR;
+    }
+    char *end;
+    errno = 0;
+    unsigned long long val = strtoull(s, &end, 10);
+    if (errno != 0 || end != s + n) {
+        return REDISMODULE_ERR;
+    }
+    *hash = val;
+    return REDISMODULE_OK;
+}
+
+// A BF.FREEZE filter construction, run by a worker unless the client cannot be blocked
+typedef struct FreezeJob {
+    struct FreezeJob *next; //< The next job waiting for a worker
+    RedisModuleBlockedClient *bc;
+    // the command arguments, held for the key name and for replication
+    RedisModuleString **argv;
+    int argc;
+    uint64_t *keys;
+    size_t n;
+    int ribbon;
+    uint32_t resultBits;
+    // the id of the Bloom filter being frozen and its number of items, 0 if the key was empty
+    uint64_t sbId;
+    size_t sbSize;
+    FuseFilter *ff;
+    RibbonFilter *rb;
+    int err;
+} FreezeJob;
+
+static void freezeJobFree(FreezeJob *job) {
+    if (job->keys) {
+        RedisModule_Free(job->keys);
+    }
+    FuseFilter_Free(job->ff);
+    RibbonFilter_Free(job->rb);
+    for (int ii = 0; ii < job->argc; ++ii) {
+        RedisModule_FreeString(NULL, job->argv[ii]);
+    }
+    RedisModule_Free(job->argv);
+    RedisModule_Free(job);
+}
+
+// Builds the filter of the job's keys. Touches nothing but the job, so it can run on any thread.
+static void freezeBuild(FreezeJob *job) {
+    if (job->ribbon) {
+        job->rb = RibbonFilter_Build(job->keys, job->n, job->resultBits, &job->err);
+    } else {
+        job->ff = FuseFilter_Build(job->keys, job->n, &job->err);
+    }
+    RedisModule_Free(job->keys);
+    job->keys = NULL;
+}
+
+/**
+ * Replaces the key with the filter built, replicates the command and replies. The key must still
+ * hold the Bloom filter the filter was built from, unchanged, since items added to it meanwhile
+ * would be lost.
+ */
+static int freezeCommit(RedisModuleCtx *ctx, FreezeJob *job) {
+    if (!job->ff && !job->rb) {
+        return RedisModule_ReplyWithError(ctx, job->err == FUSE_OOM || job->err == RIBBON_OOM
+                                                   ? "ERR Insufficient memory to create filter"
+                                                   : "ERR could not create filter");
+    }
+    RedisModuleKey *key =
+        RedisModule_OpenKey(ctx, job->argv[1], REDISMODULE_READ | REDISMODULE_WRITE);
+    SBChain *sb = NULL;
+    const int status = bfGetChain(key, &sb);
+    if (status != (job->sbId ? SB_OK : SB_EMPTY) || (sb && sb->id != job->sbId) ||
+        (sb && sb->size != job->sbSize)) {
+        RedisModule_CloseKey(key);
+        return RedisModule_ReplyWithError(ctx, "ERR filter changed while being frozen");
+    }
+    // a filter of fewer items than were added to the Bloom filter would lose some of them
+    if (sb && (job->ff ? job->ff->size : job->rb->size) < sb->size) {
+        RedisModule_CloseKey(key);
+        return RedisModule_ReplyWithError(ctx, "ERR fewer items than in the filter");
+    }
+
+    if (job->ff) {
+        RedisModule_ModuleTypeSetValue(key, FuseType, job->ff);
+    } else {
+        RedisModule_ModuleTypeSetValue(key, RibbonType, job->rb);
+    }
+    job->ff = NULL;
+    job->rb = NULL;
+    RedisModule_CloseKey(key);
+    RedisModule_Replicate(ctx, "BF.FREEZE", "v", job->argv + 1, (size_t)(job->argc - 1));
+    return RedisModule_ReplyWithSimpleString(ctx, "OK");
+}
+
+// Most BF.FREEZE filters built at once, each by a worker thread of its own
+#define FREEZE_MAX_WORKERS 4
+
+// The jobs waiting for a worker, and the workers started so far
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    FreezeJob *head, *tail;
+    size_t pending;
+    size_t workers;
+    size_t idle;
+} freezeQueue = {.lock = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER};
+
+static void *freezeWorker(void *arg) {
+    pthread_mutex_lock(&freezeQueue.lock);
+    for (;;) {
+        while (!freezeQueue.head) {
+            freezeQueue.idle++;
+            pthread_cond_wait(&freezeQueue.cond, &freezeQueue.lock);
+            freezeQueue.idle--;
+        }
+        FreezeJob *job = freezeQueue.head;
+        freezeQueue.head = job->next;
+        if (!freezeQueue.head) {
+            freezeQueue.tail = NULL;
+        }
+        freezeQueue.pending--;
+        pthread_mutex_unlock(&freezeQueue.lock);
+
+        freezeBuild(job);
+        RedisModule_UnblockClient(job->bc, job);
+        pthread_mutex_lock(&freezeQueue.lock);
+    }
+    return NULL;
+}
+
+/**
+ * Queues a job for the workers, starting one if the jobs queued already keep the idle ones busy
+ * and there are fewer than FREEZE_MAX_WORKERS.
+ * Returns 0, or nonzero if there is no worker to run it.
+ */
+static int freezeEnqueue(FreezeJob *job) {
+    pthread_mutex_lock(&freezeQueue.lock);
+    if (freezeQueue.pending >= freezeQueue.idle && freezeQueue.workers < FREEZE_MAX_WORKERS) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, freezeWorker, NULL) == 0) {
+            pthread_detach(thread);
+            freezeQueue.workers++;
+        }
+    }
+    if (freezeQueue.workers == 0) {
+        pthread_mutex_unlock(&freezeQueue.lock);
+        return -1;
+    }
+    job->next = NULL;
+    if (freezeQueue.tail) {
+        freezeQueue.tail->next = job;
+    } else {
+        freezeQueue.head = job;
+    }
+    freezeQueue.tail = job;
+    freezeQueue.pending++;
+    pthread_cond_signal(&freezeQueue.cond);
+    pthread_mutex_unlock(&freezeQueue.lock);
+    return 0;
+}
+
+static int freezeReply(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    return freezeCommit(ctx, RedisModule_GetBlockedClientPrivateData(ctx));
+}
+
+static void freezeFree(RedisModuleCtx *ctx, void *privdata) { freezeJobFree(privdata); }
+
+/**
+ * BF.FREEZE <KEY> [RIBBON [ERROR <ERROR_RATE (double)>]] ITEMS item [item...]
+ * BF.FREEZE <KEY> [RIBBON [ERROR <ERROR_RATE (double)>]] HASHES hash [hash...]
+ *
+ * Replaces the key with an immutable binary fuse filter of the items, or of their hashes as
+ * returned from FuseFilter_Hash. If the key holds a Bloom filter, all of its items must be given.
+ * A Ribbon filter takes about 7% less memory, and can have any error rate down to 2^-32.
+ * The items are hashed on the main thread, and the filter is built by one of FREEZE_MAX_WORKERS
+ * worker threads while the client is blocked. Inside MULTI, scripts, or when replicated or
+ * loaded, where a client cannot be blocked, it is built on the main thread.
+ */
+static int BFFreeze_RedisCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    RedisModule_AutoMemory(ctx);
+
+    if (argc < 4) {
+        return RedisModule_WrongArity(ctx);
+    }
+
+    int pos = 2;
+    int ribbon = 0;
+    uint32_t resultBits = 8;
+    if (rsStrcasecmp(argv[pos], "RIBBON") == 0) {
+        ribbon = 1;
+        pos++;
+        if (pos + 1 < argc && rsStrcasecmp(argv[pos], "ERROR") == 0) {
+            double error_rate;
+            if (RedisModule_StringToDouble(argv[pos + 1], &error_rate) != REDISMODULE_OK) {
+                return RedisModule_ReplyWithError(ctx, "ERR bad error rate");
+            } else if (!(error_rate > 0 && error_rate < 1)) {
+                return RedisModule_ReplyWithError(ctx,
+                                                  "ERR error rate must be in the range (0, 1)");
+            }
+            // the rate of a filter with one bit less would be above the requested one
+            const double bits = ceil(-log2(error_rate) - 1e-9);
+            resultBits = bits > RIBBON_MAX_RESULT_BITS ? RIBBON_MAX_RESULT_BITS : bits;
+            pos += 2;
+        }
+    }
+    if (argc < pos + 2) {
+        return RedisModule_WrongArity(ctx);
+    }
+
+    int hashes;
+    if (rsStrcasecmp(argv[pos], "ITEMS") == 0) {
+        hashes = 0;
+    } else if (rsStrcasecmp(argv[pos], "HASHES") == 0) {
+        hashes = 1;
+    } else {
+        return RedisModule_ReplyWithError(ctx, "Unknown argument received");
+    }
+    pos++;
+
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
+    SBChain *sb = NULL;
+    int status = bfGetChain(key, &sb);
+    if (status == SB_MISMATCH && isFrozen(key)) {
+        return RedisModule_ReplyWithError(ctx, "ERR filter is already frozen");
+    } else if (status != SB_OK && status != SB_EMPTY) {
+        return RedisModule_ReplyWithError(ctx, statusStrerror(status));
+    }
+
+    const size_t n = argc - pos;
+    uint64_t *keys = RedisModule_Calloc(n, sizeof(*keys));
+    for (size_t ii = 0; ii < n; ++ii) {
+        size_t len;
+        const char *s = RedisModule_StringPtrLen(argv[pos + ii], &len);
+        if (hashes) {
+            if (parseHash(argv[pos + ii], &keys[ii]) != REDISMODULE_OK) {
+                RedisModule_Free(keys);
+                return RedisModule_ReplyWithError(ctx, "ERR bad hash");
+            }
+        } else if (sb && !SBChain_Check(sb, s, len)) {
+            RedisModule_Free(keys);
+            return RedisModule_ReplyWithError(ctx, "ERR item is not in the filter");
+        } else {
+            keys[ii] = FuseFilter_Hash(s, len);
+        }
+    }
+    RedisModule_CloseKey(key);
+
+    FreezeJob *job = RedisModule_Calloc(1, sizeof(*job));
+    job->argv = RedisModule_Calloc(argc, sizeof(*job->argv));
+    for (int ii = 0; ii < argc; ++ii) {
+        job->argv[ii] = RedisModule_HoldString(NULL, argv[ii]);
+    }
+    job->argc = argc;
+    job->keys = keys;
+    job->n = n;
+    job->ribbon = ribbon;
+    job->resultBits = resultBits;
+    job->sbId = sb ? sb->id : 0;
+    job->sbSize = sb ? sb->size : 0;
+
+    const int noBlock = REDISMODULE_CTX_FLAGS_MULTI | REDISMODULE_CTX_FLAGS_LUA |
+                        REDISMODULE_CTX_FLAGS_DENY_BLOCKING | REDISMODULE_CTX_FLAGS_REPLICATED |
+                        REDISMODULE_CTX_FLAGS_LOADING;
+    if (!(RedisModule_GetContextFlags(ctx) & noBlock)) {
+        job->bc = RedisModule_BlockClient(ctx, freezeReply, NULL, freezeFree, 0);
+        if (job->bc && freezeEnqueue(job) == 0) {
+            return REDISMODULE_OK;
+        }
+        if (job->bc) {
+            RedisModule_AbortBlock(job->bc);
+        }
+    }
+    freezeBuild(job);
+    const int rc = freezeCommit(ctx, job);
+    freezeJobFree(job);
+    return rc;
+}
+
+static int ribbonDebug(RedisModuleCtx *ctx, const RibbonFilter *rb) {
+    RedisModule_ReplyWithArray(ctx, 2);
+
+    RedisModuleString *info_s = RedisModule_CreateStringPrintf(ctx, "size:%" PRIu64, rb->size);
+    RedisModule_ReplyWithString(ctx, info_s);
+    RedisModule_FreeString(ctx, info_s);
+
+    info_s = RedisModule_CreateStringPrintf(ctx, "bytes:%zu bits:%u slots:%" PRIu64 " width:%d",
+                                            RibbonFilter_Bytes(rb), rb->resultBits,
+                                            rb->numSlots, RIBBON_WIDTH);
+    RedisModule_ReplyWithString(ctx, info_s);
+    RedisModule_FreeString(ctx, info_s);
+    return REDISMODULE_OK;
+}
+
+static int fuseDebug(RedisModuleCtx *ctx, const FuseFilter *ff) {
+    RedisModule_ReplyWithArray(ctx, 2);
+
+    RedisModuleString *info_s = RedisModule_CreateStringPrintf(ctx, "size:%" PRIu64, ff->size);
+    RedisModule_ReplyWithString(ctx, info_s);
+    RedisModule_FreeString(ctx, info_s);
+
+    info_s = RedisModule_CreateStringPrintf(ctx, "bytes:%u bits:8 segments:%u segment_length:%u",
+                                            ff->arrayLength, ff->segmentCount,
+                                            ff->segmentLength);
+    RedisModule_ReplyWithString(ctx, info_s);
+    RedisModule_FreeString(ctx, info_s);
+    return REDISMODULE_OK;
+}
+
+static int windowDebug(RedisModuleCtx *ctx, const SBWindow *w) {
+    const long long now = RedisModule_Milliseconds();
+    RedisModule_ReplyWithArray(ctx, 1 + w->nslices);
+
+    RedisModuleString *info_s =
+        RedisModule_CreateStringPrintf(ctx, "size:%zu", SBWindow_Size(w, now));
+    RedisModule_ReplyWithString(ctx, info_s);
+    RedisModule_FreeString(ctx, info_s);
+
+    for (size_t ii = 0; ii < w->nslices; ++ii) {
+        const SBChain *sb = w->slices[ii];
+        info_s = RedisModule_CreateStringPrintf(
+            ctx, "slot:%lld live:%d size:%zu new:%zu filters:%zu", w->slots[ii],
+            SBWindow_IsLive(w, ii, now), sb->size, w->counts[ii], sb->nfilters);
+        RedisModule_ReplyWithString(ctx, info_s);
+        RedisModule_FreeString(ctx, info_s);
+    }
+    return REDISMODULE_OK;
+}
+
 /**
  * BF.DEBUG KEY
  * returns some information about the bloom filter.
@@ -447,7 +921,16 @@ static int BFDebug_RedisCommand(RedisModuleCtx *ctx, RedisModuleString **argv, i
     const SBChain *sb = NULL;
     RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
     int status = bfGetChain(key, (SBChain **)&sb);
-    if (status != SB_OK) {
+    FuseFilter *ff;
+    RibbonFilter *rb;
+    SBWindow *w;
+    if (status == SB_MISMATCH && fuseGetFilter(key, &ff) == SB_OK) {
+        return fuseDebug(ctx, ff);
+    } else if (status == SB_MISMATCH && ribbonGetFilter(key, &rb) == SB_OK) {
+        return ribbonDebug(ctx, rb);
+    } else if (status == SB_MISMATCH && bfGetWindow(key, &w) == SB_OK) {
+        return windowDebug(ctx, w);
+    } else if (status != SB_OK) {
         return RedisModule_ReplyWithError(ctx, statusStrerror(status));
     }
 
@@ -486,8 +969,16 @@ static int BFScanDump_RedisCommand(RedisModuleCtx *ctx, RedisModuleString **argv
         return RedisModule_WrongArity(ctx);
     }
     const SBChain *sb = NULL;
+    FuseFilter *ff = NULL;
+    RibbonFilter *rb = NULL;
+    SBWindow *w = NULL;
     RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
     int status = bfGetChain(key, (SBChain **)&sb);
+    if (status == SB_MISMATCH && isFrozen(key)) {
+        status = fuseGetFilter(key, &ff) == SB_OK ? SB_OK : ribbonGetFilter(key, &rb);
+    } else if (status == SB_MISMATCH) {
+        status = bfGetWindow(key, &w);
+    }
     if (status != SB_OK) {
         return RedisModule_ReplyWithError(ctx, statusStrerror(status));
     }
@@ -501,13 +992,36 @@ static int BFScanDump_RedisCommand(RedisModuleCtx *ctx, RedisModuleString **argv
 
     if (iter == 0) {
         size_t hdrlen;
-        char *hdr = SBChain_GetEncodedHeader(sb, &hdrlen);
         RedisModule_ReplyWithLongLong(ctx, SB_CHUNKITER_INIT);
-        RedisModule_ReplyWithStringBuffer(ctx, (const char *)hdr, hdrlen);
-        SB_FreeEncodedHeader(hdr);
+        if (ff) {
+            char *hdr = FuseFilter_GetEncodedHeader(ff, &hdrlen);
+            RedisModule_ReplyWithStringBuffer(ctx, (const char *)hdr, hdrlen);
+            FuseFilter_FreeEncodedHeader(hdr);
+        } else if (rb) {
+            char *hdr = RibbonFilter_GetEncodedHeader(rb, &hdrlen);
+            RedisModule_ReplyWithStringBuffer(ctx, (const char *)hdr, hdrlen);
+            RibbonFilter_FreeEncodedHeader(hdr);
+        } else if (w) {
+            char *hdr = SBWindow_GetEncodedHeader(w, &hdrlen);
+            RedisModule_ReplyWithStringBuffer(ctx, (const char *)hdr, hdrlen);
+            SBWindow_FreeEncodedHeader(hdr);
+        } else {
+            char *hdr = SBChain_GetEncodedHeader(sb, &hdrlen);
+            RedisModule_ReplyWithStringBuffer(ctx, (const char *)hdr, hdrlen);
+            SB_FreeEncodedHeader(hdr);
+        }
     } else {
         size_t bufLen = 0;
-        const char *buf = SBChain_GetEncodedChunk(sb, &iter, &bufLen, MAX_SCANDUMP_SIZE);
+        const char *buf;
+        if (ff) {
+            buf = FuseFilter_GetEncodedChunk(ff, &iter, &bufLen, MAX_SCANDUMP_SIZE);
+        } else if (rb) {
+            buf = RibbonFilter_GetEncodedChunk(rb, &iter, &bufLen, MAX_SCANDUMP_SIZE);
+        } else if (w) {
+            buf = SBWindow_GetEncodedChunk(w, &iter, &bufLen, MAX_SCANDUMP_SIZE);
+        } else {
+            buf = SBChain_GetEncodedChunk(sb, &iter, &bufLen, MAX_SCANDUMP_SIZE);
+        }
         RedisModule_ReplyWithLongLong(ctx, iter);
         RedisModule_ReplyWithStringBuffer(ctx, buf, bufLen);
     }
@@ -536,7 +1050,34 @@ static int BFLoadChunk_RedisCommand(RedisModuleCtx *ctx, RedisModuleString **arg
     RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ | REDISMODULE_WRITE);
     SBChain *sb;
     int status = bfGetChain(key, &sb);
-    if (status == SB_EMPTY && iter == 1) {
+    if (status == SB_EMPTY && iter == 1 && SBWindow_IsEncodedHeader(buf, bufLen)) {
+        const char *errmsg;
+        SBWindow *w = SBWindow_NewFromHeader(buf, bufLen, &errmsg);
+        if (!w) {
+            return RedisModule_ReplyWithError(ctx, errmsg);
+        }
+        RedisModule_ModuleTypeSetValue(key, BFWindowType, w);
+        RedisModule_ReplicateVerbatim(ctx);
+        return RedisModule_ReplyWithSimpleString(ctx, "OK");
+    } else if (status == SB_EMPTY && iter == 1 && FuseFilter_IsEncodedHeader(bufLen)) {
+        const char *errmsg;
+        FuseFilter *ff = FuseFilter_NewFromHeader(buf, bufLen, &errmsg);
+        if (!ff) {
+            return RedisModule_ReplyWithError(ctx, errmsg);
+        }
+        RedisModule_ModuleTypeSetValue(key, FuseType, ff);
+        RedisModule_ReplicateVerbatim(ctx);
+        return RedisModule_ReplyWithSimpleString(ctx, "OK");
+    } else if (status == SB_EMPTY && iter == 1 && RibbonFilter_IsEncodedHeader(bufLen)) {
+        const char *errmsg;
+        RibbonFilter *rb = RibbonFilter_NewFromHeader(buf, bufLen, &errmsg);
+        if (!rb) {
+            return RedisModule_ReplyWithError(ctx, errmsg);
+        }
+        RedisModule_ModuleTypeSetValue(key, RibbonType, rb);
+        RedisModule_ReplicateVerbatim(ctx);
+        return RedisModule_ReplyWithSimpleString(ctx, "OK");
+    } else if (status == SB_EMPTY && iter == 1) {
         const char *errmsg;
         SBChain *sb = SB_NewChainFromHeader(buf, bufLen, &errmsg);
         if (!sb) {
@@ -546,14 +1087,32 @@ static int BFLoadChunk_RedisCommand(RedisModuleCtx *ctx, RedisModuleString **arg
             RedisModule_ReplicateVerbatim(ctx);
             return RedisModule_ReplyWithSimpleString(ctx, "OK");
         }
-    } else if (status != SB_OK) {
-        return RedisModule_ReplyWithError(ctx, statusStrerror(status));
     }
 
-    assert(sb);
+    FuseFilter *ff = NULL;
+    RibbonFilter *rb = NULL;
+    SBWindow *w = NULL;
+    if (status == SB_MISMATCH && isFrozen(key)) {
+        status = fuseGetFilter(key, &ff) == SB_OK ? SB_OK : ribbonGetFilter(key, &rb);
+    } else if (status == SB_MISMATCH) {
+        status = bfGetWindow(key, &w);
+    }
+    if (status != SB_OK) {
+        return RedisModule_ReplyWithError(ctx, statusStrerror(status));
+    }
 
     const char *errMsg;
-    if (SBChain_LoadEncodedChunk(sb, iter, buf, bufLen, &errMsg) != 0) {
+    int rc;
+    if (ff) {
+        rc = FuseFilter_LoadEncodedChunk(ff, iter, buf, bufLen, &errMsg);
+    } else if (rb) {
+        rc = RibbonFilter_LoadEncodedChunk(rb, iter, buf, bufLen, &errMsg);
+    } else if (w) {
+        rc = SBWindow_LoadEncodedChunk(w, iter, buf, bufLen, &errMsg);
+    } else {
+        rc = SBChain_LoadEncodedChunk(sb, iter, buf, bufLen, &errMsg);
+    }
+    if (rc != 0) {
         return RedisModule_ReplyWithError(ctx, errMsg);
     } else {
         RedisModule_ReplicateVerbatim(ctx); // Should be replicated?
@@ -1027,6 +1586,9 @@ uint64_t BFCapacity(SBChain *bf) {
 
 static size_t BFMemUsage(const void *value);
 static size_t CFMemUsage(const void *value);
+static size_t FuseMemUsage(const void *value);
+static size_t RibbonMemUsage(const void *value);
+static size_t BFWindowMemUsage(const void *value);
 
 static int BFInfo_RedisCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
     RedisModule_AutoMemory(ctx);
@@ -1035,10 +1597,42 @@ static int BFInfo_RedisCommand(RedisModuleCtx *ctx, RedisModuleString **argv, in
     }
 
     SBChain *bf;
+    FuseFilter *ff;
+    RibbonFilter *rb;
+    SBWindow *w = NULL;
     RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
     int status = bfGetChain(key, &bf);
-    if (status != REDISMODULE_OK) {
+    long long capacity, size, nfilters, items, expansion;
+    if (status == SB_MISMATCH && fuseGetFilter(key, &ff) == SB_OK) {
+        // a frozen filter holds exactly its items, and cannot expand
+        capacity = items = ff->size;
+        size = FuseMemUsage(ff);
+        nfilters = 1;
+        expansion = -1;
+    } else if (status == SB_MISMATCH && ribbonGetFilter(key, &rb) == SB_OK) {
+        capacity = items = rb->size;
+        size = RibbonMemUsage(rb);
+        nfilters = 1;
+        expansion = -1;
+    } else if (status == SB_MISMATCH && bfGetWindow(key, &w) == SB_OK) {
+        // the chains of all the slices, and the items of those inside the window
+        capacity = nfilters = 0;
+        for (size_t ii = 0; ii < w->nslices; ++ii) {
+            capacity += BFCapacity(w->slices[ii]);
+            nfilters += w->slices[ii]->nfilters;
+        }
+        size = BFWindowMemUsage(w);
+        items = SBWindow_Size(w, RedisModule_Milliseconds());
+        const SBChain *slice = w->slices[0];
+        expansion = slice->options & BLOOM_OPT_NO_SCALING ? -1 : slice->growth;
+    } else if (status != REDISMODULE_OK) {
         return RedisModule_ReplyWithError(ctx, statusStrerror(status));
+    } else {
+        capacity = BFCapacity(bf);
+        size = BFMemUsage(bf);
+        nfilters = bf->nfilters;
+        items = bf->size;
+        expansion = bf->options & BLOOM_OPT_NO_SCALING ? -1 : bf->growth;
     }
 
     if (argc == 3) {
@@ -1047,32 +1641,32 @@ static int BFInfo_RedisCommand(RedisModuleCtx *ctx, RedisModuleString **argv, in
             if (_ReplyMap(ctx)) {
                 RedisModule_ReplyWithSimpleString(ctx, "Capacity");
             }
-            RedisModule_ReplyWithLongLong(ctx, BFCapacity(bf));
+            RedisModule_ReplyWithLongLong(ctx, capacity);
         } else if (!rsStrcasecmp(argv[2], "size")) {
             RedisModule_ReplyWithMapOrArray(ctx, 1, false);
             if (_ReplyMap(ctx)) {
                 RedisModule_ReplyWithSimpleString(ctx, "Size");
             }
-            RedisModule_ReplyWithLongLong(ctx, BFMemUsage(bf));
+            RedisModule_ReplyWithLongLong(ctx, size);
         } else if (!rsStrcasecmp(argv[2], "filters")) {
             RedisModule_ReplyWithMapOrArray(ctx, 1, false);
             if (_ReplyMap(ctx)) {
                 RedisModule_ReplyWithSimpleString(ctx, "Number of filters");
             }
-            RedisModule_ReplyWithLongLong(ctx, bf->nfilters);
+            RedisModule_ReplyWithLongLong(ctx, nfilters);
         } else if (!rsStrcasecmp(argv[2], "items")) {
             RedisModule_ReplyWithMapOrArray(ctx, 1, false);
             if (_ReplyMap(ctx)) {
                 RedisModule_ReplyWithSimpleString(ctx, "Number of items inserted");
             }
-            RedisModule_ReplyWithLongLong(ctx, bf->size);
+            RedisModule_ReplyWithLongLong(ctx, items);
         } else if (!rsStrcasecmp(argv[2], "expansion")) {
             RedisModule_ReplyWithMapOrArray(ctx, 1, false);
             if (_ReplyMap(ctx)) {
                 RedisModule_ReplyWithSimpleString(ctx, "Expansion rate");
             }
-            bf->options &BLOOM_OPT_NO_SCALING ? RedisModule_ReplyWithNull(ctx)
-                                              : RedisModule_ReplyWithLongLong(ctx, bf->growth);
+            expansion < 0 ? RedisModule_ReplyWithNull(ctx)
+                          : RedisModule_ReplyWithLongLong(ctx, expansion);
         } else {
             return RedisModule_ReplyWithError(ctx, "Invalid information value");
         }
@@ -1080,18 +1674,23 @@ static int BFInfo_RedisCommand(RedisModuleCtx *ctx, RedisModuleString **argv, in
         return REDISMODULE_OK;
     }
 
-    RedisModule_ReplyWithMapOrArray(ctx, 5 * 2, true);
+    RedisModule_ReplyWithMapOrArray(ctx, (w ? 7 : 5) * 2, true);
     RedisModule_ReplyWithSimpleString(ctx, "Capacity");
-    RedisModule_ReplyWithLongLong(ctx, BFCapacity(bf));
+    RedisModule_ReplyWithLongLong(ctx, capacity);
     RedisModule_ReplyWithSimpleString(ctx, "Size");
-    RedisModule_ReplyWithLongLong(ctx, BFMemUsage(bf));
+    RedisModule_ReplyWithLongLong(ctx, size);
     RedisModule_ReplyWithSimpleString(ctx, "Number of filters");
-    RedisModule_ReplyWithLongLong(ctx, bf->nfilters);
+    RedisModule_ReplyWithLongLong(ctx, nfilters);
     RedisModule_ReplyWithSimpleString(ctx, "Number of items inserted");
-    RedisModule_ReplyWithLongLong(ctx, bf->size);
+    RedisModule_ReplyWithLongLong(ctx, items);
     RedisModule_ReplyWithSimpleString(ctx, "Expansion rate");
-    bf->options &BLOOM_OPT_NO_SCALING ? RedisModule_ReplyWithNull(ctx)
-                                      : RedisModule_ReplyWithLongLong(ctx, bf->growth);
+    expansion < 0 ? RedisModule_ReplyWithNull(ctx) : RedisModule_ReplyWithLongLong(ctx, expansion);
+    if (w) {
+        RedisModule_ReplyWithSimpleString(ctx, "Window");
+        RedisModule_ReplyWithLongLong(ctx, w->window);
+        RedisModule_ReplyWithSimpleString(ctx, "Slices");
+        RedisModule_ReplyWithLongLong(ctx, w->nslices);
+    }
 
     return REDISMODULE_OK;
 }
@@ -1103,13 +1702,22 @@ static int BFCard_RedisCommand(RedisModuleCtx *ctx, RedisModuleString **argv, in
     }
 
     SBChain *bf;
+    FuseFilter *ff;
+    RibbonFilter *rb;
+    SBWindow *w;
     RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
     if (key == NULL) {
         RedisModule_ReplyWithLongLong(ctx, 0);
         return REDISMODULE_OK;
     }
     int status = bfGetChain(key, &bf);
-    if (status != REDISMODULE_OK) {
+    if (status == SB_MISMATCH && fuseGetFilter(key, &ff) == SB_OK) {
+        return RedisModule_ReplyWithLongLong(ctx, ff->size);
+    } else if (status == SB_MISMATCH && ribbonGetFilter(key, &rb) == SB_OK) {
+        return RedisModule_ReplyWithLongLong(ctx, rb->size);
+    } else if (status == SB_MISMATCH && bfGetWindow(key, &w) == SB_OK) {
+        return RedisModule_ReplyWithLongLong(ctx, SBWindow_Size(w, RedisModule_Milliseconds()));
+    } else if (status != REDISMODULE_OK) {
         return RedisModule_ReplyWithError(ctx, statusStrerror(status));
     }
 
@@ -1185,6 +1793,10 @@ static int CFDebug_RedisCommand(RedisModuleCtx *ctx, RedisModuleString **argv, i
 
 #define CF_MIN_EXPANSION_VERSION 4
 
+#define FUSE_ENCODING_VERSION 0
+#define RIBBON_ENCODING_VERSION 0
+#define BFWINDOW_ENCODING_VERSION 0
+
 static void BFRdbSave(RedisModuleIO *io, void *obj) {
     // Save the setting!
     SBChain *sb = obj;
@@ -1218,6 +1830,7 @@ static void *BFRdbLoad(RedisModuleIO *io, int encver) {
 
     // Load our modules
     SBChain *sb = RedisModule_Calloc(1, sizeof(*sb));
+    sb->id = SB_NewChainId();
     bool err = false;
     errdefer(err, SBChain_Free(sb));
 
@@ -1425,6 +2038,223 @@ static void CFAofRewrite(RedisModuleIO *aof, RedisModuleString *key, void *obj)
     }
 }
 
+static void FuseRdbSave(RedisModuleIO *io, void *obj) {
+    FuseFilter *ff = obj;
+    RedisModule_SaveUnsigned(io, ff->size);
+    RedisModule_SaveUnsigned(io, ff->seed);
+    RedisModule_SaveUnsigned(io, ff->segmentLength);
+    RedisModule_SaveUnsigned(io, ff->segmentCount);
+    RedisModule_SaveStringBuffer(io, (const char *)ff->fingerprints, ff->arrayLength);
+}
+
+static void *FuseRdbLoad(RedisModuleIO *io, int encver) {
+    if (encver > FUSE_ENCODING_VERSION) {
+        return NULL;
+    }
+
+    FuseFilter *ff = RedisModule_Calloc(1, sizeof(*ff));
+    bool err = false;
+    errdefer(err, FuseFilter_Free(ff));
+
+    ff->size = LoadUnsigned_IOError(io, err, NULL);
+    ff->seed = LoadUnsigned_IOError(io, err, NULL);
+    const uint64_t segmentLength = LoadUnsigned_IOError(io, err, NULL);
+    const uint64_t segmentCount = LoadUnsigned_IOError(io, err, NULL);
+    size_t arrayLength;
+    ff->fingerprints = (uint8_t *)LoadStringBuffer_IOError(io, &arrayLength, err, NULL);
+    if (segmentLength > UINT32_MAX || segmentCount > UINT32_MAX || arrayLength > UINT32_MAX) {
+        err = true;
+        return NULL;
+    }
+    ff->segmentLength = segmentLength;
+    ff->segmentCount = segmentCount;
+    ff->arrayLength = arrayLength;
+    if (FuseFilter_ValidateLayout(ff) != 0) {
+        err = true;
+        return NULL;
+    }
+    return ff;
+}
+
+static void FuseAofRewrite(RedisModuleIO *aof, RedisModuleString *key, void *value) {
+    FuseFilter *ff = value;
+    size_t len;
+    char *hdr = FuseFilter_GetEncodedHeader(ff, &len);
+    RedisModule_EmitAOF(aof, "BF.LOADCHUNK", "slb", key, 1, hdr, len);
+    FuseFilter_FreeEncodedHeader(hdr);
+
+    long long iter = SB_CHUNKITER_INIT;
+    const char *chunk;
+    while ((chunk = FuseFilter_GetEncodedChunk(ff, &iter, &len, MAX_SCANDUMP_SIZE)) != NULL) {
+        RedisModule_EmitAOF(aof, "BF.LOADCHUNK", "slb", key, iter, chunk, len);
+    }
+}
+
+static void FuseFree(void *value) { FuseFilter_Free(value); }
+
+static size_t FuseMemUsage(const void *value) {
+    const FuseFilter *ff = value;
+    return sizeof *ff + ff->arrayLength;
+}
+
+static int FuseDefrag(RedisModuleDefragCtx *ctx, RedisModuleString *key, void **value) {
+    *value = defragPtr(ctx, *value);
+    FuseFilter *ff = *value;
+    ff->fingerprints = defragPtr(ctx, ff->fingerprints);
+    return REDISMODULE_OK;
+}
+
+static void RibbonRdbSave(RedisModuleIO *io, void *obj) {
+    RibbonFilter *rb = obj;
+    RedisModule_SaveUnsigned(io, rb->size);
+    RedisModule_SaveUnsigned(io, rb->numSlots);
+    RedisModule_SaveUnsigned(io, rb->resultBits);
+    RedisModule_SaveStringBuffer(io, (const char *)rb->solution, RibbonFilter_Bytes(rb));
+}
+
+static void *RibbonRdbLoad(RedisModuleIO *io, int encver) {
+    if (encver > RIBBON_ENCODING_VERSION) {
+        return NULL;
+    }
+
+    RibbonFilter *rb = RedisModule_Calloc(1, sizeof(*rb));
+    bool err = false;
+    errdefer(err, RibbonFilter_Free(rb));
+
+    rb->size = LoadUnsigned_IOError(io, err, NULL);
+    rb->numSlots = LoadUnsigned_IOError(io, err, NULL);
+    const uint64_t resultBits = LoadUnsigned_IOError(io, err, NULL);
+    size_t bytes;
+    rb->solution = (uint64_t *)LoadStringBuffer_IOError(io, &bytes, err, NULL);
+    if (resultBits > RIBBON_MAX_RESULT_BITS) {
+        err = true;
+        return NULL;
+    }
+    rb->resultBits = resultBits;
+    if (RibbonFilter_ValidateLayout(rb, bytes) != 0) {
+        err = true;
+        return NULL;
+    }
+    return rb;
+}
+
+static void RibbonAofRewrite(RedisModuleIO *aof, RedisModuleString *key, void *value) {
+    RibbonFilter *rb = value;
+    size_t len;
+    char *hdr = RibbonFilter_GetEncodedHeader(rb, &len);
+    RedisModule_EmitAOF(aof, "BF.LOADCHUNK", "slb", key, 1, hdr, len);
+    RibbonFilter_FreeEncodedHeader(hdr);
+
+    long long iter = SB_CHUNKITER_INIT;
+    const char *chunk;
+    while ((chunk = RibbonFilter_GetEncodedChunk(rb, &iter, &len, MAX_SCANDUMP_SIZE)) != NULL) {
+        RedisModule_EmitAOF(aof, "BF.LOADCHUNK", "slb", key, iter, chunk, len);
+    }
+}
+
+static void RibbonFree(void *value) { RibbonFilter_Free(value); }
+
+static size_t RibbonMemUsage(const void *value) {
+    const RibbonFilter *rb = value;
+    return sizeof *rb + RibbonFilter_Bytes(rb);
+}
+
+static int RibbonDefrag(RedisModuleDefragCtx *ctx, RedisModuleString *key, void **value) {
+    *value = defragPtr(ctx, *value);
+    RibbonFilter *rb = *value;
+    rb->solution = defragPtr(ctx, rb->solution);
+    return REDISMODULE_OK;
+}
+
+static void BFWindowRdbSave(RedisModuleIO *io, void *obj) {
+    SBWindow *w = obj;
+    RedisModule_SaveSigned(io, w->window);
+    RedisModule_SaveUnsigned(io, w->nslices);
+    // the slices are saved as the chains of the BF type, in its current encoding
+    RedisModule_SaveUnsigned(io, BF_MIN_GROWTH_ENC);
+    for (size_t ii = 0; ii < w->nslices; ++ii) {
+        RedisModule_SaveSigned(io, w->slots[ii]);
+        RedisModule_SaveUnsigned(io, w->counts[ii]);
+        BFRdbSave(io, w->slices[ii]);
+    }
+}
+
+static void *BFWindowRdbLoad(RedisModuleIO *io, int encver) {
+    if (encver > BFWINDOW_ENCODING_VERSION) {
+        return NULL;
+    }
+
+    SBWindow *w = RedisModule_Calloc(1, sizeof(*w));
+    bool err = false;
+    errdefer(err, SBWindow_Free(w));
+
+    w->window = LoadSigned_IOError(io, err, NULL);
+    const uint64_t nslices = LoadUnsigned_IOError(io, err, NULL);
+    // windows postdate the growth encoding, and later chain encodings are unknown to this build
+    const uint64_t sliceEncver = LoadUnsigned_IOError(io, err, NULL);
+    if (nslices == 0 || nslices > SBWINDOW_MAX_SLICES || sliceEncver < BF_MIN_GROWTH_ENC ||
+        sliceEncver > BF_MIN_GROWTH_ENC) {
+        err = true;
+        return NULL;
+    }
+    w->slices = RedisModule_Calloc(nslices, sizeof(*w->slices));
+    w->slots = RedisModule_Calloc(nslices, sizeof(*w->slots));
+    w->counts = RedisModule_Calloc(nslices, sizeof(*w->counts));
+    w->nslices = nslices;
+    for (size_t ii = 0; ii < w->nslices; ++ii) {
+        w->slots[ii] = LoadSigned_IOError(io, err, NULL);
+        w->counts[ii] = LoadUnsigned_IOError(io, err, NULL);
+        w->slices[ii] = BFRdbLoad(io, sliceEncver);
+        if (w->slices[ii] == NULL) {
+            err = true;
+            return NULL;
+        }
+    }
+    if (SBWindow_ValidateIntegrity(w) != 0) {
+        err = true;
+        return NULL;
+    }
+    return w;
+}
+
+static void BFWindowAofRewrite(RedisModuleIO *aof, RedisModuleString *key, void *value) {
+    SBWindow *w = value;
+    size_t len;
+    char *hdr = SBWindow_GetEncodedHeader(w, &len);
+    RedisModule_EmitAOF(aof, "BF.LOADCHUNK", "slb", key, 1, hdr, len);
+    SBWindow_FreeEncodedHeader(hdr);
+
+    long long iter = SB_CHUNKITER_INIT;
+    const char *chunk;
+    while ((chunk = SBWindow_GetEncodedChunk(w, &iter, &len, MAX_SCANDUMP_SIZE)) != NULL) {
+        RedisModule_EmitAOF(aof, "BF.LOADCHUNK", "slb", key, iter, chunk, len);
+    }
+}
+
+static void BFWindowFree(void *value) { SBWindow_Free(value); }
+
+static size_t BFWindowMemUsage(const void *value) {
+    const SBWindow *w = value;
+    size_t size =
+        sizeof *w + (sizeof *w->slices + sizeof *w->slots + sizeof *w->counts) * w->nslices;
+    for (size_t ii = 0; ii < w->nslices; ++ii) {
+        size += BFMemUsage(w->slices[ii]);
+    }
+    return size;
+}
+
+static int BFWindowDefrag(RedisModuleDefragCtx *ctx, RedisModuleString *key, void **value) {
+    *value = defragPtr(ctx, *value);
+    SBWindow *w = *value;
+    w->slices = defragPtr(ctx, w->slices);
+    w->slots = defragPtr(ctx, w->slots);
+    w->counts = defragPtr(ctx, w->counts);
+    for (size_t ii = 0; ii < w->nslices; ++ii) {
+        BFDefrag(ctx, key, (void **)&w->slices[ii]);
+    }
+    return REDISMODULE_OK;
+}
+
 static int rsStrcasecmp(const RedisModuleString *rs1, const char *s2) {
     size_t n1 = strlen(s2);
     size_t n2;
@@ -1543,6 +2373,7 @@ int RedisModule_OnLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc)
     RegisterCommand(ctx, "bf.mexists", BFCheck_RedisCommand, "readonly fast", "read");
     RegisterCommand(ctx, "bf.info", BFInfo_RedisCommand, "readonly fast", "read fast");
     RegisterCommand(ctx, "bf.card", BFCard_RedisCommand, "readonly fast", "read fast");
+    RegisterCommand(ctx, "bf.freeze", BFFreeze_RedisCommand, "write deny-oom", "write");
 
     // Bloom - Debug
     RegisterCommand(ctx, "bf.debug", BFDebug_RedisCommand, "readonly fast", "read");
@@ -1589,6 +2420,18 @@ int RedisModule_OnLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc)
         return REDISMODULE_ERR;
     if (TDigestModule_onLoad(ctx, argv, argc) == REDISMODULE_ERR)
         return REDISMODULE_ERR;
+    if (DDSketchModule_onLoad(ctx, argv, argc) == REDISMODULE_ERR)
+        return REDISMODULE_ERR;
+    if (HDRModule_onLoad(ctx, argv, argc) == REDISMODULE_ERR)
+        return REDISMODULE_ERR;
+    if (CBFModule_onLoad(ctx, argv, argc) == REDISMODULE_ERR)
+        return REDISMODULE_ERR;
+    if (RFModule_onLoad(ctx, argv, argc) == REDISMODULE_ERR)
+        return REDISMODULE_ERR;
+    if (MHModule_onLoad(ctx, argv, argc) == REDISMODULE_ERR)
+        return REDISMODULE_ERR;
+    if (ThetaModule_onLoad(ctx, argv, argc) == REDISMODULE_ERR)
+        return REDISMODULE_ERR;
 
     static RedisModuleTypeMethods typeprocs = {
         .version = REDISMODULE_TYPE_METHOD_VERSION,
@@ -1618,5 +2461,50 @@ int RedisModule_OnLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc)
         return REDISMODULE_ERR;
     }
 
+    static RedisModuleTypeMethods fuseTypeProcs = {
+        .version = REDISMODULE_TYPE_METHOD_VERSION,
+        .rdb_load = FuseRdbLoad,
+        .rdb_save = FuseRdbSave,
+        .aof_rewrite = FuseAofRewrite,
+        .free = FuseFree,
+        .mem_usage = FuseMemUsage,
+        .defrag = FuseDefrag,
+    };
+    FuseType =
+        RedisModule_CreateDataType(ctx, "MBbloomFF", FUSE_ENCODING_VERSION, &fuseTypeProcs);
+    if (FuseType == NULL) {
+        return REDISMODULE_ERR;
+    }
+
+    static RedisModuleTypeMethods ribbonTypeProcs = {
+        .version = REDISMODULE_TYPE_METHOD_VERSION,
+        .rdb_load = RibbonRdbLoad,
+        .rdb_save = RibbonRdbSave,
+        .aof_rewrite = RibbonAofRewrite,
+        .free = RibbonFree,
+        .mem_usage = RibbonMemUsage,
+        .defrag = RibbonDefrag,
+    };
+    RibbonType =
+        RedisModule_CreateDataType(ctx, "MBbloomRB", RIBBON_ENCODING_VERSION, &ribbonTypeProcs);
+    if (RibbonType == NULL) {
+        return REDISMODULE_ERR;
+    }
+
+    static RedisModuleTypeMethods windowTypeProcs = {
+        .version = REDISMODULE_TYPE_METHOD_VERSION,
+        .rdb_load = BFWindowRdbLoad,
+        .rdb_save = BFWindowRdbSave,
+        .aof_rewrite = BFWindowAofRewrite,
+        .free = BFWindowFree,
+        .mem_usage = BFWindowMemUsage,
+        .defrag = BFWindowDefrag,
+    };
+    BFWindowType = RedisModule_CreateDataType(ctx, "MBbloomWN", BFWINDOW_ENCODING_VERSION,
+                                              &windowTypeProcs);
+    if (BFWindowType == NULL) {
+        return REDISMODULE_ERR;
+    }
+
     return REDISMODULE_OK;
 }
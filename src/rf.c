@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#include "rf.h"
+#include "murmur2/murmurhash2.h"
+
+#include <math.h>
+#include <string.h>
+
+#define LN2 (0.693147180559945)
+
+// Bits per item of a Bloom filter with an 'error' rate
+static double _RF_BitsPerEntry(double error) { return -log(error) / (LN2 * LN2); }
+
+RangeFilter *RF_Create(uint64_t capacity, double error, uint32_t levels) {
+    if (capacity < 1 || !(error > 0 && error < 1) || levels < 1 || levels > RF_MAX_LEVELS) {
+        return NULL;
+    }
+    // every key is stored at each level, rounded up to a power of two of blocks
+    const double bpe = _RF_BitsPerEntry(error) * (levels + 1);
+    const double blocks = capacity * bpe / RF_BLOCK_BITS;
+    const double bn2 = blocks < 1 ? -1 : logb(blocks);
+    if (bn2 + 1 > RF_MAX_N2) {
+        return NULL;
+    }
+    RangeFilter *rf = RF_CALLOC(1, sizeof *rf);
+    rf->n2 = bn2 + 1;
+    rf->error = error;
+    rf->levels = levels;
+    rf->hashes = ceil(LN2 * _RF_BitsPerEntry(error));
+    if (rf->hashes > RF_MAX_HASHES) {
+        rf->hashes = RF_MAX_HASHES;
+    }
+    rf->capacity = ((uint64_t)RF_BLOCK_BITS << rf->n2) / bpe;
+    rf->blocks = RF_TRYCALLOC(RF_Bytes(rf), 1);
+    if (!rf->blocks) {
+        RF_FREE(rf);
+        return NULL;
+    }
+    return rf;
+}
+
+void RF_Destroy(RangeFilter *rf) {
+    if (!rf) {
+        return;
+    }
+    if (rf->blocks) {
+        RF_FREE(rf->blocks);
+    }
+    RF_FREE(rf);
+}
+
+size_t RF_Bytes(const RangeFilter *rf) {
+    return ((size_t)RF_BLOCK_WORDS * sizeof *rf->blocks) << rf->n2;
+}
+
+/*  The block of a prefix is taken from the high bits of its hash, and its bits in the block from
+    the low ones, by double hashing as in bloom_add_h. The level seeds the hash, so that the
+    prefixes of the levels do not collide. */
+#define RF_PREFIX(rf, prefix, level, block, a, b)                                                  \
+    const uint64_t h_ = MurmurHash64A_Bloom(&(prefix), sizeof(prefix), level);                     \
+    uint64_t *block = (rf)->blocks + ((rf)->n2 ? h_ >> (64 - (rf)->n2) : 0) * RF_BLOCK_WORDS;      \
+    const uint64_t a = h_ % RF_BLOCK_BITS;                                                         \
+    const uint64_t b = (h_ / RF_BLOCK_BITS) | 1
+
+static void _RF_Set(RangeFilter *rf, uint64_t prefix, uint32_t level) {
+    RF_PREFIX(rf, prefix, level, block, a, b);
+    for (uint64_t i = 0; i < rf->hashes; i++) {
+        const uint64_t x = (a + i * b) % RF_BLOCK_BITS;
+        block[x / 64] |= (uint64_t)1 << (x % 64);
+    }
+}
+
+static int _RF_Probe(const RangeFilter *rf, uint64_t prefix, uint32_t level) {
+    RF_PREFIX(rf, prefix, level, block, a, b);
+    for (uint64_t i = 0; i < rf->hashes; i++) {
+        const uint64_t x = (a + i * b) % RF_BLOCK_BITS;
+        if (!(block[x / 64] & (uint64_t)1 << (x % 64))) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void RF_Add(RangeFilter *rf, uint64_t key) {
+    for (uint32_t level = 0; level <= rf->levels; level++) {
+        _RF_Set(rf, key >> level, level);
+    }
+    rf->size++;
+}
+
+int RF_Check(const RangeFilter *rf, uint64_t key) { return _RF_Probe(rf, key, 0); }
+
+// Returns 1 if the interval of a prefix may hold a key, probing its halves down to the keys
+static int _RF_Doubt(const RangeFilter *rf, uint64_t prefix, uint32_t level) {
+    if (!_RF_Probe(rf, prefix, level)) {
+        return 0;
+    }
+    if (level == 0) {
+        return 1;
+    }
+    return _RF_Doubt(rf, prefix << 1, level - 1) || _RF_Doubt(rf, prefix << 1 | 1, level - 1);
+}
+
+int RF_Range(const RangeFilter *rf, uint64_t lo, uint64_t hi) {
+    for (size_t intervals = 0; lo <= hi; intervals++) {
+        if (intervals == RF_MAX_INTERVALS) {
+            return 1;
+        }
+        // the largest aligned interval starting at 'lo' and ending at 'hi' at the latest
+        uint32_t level = lo ? __builtin_ctzll(lo) : 64;
+        if (level > rf->levels) {
+            level = rf->levels;
+        }
+        while (hi - lo < ((uint64_t)1 << level) - 1) {
+            level--;
+        }
+        if (_RF_Doubt(rf, lo >> level, level)) {
+            return 1;
+        }
+        const uint64_t last = lo + (((uint64_t)1 << level) - 1);
+        if (last == hi) {
+            break;
+        }
+        lo = last + 1;
+    }
+    return 0;
+}
+
+int RF_ValidateLayout(const RangeFilter *rf, size_t bytes) {
+    if (rf->levels < 1 || rf->levels > RF_MAX_LEVELS || rf->hashes < 1 ||
+        rf->hashes > RF_MAX_HASHES || rf->n2 > RF_MAX_N2 || !(rf->error > 0 && rf->error < 1)) {
+        return 1;
+    }
+    return RF_Bytes(rf) != bytes;
+}
+
+typedef struct __attribute__((packed)) {
+    uint64_t capacity;
+    double error;
+    uint32_t levels;
+    uint32_t hashes;
+    uint8_t n2;
+    uint64_t size;
+} dumpedRangeFilterHeader;
+
+char *RF_GetEncodedHeader(const RangeFilter *rf, size_t *hdrlen) {
+    *hdrlen = sizeof(dumpedRangeFilterHeader);
+    dumpedRangeFilterHeader *hdr = RF_CALLOC(1, *hdrlen);
+    hdr->capacity = rf->capacity;
+    hdr->error = rf->error;
+    hdr->levels = rf->levels;
+    hdr->hashes = rf->hashes;
+    hdr->n2 = rf->n2;
+    hdr->size = rf->size;
+    return (char *)hdr;
+}
+
+void RF_FreeEncodedHeader(char *s) { RF_FREE(s); }
+
+const char *RF_GetEncodedChunk(const RangeFilter *rf, long long *curIter, size_t *len,
+                               size_t maxChunkSize) {
+    const size_t bytes = RF_Bytes(rf);
+    if (*curIter < 1 || *curIter - 1 >= bytes) {
+        *curIter = 0;
+        return NULL;
+    }
+    const size_t offset = *curIter - 1;
+    *len = bytes - offset;
+    if (*len > maxChunkSize) {
+        *len = maxChunkSize;
+    }
+    *curIter += *len;
+    return (const char *)rf->blocks + offset;
+}
+
+RangeFilter *RF_NewFromHeader(const char *buf, size_t bufLen, const char **errmsg) {
+    dumpedRangeFilterHeader header;
+    if (bufLen != sizeof(header)) {
+        *errmsg = "ERR received bad data";
+        return NULL;
+    }
+    memcpy(&header, buf, sizeof(header));
+    RangeFilter *rf = RF_CALLOC(1, sizeof *rf);
+    rf->capacity = header.capacity;
+    rf->error = header.error;
+    rf->levels = header.levels;
+    rf->hashes = header.hashes;
+    rf->n2 = header.n2;
+    rf->size = header.size;
+    if (header.n2 > RF_MAX_N2 || RF_ValidateLayout(rf, RF_Bytes(rf)) != 0) {
+        RF_Destroy(rf);
+        *errmsg = "ERR received bad data";
+        return NULL;
+    }
+    rf->blocks = RF_TRYCALLOC(RF_Bytes(rf), 1);
+    if (!rf->blocks) {
+        RF_Destroy(rf);
+        *errmsg = "ERR Insufficient memory to create filter";
+        return NULL;
+    }
+    return rf;
+}
+
+int RF_LoadEncodedChunk(RangeFilter *rf, long long iter, const char *buf, size_t bufLen,
+                        const char **errmsg) {
+    if (!buf || iter <= 0 || iter <= bufLen) {
+        *errmsg = "ERR received bad data";
+        return -1;
+    }
+    const size_t offset = iter - bufLen - 1;
+    const size_t bytes = RF_Bytes(rf);
+    if (offset > bytes || bufLen > bytes - offset) {
+        *errmsg = "ERR invalid chunk - Too big for current filter";
+        return -1;
+    }
+    memcpy((char *)rf->blocks + offset, buf, bufLen);
+    return 0;
+}
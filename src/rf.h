@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef REDIS_MODULE_TARGET
+#include "redismodule.h"
+#define RF_TRYCALLOC(...)                                                                          \
+    RedisModule_TryCalloc ? RedisModule_TryCalloc(__VA_ARGS__) : RedisModule_Calloc(__VA_ARGS__)
+#define RF_CALLOC(count, size) RedisModule_Calloc(count, size)
+#define RF_FREE(ptr) RedisModule_Free(ptr)
+#endif
+
+#define RF_BLOCK_BITS 512
+#define RF_BLOCK_WORDS (RF_BLOCK_BITS / 64)
+#define RF_DEFAULT_LEVELS 16
+#define RF_MAX_LEVELS 32
+#define RF_MAX_HASHES 64
+#define RF_MAX_N2 32
+// Dyadic intervals probed by a range query before it answers "may exist" without probing
+#define RF_MAX_INTERVALS 256
+
+/*  A range filter over uint64 keys, after Rosetta: every key is stored in a Bloom filter along
+    with its prefixes, the key shifted right by 1 to 'levels' bits. A prefix of level l stands
+    for the aligned dyadic interval of 2^l keys below it.
+
+    A range is split into dyadic intervals of up to 2^levels keys, and each one is doubted: it is
+    probed, and if it may hold a key, so are its two halves, down to the keys themselves. An
+    empty range is then only reported as not empty when a key inside it is a false positive at
+    every level above it, which keeps the false positive rate of short ranges close to that of a
+    point query.
+
+    The Bloom filter is blocked: the bits of a prefix all fall in a block of 512 bits, which is a
+    cache line, so that a probe costs a single cache miss. */
+typedef struct RangeFilter {
+    uint64_t capacity; //  keys at the error rate
+    double error;
+    uint32_t levels;
+    uint32_t hashes;
+    uint8_t n2; //  2^n2 blocks
+    uint64_t size; //  keys added
+    uint64_t *blocks;
+} RangeFilter;
+
+/*  Returns a new empty filter of at least 'capacity' keys at an 'error' rate, that answers
+    ranges of up to 2^levels keys, or NULL if the parameters are invalid or out of memory.
+    Complexity - O(blocks) */
+RangeFilter *RF_Create(uint64_t capacity, double error, uint32_t levels);
+
+/*  Releases resources of a filter.
+    Complexity - O(1) */
+void RF_Destroy(RangeFilter *rf);
+
+/*  Returns the size of the blocks in bytes.
+    Complexity - O(1) */
+size_t RF_Bytes(const RangeFilter *rf);
+
+/*  Adds a key and its prefixes.
+    Complexity - O(levels * hashes) */
+void RF_Add(RangeFilter *rf, uint64_t key);
+
+/*  Returns 1 if the key may be in the filter, 0 if it is not.
+    Complexity - O(hashes) */
+int RF_Check(const RangeFilter *rf, uint64_t key);
+
+/*  Returns 1 if a key in [lo, hi] may be in the filter, 0 if none is. Ranges split into more
+    than RF_MAX_INTERVALS intervals may be in the filter.
+    Complexity - O(levels * hashes) for ranges of up to 2^levels keys */
+int RF_Range(const RangeFilter *rf, uint64_t lo, uint64_t hi);
+
+/*  Checks the parameters of 'rf', as read from a dump.
+    Returns 0 if they are consistent with blocks of 'bytes', nonzero otherwise.
+    Complexity - O(1) */
+int RF_ValidateLayout(const RangeFilter *rf, size_t bytes);
+
+/*  Returns the header of the filter for RF.SCANDUMP, with its length in 'hdrlen'. The header
+    should be freed with RF_FreeEncodedHeader.
+    Complexity - O(1) */
+char *RF_GetEncodedHeader(const RangeFilter *rf, size_t *hdrlen);
+void RF_FreeEncodedHeader(char *s);
+
+/*  Returns the chunk of the blocks at iterator 'curIter', of at most 'maxChunkSize' bytes, and
+    advances the iterator. Returns NULL and resets the iterator to 0 at the end of the blocks.
+    Complexity - O(1) */
+const char *RF_GetEncodedChunk(const RangeFilter *rf, long long *curIter, size_t *len,
+                               size_t maxChunkSize);
+
+/*  Returns a new empty filter from a header of RF_GetEncodedHeader, or NULL and sets 'errmsg'
+    if the header is corrupt.
+    Complexity - O(blocks) */
+RangeFilter *RF_NewFromHeader(const char *buf, size_t bufLen, const char **errmsg);
+
+/*  Loads a chunk of RF_GetEncodedChunk, which was returned with iterator 'iter'.
+    Returns 0 on success, or -1 and sets 'errmsg' if the chunk does not fit the filter.
+    Complexity - O(bufLen) */
+int RF_LoadEncodedChunk(RangeFilter *rf, long long iter, const char *buf, size_t bufLen,
+                        const char **errmsg);
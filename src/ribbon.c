@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#include "ribbon.h"
+
+#include "redismodule.h"
+
+#define RIBBON_TRYCALLOC(...)                                                                      \
+    RedisModule_TryCalloc ? RedisModule_TryCalloc(__VA_ARGS__) : RedisModule_Calloc(__VA_ARGS__)
+#define RIBBON_FREE RedisModule_Free
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static inline uint64_t _Ribbon_Mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// A band of RIBBON_WIDTH coefficients
+typedef __uint128_t ribbon_row;
+
+static inline int _Ribbon_Parity(ribbon_row x) {
+    return __builtin_parityll((uint64_t)x) ^ __builtin_parityll((uint64_t)(x >> 64));
+}
+
+static inline int _Ribbon_Ctz(ribbon_row x) {
+    return (uint64_t)x ? __builtin_ctzll((uint64_t)x) : 64 + __builtin_ctzll((uint64_t)(x >> 64));
+}
+
+static inline uint64_t _Ribbon_NumStarts(const RibbonFilter *rb) {
+    return rb->numSlots - RIBBON_WIDTH + 1;
+}
+
+static inline uint64_t _Ribbon_Start(const RibbonFilter *rb, uint64_t hash) {
+    return (uint64_t)(((__uint128_t)hash * _Ribbon_NumStarts(rb)) >> 64);
+}
+
+// The band of a key, whose first coefficient is always set
+static inline ribbon_row _Ribbon_Coefficients(uint64_t hash) {
+    return (ribbon_row)_Ribbon_Mix(hash * 0x9e3779b97f4a7c15ULL) << 64 |
+           _Ribbon_Mix(hash * 0xbf58476d1ce4e5b9ULL) | 1;
+}
+
+static int _Ribbon_CompareHashes(const void *a, const void *b) {
+    const uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// The RIBBON_WIDTH solution bits of column 'j' from slot 'start', read from the three blocks
+// the band may span, with zeros past the last slot.
+static inline ribbon_row _Ribbon_Band(const RibbonFilter *rb, uint64_t start, uint32_t j) {
+    const uint64_t block = start / RIBBON_BLOCK, offset = start % RIBBON_BLOCK;
+    const uint64_t blocks = rb->numSlots / RIBBON_BLOCK;
+    const uint64_t *words = rb->solution + block * rb->resultBits + j;
+    ribbon_row band = words[0];
+    if (block + 1 < blocks) {
+        band |= (ribbon_row)words[rb->resultBits] << 64;
+    }
+    band >>= offset;
+    if (offset && block + 2 < blocks) {
+        band |= (ribbon_row)words[2 * rb->resultBits] << (RIBBON_WIDTH - offset);
+    }
+    return band;
+}
+
+/*  Adds the band of every key to an upper triangular system with a row per slot, by
+    eliminating its leading coefficient with the row already at its slot, until it reaches a
+    free slot or vanishes. Keys sorted by hash are sorted by start, so the rows touched stay in
+    cache. Then solves the system from the last slot, setting the free variables at random. */
+static void _Ribbon_Solve(RibbonFilter *rb, const uint64_t *hashes, size_t n, ribbon_row *rows) {
+    for (size_t i = 0; i < n; i++) {
+        uint64_t start = _Ribbon_Start(rb, hashes[i]);
+        ribbon_row coefficients = _Ribbon_Coefficients(hashes[i]);
+        while (coefficients && rows[start]) {
+            coefficients ^= rows[start];
+            if (coefficients) {
+                const int shift = _Ribbon_Ctz(coefficients);
+                coefficients >>= shift;
+                start += shift;
+            }
+        }
+        // unless it vanished as a combination of the others, which the solution satisfies
+        if (coefficients) {
+            rows[start] = coefficients;
+        }
+    }
+
+    for (uint64_t slot = rb->numSlots; slot-- > 0;) {
+        const uint64_t block = slot / RIBBON_BLOCK, offset = slot % RIBBON_BLOCK;
+        uint64_t *words = rb->solution + block * rb->resultBits;
+        const ribbon_row row = rows[slot];
+        const uint64_t random = _Ribbon_Mix(slot + 0x632be59bd9b4e019ULL);
+        for (uint32_t j = 0; j < rb->resultBits; j++) {
+            // the product of the row with the solution so far, whose bit at 'slot' is not set
+            const uint64_t bit =
+                row ? _Ribbon_Parity(row & _Ribbon_Band(rb, slot, j)) : (random >> j) & 1;
+            words[j] |= bit << offset;
+        }
+    }
+}
+
+// The slots per key, past which more slots barely lower the false positive rate. Fewer slots
+// leave a dense stretch of the band somewhere, where the rows of other keys are mostly
+// combinations of those of the set.
+static double _Ribbon_Overhead(size_t n) {
+    return n <= 10000000 ? 1.05 : 1.05 + 0.005 * log10(n / 1e7);
+}
+
+RibbonFilter *RibbonFilter_Build(uint64_t *keys, size_t n, uint32_t resultBits, int *err) {
+    *err = RIBBON_SUCCESS;
+    // the mix is a bijection, so the hashes of distinct keys are distinct
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = _Ribbon_Mix(keys[i]);
+    }
+    qsort(keys, n, sizeof *keys, _Ribbon_CompareHashes);
+    size_t distinct = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (i == 0 || keys[i] != keys[distinct - 1]) {
+            keys[distinct++] = keys[i];
+        }
+    }
+    n = distinct;
+
+    RibbonFilter *rb = RIBBON_TRYCALLOC(1, sizeof *rb);
+    if (!rb) {
+        *err = RIBBON_OOM;
+        return NULL;
+    }
+    rb->size = n;
+    rb->resultBits = resultBits;
+    const uint64_t blocks = (uint64_t)(n * _Ribbon_Overhead(n)) / RIBBON_BLOCK + 2;
+    rb->numSlots = blocks * RIBBON_BLOCK;
+    rb->solution = RIBBON_TRYCALLOC(blocks * resultBits, sizeof *rb->solution);
+    ribbon_row *rows = RIBBON_TRYCALLOC(rb->numSlots, sizeof *rows);
+    if (!rb->solution || !rows) {
+        *err = RIBBON_OOM;
+        if (rows) {
+            RIBBON_FREE(rows);
+        }
+        RibbonFilter_Free(rb);
+        return NULL;
+    }
+    _Ribbon_Solve(rb, keys, n, rows);
+    RIBBON_FREE(rows);
+    return rb;
+}
+
+void RibbonFilter_Free(RibbonFilter *rb) {
+    if (!rb) {
+        return;
+    }
+    if (rb->solution) {
+        RIBBON_FREE(rb->solution);
+    }
+    RIBBON_FREE(rb);
+}
+
+int RibbonFilter_Contains(const RibbonFilter *rb, uint64_t key) {
+    const uint64_t hash = _Ribbon_Mix(key);
+    const uint64_t start = _Ribbon_Start(rb, hash);
+    const ribbon_row coefficients = _Ribbon_Coefficients(hash);
+    // a key of the set has a zero product in every column
+    int product = 0;
+    for (uint32_t j = 0; j < rb->resultBits; j++) {
+        product |= _Ribbon_Parity(coefficients & _Ribbon_Band(rb, start, j));
+    }
+    return !product;
+}
+
+size_t RibbonFilter_Bytes(const RibbonFilter *rb) {
+    return rb->numSlots / RIBBON_BLOCK * rb->resultBits * sizeof *rb->solution;
+}
+
+int RibbonFilter_ValidateLayout(const RibbonFilter *rb, size_t bytes) {
+    if (rb->numSlots < RIBBON_WIDTH || rb->numSlots % RIBBON_BLOCK || rb->size > rb->numSlots ||
+        rb->resultBits < RIBBON_MIN_RESULT_BITS || rb->resultBits > RIBBON_MAX_RESULT_BITS ||
+        rb->numSlots / RIBBON_BLOCK > SIZE_MAX / sizeof *rb->solution / rb->resultBits) {
+        return 1;
+    }
+    return RibbonFilter_Bytes(rb) != bytes;
+}
+
+typedef struct __attribute__((packed)) {
+    uint64_t size;
+    uint64_t numSlots;
+    uint8_t resultBits;
+    uint8_t width;
+} dumpedRibbonHeader;
+
+char *RibbonFilter_GetEncodedHeader(const RibbonFilter *rb, size_t *hdrlen) {
+    *hdrlen = sizeof(dumpedRibbonHeader);
+    dumpedRibbonHeader *hdr = RedisModule_Calloc(1, *hdrlen);
+    hdr->size = rb->size;
+    hdr->numSlots = rb->numSlots;
+    hdr->resultBits = rb->resultBits;
+    hdr->width = RIBBON_WIDTH;
+    return (char *)hdr;
+}
+
+void RibbonFilter_FreeEncodedHeader(char *s) { RedisModule_Free(s); }
+
+int RibbonFilter_IsEncodedHeader(size_t bufLen) { return bufLen == sizeof(dumpedRibbonHeader); }
+
+const char *RibbonFilter_GetEncodedChunk(const RibbonFilter *rb, long long *curIter, size_t *len,
+                                         size_t maxChunkSize) {
+    const size_t bytes = RibbonFilter_Bytes(rb);
+    if (*curIter < 1 || *curIter - 1 >= bytes) {
+        *curIter = 0;
+        return NULL;
+    }
+    const size_t offset = *curIter - 1;
+    *len = bytes - offset;
+    if (*len > maxChunkSize) {
+        *len = maxChunkSize;
+    }
+    *curIter += *len;
+    return (const char *)rb->solution + offset;
+}
+
+RibbonFilter *RibbonFilter_NewFromHeader(const char *buf, size_t bufLen, const char **errmsg) {
+    const dumpedRibbonHeader *header = (const void *)buf;
+    if (!RibbonFilter_IsEncodedHeader(bufLen) || header->width != RIBBON_WIDTH) {
+        *errmsg = "ERR received bad data";
+        return NULL;
+    }
+    RibbonFilter *rb = RedisModule_Calloc(1, sizeof(*rb));
+    rb->size = header->size;
+    rb->numSlots = header->numSlots;
+    rb->resultBits = header->resultBits;
+    if (RibbonFilter_ValidateLayout(rb, RibbonFilter_Bytes(rb)) != 0) {
+        RibbonFilter_Free(rb);
+        *errmsg = "ERR received bad data";
+        return NULL;
+    }
+    rb->solution = RIBBON_TRYCALLOC(RibbonFilter_Bytes(rb), 1);
+    if (!rb->solution) {
+        RibbonFilter_Free(rb);
+        *errmsg = "ERR Insufficient memory to create filter";
+        return NULL;
+    }
+    return rb;
+}
+
+int RibbonFilter_LoadEncodedChunk(RibbonFilter *rb, long long iter, const char *buf,
+                                  size_t bufLen, const char **errmsg) {
+    if (!buf || iter <= 0 || iter <= bufLen) {
+        *errmsg = "ERR received bad data";
+        return -1;
+    }
+    const size_t bytes = RibbonFilter_Bytes(rb);
+    const size_t offset = iter - bufLen - 1;
+    if (offset > bytes || bufLen > bytes - offset) {
+        *errmsg = "ERR invalid chunk - Too big for current filter";
+        return -1;
+    }
+    memcpy((char *)rb->solution + offset, buf, bufLen);
+    return 0;
+}
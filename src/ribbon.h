@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RIBBON_WIDTH 128
+#define RIBBON_BLOCK 64
+#define RIBBON_MIN_RESULT_BITS 1
+#define RIBBON_MAX_RESULT_BITS 32
+
+/**
+ * An immutable homogeneous Ribbon filter: each key maps to a 128-bit wide band of coefficients
+ * starting at one of the slots, and the filter is a solution of the linear system over GF(2)
+ * where the band of every key times the solution is zero. Other keys get a random product,
+ * which is zero in all of the 'resultBits' columns with a probability of about 2^-resultBits.
+ *
+ * The solution is bit-sliced: each block of 64 slots is stored as 'resultBits' words, one for
+ * every column, so that a lookup reads at most three adjacent blocks.
+ */
+typedef struct RibbonFilter {
+    uint64_t size; //< Number of distinct keys
+    uint64_t numSlots;
+    uint32_t resultBits;
+    uint64_t *solution;
+} RibbonFilter;
+
+enum ribbon_rc {
+    RIBBON_SUCCESS = 0,
+    RIBBON_OOM = -1,
+};
+
+/**
+ * Builds a filter of the 'n' keys, as returned from FuseFilter_Hash, with 'resultBits'
+ * bits per slot. The keys are rewritten, sorted and deduplicated in place. The filter of a set
+ * of keys is always the same, and building it never fails but for lack of memory.
+ */
+RibbonFilter *RibbonFilter_Build(uint64_t *keys, size_t n, uint32_t resultBits, int *err);
+
+/** Free a created filter */
+void RibbonFilter_Free(RibbonFilter *rb);
+
+/**
+ * Check if a key may have been in the set the filter was built from
+ * Return 0 if the key was not, nonzero otherwise
+ */
+int RibbonFilter_Contains(const RibbonFilter *rb, uint64_t key);
+
+/** Returns the size of the solution in bytes. */
+size_t RibbonFilter_Bytes(const RibbonFilter *rb);
+
+/**
+ * Checks the number of slots, result bits and size of 'rb', as read from a dump.
+ * Returns 0 if they are consistent with a solution of 'bytes', nonzero otherwise.
+ */
+int RibbonFilter_ValidateLayout(const RibbonFilter *rb, size_t bytes);
+
+/**
+ * Get an encoded header, the counterpart of FuseFilter_GetEncodedHeader. Its length differs
+ * from that of fuse and chain headers.
+ *
+ * The header should be freed with RibbonFilter_FreeEncodedHeader.
+ */
+char *RibbonFilter_GetEncodedHeader(const RibbonFilter *rb, size_t *hdrlen);
+void RibbonFilter_FreeEncodedHeader(char *s);
+
+/** Returns whether 'bufLen' is the length of a header from RibbonFilter_GetEncodedHeader. */
+int RibbonFilter_IsEncodedHeader(size_t bufLen);
+
+/**
+ * Get an encoded chunk of the solution, with the same iterator protocol as
+ * SBChain_GetEncodedChunk.
+ */
+const char *RibbonFilter_GetEncodedChunk(const RibbonFilter *rb, long long *curIter, size_t *len,
+                                         size_t maxChunkSize);
+
+/**
+ * Creates a new filter, with a zeroed solution, from a header returned by
+ * RibbonFilter_GetEncodedHeader. Returns NULL and sets errmsg if the header is corrupt.
+ */
+RibbonFilter *RibbonFilter_NewFromHeader(const char *buf, size_t bufLen, const char **errmsg);
+
+/**
+ * Loads a chunk returned from RibbonFilter_GetEncodedChunk.
+ * Returns 0 on success, and nonzero on failure - in which case errmsg is populated.
+ */
+int RibbonFilter_LoadEncodedChunk(RibbonFilter *rb, long long iter, const char *buf,
+                                  size_t bufLen, const char **errmsg);
+
+#ifdef __cplusplus
+}
+#endif
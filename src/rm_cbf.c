@@ -0,0 +1,367 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#include "cbf.h"
+#include "rm_cbf.h"
+#include "rm_cms.h"
+
+#include "rmutil/util.h"
+#include "version.h"
+#include "common.h"
+#include "config.h"
+#include "cmd_info/command_info.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "load_io_error.h"
+
+RedisModuleType *CBFType;
+
+static int _CBF_KeyCheck(RedisModuleCtx *ctx, RedisModuleKey *key) {
+    if (RedisModule_KeyType(key) == REDISMODULE_KEYTYPE_EMPTY) {
+        RedisModule_CloseKey(key);
+        RedisModule_ReplyWithError(ctx, "ERR CBF: key does not exist");
+        return REDISMODULE_ERR;
+    } else if (RedisModule_ModuleTypeGetType(key) != CBFType) {
+        RedisModule_CloseKey(key);
+        RedisModule_ReplyWithError(ctx, REDISMODULE_ERRORMSG_WRONGTYPE);
+        return REDISMODULE_ERR;
+    }
+    return REDISMODULE_OK;
+}
+
+static void _CBF_ReplyWithBool(RedisModuleCtx *ctx, int value) {
+    if (_is_resp3(ctx)) {
+        RedisModule_ReplyWithBool(ctx, value);
+    } else {
+        RedisModule_ReplyWithLongLong(ctx, value);
+    }
+}
+
+/**
+ * Command: CBF.RESERVE {key} {error_rate} {capacity}
+ *
+ * Creates an empty counting Bloom filter of 'capacity' items at 'error_rate'. Its number of
+ * counters is rounded up to a power of two, and it does not scale.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int CBF_ReserveCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc != 4) {
+        return RedisModule_WrongArity(ctx);
+    }
+    double error_rate;
+    if (RedisModule_StringToDouble(argv[2], &error_rate) != REDISMODULE_OK) {
+        return RedisModule_ReplyWithError(ctx, "ERR CBF: bad error rate");
+    } else if (!isConfigValid(error_rate, rm_config.bf_error_rate)) {
+        return RedisModule_ReplyWithErrorFormat(
+            ctx, "ERR CBF: error rate must be in the range (%f, %f)", rm_config.bf_error_rate.min,
+            rm_config.bf_error_rate.max);
+    }
+    long long capacity;
+    if (RedisModule_StringToLongLong(argv[3], &capacity) != REDISMODULE_OK) {
+        return RedisModule_ReplyWithError(ctx, "ERR CBF: bad capacity");
+    } else if (!isConfigValid(capacity, rm_config.bf_initial_size)) {
+        return RedisModule_ReplyWithErrorFormat(
+            ctx, "ERR CBF: capacity must be in the range [%lld, %lld]",
+            rm_config.bf_initial_size.min, rm_config.bf_initial_size.max);
+    }
+
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ | REDISMODULE_WRITE);
+    if (RedisModule_KeyType(key) != REDISMODULE_KEYTYPE_EMPTY) {
+        RedisModule_CloseKey(key);
+        return RedisModule_ReplyWithError(ctx, "ERR CBF: key already exists");
+    }
+    CountingBloom *cbf = CBF_Create(capacity, error_rate);
+    if (!cbf) {
+        RedisModule_CloseKey(key);
+        return RedisModule_ReplyWithError(ctx, "ERR CBF: Insufficient memory to create filter");
+    }
+    RedisModule_ModuleTypeSetValue(key, CBFType, cbf);
+    RedisModule_CloseKey(key);
+    RedisModule_ReplicateVerbatim(ctx);
+    return RedisModule_ReplyWithSimpleString(ctx, "OK");
+}
+
+static int _CBF_AddCommon(RedisModuleCtx *ctx, RedisModuleString **argv, int argc, bool multi) {
+    if ((multi && argc < 3) || (!multi && argc != 3)) {
+        return RedisModule_WrongArity(ctx);
+    }
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ | REDISMODULE_WRITE);
+    CountingBloom *cbf;
+    if (RedisModule_KeyType(key) == REDISMODULE_KEYTYPE_EMPTY) {
+        // created with the defaults of the Bloom filters
+        cbf = CBF_Create(rm_config.bf_initial_size.value, rm_config.bf_error_rate.value);
+        if (!cbf) {
+            RedisModule_CloseKey(key);
+            return RedisModule_ReplyWithError(ctx,
+                                              "ERR CBF: Insufficient memory to create filter");
+        }
+        RedisModule_ModuleTypeSetValue(key, CBFType, cbf);
+    } else if (_CBF_KeyCheck(ctx, key) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+    } else {
+        cbf = RedisModule_ModuleTypeGetValue(key);
+    }
+
+    if (multi) {
+        RedisModule_ReplyWithArray(ctx, argc - 2);
+    }
+    for (int i = 2; i < argc; i++) {
+        size_t len;
+        const char *item = RedisModule_StringPtrLen(argv[i], &len);
+        _CBF_ReplyWithBool(ctx, CBF_Add(cbf, CBF_Hash(item, len)));
+    }
+    RedisModule_CloseKey(key);
+    RedisModule_ReplicateVerbatim(ctx);
+    return REDISMODULE_OK;
+}
+
+/**
+ * Command: CBF.ADD {key} {item}
+ *
+ * Adds an item to the filter, which is created with the default error rate and capacity of the
+ * Bloom filters if it does not exist. Returns 1 if the item was not in the filter, 0 otherwise.
+ * An item added twice must be deleted twice.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int CBF_AddCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    return _CBF_AddCommon(ctx, argv, argc, false);
+}
+
+/**
+ * Command: CBF.MADD {key} {item} [{item} ...]
+ *
+ * Adds one or more items to the filter, as CBF.ADD, and returns an array of the replies.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int CBF_MAddCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    return _CBF_AddCommon(ctx, argv, argc, true);
+}
+
+static int _CBF_ExistsCommon(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
+                             bool multi) {
+    if ((multi && argc < 3) || (!multi && argc != 3)) {
+        return RedisModule_WrongArity(ctx);
+    }
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
+    const CountingBloom *cbf = NULL;
+    if (RedisModule_KeyType(key) != REDISMODULE_KEYTYPE_EMPTY) {
+        if (_CBF_KeyCheck(ctx, key) != REDISMODULE_OK) {
+            return REDISMODULE_ERR;
+        }
+        cbf = RedisModule_ModuleTypeGetValue(key);
+    }
+
+    if (multi) {
+        RedisModule_ReplyWithArray(ctx, argc - 2);
+    }
+    for (int i = 2; i < argc; i++) {
+        size_t len;
+        const char *item = RedisModule_StringPtrLen(argv[i], &len);
+        _CBF_ReplyWithBool(ctx, cbf && CBF_Check(cbf, CBF_Hash(item, len)));
+    }
+    RedisModule_CloseKey(key);
+    return REDISMODULE_OK;
+}
+
+/**
+ * Command: CBF.EXISTS {key} {item}
+ *
+ * Returns 1 if the item may be in the filter, 0 if it is not or the filter does not exist.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int CBF_ExistsCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    return _CBF_ExistsCommon(ctx, argv, argc, false);
+}
+
+/**
+ * Command: CBF.MEXISTS {key} {item} [{item} ...]
+ *
+ * Checks one or more items, as CBF.EXISTS, and returns an array of the replies.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int CBF_MExistsCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    return _CBF_ExistsCommon(ctx, argv, argc, true);
+}
+
+/**
+ * Command: CBF.DEL {key} {item}
+ *
+ * Deletes one occurrence of an item. Returns 1 if it was deleted, and 0 if it was not in the
+ * filter, which is then left as it was. Deleting an item that was never added is only possible
+ * for a false positive, and may cause false negatives for the items sharing its counters.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int CBF_DelCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc != 3) {
+        return RedisModule_WrongArity(ctx);
+    }
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ | REDISMODULE_WRITE);
+    if (_CBF_KeyCheck(ctx, key) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+    }
+    CountingBloom *cbf = RedisModule_ModuleTypeGetValue(key);
+    size_t len;
+    const char *item = RedisModule_StringPtrLen(argv[2], &len);
+    const int deleted = CBF_Delete(cbf, CBF_Hash(item, len));
+    RedisModule_CloseKey(key);
+    if (deleted) {
+        RedisModule_ReplicateVerbatim(ctx);
+    }
+    _CBF_ReplyWithBool(ctx, deleted);
+    return REDISMODULE_OK;
+}
+
+size_t CBFMemUsage(const void *value) {
+    const CountingBloom *cbf = value;
+    return sizeof *cbf + CBF_Bytes(cbf);
+}
+
+/**
+ * Command: CBF.INFO {key}
+ *
+ * Returns the capacity, the memory usage, the number of counters and hash functions, and the
+ * number of items added and not deleted of the filter.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int CBF_InfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc != 2) {
+        return RedisModule_WrongArity(ctx);
+    }
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
+    if (_CBF_KeyCheck(ctx, key) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+    }
+    const CountingBloom *cbf = RedisModule_ModuleTypeGetValue(key);
+    RedisModule_ReplyWithMapOrArray(ctx, 5 * 2, true);
+    RedisModule_ReplyWithSimpleString(ctx, "Capacity");
+    RedisModule_ReplyWithLongLong(ctx, cbf->entries);
+    RedisModule_ReplyWithSimpleString(ctx, "Size");
+    RedisModule_ReplyWithLongLong(ctx, CBFMemUsage(cbf));
+    RedisModule_ReplyWithSimpleString(ctx, "Counters");
+    RedisModule_ReplyWithLongLong(ctx, (long long)1 << cbf->n2);
+    RedisModule_ReplyWithSimpleString(ctx, "Hash functions");
+    RedisModule_ReplyWithLongLong(ctx, cbf->hashes);
+    RedisModule_ReplyWithSimpleString(ctx, "Number of items inserted");
+    RedisModule_ReplyWithLongLong(ctx, cbf->size);
+    RedisModule_CloseKey(key);
+    return REDISMODULE_OK;
+}
+
+void CBFRdbSave(RedisModuleIO *rdb, void *value) {
+    const CountingBloom *cbf = value;
+    RedisModule_SaveUnsigned(rdb, cbf->entries);
+    RedisModule_SaveDouble(rdb, cbf->error);
+    RedisModule_SaveUnsigned(rdb, cbf->hashes);
+    RedisModule_SaveUnsigned(rdb, cbf->n2);
+    RedisModule_SaveUnsigned(rdb, cbf->size);
+    RedisModule_SaveStringBuffer(rdb, (const char *)cbf->counters, CBF_Bytes(cbf));
+}
+
+void CBFFree(void *value) { CBF_Destroy(value); }
+
+void *CBFRdbLoad(RedisModuleIO *rdb, int encver) {
+    if (encver > CBF_ENC_VER) {
+        return NULL;
+    }
+    CountingBloom *cbf = RedisModule_Calloc(1, sizeof *cbf);
+    bool err = false;
+    errdefer(err, CBF_Destroy(cbf));
+    cbf->entries = LoadUnsigned_IOError(rdb, err, NULL);
+    cbf->error = LoadDouble_IOError(rdb, err, NULL);
+    const uint64_t hashes = LoadUnsigned_IOError(rdb, err, NULL);
+    const uint64_t n2 = LoadUnsigned_IOError(rdb, err, NULL);
+    cbf->size = LoadUnsigned_IOError(rdb, err, NULL);
+    size_t bytes;
+    cbf->counters = (uint64_t *)LoadStringBuffer_IOError(rdb, &bytes, err, NULL);
+    if (hashes > UINT32_MAX || n2 > CBF_MAX_N2) {
+        err = true;
+        return NULL;
+    }
+    cbf->hashes = hashes;
+    cbf->n2 = n2;
+    if (CBF_ValidateLayout(cbf, bytes) != 0) {
+        err = true;
+        return NULL;
+    }
+    return cbf;
+}
+
+static int CBFDefrag(RedisModuleDefragCtx *ctx, RedisModuleString *key, void **value) {
+    *value = defragPtr(ctx, *value);
+    CountingBloom *cbf = *value;
+    cbf->counters = defragPtr(ctx, cbf->counters);
+    return 0;
+}
+
+int CBFModule_onLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    RedisModuleTypeMethods tm = {
+        .version = REDISMODULE_TYPE_METHOD_VERSION,
+        .rdb_load = CBFRdbLoad,
+        .rdb_save = CBFRdbSave,
+        .aof_rewrite = RMUtil_DefaultAofRewrite,
+        .mem_usage = CBFMemUsage,
+        .free = CBFFree,
+        .defrag = CBFDefrag,
+    };
+
+    CBFType = RedisModule_CreateDataType(ctx, "MBbloomCB", CBF_ENC_VER, &tm);
+    if (CBFType == NULL) {
+        return REDISMODULE_ERR;
+    }
+
+#define RegisterCommand(ctx, name, cmd, mode, acl)                                                 \
+    RegisterCommandWithModesAndAcls(ctx, name, cmd, mode, acl " cbf")
+
+    RegisterAclCategory(ctx, "cbf");
+    RegisterCommand(ctx, "cbf.reserve", CBF_ReserveCommand, "write deny-oom", "write fast");
+    RegisterCommand(ctx, "cbf.add", CBF_AddCommand, "write deny-oom", "write fast");
+    RegisterCommand(ctx, "cbf.madd", CBF_MAddCommand, "write deny-oom", "write");
+    RegisterCommand(ctx, "cbf.exists", CBF_ExistsCommand, "readonly", "read fast");
+    RegisterCommand(ctx, "cbf.mexists", CBF_MExistsCommand, "readonly", "read fast");
+    RegisterCommand(ctx, "cbf.del", CBF_DelCommand, "write", "write fast");
+    RegisterCommand(ctx, "cbf.info", CBF_InfoCommand, "readonly", "read fast");
+
+#undef RegisterCommand
+
+    if (RegisterCBFCommandInfos(ctx) != REDISMODULE_OK)
+        return REDISMODULE_ERR;
+
+    return REDISMODULE_OK;
+}
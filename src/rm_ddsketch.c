@@ -0,0 +1,506 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#include "ddsketch.h"
+#include "rm_ddsketch.h"
+#include "rm_cms.h"
+
+#include "rmutil/util.h"
+#include "version.h"
+#include "common.h"
+#include "cmd_info/command_info.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "load_io_error.h"
+
+RedisModuleType *DDSketchType;
+
+static int _DDSketch_KeyCheck(RedisModuleCtx *ctx, RedisModuleKey *key) {
+    if (RedisModule_KeyType(key) == REDISMODULE_KEYTYPE_EMPTY) {
+        RedisModule_CloseKey(key);
+        RedisModule_ReplyWithError(ctx, "ERR DDSketch: key does not exist");
+        return REDISMODULE_ERR;
+    } else if (RedisModule_ModuleTypeGetType(key) != DDSketchType) {
+        RedisModule_CloseKey(key);
+        RedisModule_ReplyWithError(ctx, REDISMODULE_ERRORMSG_WRONGTYPE);
+        return REDISMODULE_ERR;
+    }
+    return REDISMODULE_OK;
+}
+
+/**
+ * Command: DDSKETCH.CREATE {key} [ACCURACY {accuracy}] [MAXBINS {maxbins}]
+ *
+ * Creates an empty DDSketch answering quantiles within a relative error of 'accuracy'. Values
+ * are counted in bins of logarithmically growing width, and once the values of either sign span
+ * more than 'maxbins' bins the lowest bins are collapsed together.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int DDSketch_CreateCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc < 2 || argc > 6 || argc % 2 != 0) {
+        return RedisModule_WrongArity(ctx);
+    }
+    double accuracy = DDS_DEFAULT_ACCURACY;
+    long long max_bins = DDS_DEFAULT_MAX_BINS;
+    // the optional arguments are keyword and value pairs
+    for (int i = 2; i < argc; i += 2) {
+        if (RMUtil_ArgIndex("ACCURACY", argv + i, 1) == 0) {
+            if (RedisModule_StringToDouble(argv[i + 1], &accuracy) != REDISMODULE_OK ||
+                !(accuracy >= DDS_MIN_ACCURACY && accuracy <= DDS_MAX_ACCURACY)) {
+                return RedisModule_ReplyWithError(
+                    ctx, "ERR DDSketch: accuracy needs to be between 0.0001 and 0.5");
+            }
+        } else if (RMUtil_ArgIndex("MAXBINS", argv + i, 1) == 0) {
+            if (RedisModule_StringToLongLong(argv[i + 1], &max_bins) != REDISMODULE_OK ||
+                max_bins < DDS_MIN_MAX_BINS || max_bins > DDS_MAX_MAX_BINS) {
+                return RedisModule_ReplyWithError(
+                    ctx, "ERR DDSketch: maxbins needs to be an integer between 16 and 65536");
+            }
+        } else {
+            return RedisModule_ReplyWithError(ctx, "ERR DDSketch: wrong keyword");
+        }
+    }
+
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ | REDISMODULE_WRITE);
+    if (RedisModule_KeyType(key) != REDISMODULE_KEYTYPE_EMPTY) {
+        RedisModule_CloseKey(key);
+        return RedisModule_ReplyWithError(ctx, "ERR DDSketch: key already exists");
+    }
+    DDSketch *dds = DDSketch_Create(accuracy, max_bins);
+    if (!dds) {
+        RedisModule_CloseKey(key);
+        return RedisModule_ReplyWithError(ctx, "ERR DDSketch: allocation failed");
+    }
+    RedisModule_ModuleTypeSetValue(key, DDSketchType, dds);
+    RedisModule_CloseKey(key);
+    RedisModule_ReplicateVerbatim(ctx);
+    return RedisModule_ReplyWithSimpleString(ctx, "OK");
+}
+
+/**
+ * Command: DDSKETCH.ADD {key} {value} [{value} ...]
+ *
+ * Adds one or more values to the sketch, each with one log and one counter increment.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int DDSketch_AddCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc < 3) {
+        return RedisModule_WrongArity(ctx);
+    }
+    const size_t n_values = argc - 2;
+    double *vals = RedisModule_Alloc(n_values * sizeof *vals);
+    for (size_t i = 0; i < n_values; i++) {
+        if (RedisModule_StringToDouble(argv[2 + i], &vals[i]) != REDISMODULE_OK ||
+            !isfinite(vals[i])) {
+            RedisModule_Free(vals);
+            return RedisModule_ReplyWithError(
+                ctx, "ERR DDSketch: value needs to be a finite number");
+        }
+    }
+
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ | REDISMODULE_WRITE);
+    if (_DDSketch_KeyCheck(ctx, key) != REDISMODULE_OK) {
+        RedisModule_Free(vals);
+        return REDISMODULE_ERR;
+    }
+    DDSketch *dds = RedisModule_ModuleTypeGetValue(key);
+    if (dds->count > UINT64_MAX - n_values) {
+        RedisModule_CloseKey(key);
+        RedisModule_Free(vals);
+        return RedisModule_ReplyWithError(ctx, "ERR DDSketch: overflow detected");
+    }
+    size_t added = 0;
+    while (added < n_values && DDSketch_Add(dds, vals[added], 1) == 0) {
+        added++;
+    }
+    RedisModule_CloseKey(key);
+    RedisModule_Free(vals);
+    if (added < n_values) {
+        // the values added before the failure stay added
+        if (added) {
+            RedisModule_ReplicateVerbatim(ctx);
+        }
+        return RedisModule_ReplyWithError(ctx, "ERR DDSketch: allocation failed");
+    }
+    RedisModule_ReplicateVerbatim(ctx);
+    return RedisModule_ReplyWithSimpleString(ctx, "OK");
+}
+
+/**
+ * Command: DDSKETCH.MERGE {destination} {numkeys} {source} [{source} ...] [OVERRIDE]
+ *
+ * Adds the bins of the source sketches to the destination, which is created with the parameters
+ * of the first source if it does not exist. With OVERRIDE, the destination is replaced by the
+ * merge of the sources. All sketches need the same accuracy.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int DDSketch_MergeCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc < 4) {
+        return RedisModule_WrongArity(ctx);
+    }
+    long long numkeys = 0;
+    if (RedisModule_StringToLongLong(argv[2], &numkeys) != REDISMODULE_OK || numkeys <= 0) {
+        return RedisModule_ReplyWithError(ctx,
+                                          "ERR DDSketch: numkeys needs to be a positive integer");
+    }
+    if (numkeys > argc - 3) {
+        return RedisModule_WrongArity(ctx);
+    }
+    bool override = false;
+    if (numkeys + 3 < argc) {
+        if (numkeys + 4 != argc || RMUtil_ArgIndex("OVERRIDE", argv + numkeys + 3, 1) != 0) {
+            return RedisModule_ReplyWithError(ctx, "ERR DDSketch: wrong keyword");
+        }
+        override = true;
+    }
+
+    const DDSketch *dest = NULL;
+    RedisModuleKey *destKey = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
+    if (RedisModule_KeyType(destKey) != REDISMODULE_KEYTYPE_EMPTY) {
+        if (RedisModule_ModuleTypeGetType(destKey) != DDSketchType) {
+            RedisModule_CloseKey(destKey);
+            return RedisModule_ReplyWithError(ctx, REDISMODULE_ERRORMSG_WRONGTYPE);
+        }
+        dest = RedisModule_ModuleTypeGetValue(destKey);
+    }
+    RedisModule_CloseKey(destKey);
+
+    const DDSketch **sources = RedisModule_Calloc(numkeys, sizeof *sources);
+    uint32_t max_bins = 0;
+    for (long long i = 0; i < numkeys; i++) {
+        RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[3 + i], REDISMODULE_READ);
+        if (_DDSketch_KeyCheck(ctx, key) != REDISMODULE_OK) {
+            RedisModule_Free(sources);
+            return REDISMODULE_ERR;
+        }
+        sources[i] = RedisModule_ModuleTypeGetValue(key);
+        RedisModule_CloseKey(key);
+        if (sources[i]->maxBins > max_bins) {
+            max_bins = sources[i]->maxBins;
+        }
+    }
+    // an existing destination keeps its parameters, otherwise the largest maxbins is used
+    const DDSketch *model = dest && !override ? dest : sources[0];
+    if (model == dest) {
+        max_bins = dest->maxBins;
+    }
+    for (long long i = 0; i < numkeys; i++) {
+        if (sources[i]->accuracy != model->accuracy) {
+            RedisModule_Free(sources);
+            return RedisModule_ReplyWithError(ctx,
+                                              "ERR DDSketch: sketches need the same accuracy");
+        }
+    }
+
+    // the merge is built aside, so the destination is left as it was on failure even when it is
+    // also a source
+    DDSketch *merged = DDSketch_Create(model->accuracy, max_bins);
+    int res = merged ? 0 : -2;
+    if (res == 0 && dest && !override) {
+        res = DDSketch_Merge(merged, dest);
+    }
+    for (long long i = 0; i < numkeys && res == 0; i++) {
+        res = DDSketch_Merge(merged, sources[i]);
+    }
+    RedisModule_Free(sources);
+    if (res != 0) {
+        if (merged) {
+            DDSketch_Destroy(merged);
+        }
+        return RedisModule_ReplyWithError(ctx, res == -1 ? "ERR DDSketch: overflow detected"
+                                                         : "ERR DDSketch: allocation failed");
+    }
+
+    destKey = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ | REDISMODULE_WRITE);
+    RedisModule_ModuleTypeSetValue(destKey, DDSketchType, merged);
+    RedisModule_CloseKey(destKey);
+    RedisModule_ReplicateVerbatim(ctx);
+    return RedisModule_ReplyWithSimpleString(ctx, "OK");
+}
+
+/**
+ * Command: DDSKETCH.QUANTILE {key} {quantile} [{quantile} ...]
+ *
+ * Returns, for each quantile, an estimate of the value at that quantile, within the relative
+ * accuracy of the sketch unless its bins were collapsed down to that quantile.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int DDSketch_QuantileCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc < 3) {
+        return RedisModule_WrongArity(ctx);
+    }
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
+    if (_DDSketch_KeyCheck(ctx, key) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+    }
+    const DDSketch *dds = RedisModule_ModuleTypeGetValue(key);
+    const size_t n_quantiles = argc - 2;
+    double *quantiles = RedisModule_Alloc(n_quantiles * sizeof *quantiles);
+    for (size_t i = 0; i < n_quantiles; i++) {
+        if (RedisModule_StringToDouble(argv[2 + i], &quantiles[i]) != REDISMODULE_OK) {
+            RedisModule_CloseKey(key);
+            RedisModule_Free(quantiles);
+            return RedisModule_ReplyWithError(ctx, "ERR DDSketch: error parsing quantile");
+        }
+        if (!(quantiles[i] >= 0 && quantiles[i] <= 1)) {
+            RedisModule_CloseKey(key);
+            RedisModule_Free(quantiles);
+            return RedisModule_ReplyWithError(ctx, "ERR DDSketch: quantile should be in [0,1]");
+        }
+    }
+    RedisModule_ReplyWithArray(ctx, n_quantiles);
+    for (size_t i = 0; i < n_quantiles; i++) {
+        RedisModule_ReplyWithDouble(ctx, DDSketch_Quantile(dds, quantiles[i]));
+    }
+    RedisModule_CloseKey(key);
+    RedisModule_Free(quantiles);
+    return REDISMODULE_OK;
+}
+
+/**
+ * Command: DDSKETCH.CDF {key} {value} [{value} ...]
+ *
+ * Returns, for each value, an estimate of the fraction of the observations smaller than or equal
+ * to it.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int DDSketch_CdfCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc < 3) {
+        return RedisModule_WrongArity(ctx);
+    }
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
+    if (_DDSketch_KeyCheck(ctx, key) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+    }
+    const DDSketch *dds = RedisModule_ModuleTypeGetValue(key);
+    const size_t n_values = argc - 2;
+    double *values = RedisModule_Alloc(n_values * sizeof *values);
+    for (size_t i = 0; i < n_values; i++) {
+        if (RedisModule_StringToDouble(argv[2 + i], &values[i]) != REDISMODULE_OK ||
+            isnan(values[i])) {
+            RedisModule_CloseKey(key);
+            RedisModule_Free(values);
+            return RedisModule_ReplyWithError(ctx, "ERR DDSketch: error parsing value");
+        }
+    }
+    RedisModule_ReplyWithArray(ctx, n_values);
+    for (size_t i = 0; i < n_values; i++) {
+        RedisModule_ReplyWithDouble(ctx, DDSketch_Cdf(dds, values[i]));
+    }
+    RedisModule_CloseKey(key);
+    RedisModule_Free(values);
+    return REDISMODULE_OK;
+}
+
+size_t DDSketchMemUsage(const void *value) {
+    const DDSketch *dds = value;
+    return sizeof *dds + DDSketch_Capacity(dds) * sizeof(uint64_t);
+}
+
+/**
+ * Command: DDSKETCH.INFO {key}
+ *
+ * Returns the relative accuracy, the maximum and allocated number of bins per sign, the number of
+ * bins in use, the number of observations and the memory usage of the sketch.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int DDSketch_InfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc != 2) {
+        return RedisModule_WrongArity(ctx);
+    }
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
+    if (_DDSketch_KeyCheck(ctx, key) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+    }
+    const DDSketch *dds = RedisModule_ModuleTypeGetValue(key);
+    RedisModule_ReplyWithMapOrArray(ctx, 6 * 2, true);
+    RedisModule_ReplyWithSimpleString(ctx, "Accuracy");
+    RedisModule_ReplyWithDouble(ctx, dds->accuracy);
+    RedisModule_ReplyWithSimpleString(ctx, "Max bins");
+    RedisModule_ReplyWithLongLong(ctx, dds->maxBins);
+    RedisModule_ReplyWithSimpleString(ctx, "Capacity");
+    RedisModule_ReplyWithLongLong(ctx, DDSketch_Capacity(dds));
+    RedisModule_ReplyWithSimpleString(ctx, "Bins used");
+    RedisModule_ReplyWithLongLong(ctx, DDSketch_BinsUsed(dds));
+    RedisModule_ReplyWithSimpleString(ctx, "Observations");
+    RedisModule_ReplyWithLongLong(ctx, dds->count);
+    RedisModule_ReplyWithSimpleString(ctx, "Memory usage");
+    RedisModule_ReplyWithLongLong(ctx, DDSketchMemUsage(dds));
+    RedisModule_CloseKey(key);
+    return REDISMODULE_OK;
+}
+
+static void _DDSketch_SaveStore(RedisModuleIO *rdb, const DDStore *store) {
+    RedisModule_SaveUnsigned(rdb, store->count);
+    if (!store->count) {
+        return;
+    }
+    RedisModule_SaveSigned(rdb, store->minIndex);
+    RedisModule_SaveSigned(rdb, store->maxIndex);
+    // only the bins in use are saved
+    RedisModule_SaveStringBuffer(rdb, (const char *)(store->bins + store->minIndex - store->base),
+                                 (store->maxIndex - store->minIndex + 1) * sizeof *store->bins);
+}
+
+void DDSketchRdbSave(RedisModuleIO *rdb, void *value) {
+    const DDSketch *dds = value;
+    RedisModule_SaveDouble(rdb, dds->accuracy);
+    RedisModule_SaveUnsigned(rdb, dds->maxBins);
+    RedisModule_SaveUnsigned(rdb, dds->zeroCount);
+    RedisModule_SaveDouble(rdb, dds->min);
+    RedisModule_SaveDouble(rdb, dds->max);
+    _DDSketch_SaveStore(rdb, &dds->positive);
+    _DDSketch_SaveStore(rdb, &dds->negative);
+}
+
+static int _DDSketch_LoadStore(RedisModuleIO *rdb, DDStore *store, uint32_t max_bins, bool *err) {
+    store->count = LoadUnsigned_IOError(rdb, *err, REDISMODULE_ERR);
+    if (!store->count) {
+        return REDISMODULE_OK;
+    }
+    const int64_t min_index = LoadSigned_IOError(rdb, *err, REDISMODULE_ERR);
+    const int64_t max_index = LoadSigned_IOError(rdb, *err, REDISMODULE_ERR);
+    if (min_index < INT32_MIN || max_index > INT32_MAX || min_index > max_index ||
+        max_index - min_index + 1 > max_bins) {
+        *err = true;
+        return REDISMODULE_ERR;
+    }
+    size_t len = 0;
+    store->bins = (uint64_t *)LoadStringBuffer_IOError(rdb, &len, *err, REDISMODULE_ERR);
+    store->base = min_index;
+    store->cap = max_index - min_index + 1;
+    store->minIndex = min_index;
+    store->maxIndex = max_index;
+    if (len != store->cap * sizeof *store->bins) {
+        *err = true;
+        return REDISMODULE_ERR;
+    }
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < store->cap; i++) {
+        if (total > UINT64_MAX - store->bins[i]) {
+            *err = true;
+            return REDISMODULE_ERR;
+        }
+        total += store->bins[i];
+    }
+    if (total != store->count) {
+        *err = true;
+        return REDISMODULE_ERR;
+    }
+    return REDISMODULE_OK;
+}
+
+void DDSketchFree(void *value) { DDSketch_Destroy(value); }
+
+void *DDSketchRdbLoad(RedisModuleIO *rdb, int encver) {
+    if (encver > DDSKETCH_ENC_VER) {
+        return NULL;
+    }
+    bool err = false;
+    const double accuracy = LoadDouble_IOError(rdb, err, NULL);
+    const uint64_t max_bins = LoadUnsigned_IOError(rdb, err, NULL);
+    if (!(accuracy >= DDS_MIN_ACCURACY && accuracy <= DDS_MAX_ACCURACY) ||
+        max_bins < DDS_MIN_MAX_BINS || max_bins > DDS_MAX_MAX_BINS) {
+        return NULL;
+    }
+    DDSketch *dds = DDSketch_Create(accuracy, max_bins);
+    if (!dds) {
+        return NULL;
+    }
+    errdefer(err, DDSketch_Destroy(dds));
+    dds->zeroCount = LoadUnsigned_IOError(rdb, err, NULL);
+    dds->min = LoadDouble_IOError(rdb, err, NULL);
+    dds->max = LoadDouble_IOError(rdb, err, NULL);
+    if (_DDSketch_LoadStore(rdb, &dds->positive, max_bins, &err) != REDISMODULE_OK ||
+        _DDSketch_LoadStore(rdb, &dds->negative, max_bins, &err) != REDISMODULE_OK) {
+        return NULL;
+    }
+    // the total is rebuilt from the stores, so it matches them
+    if (dds->zeroCount > UINT64_MAX - dds->positive.count ||
+        dds->zeroCount + dds->positive.count > UINT64_MAX - dds->negative.count) {
+        err = true;
+        return NULL;
+    }
+    dds->count = dds->zeroCount + dds->positive.count + dds->negative.count;
+    return dds;
+}
+
+static int DDSketchDefrag(RedisModuleDefragCtx *ctx, RedisModuleString *key, void **value) {
+    *value = defragPtr(ctx, *value);
+    DDSketch *dds = *value;
+    if (dds->positive.bins) {
+        dds->positive.bins = defragPtr(ctx, dds->positive.bins);
+    }
+    if (dds->negative.bins) {
+        dds->negative.bins = defragPtr(ctx, dds->negative.bins);
+    }
+    return 0;
+}
+
+int DDSketchModule_onLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    RedisModuleTypeMethods tm = {
+        .version = REDISMODULE_TYPE_METHOD_VERSION,
+        .rdb_load = DDSketchRdbLoad,
+        .rdb_save = DDSketchRdbSave,
+        .aof_rewrite = RMUtil_DefaultAofRewrite,
+        .mem_usage = DDSketchMemUsage,
+        .free = DDSketchFree,
+        .defrag = DDSketchDefrag,
+    };
+
+    DDSketchType = RedisModule_CreateDataType(ctx, "DDSk-TYPE", DDSKETCH_ENC_VER, &tm);
+    if (DDSketchType == NULL) {
+        return REDISMODULE_ERR;
+    }
+
+#define RegisterCommand(ctx, name, cmd, mode, acl)                                                 \
+    RegisterCommandWithModesAndAcls(ctx, name, cmd, mode, acl " ddsketch")
+
+    RegisterAclCategory(ctx, "ddsketch");
+    RegisterCommand(ctx, "ddsketch.create", DDSketch_CreateCommand, "write deny-oom", "write fast");
+    RegisterCommand(ctx, "ddsketch.add", DDSketch_AddCommand, "write deny-oom", "write");
+    RegisterCommand(ctx, "ddsketch.merge", DDSketch_MergeCommand, "write deny-oom", "write");
+    RegisterCommand(ctx, "ddsketch.quantile", DDSketch_QuantileCommand, "readonly", "read fast");
+    RegisterCommand(ctx, "ddsketch.cdf", DDSketch_CdfCommand, "readonly", "read fast");
+    RegisterCommand(ctx, "ddsketch.info", DDSketch_InfoCommand, "readonly", "read fast");
+
+#undef RegisterCommand
+
+    if (RegisterDDSketchCommandInfos(ctx) != REDISMODULE_OK)
+        return REDISMODULE_ERR;
+
+    return REDISMODULE_OK;
+}
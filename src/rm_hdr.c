@@ -0,0 +1,626 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#include "hdr.h"
+#include "rm_hdr.h"
+#include "rm_cms.h"
+
+#include "rmutil/util.h"
+#include "version.h"
+#include "common.h"
+#include "cmd_info/command_info.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "load_io_error.h"
+
+RedisModuleType *HDRType;
+
+static int _HDR_KeyCheck(RedisModuleCtx *ctx, RedisModuleKey *key) {
+    if (RedisModule_KeyType(key) == REDISMODULE_KEYTYPE_EMPTY) {
+        RedisModule_CloseKey(key);
+        RedisModule_ReplyWithError(ctx, "ERR HDR: key does not exist");
+        return REDISMODULE_ERR;
+    } else if (RedisModule_ModuleTypeGetType(key) != HDRType) {
+        RedisModule_CloseKey(key);
+        RedisModule_ReplyWithError(ctx, REDISMODULE_ERRORMSG_WRONGTYPE);
+        return REDISMODULE_ERR;
+    }
+    return REDISMODULE_OK;
+}
+
+/**
+ * Command: HDR.CREATE {key} [HIGHEST {highest}] [SIGFIGS {sigfigs}]
+ *
+ * Creates an empty histogram of the integer values from 0 to 'highest', each counted with
+ * 'sigfigs' significant decimal figures. All its counters are allocated upfront, so its memory
+ * usage does not depend on the values added.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int HDR_CreateCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc < 2 || argc > 6 || argc % 2 != 0) {
+        return RedisModule_WrongArity(ctx);
+    }
+    long long highest = HDR_DEFAULT_HIGHEST;
+    long long sigfigs = HDR_DEFAULT_SIGFIGS;
+    // the optional arguments are keyword and value pairs
+    for (int i = 2; i < argc; i += 2) {
+        if (RMUtil_ArgIndex("HIGHEST", argv + i, 1) == 0) {
+            if (RedisModule_StringToLongLong(argv[i + 1], &highest) != REDISMODULE_OK ||
+                highest < 2) {
+                return RedisModule_ReplyWithError(
+                    ctx, "ERR HDR: highest needs to be an integer larger than 1");
+            }
+        } else if (RMUtil_ArgIndex("SIGFIGS", argv + i, 1) == 0) {
+            if (RedisModule_StringToLongLong(argv[i + 1], &sigfigs) != REDISMODULE_OK ||
+                sigfigs < HDR_MIN_SIGFIGS || sigfigs > HDR_MAX_SIGFIGS) {
+                return RedisModule_ReplyWithError(
+                    ctx, "ERR HDR: sigfigs needs to be an integer between 1 and 5");
+            }
+        } else {
+            return RedisModule_ReplyWithError(ctx, "ERR HDR: wrong keyword");
+        }
+    }
+    if (!HDR_CountersNeeded(highest, sigfigs)) {
+        return RedisModule_ReplyWithError(
+            ctx, "ERR HDR: highest and sigfigs need too many counters");
+    }
+
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ | REDISMODULE_WRITE);
+    if (RedisModule_KeyType(key) != REDISMODULE_KEYTYPE_EMPTY) {
+        RedisModule_CloseKey(key);
+        return RedisModule_ReplyWithError(ctx, "ERR HDR: key already exists");
+    }
+    HDRHistogram *h = HDR_Create(highest, sigfigs);
+    if (!h) {
+        RedisModule_CloseKey(key);
+        return RedisModule_ReplyWithError(ctx, "ERR HDR: allocation failed");
+    }
+    RedisModule_ModuleTypeSetValue(key, HDRType, h);
+    RedisModule_CloseKey(key);
+    RedisModule_ReplicateVerbatim(ctx);
+    return RedisModule_ReplyWithSimpleString(ctx, "OK");
+}
+
+/**
+ * Command: HDR.ADD {key} {value} [{value} ...]
+ *
+ * Adds one or more integer values to the histogram, each with one counter increment. No value
+ * is added unless all of them are in [0, highest].
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int HDR_AddCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc < 3) {
+        return RedisModule_WrongArity(ctx);
+    }
+    const size_t n_values = argc - 2;
+    long long *vals = RedisModule_Alloc(n_values * sizeof *vals);
+    for (size_t i = 0; i < n_values; i++) {
+        if (RedisModule_StringToLongLong(argv[2 + i], &vals[i]) != REDISMODULE_OK ||
+            vals[i] < 0) {
+            RedisModule_Free(vals);
+            return RedisModule_ReplyWithError(
+                ctx, "ERR HDR: value needs to be a non-negative integer");
+        }
+    }
+
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ | REDISMODULE_WRITE);
+    if (_HDR_KeyCheck(ctx, key) != REDISMODULE_OK) {
+        RedisModule_Free(vals);
+        return REDISMODULE_ERR;
+    }
+    HDRHistogram *h = RedisModule_ModuleTypeGetValue(key);
+    const char *error = NULL;
+    if (h->totalCount > UINT64_MAX - n_values) {
+        error = "ERR HDR: overflow detected";
+    }
+    for (size_t i = 0; i < n_values && !error; i++) {
+        if (vals[i] > h->highest) {
+            error = "ERR HDR: value exceeds the highest trackable value";
+        }
+    }
+    for (size_t i = 0; i < n_values && !error; i++) {
+        HDR_Add(h, vals[i], 1);
+    }
+    RedisModule_CloseKey(key);
+    RedisModule_Free(vals);
+    if (error) {
+        return RedisModule_ReplyWithError(ctx, error);
+    }
+    RedisModule_ReplicateVerbatim(ctx);
+    return RedisModule_ReplyWithSimpleString(ctx, "OK");
+}
+
+/**
+ * Command: HDR.RESET {key}
+ *
+ * Empties the histogram, keeping its parameters and counters.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int HDR_ResetCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc != 2) {
+        return RedisModule_WrongArity(ctx);
+    }
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ | REDISMODULE_WRITE);
+    if (_HDR_KeyCheck(ctx, key) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+    }
+    HDR_Reset(RedisModule_ModuleTypeGetValue(key));
+    RedisModule_CloseKey(key);
+    RedisModule_ReplicateVerbatim(ctx);
+    return RedisModule_ReplyWithSimpleString(ctx, "OK");
+}
+
+/**
+ * Command: HDR.MERGE {destination} {numkeys} {source} [{source} ...] [OVERRIDE]
+ *
+ * Adds the counters of the source histograms to the destination, which is created with the
+ * significant figures of the first source and the largest highest value of the sources if it
+ * does not exist. With OVERRIDE, the destination is replaced by the merge of the sources. The
+ * counters of histograms with the same significant figures are added one to one.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int HDR_MergeCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc < 4) {
+        return RedisModule_WrongArity(ctx);
+    }
+    long long numkeys = 0;
+    if (RedisModule_StringToLongLong(argv[2], &numkeys) != REDISMODULE_OK || numkeys <= 0) {
+        return RedisModule_ReplyWithError(ctx, "ERR HDR: numkeys needs to be a positive integer");
+    }
+    if (numkeys > argc - 3) {
+        return RedisModule_WrongArity(ctx);
+    }
+    bool override = false;
+    if (numkeys + 3 < argc) {
+        if (numkeys + 4 != argc || RMUtil_ArgIndex("OVERRIDE", argv + numkeys + 3, 1) != 0) {
+            return RedisModule_ReplyWithError(ctx, "ERR HDR: wrong keyword");
+        }
+        override = true;
+    }
+
+    const HDRHistogram *dest = NULL;
+    RedisModuleKey *destKey = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
+    if (RedisModule_KeyType(destKey) != REDISMODULE_KEYTYPE_EMPTY) {
+        if (RedisModule_ModuleTypeGetType(destKey) != HDRType) {
+            RedisModule_CloseKey(destKey);
+            return RedisModule_ReplyWithError(ctx, REDISMODULE_ERRORMSG_WRONGTYPE);
+        }
+        dest = RedisModule_ModuleTypeGetValue(destKey);
+    }
+    RedisModule_CloseKey(destKey);
+
+    const HDRHistogram **sources = RedisModule_Calloc(numkeys, sizeof *sources);
+    int64_t highest = 0;
+    for (long long i = 0; i < numkeys; i++) {
+        RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[3 + i], REDISMODULE_READ);
+        if (_HDR_KeyCheck(ctx, key) != REDISMODULE_OK) {
+            RedisModule_Free(sources);
+            return REDISMODULE_ERR;
+        }
+        sources[i] = RedisModule_ModuleTypeGetValue(key);
+        RedisModule_CloseKey(key);
+        if (sources[i]->highest > highest) {
+            highest = sources[i]->highest;
+        }
+    }
+    // an existing destination keeps its parameters
+    const HDRHistogram *model = dest && !override ? dest : sources[0];
+    if (model == dest) {
+        highest = dest->highest;
+    }
+    if (!HDR_CountersNeeded(highest, model->sigfigs)) {
+        RedisModule_Free(sources);
+        return RedisModule_ReplyWithError(
+            ctx, "ERR HDR: highest and sigfigs need too many counters");
+    }
+
+    // the merge is built aside, so the destination is left as it was on failure even when it is
+    // also a source
+    HDRHistogram *merged = HDR_Create(highest, model->sigfigs);
+    int res = merged ? 0 : -3;
+    if (res == 0 && dest && !override) {
+        res = HDR_Merge(merged, dest);
+    }
+    for (long long i = 0; i < numkeys && res == 0; i++) {
+        res = HDR_Merge(merged, sources[i]);
+    }
+    RedisModule_Free(sources);
+    if (res != 0) {
+        if (merged) {
+            HDR_Destroy(merged);
+        }
+        return RedisModule_ReplyWithError(
+            ctx, res == -1   ? "ERR HDR: overflow detected"
+                 : res == -2 ? "ERR HDR: value exceeds the highest trackable value"
+                             : "ERR HDR: allocation failed");
+    }
+
+    destKey = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ | REDISMODULE_WRITE);
+    RedisModule_ModuleTypeSetValue(destKey, HDRType, merged);
+    RedisModule_CloseKey(destKey);
+    RedisModule_ReplicateVerbatim(ctx);
+    return RedisModule_ReplyWithSimpleString(ctx, "OK");
+}
+
+static int _HDR_ExtremeCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
+                               bool max) {
+    if (argc != 2) {
+        return RedisModule_WrongArity(ctx);
+    }
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
+    if (_HDR_KeyCheck(ctx, key) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+    }
+    const HDRHistogram *h = RedisModule_ModuleTypeGetValue(key);
+    RedisModule_ReplyWithDouble(ctx, HDR_Quantile(h, max ? 1 : 0));
+    RedisModule_CloseKey(key);
+    return REDISMODULE_OK;
+}
+
+/**
+ * Command: HDR.MIN {key}
+ *
+ * Returns the smallest value added to the histogram, or nan if it is empty.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int HDR_MinCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    return _HDR_ExtremeCommand(ctx, argv, argc, false);
+}
+
+/**
+ * Command: HDR.MAX {key}
+ *
+ * Returns the largest value added to the histogram, or nan if it is empty.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int HDR_MaxCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    return _HDR_ExtremeCommand(ctx, argv, argc, true);
+}
+
+/**
+ * Command: HDR.QUANTILE {key} {quantile} [{quantile} ...]
+ *
+ * Returns, for each quantile, the highest value counted with the value at that quantile, within
+ * the significant figures of the histogram.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int HDR_QuantileCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc < 3) {
+        return RedisModule_WrongArity(ctx);
+    }
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
+    if (_HDR_KeyCheck(ctx, key) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+    }
+    const HDRHistogram *h = RedisModule_ModuleTypeGetValue(key);
+    const size_t n_quantiles = argc - 2;
+    double *quantiles = RedisModule_Alloc(n_quantiles * sizeof *quantiles);
+    for (size_t i = 0; i < n_quantiles; i++) {
+        if (RedisModule_StringToDouble(argv[2 + i], &quantiles[i]) != REDISMODULE_OK) {
+            RedisModule_CloseKey(key);
+            RedisModule_Free(quantiles);
+            return RedisModule_ReplyWithError(ctx, "ERR HDR: error parsing quantile");
+        }
+        if (!(quantiles[i] >= 0 && quantiles[i] <= 1)) {
+            RedisModule_CloseKey(key);
+            RedisModule_Free(quantiles);
+            return RedisModule_ReplyWithError(ctx, "ERR HDR: quantile should be in [0,1]");
+        }
+    }
+    RedisModule_ReplyWithArray(ctx, n_quantiles);
+    for (size_t i = 0; i < n_quantiles; i++) {
+        RedisModule_ReplyWithDouble(ctx, HDR_Quantile(h, quantiles[i]));
+    }
+    RedisModule_CloseKey(key);
+    RedisModule_Free(quantiles);
+    return REDISMODULE_OK;
+}
+
+/**
+ * Command: HDR.CDF {key} {value} [{value} ...]
+ *
+ * Returns, for each value, the fraction of the observations counted up to the counter of that
+ * value.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int HDR_CdfCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc < 3) {
+        return RedisModule_WrongArity(ctx);
+    }
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
+    if (_HDR_KeyCheck(ctx, key) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+    }
+    const HDRHistogram *h = RedisModule_ModuleTypeGetValue(key);
+    const size_t n_values = argc - 2;
+    double *values = RedisModule_Alloc(n_values * sizeof *values);
+    for (size_t i = 0; i < n_values; i++) {
+        if (RedisModule_StringToDouble(argv[2 + i], &values[i]) != REDISMODULE_OK ||
+            isnan(values[i])) {
+            RedisModule_CloseKey(key);
+            RedisModule_Free(values);
+            return RedisModule_ReplyWithError(ctx, "ERR HDR: error parsing value");
+        }
+    }
+    RedisModule_ReplyWithArray(ctx, n_values);
+    for (size_t i = 0; i < n_values; i++) {
+        RedisModule_ReplyWithDouble(ctx, HDR_Cdf(h, values[i]));
+    }
+    RedisModule_CloseKey(key);
+    RedisModule_Free(values);
+    return REDISMODULE_OK;
+}
+
+/**
+ * Command: HDR.BUCKETS {key} [WITHCOUNTS]
+ *
+ * Returns the highest value counted by each non-empty counter of the histogram, in increasing
+ * order. With WITHCOUNTS, each value is followed by the number of observations of its counter.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int HDR_BucketsCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc < 2 || argc > 3) {
+        return RedisModule_WrongArity(ctx);
+    }
+    bool with_counts = false;
+    if (argc == 3) {
+        if (RMUtil_ArgIndex("WITHCOUNTS", argv + 2, 1) != 0) {
+            return RedisModule_ReplyWithError(ctx, "ERR HDR: wrong keyword");
+        }
+        with_counts = true;
+    }
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
+    if (_HDR_KeyCheck(ctx, key) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+    }
+    const HDRHistogram *h = RedisModule_ModuleTypeGetValue(key);
+    const size_t used = HDR_CountersUsed(h);
+    RedisModule_ReplyWithArray(ctx, with_counts ? used * 2 : used);
+    for (uint32_t i = 0; i < h->countsLen; i++) {
+        if (!h->counts[i]) {
+            continue;
+        }
+        RedisModule_ReplyWithLongLong(ctx,
+                                      HDR_HighestEquivalentValue(h, HDR_ValueAtIndex(h, i)));
+        if (with_counts) {
+            RedisModule_ReplyWithLongLong(ctx, h->counts[i]);
+        }
+    }
+    RedisModule_CloseKey(key);
+    return REDISMODULE_OK;
+}
+
+size_t HDRMemUsage(const void *value) {
+    const HDRHistogram *h = value;
+    return sizeof *h + h->countsLen * sizeof *h->counts;
+}
+
+/**
+ * Command: HDR.INFO {key}
+ *
+ * Returns the highest trackable value, the significant figures, the number of counters, the
+ * number of observations and the memory usage of the histogram.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int HDR_InfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc != 2) {
+        return RedisModule_WrongArity(ctx);
+    }
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
+    if (_HDR_KeyCheck(ctx, key) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+    }
+    const HDRHistogram *h = RedisModule_ModuleTypeGetValue(key);
+    RedisModule_ReplyWithMapOrArray(ctx, 5 * 2, true);
+    RedisModule_ReplyWithSimpleString(ctx, "Highest trackable value");
+    RedisModule_ReplyWithLongLong(ctx, h->highest);
+    RedisModule_ReplyWithSimpleString(ctx, "Significant figures");
+    RedisModule_ReplyWithLongLong(ctx, h->sigfigs);
+    RedisModule_ReplyWithSimpleString(ctx, "Counters");
+    RedisModule_ReplyWithLongLong(ctx, h->countsLen);
+    RedisModule_ReplyWithSimpleString(ctx, "Observations");
+    RedisModule_ReplyWithLongLong(ctx, h->totalCount);
+    RedisModule_ReplyWithSimpleString(ctx, "Memory usage");
+    RedisModule_ReplyWithLongLong(ctx, HDRMemUsage(h));
+    RedisModule_CloseKey(key);
+    return REDISMODULE_OK;
+}
+
+// Writes 'value' as a little-endian base 128 varint, and returns the number of bytes written.
+static size_t _HDR_PutVarint(uint8_t *buf, uint64_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        buf[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    buf[n++] = (uint8_t)value;
+    return n;
+}
+
+static bool _HDR_GetVarint(const uint8_t *buf, size_t len, size_t *pos, uint64_t *value) {
+    *value = 0;
+    for (uint32_t shift = 0; shift < 64 && *pos < len; shift += 7) {
+        const uint8_t byte = buf[(*pos)++];
+        *value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*  The counters are saved sparsely, as pairs of the number of empty counters skipped and the
+    count of the next non-empty one, so that the size follows the counters in use rather than
+    the range of the histogram. */
+void HDRRdbSave(RedisModuleIO *rdb, void *value) {
+    const HDRHistogram *h = value;
+    RedisModule_SaveSigned(rdb, h->highest);
+    RedisModule_SaveUnsigned(rdb, h->sigfigs);
+    RedisModule_SaveUnsigned(rdb, h->totalCount);
+    RedisModule_SaveUnsigned(rdb, h->min);
+    RedisModule_SaveUnsigned(rdb, h->max);
+
+    // a varint takes at most 10 bytes
+    uint8_t *buf = RedisModule_Alloc(HDR_CountersUsed(h) * 2 * 10 + 1);
+    size_t len = 0;
+    uint32_t next = 0;
+    for (uint32_t i = 0; i < h->countsLen; i++) {
+        if (h->counts[i]) {
+            len += _HDR_PutVarint(buf + len, i - next);
+            len += _HDR_PutVarint(buf + len, h->counts[i]);
+            next = i + 1;
+        }
+    }
+    RedisModule_SaveStringBuffer(rdb, (const char *)buf, len);
+    RedisModule_Free(buf);
+}
+
+static int _HDR_LoadCounts(HDRHistogram *h, const uint8_t *buf, size_t len) {
+    size_t pos = 0;
+    uint64_t index = 0, total = 0;
+    while (pos < len) {
+        uint64_t skipped, count;
+        if (!_HDR_GetVarint(buf, len, &pos, &skipped) || !_HDR_GetVarint(buf, len, &pos, &count) ||
+            skipped >= h->countsLen - index || count == 0 || total > UINT64_MAX - count) {
+            return REDISMODULE_ERR;
+        }
+        index += skipped;
+        h->counts[index++] = count;
+        total += count;
+    }
+    return total == h->totalCount ? REDISMODULE_OK : REDISMODULE_ERR;
+}
+
+void HDRFree(void *value) { HDR_Destroy(value); }
+
+void *HDRRdbLoad(RedisModuleIO *rdb, int encver) {
+    if (encver > HDR_ENC_VER) {
+        return NULL;
+    }
+    bool err = false;
+    const int64_t highest = LoadSigned_IOError(rdb, err, NULL);
+    const uint64_t sigfigs = LoadUnsigned_IOError(rdb, err, NULL);
+    if (sigfigs > HDR_MAX_SIGFIGS || !HDR_CountersNeeded(highest, sigfigs)) {
+        return NULL;
+    }
+    HDRHistogram *h = HDR_Create(highest, sigfigs);
+    if (!h) {
+        return NULL;
+    }
+    errdefer(err, HDR_Destroy(h));
+    h->totalCount = LoadUnsigned_IOError(rdb, err, NULL);
+    h->min = LoadUnsigned_IOError(rdb, err, NULL);
+    h->max = LoadUnsigned_IOError(rdb, err, NULL);
+    if (h->totalCount && (h->min > h->max || h->max > (uint64_t)highest)) {
+        err = true;
+        return NULL;
+    }
+    size_t len = 0;
+    char *buf = LoadStringBuffer_IOError(rdb, &len, err, NULL);
+    const int res = _HDR_LoadCounts(h, (const uint8_t *)buf, len);
+    RedisModule_Free(buf);
+    if (res != REDISMODULE_OK) {
+        err = true;
+        return NULL;
+    }
+    if (!h->totalCount) {
+        h->min = UINT64_MAX;
+        h->max = 0;
+    }
+    return h;
+}
+
+static int HDRDefrag(RedisModuleDefragCtx *ctx, RedisModuleString *key, void **value) {
+    *value = defragPtr(ctx, *value);
+    HDRHistogram *h = *value;
+    h->counts = defragPtr(ctx, h->counts);
+    return 0;
+}
+
+int HDRModule_onLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    RedisModuleTypeMethods tm = {
+        .version = REDISMODULE_TYPE_METHOD_VERSION,
+        .rdb_load = HDRRdbLoad,
+        .rdb_save = HDRRdbSave,
+        .aof_rewrite = RMUtil_DefaultAofRewrite,
+        .mem_usage = HDRMemUsage,
+        .free = HDRFree,
+        .defrag = HDRDefrag,
+    };
+
+    HDRType = RedisModule_CreateDataType(ctx, "HDRh-TYPE", HDR_ENC_VER, &tm);
+    if (HDRType == NULL) {
+        return REDISMODULE_ERR;
+    }
+
+#define RegisterCommand(ctx, name, cmd, mode, acl)                                                 \
+    RegisterCommandWithModesAndAcls(ctx, name, cmd, mode, acl " hdr")
+
+    RegisterAclCategory(ctx, "hdr");
+    RegisterCommand(ctx, "hdr.create", HDR_CreateCommand, "write deny-oom", "write fast");
+    RegisterCommand(ctx, "hdr.add", HDR_AddCommand, "write deny-oom", "write");
+    RegisterCommand(ctx, "hdr.reset", HDR_ResetCommand, "write deny-oom", "write fast");
+    RegisterCommand(ctx, "hdr.merge", HDR_MergeCommand, "write deny-oom", "write");
+    RegisterCommand(ctx, "hdr.min", HDR_MinCommand, "readonly", "read fast");
+    RegisterCommand(ctx, "hdr.max", HDR_MaxCommand, "readonly", "read fast");
+    RegisterCommand(ctx, "hdr.quantile", HDR_QuantileCommand, "readonly", "read fast");
+    RegisterCommand(ctx, "hdr.cdf", HDR_CdfCommand, "readonly", "read fast");
+    RegisterCommand(ctx, "hdr.buckets", HDR_BucketsCommand, "readonly", "read");
+    RegisterCommand(ctx, "hdr.info", HDR_InfoCommand, "readonly", "read fast");
+
+#undef RegisterCommand
+
+    if (RegisterHDRCommandInfos(ctx) != REDISMODULE_OK)
+        return REDISMODULE_ERR;
+
+    return REDISMODULE_OK;
+}
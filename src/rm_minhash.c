@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#include "minhash.h"
+#include "rm_minhash.h"
+#include "rm_cms.h"
+
+#include "rmutil/util.h"
+#include "version.h"
+#include "common.h"
+#include "cmd_info/command_info.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "load_io_error.h"
+
+RedisModuleType *MHType;
+
+static int _MH_KeyCheck(RedisModuleCtx *ctx, RedisModuleKey *key) {
+    if (RedisModule_KeyType(key) == REDISMODULE_KEYTYPE_EMPTY) {
+        RedisModule_CloseKey(key);
+        RedisModule_ReplyWithError(ctx, "ERR MH: key does not exist");
+        return REDISMODULE_ERR;
+    } else if (RedisModule_ModuleTypeGetType(key) != MHType) {
+        RedisModule_CloseKey(key);
+        RedisModule_ReplyWithError(ctx, REDISMODULE_ERRORMSG_WRONGTYPE);
+        return REDISMODULE_ERR;
+    }
+    return REDISMODULE_OK;
+}
+
+/**
+ * Command: MH.ADD {key} {item} [{item} ...]
+ *
+ * Adds one or more items to the MinHash sketch, which is created if it does not exist.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int MH_AddCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc < 3) {
+        return RedisModule_WrongArity(ctx);
+    }
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ | REDISMODULE_WRITE);
+    MinHash *mh;
+    if (RedisModule_KeyType(key) == REDISMODULE_KEYTYPE_EMPTY) {
+        mh = MH_New();
+        RedisModule_ModuleTypeSetValue(key, MHType, mh);
+    } else if (_MH_KeyCheck(ctx, key) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+    } else {
+        mh = RedisModule_ModuleTypeGetValue(key);
+    }
+
+    for (int i = 2; i < argc; i++) {
+        size_t len;
+        const char *item = RedisModule_StringPtrLen(argv[i], &len);
+        MH_Add(mh, MH_Hash(item, len));
+    }
+    RedisModule_CloseKey(key);
+    RedisModule_ReplicateVerbatim(ctx);
+    return RedisModule_ReplyWithSimpleString(ctx, "OK");
+}
+
+/**
+ * Command: MH.SIMILARITY {key} {other} [{other} ...]
+ *
+ * Returns the estimated Jaccard similarity of the set of the sketch with those of each of the
+ * other sketches, as an array in their order. The similarity with an empty set is 0.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int MH_SimilarityCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc < 3) {
+        return RedisModule_WrongArity(ctx);
+    }
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
+    if (_MH_KeyCheck(ctx, key) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+    }
+    const MinHash *mh = RedisModule_ModuleTypeGetValue(key);
+
+    // all keys are checked before replying, so that an error is the only reply
+    double *similarities = RedisModule_Calloc(argc - 2, sizeof *similarities);
+    for (int i = 2; i < argc; i++) {
+        RedisModuleKey *other = RedisModule_OpenKey(ctx, argv[i], REDISMODULE_READ);
+        if (_MH_KeyCheck(ctx, other) != REDISMODULE_OK) {
+            RedisModule_Free(similarities);
+            RedisModule_CloseKey(key);
+            return REDISMODULE_ERR;
+        }
+        similarities[i - 2] = MH_Similarity(mh, RedisModule_ModuleTypeGetValue(other));
+        RedisModule_CloseKey(other);
+    }
+    RedisModule_CloseKey(key);
+
+    RedisModule_ReplyWithArray(ctx, argc - 2);
+    for (int i = 0; i < argc - 2; i++) {
+        RedisModule_ReplyWithDouble(ctx, similarities[i]);
+    }
+    RedisModule_Free(similarities);
+    return REDISMODULE_OK;
+}
+
+size_t MHMemUsage(const void *value) { return sizeof(MinHash); }
+
+/**
+ * Command: MH.INFO {key}
+ *
+ * Returns the number of lanes of the signature, the memory usage, and the number of items added
+ * to the sketch.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int MH_InfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc != 2) {
+        return RedisModule_WrongArity(ctx);
+    }
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
+    if (_MH_KeyCheck(ctx, key) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+    }
+    const MinHash *mh = RedisModule_ModuleTypeGetValue(key);
+    RedisModule_ReplyWithMapOrArray(ctx, 3 * 2, true);
+    RedisModule_ReplyWithSimpleString(ctx, "Lanes");
+    RedisModule_ReplyWithLongLong(ctx, MH_LANES);
+    RedisModule_ReplyWithSimpleString(ctx, "Size");
+    RedisModule_ReplyWithLongLong(ctx, MHMemUsage(mh));
+    RedisModule_ReplyWithSimpleString(ctx, "Number of items inserted");
+    RedisModule_ReplyWithLongLong(ctx, mh->size);
+    RedisModule_CloseKey(key);
+    return REDISMODULE_OK;
+}
+
+void MHRdbSave(RedisModuleIO *rdb, void *value) {
+    const MinHash *mh = value;
+    RedisModule_SaveUnsigned(rdb, mh->size);
+    RedisModule_SaveStringBuffer(rdb, (const char *)mh->signature, sizeof mh->signature);
+}
+
+void MHFree(void *value) { MH_Free(value); }
+
+void *MHRdbLoad(RedisModuleIO *rdb, int encver) {
+    if (encver > MH_ENC_VER) {
+        return NULL;
+    }
+    MinHash *mh = MH_New();
+    bool err = false;
+    errdefer(err, MH_Free(mh));
+    mh->size = LoadUnsigned_IOError(rdb, err, NULL);
+    size_t len;
+    char *signature = LoadStringBuffer_IOError(rdb, &len, err, NULL);
+    if (len != sizeof mh->signature) {
+        RedisModule_Free(signature);
+        err = true;
+        return NULL;
+    }
+    memcpy(mh->signature, signature, len);
+    RedisModule_Free(signature);
+    return mh;
+}
+
+static int MHDefrag(RedisModuleDefragCtx *ctx, RedisModuleString *key, void **value) {
+    *value = defragPtr(ctx, *value);
+    return 0;
+}
+
+int MHModule_onLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    RedisModuleTypeMethods tm = {
+        .version = REDISMODULE_TYPE_METHOD_VERSION,
+        .rdb_load = MHRdbLoad,
+        .rdb_save = MHRdbSave,
+        .aof_rewrite = RMUtil_DefaultAofRewrite,
+        .mem_usage = MHMemUsage,
+        .free = MHFree,
+        .defrag = MHDefrag,
+    };
+
+    MHType = RedisModule_CreateDataType(ctx, "MBbloomMH", MH_ENC_VER, &tm);
+    if (MHType == NULL) {
+        return REDISMODULE_ERR;
+    }
+
+#define RegisterCommand(ctx, name, cmd, mode, acl)                                                 \
+    RegisterCommandWithModesAndAcls(ctx, name, cmd, mode, acl " mh")
+
+    RegisterAclCategory(ctx, "mh");
+    RegisterCommand(ctx, "mh.add", MH_AddCommand, "write deny-oom", "write");
+    RegisterCommand(ctx, "mh.similarity", MH_SimilarityCommand, "readonly", "read");
+    RegisterCommand(ctx, "mh.info", MH_InfoCommand, "readonly", "read fast");
+
+#undef RegisterCommand
+
+    if (RegisterMHCommandInfos(ctx) != REDISMODULE_OK)
+        return REDISMODULE_ERR;
+
+    return REDISMODULE_OK;
+}
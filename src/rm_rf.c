@@ -0,0 +1,466 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#include "rf.h"
+#include "rm_rf.h"
+#include "rm_cms.h"
+
+#include "rmutil/util.h"
+#include "version.h"
+#include "common.h"
+#include "config.h"
+#include "cmd_info/command_info.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "load_io_error.h"
+
+#define RF_MAX_SCANDUMP_SIZE (1024 * 1024 * 16)
+
+RedisModuleType *RFType;
+
+static int _RF_KeyCheck(RedisModuleCtx *ctx, RedisModuleKey *key) {
+    if (RedisModule_KeyType(key) == REDISMODULE_KEYTYPE_EMPTY) {
+        RedisModule_CloseKey(key);
+        RedisModule_ReplyWithError(ctx, "ERR RF: key does not exist");
+        return REDISMODULE_ERR;
+    } else if (RedisModule_ModuleTypeGetType(key) != RFType) {
+        RedisModule_CloseKey(key);
+        RedisModule_ReplyWithError(ctx, REDISMODULE_ERRORMSG_WRONGTYPE);
+        return REDISMODULE_ERR;
+    }
+    return REDISMODULE_OK;
+}
+
+static void _RF_ReplyWithBool(RedisModuleCtx *ctx, int value) {
+    if (_is_resp3(ctx)) {
+        RedisModule_ReplyWithBool(ctx, value);
+    } else {
+        RedisModule_ReplyWithLongLong(ctx, value);
+    }
+}
+
+// Parses an unsigned 64-bit key, which is beyond the range of RedisModule_StringToLongLong
+static int _RF_ParseKey(RedisModuleString *str, uint64_t *value) {
+    size_t len;
+    const char *s = RedisModule_StringPtrLen(str, &len);
+    if (len == 0 || len > 20) {
+        return REDISMODULE_ERR;
+    }
+    uint64_t v = 0;
+    for (size_t i = 0; i < len; i++) {
+        const uint64_t digit = s[i] - '0';
+        if (digit > 9 || v > (UINT64_MAX - digit) / 10) {
+            return REDISMODULE_ERR;
+        }
+        v = v * 10 + digit;
+    }
+    *value = v;
+    return REDISMODULE_OK;
+}
+
+/**
+ * Command: RF.RESERVE {key} {error_rate} {capacity} [LEVELS {levels}]
+ *
+ * Creates an empty range filter of 'capacity' keys at 'error_rate', that answers ranges of up to
+ * 2^levels keys with a few probes each. Longer ranges are split into more probes. Defaults to
+ * 16 levels. Its memory grows with the number of levels, and it does not scale.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int RF_ReserveCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc != 4 && argc != 6) {
+        return RedisModule_WrongArity(ctx);
+    }
+    double error_rate;
+    if (RedisModule_StringToDouble(argv[2], &error_rate) != REDISMODULE_OK) {
+        return RedisModule_ReplyWithError(ctx, "ERR RF: bad error rate");
+    } else if (!isConfigValid(error_rate, rm_config.bf_error_rate)) {
+        return RedisModule_ReplyWithErrorFormat(
+            ctx, "ERR RF: error rate must be in the range (%f, %f)", rm_config.bf_error_rate.min,
+            rm_config.bf_error_rate.max);
+    }
+    long long capacity;
+    if (RedisModule_StringToLongLong(argv[3], &capacity) != REDISMODULE_OK) {
+        return RedisModule_ReplyWithError(ctx, "ERR RF: bad capacity");
+    } else if (!isConfigValid(capacity, rm_config.bf_initial_size)) {
+        return RedisModule_ReplyWithErrorFormat(
+            ctx, "ERR RF: capacity must be in the range [%lld, %lld]",
+            rm_config.bf_initial_size.min, rm_config.bf_initial_size.max);
+    }
+    long long levels = RF_DEFAULT_LEVELS;
+    if (argc == 6) {
+        if (RMUtil_ArgIndex("LEVELS", argv + 4, 1) != 0) {
+            return RedisModule_ReplyWithError(ctx, "ERR RF: wrong keyword");
+        } else if (RedisModule_StringToLongLong(argv[5], &levels) != REDISMODULE_OK ||
+                   levels < 1 || levels > RF_MAX_LEVELS) {
+            return RedisModule_ReplyWithErrorFormat(
+                ctx, "ERR RF: levels must be in the range [1, %d]", RF_MAX_LEVELS);
+        }
+    }
+
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ | REDISMODULE_WRITE);
+    if (RedisModule_KeyType(key) != REDISMODULE_KEYTYPE_EMPTY) {
+        RedisModule_CloseKey(key);
+        return RedisModule_ReplyWithError(ctx, "ERR RF: key already exists");
+    }
+    RangeFilter *rf = RF_Create(capacity, error_rate, levels);
+    if (!rf) {
+        RedisModule_CloseKey(key);
+        return RedisModule_ReplyWithError(ctx, "ERR RF: Insufficient memory to create filter");
+    }
+    RedisModule_ModuleTypeSetValue(key, RFType, rf);
+    RedisModule_CloseKey(key);
+    RedisModule_ReplicateVerbatim(ctx);
+    return RedisModule_ReplyWithSimpleString(ctx, "OK");
+}
+
+/**
+ * Command: RF.ADD {key} {value} [{value} ...]
+ *
+ * Adds one or more unsigned 64-bit keys to the filter, which is created with the default error
+ * rate and capacity of the Bloom filters, and 16 levels, if it does not exist.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int RF_AddCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc < 3) {
+        return RedisModule_WrongArity(ctx);
+    }
+    // all values are parsed first, so that none is added if one is invalid
+    uint64_t *values = RedisModule_Calloc(argc - 2, sizeof *values);
+    for (int i = 2; i < argc; i++) {
+        if (_RF_ParseKey(argv[i], &values[i - 2]) != REDISMODULE_OK) {
+            RedisModule_Free(values);
+            return RedisModule_ReplyWithError(ctx, "ERR RF: value is not an unsigned integer");
+        }
+    }
+
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ | REDISMODULE_WRITE);
+    RangeFilter *rf;
+    if (RedisModule_KeyType(key) == REDISMODULE_KEYTYPE_EMPTY) {
+        rf = RF_Create(rm_config.bf_initial_size.value, rm_config.bf_error_rate.value,
+                       RF_DEFAULT_LEVELS);
+        if (!rf) {
+            RedisModule_Free(values);
+            RedisModule_CloseKey(key);
+            return RedisModule_ReplyWithError(ctx, "ERR RF: Insufficient memory to create filter");
+        }
+        RedisModule_ModuleTypeSetValue(key, RFType, rf);
+    } else if (_RF_KeyCheck(ctx, key) != REDISMODULE_OK) {
+        RedisModule_Free(values);
+        return REDISMODULE_ERR;
+    } else {
+        rf = RedisModule_ModuleTypeGetValue(key);
+    }
+
+    for (int i = 0; i < argc - 2; i++) {
+        RF_Add(rf, values[i]);
+    }
+    RedisModule_Free(values);
+    RedisModule_CloseKey(key);
+    RedisModule_ReplicateVerbatim(ctx);
+    return RedisModule_ReplyWithSimpleString(ctx, "OK");
+}
+
+// Returns the filter of a key for a query, or NULL if the key does not exist, in which case it
+// is empty. Replies with an error and sets 'err' if the key is of another type.
+static const RangeFilter *_RF_GetForQuery(RedisModuleCtx *ctx, RedisModuleKey *key, int *err) {
+    *err = 0;
+    if (RedisModule_KeyType(key) == REDISMODULE_KEYTYPE_EMPTY) {
+        return NULL;
+    } else if (_RF_KeyCheck(ctx, key) != REDISMODULE_OK) {
+        *err = 1;
+        return NULL;
+    }
+    return RedisModule_ModuleTypeGetValue(key);
+}
+
+/**
+ * Command: RF.EXISTS {key} {value}
+ *
+ * Returns 1 if the key may be in the filter, 0 if it is not or the filter does not exist.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int RF_ExistsCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc != 3) {
+        return RedisModule_WrongArity(ctx);
+    }
+    uint64_t value;
+    if (_RF_ParseKey(argv[2], &value) != REDISMODULE_OK) {
+        return RedisModule_ReplyWithError(ctx, "ERR RF: value is not an unsigned integer");
+    }
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
+    int err;
+    const RangeFilter *rf = _RF_GetForQuery(ctx, key, &err);
+    if (err) {
+        return REDISMODULE_ERR;
+    }
+    _RF_ReplyWithBool(ctx, rf && RF_Check(rf, value));
+    RedisModule_CloseKey(key);
+    return REDISMODULE_OK;
+}
+
+/**
+ * Command: RF.RANGE {key} {lo} {hi}
+ *
+ * Returns 1 if a key in [lo, hi] may be in the filter, 0 if none is or the filter does not exist.
+ * A range is probed in at most 256 intervals of up to 2^levels keys, and past those it may hold
+ * a key.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int RF_RangeCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc != 4) {
+        return RedisModule_WrongArity(ctx);
+    }
+    uint64_t lo, hi;
+    if (_RF_ParseKey(argv[2], &lo) != REDISMODULE_OK ||
+        _RF_ParseKey(argv[3], &hi) != REDISMODULE_OK) {
+        return RedisModule_ReplyWithError(ctx, "ERR RF: value is not an unsigned integer");
+    } else if (lo > hi) {
+        return RedisModule_ReplyWithError(ctx, "ERR RF: lo must not be greater than hi");
+    }
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
+    int err;
+    const RangeFilter *rf = _RF_GetForQuery(ctx, key, &err);
+    if (err) {
+        return REDISMODULE_ERR;
+    }
+    _RF_ReplyWithBool(ctx, rf && RF_Range(rf, lo, hi));
+    RedisModule_CloseKey(key);
+    return REDISMODULE_OK;
+}
+
+size_t RFMemUsage(const void *value) {
+    const RangeFilter *rf = value;
+    return sizeof *rf + RF_Bytes(rf);
+}
+
+/**
+ * Command: RF.INFO {key}
+ *
+ * Returns the capacity, the memory usage, the number of levels and the longest range they cover,
+ * the number of hash functions, and the number of keys added to the filter.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int RF_InfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc != 2) {
+        return RedisModule_WrongArity(ctx);
+    }
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
+    if (_RF_KeyCheck(ctx, key) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+    }
+    const RangeFilter *rf = RedisModule_ModuleTypeGetValue(key);
+    RedisModule_ReplyWithMapOrArray(ctx, 6 * 2, true);
+    RedisModule_ReplyWithSimpleString(ctx, "Capacity");
+    RedisModule_ReplyWithLongLong(ctx, rf->capacity);
+    RedisModule_ReplyWithSimpleString(ctx, "Size");
+    RedisModule_ReplyWithLongLong(ctx, RFMemUsage(rf));
+    RedisModule_ReplyWithSimpleString(ctx, "Levels");
+    RedisModule_ReplyWithLongLong(ctx, rf->levels);
+    RedisModule_ReplyWithSimpleString(ctx, "Max range");
+    RedisModule_ReplyWithLongLong(ctx, (long long)1 << rf->levels);
+    RedisModule_ReplyWithSimpleString(ctx, "Hash functions");
+    RedisModule_ReplyWithLongLong(ctx, rf->hashes);
+    RedisModule_ReplyWithSimpleString(ctx, "Number of items inserted");
+    RedisModule_ReplyWithLongLong(ctx, rf->size);
+    RedisModule_CloseKey(key);
+    return REDISMODULE_OK;
+}
+
+/**
+ * Command: RF.SCANDUMP {key} {iterator}
+ *
+ * Returns an (iterator, data) pair to be passed to RF.LOADCHUNK, starting with an iterator of 0.
+ * The first pair holds the parameters of the filter, and the next ones its blocks. The last pair
+ * has an iterator of 0 and no data.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int RF_ScanDumpCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc != 3) {
+        return RedisModule_WrongArity(ctx);
+    }
+    long long iter;
+    if (RedisModule_StringToLongLong(argv[2], &iter) != REDISMODULE_OK || iter < 0) {
+        return RedisModule_ReplyWithError(ctx, "ERR RF: invalid iterator");
+    }
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
+    if (_RF_KeyCheck(ctx, key) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+    }
+    const RangeFilter *rf = RedisModule_ModuleTypeGetValue(key);
+
+    RedisModule_ReplyWithArray(ctx, 2);
+    if (iter == 0) {
+        size_t hdrlen;
+        char *hdr = RF_GetEncodedHeader(rf, &hdrlen);
+        RedisModule_ReplyWithLongLong(ctx, 1);
+        RedisModule_ReplyWithStringBuffer(ctx, hdr, hdrlen);
+        RF_FreeEncodedHeader(hdr);
+    } else {
+        size_t len = 0;
+        const char *chunk = RF_GetEncodedChunk(rf, &iter, &len, RF_MAX_SCANDUMP_SIZE);
+        RedisModule_ReplyWithLongLong(ctx, iter);
+        RedisModule_ReplyWithStringBuffer(ctx, chunk ? chunk : "", len);
+    }
+    RedisModule_CloseKey(key);
+    return REDISMODULE_OK;
+}
+
+/**
+ * Command: RF.LOADCHUNK {key} {iterator} {data}
+ *
+ * Restores a filter from the pairs of RF.SCANDUMP, in their order. The first one creates the
+ * filter, and the key must not exist.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int RF_LoadChunkCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc != 4) {
+        return RedisModule_WrongArity(ctx);
+    }
+    long long iter;
+    if (RedisModule_StringToLongLong(argv[2], &iter) != REDISMODULE_OK || iter < 1) {
+        return RedisModule_ReplyWithError(ctx, "ERR RF: invalid iterator");
+    }
+    size_t bufLen;
+    const char *buf = RedisModule_StringPtrLen(argv[3], &bufLen);
+    const char *errmsg;
+
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ | REDISMODULE_WRITE);
+    if (iter == 1 && RedisModule_KeyType(key) == REDISMODULE_KEYTYPE_EMPTY) {
+        RangeFilter *rf = RF_NewFromHeader(buf, bufLen, &errmsg);
+        if (!rf) {
+            RedisModule_CloseKey(key);
+            return RedisModule_ReplyWithError(ctx, errmsg);
+        }
+        RedisModule_ModuleTypeSetValue(key, RFType, rf);
+    } else if (_RF_KeyCheck(ctx, key) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+    } else if (RF_LoadEncodedChunk(RedisModule_ModuleTypeGetValue(key), iter, buf, bufLen,
+                                   &errmsg) != 0) {
+        RedisModule_CloseKey(key);
+        return RedisModule_ReplyWithError(ctx, errmsg);
+    }
+    RedisModule_CloseKey(key);
+    RedisModule_ReplicateVerbatim(ctx);
+    return RedisModule_ReplyWithSimpleString(ctx, "OK");
+}
+
+void RFRdbSave(RedisModuleIO *rdb, void *value) {
+    const RangeFilter *rf = value;
+    RedisModule_SaveUnsigned(rdb, rf->capacity);
+    RedisModule_SaveDouble(rdb, rf->error);
+    RedisModule_SaveUnsigned(rdb, rf->levels);
+    RedisModule_SaveUnsigned(rdb, rf->hashes);
+    RedisModule_SaveUnsigned(rdb, rf->n2);
+    RedisModule_SaveUnsigned(rdb, rf->size);
+    RedisModule_SaveStringBuffer(rdb, (const char *)rf->blocks, RF_Bytes(rf));
+}
+
+void RFFree(void *value) { RF_Destroy(value); }
+
+void *RFRdbLoad(RedisModuleIO *rdb, int encver) {
+    if (encver > RF_ENC_VER) {
+        return NULL;
+    }
+    RangeFilter *rf = RedisModule_Calloc(1, sizeof *rf);
+    bool err = false;
+    errdefer(err, RF_Destroy(rf));
+    rf->capacity = LoadUnsigned_IOError(rdb, err, NULL);
+    rf->error = LoadDouble_IOError(rdb, err, NULL);
+    const uint64_t levels = LoadUnsigned_IOError(rdb, err, NULL);
+    const uint64_t hashes = LoadUnsigned_IOError(rdb, err, NULL);
+    const uint64_t n2 = LoadUnsigned_IOError(rdb, err, NULL);
+    rf->size = LoadUnsigned_IOError(rdb, err, NULL);
+    size_t bytes;
+    rf->blocks = (uint64_t *)LoadStringBuffer_IOError(rdb, &bytes, err, NULL);
+    if (levels > RF_MAX_LEVELS || hashes > RF_MAX_HASHES || n2 > RF_MAX_N2) {
+        err = true;
+        return NULL;
+    }
+    rf->levels = levels;
+    rf->hashes = hashes;
+    rf->n2 = n2;
+    if (RF_ValidateLayout(rf, bytes) != 0) {
+        err = true;
+        return NULL;
+    }
+    return rf;
+}
+
+static int RFDefrag(RedisModuleDefragCtx *ctx, RedisModuleString *key, void **value) {
+    *value = defragPtr(ctx, *value);
+    RangeFilter *rf = *value;
+    rf->blocks = defragPtr(ctx, rf->blocks);
+    return 0;
+}
+
+int RFModule_onLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    RedisModuleTypeMethods tm = {
+        .version = REDISMODULE_TYPE_METHOD_VERSION,
+        .rdb_load = RFRdbLoad,
+        .rdb_save = RFRdbSave,
+        .aof_rewrite = RMUtil_DefaultAofRewrite,
+        .mem_usage = RFMemUsage,
+        .free = RFFree,
+        .defrag = RFDefrag,
+    };
+
+    RFType = RedisModule_CreateDataType(ctx, "MBbloomRF", RF_ENC_VER, &tm);
+    if (RFType == NULL) {
+        return REDISMODULE_ERR;
+    }
+
+#define RegisterCommand(ctx, name, cmd, mode, acl)                                                 \
+    RegisterCommandWithModesAndAcls(ctx, name, cmd, mode, acl " rf")
+
+    RegisterAclCategory(ctx, "rf");
+    RegisterCommand(ctx, "rf.reserve", RF_ReserveCommand, "write deny-oom", "write fast");
+    RegisterCommand(ctx, "rf.add", RF_AddCommand, "write deny-oom", "write");
+    RegisterCommand(ctx, "rf.exists", RF_ExistsCommand, "readonly", "read fast");
+    RegisterCommand(ctx, "rf.range", RF_RangeCommand, "readonly", "read fast");
+    RegisterCommand(ctx, "rf.info", RF_InfoCommand, "readonly", "read fast");
+    RegisterCommand(ctx, "rf.scandump", RF_ScanDumpCommand, "readonly fast", "read");
+    RegisterCommand(ctx, "rf.loadchunk", RF_LoadChunkCommand, "write deny-oom", "write");
+
+#undef RegisterCommand
+
+    if (RegisterRFCommandInfos(ctx) != REDISMODULE_OK)
+        return REDISMODULE_ERR;
+
+    return REDISMODULE_OK;
+}
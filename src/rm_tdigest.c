@@ -12,6 +12,7 @@
 #include "version.h"
 #include "rm_cms.h"
 #include "cmd_info/command_info.h"
+#include "config.h"
 
 #include "redismodule.h"
 #include "common.h"
@@ -20,6 +21,10 @@
 #include <stdlib.h>
 #include <strings.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+#include <string.h>
 
 // defining TD_ALLOC_H is used to change the t-digest allocator at compile time
 // The define should be placed before including "tdigest.h" for the first time
@@ -32,12 +37,380 @@
     RedisModule_TryRealloc ? RedisModule_TryRealloc(__VA_ARGS__) : RedisModule_Realloc(__VA_ARGS__)
 #define td_free_ RedisModule_Free
 #define TD_DEFAULT_COMPRESSION 100
+// TDIGEST.ADD calls with at least this many values go through TDigest_AddBatch
+#define TD_ADD_BATCH_MIN 64
+// initial number of samples an exact sketch has room for
+#define TD_EXACT_INITIAL_CAP 8
+// an exact sketch turns into a digest once it holds more than this many samples per unit of
+// compression
+#define TD_EXACT_MAX_FACTOR 2
 
 #include "tdigest.h"
 #include "load_io_error.h"
 
 RedisModuleType *TDigestSketchType;
 size_t TDigestMemUsage(const void *value);
+static int _TDigest_MergeInto(td_histogram_t *into, td_histogram_t *const *sources,
+                              size_t n_sources);
+
+/*
+ * The value stored under a t-digest key. The histogram itself belongs to the t-digest library, so
+ * state derived from it for faster queries is kept alongside.
+ */
+typedef struct {
+    td_histogram_t *td;
+    // 'td' holds the raw samples as unit centroids in node arrays sized to them, sorted but never
+    // merged, until there are too many of them and it is turned into a digest
+    bool exact;
+    // incremented on every write to 'td'
+    uint64_t generation;
+    // generation at which 'prefix' was computed
+    uint64_t prefixGeneration;
+    // prefix[i] is the total weight of the merged centroids before centroid i
+    double *prefix;
+    size_t prefixCap;
+    // Sliding window, only used when nBuckets is non-zero. Writes go to the bucket of the time slot
+    // they are made at and 'td' caches the merge of the buckets still inside the window.
+    td_histogram_t **buckets;
+    // time slot, in units of window / nBuckets milliseconds, each bucket currently holds
+    long long *bucketSlot;
+    long long nBuckets;
+    // window duration in milliseconds
+    long long window;
+    // time slot and generation at which 'td' was last merged from the buckets
+    long long viewSlot;
+    uint64_t viewGeneration;
+} TDigest;
+
+static TDigest *TDigest_Wrap(td_histogram_t *td) {
+    TDigest *sketch = td_calloc_(1, sizeof *sketch);
+    if (!sketch) {
+        return NULL;
+    }
+    sketch->td = td;
+    sketch->generation = 1;
+    return sketch;
+}
+
+static void TDigest_Free(TDigest *sketch) {
+    td_free(sketch->td);
+    if (sketch->prefix) {
+        td_free_(sketch->prefix);
+    }
+    if (sketch->buckets) {
+        for (long long i = 0; i < sketch->nBuckets; i++) {
+            if (sketch->buckets[i]) {
+                td_free(sketch->buckets[i]);
+            }
+        }
+        td_free_(sketch->buckets);
+    }
+    if (sketch->bucketSlot) {
+        td_free_(sketch->bucketSlot);
+    }
+    td_free_(sketch);
+}
+
+// Invalidates the cached query state. Must be called on every write to sketch->td.
+static inline void TDigest_Touch(TDigest *sketch) { sketch->generation++; }
+
+/**
+ * Turns 'sketch' into a sliding window digest of 'n_buckets' empty buckets covering the last
+ * 'window' milliseconds, each with the compression of sketch->td. The merge of the buckets is no
+ * more accurate than its coarsest input, so buckets of a lower compression would leave a window
+ * digest less accurate than a plain one of the same COMPRESSION.
+ * Returns 0 on success or ENOMEM, in which case the sketch must be freed.
+ */
+static int TDigest_InitWindow(TDigest *sketch, long long window, long long n_buckets) {
+    sketch->window = window;
+    sketch->nBuckets = n_buckets;
+    sketch->viewSlot = LLONG_MIN;
+    sketch->buckets = td_calloc_(n_buckets, sizeof *sketch->buckets);
+    sketch->bucketSlot = td_calloc_(n_buckets, sizeof *sketch->bucketSlot);
+    if (!sketch->buckets || !sketch->bucketSlot) {
+        return ENOMEM;
+    }
+    for (long long i = 0; i < n_buckets; i++) {
+        sketch->bucketSlot[i] = LLONG_MIN;
+        if (!(sketch->buckets[i] = td_new(sketch->td->compression))) {
+            return ENOMEM;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Allocates an empty exact histogram with room for 'cap' samples. It is laid out like any
+ * td_histogram_t, so the t-digest library can query it and td_free releases it, but samples
+ * must only be added with _TDigest_ExactAdd.
+ */
+static td_histogram_t *_TDigest_NewExact(double compression, int cap) {
+    td_histogram_t *h = td_calloc_(1, sizeof *h);
+    if (!h) {
+        return NULL;
+    }
+    h->nodes_mean = td_malloc_(cap * sizeof *h->nodes_mean);
+    h->nodes_weight = td_malloc_(cap * sizeof *h->nodes_weight);
+    if (!h->nodes_mean || !h->nodes_weight) {
+        if (h->nodes_mean) {
+            td_free_(h->nodes_mean);
+        }
+        if (h->nodes_weight) {
+            td_free_(h->nodes_weight);
+        }
+        td_free_(h);
+        return NULL;
+    }
+    h->compression = compression;
+    h->cap = cap;
+    td_reset(h);
+    return h;
+}
+
+// Samples are ordered by value, and those of equal value by weight, so that the order they are
+// stored in only depends on which samples were added.
+static inline bool _TDigest_NodeLess(const double *mean, const long long *weight, size_t a,
+                                     size_t b) {
+    return mean[a] < mean[b] || (mean[a] == mean[b] && weight[a] < weight[b]);
+}
+
+static void _TDigest_SwapNodes(double *mean, long long *weight, size_t a, size_t b) {
+    const double m = mean[a];
+    const long long w = weight[a];
+    mean[a] = mean[b];
+    weight[a] = weight[b];
+    mean[b] = m;
+    weight[b] = w;
+}
+
+static void _TDigest_SiftDown(double *mean, long long *weight, size_t i, size_t n) {
+    for (;;) {
+        size_t largest = i;
+        const size_t left = 2 * i + 1, right = 2 * i + 2;
+        if (left < n && _TDigest_NodeLess(mean, weight, largest, left)) {
+            largest = left;
+        }
+        if (right < n && _TDigest_NodeLess(mean, weight, largest, right)) {
+            largest = right;
+        }
+        if (largest == i) {
+            return;
+        }
+        _TDigest_SwapNodes(mean, weight, i, largest);
+        i = largest;
+    }
+}
+
+// Heap sorts 'n' samples in place.
+static void _TDigest_SortNodes(double *mean, long long *weight, size_t n) {
+    for (size_t i = n / 2; i-- > 0;) {
+        _TDigest_SiftDown(mean, weight, i, n);
+    }
+    for (size_t end = n; end-- > 1;) {
+        _TDigest_SwapNodes(mean, weight, 0, end);
+        _TDigest_SiftDown(mean, weight, 0, end);
+    }
+}
+
+/**
+ * Adds 'n' samples, of unit weight if 'weights' is NULL, to the exact histogram of 'sketch', in
+ * order with the others so that all of them stay merged nodes, which td_compress leaves alone.
+ * Returns 0 on success, EDOM if the total weight would overflow, ENOMEM, or ERANGE if the sketch
+ * would hold too many samples to stay exact, in which case nothing is added.
+ */
+static int _TDigest_ExactAdd(TDigest *sketch, const double *vals, const long long *weights,
+                             size_t n) {
+    td_histogram_t *h = sketch->td;
+    const long long nodes = h->merged_nodes;
+    if ((double)(nodes + n) > TD_EXACT_MAX_FACTOR * h->compression) {
+        return ERANGE;
+    }
+    long long added = 0;
+    const long long total = h->merged_weight;
+    for (size_t i = 0; i < n; i++) {
+        const long long weight = weights ? weights[i] : 1;
+        if (weight > LLONG_MAX - total - added) {
+            return EDOM;
+        }
+        added += weight;
+    }
+    if (nodes + (long long)n > h->cap) {
+        long long cap = 2 * (long long)h->cap;
+        cap = cap < nodes + (long long)n ? nodes + (long long)n : cap;
+        double *mean = td_realloc_(h->nodes_mean, cap * sizeof *mean);
+        if (!mean) {
+            return ENOMEM;
+        }
+        h->nodes_mean = mean;
+        long long *weight = td_realloc_(h->nodes_weight, cap * sizeof *weight);
+        if (!weight) {
+            return ENOMEM;
+        }
+        h->nodes_weight = weight;
+        h->cap = cap;
+    }
+    // the new samples are sorted on their own, then merged in from the back
+    double *mean = td_malloc_(n * sizeof *mean);
+    long long *weight = td_malloc_(n * sizeof *weight);
+    if (!mean || !weight) {
+        if (mean) {
+            td_free_(mean);
+        }
+        if (weight) {
+            td_free_(weight);
+        }
+        return ENOMEM;
+    }
+    for (size_t i = 0; i < n; i++) {
+        mean[i] = vals[i];
+        weight[i] = weights ? weights[i] : 1;
+        h->min = vals[i] < h->min ? vals[i] : h->min;
+        h->max = vals[i] > h->max ? vals[i] : h->max;
+    }
+    _TDigest_SortNodes(mean, weight, n);
+
+    TDigest_Touch(sketch);
+    long long i = nodes - 1, j = (long long)n - 1;
+    for (long long k = nodes + (long long)n - 1; j >= 0; k--) {
+        // whether the largest sample left is an old one
+        bool old = false;
+        if (i >= 0) {
+            const double m = h->nodes_mean[i];
+            old = m > mean[j] || (m == mean[j] && h->nodes_weight[i] > weight[j]);
+        }
+        h->nodes_mean[k] = old ? h->nodes_mean[i] : mean[j];
+        h->nodes_weight[k] = old ? h->nodes_weight[i--] : weight[j--];
+    }
+    td_free_(mean);
+    td_free_(weight);
+    h->merged_nodes += n;
+    h->merged_weight += added;
+    return 0;
+}
+
+/**
+ * Turns the exact histogram of 'sketch' into a digest of the same compression. The samples are
+ * added in their sorted order, so that the digest only depends on which samples were added, not on
+ * the order they arrived in.
+ * Returns 0 on success, or ENOMEM in which case the sketch is left exact.
+ */
+static int TDigest_ToDigest(TDigest *sketch) {
+    td_histogram_t *exact = sketch->td;
+    td_histogram_t *tdigest = NULL;
+    if (td_init(exact->compression, &tdigest) != 0) {
+        return ENOMEM;
+    }
+    for (int i = 0; i < exact->merged_nodes; i++) {
+        // the total weight was checked when the samples were added
+        td_add(tdigest, exact->nodes_mean[i], exact->nodes_weight[i]);
+    }
+    td_free(exact);
+    sketch->td = tdigest;
+    sketch->exact = false;
+    TDigest_Touch(sketch);
+    return 0;
+}
+
+// Returns the time slot of the Unix time 'now', in milliseconds.
+static inline long long TDigest_Slot(const TDigest *sketch, long long now) {
+    return now / (sketch->window / sketch->nBuckets);
+}
+
+/**
+ * Returns the histogram to add samples made at the Unix time 'now', in milliseconds, to. For a
+ * sliding window digest this is the bucket of that time slot, which is emptied first if it still
+ * holds an earlier slot. Returns NULL if the bucket already holds a later slot: that time left the
+ * window as of an earlier write, and its samples are dropped.
+ */
+static td_histogram_t *TDigest_WriteTarget(TDigest *sketch, long long now) {
+    if (!sketch->nBuckets) {
+        return sketch->td;
+    }
+    const long long slot = TDigest_Slot(sketch, now);
+    const long long i = slot % sketch->nBuckets;
+    if (sketch->bucketSlot[i] > slot) {
+        return NULL;
+    }
+    if (sketch->bucketSlot[i] < slot) {
+        td_reset(sketch->buckets[i]);
+        sketch->bucketSlot[i] = slot;
+    }
+    return sketch->buckets[i];
+}
+
+/**
+ * Returns the histogram to answer queries from. For a sliding window digest sketch->td is rebuilt
+ * as the merge of the buckets inside the window, unless it is still current: no bucket was written
+ * and no time slot started since it was last merged.
+ * Returns NULL if the total weight of the buckets overflows.
+ */
+static td_histogram_t *TDigest_View(TDigest *sketch) {
+    if (!sketch->nBuckets) {
+        return sketch->td;
+    }
+    const long long slot = TDigest_Slot(sketch, RedisModule_Milliseconds());
+    if (sketch->viewSlot == slot && sketch->viewGeneration == sketch->generation) {
+        return sketch->td;
+    }
+    td_histogram_t **live = td_malloc_(sketch->nBuckets * sizeof *live);
+    if (!live) {
+        return NULL;
+    }
+    size_t n_live = 0;
+    for (long long i = 0; i < sketch->nBuckets; i++) {
+        if (sketch->bucketSlot[i] > slot - sketch->nBuckets && sketch->bucketSlot[i] <= slot) {
+            live[n_live++] = sketch->buckets[i];
+        }
+    }
+    td_reset(sketch->td);
+    const int res = _TDigest_MergeInto(sketch->td, live, n_live);
+    bool overflow = res == EDOM;
+    for (size_t i = 0; !overflow && res != 0 && i < n_live; i++) {
+        overflow = td_merge(sketch->td, live[i]) != 0;
+    }
+    td_free_(live);
+    if (overflow) {
+        td_reset(sketch->td);
+        return NULL;
+    }
+    TDigest_Touch(sketch);
+    sketch->viewSlot = slot;
+    sketch->viewGeneration = sketch->generation;
+    return sketch->td;
+}
+
+/**
+ * Returns the prefix weights of the merged centroids, computing them if the digest was written
+ * since they were last computed. Returns NULL if the digest is empty, has more merged centroids
+ * than tdigest-cache-max-nodes, or the cache could not be allocated.
+ */
+static const double *TDigest_PrefixWeights(TDigest *sketch) {
+    td_histogram_t *tdigest = sketch->td;
+    td_compress(tdigest);
+    const long long nodes = tdigest->merged_nodes;
+    if (nodes <= 0 || nodes > rm_config.tdigest_cache_max_nodes.value) {
+        return NULL;
+    }
+    if (sketch->prefixGeneration == sketch->generation) {
+        return sketch->prefix;
+    }
+    if ((size_t)nodes > sketch->prefixCap) {
+        double *prefix = td_realloc_(sketch->prefix, nodes * sizeof *prefix);
+        if (!prefix) {
+            return NULL;
+        }
+        sketch->prefix = prefix;
+        sketch->prefixCap = nodes;
+    }
+    // accumulated in the same order as td_cdf does, so cached answers are identical
+    double weightSoFar = 0;
+    for (long long i = 0; i < nodes; i++) {
+        sketch->prefix[i] = weightSoFar;
+        weightSoFar += (double)tdigest->nodes_weight[i];
+    }
+    sketch->prefixGeneration = sketch->generation;
+    return sketch->prefix;
+}
 
 /**
  * Helper method to check if key is empty and it's type.
@@ -83,10 +456,16 @@ double _halfRoundDown(double f) {
     return int_part >= 0.0 ? int_part + 1.0 : int_part - 1.0;
 }
 
+// Largest number of buckets of a sliding window digest.
+#define TD_MAX_WINDOW_BUCKETS 1024
+
 /**
- * Command: TDIGEST.CREATE {key} [{compression}]
+ * Command: TDIGEST.CREATE {key} [COMPRESSION {compression}] [WINDOW {duration} BUCKETS {n}]
  *
- * Allocate the memory and initialize the t-digest.
+ * Allocate the memory and initialize the t-digest. The sketch keeps the exact samples until there
+ * are more than 2 * compression of them.
+ * With WINDOW the digest only answers for the samples added during the last 'duration'
+ * milliseconds, kept in 'n' buckets of duration/n milliseconds each that expire one at a time.
  *
  * @param ctx Context in which Redis modules operate
  * @param argv Redis command arguments, as an array of strings
@@ -94,7 +473,7 @@ double _halfRoundDown(double f) {
  * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
  */
 int TDigestSketch_Create(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
-    if (argc != 2 && argc != 4) {
+    if (argc < 2 || argc > 8 || argc % 2 != 0) {
         return RedisModule_WrongArity(ctx);
     }
 
@@ -111,25 +490,74 @@ int TDigestSketch_Create(RedisModuleCtx *ctx, RedisModuleString **argv, int argc
         return REDISMODULE_ERR;
     }
     long long compression = TD_DEFAULT_COMPRESSION;
-    // if argc is 3 we have the compression parameter defined
-    // otherwise we use the default value
-    if (argc == 4) {
-        int compression_loc = RMUtil_ArgIndex("COMPRESSION", argv + 2, argc - 2);
-        if (compression_loc == -1) {
-            RedisModule_ReplyWithError(ctx, "ERR T-Digest: wrong keyword");
-            RedisModule_CloseKey(key);
-            return REDISMODULE_ERR;
+    long long window = 0;
+    long long n_buckets = 0;
+    // the optional arguments are keyword and value pairs
+    for (int i = 2; i < argc; i += 2) {
+        const char *error = NULL;
+        if (RMUtil_ArgIndex("COMPRESSION", argv + i, 1) == 0) {
+            if (_TDigest_ParseCompressionParameter(ctx, argv[i + 1], &compression) !=
+                REDISMODULE_OK) {
+                RedisModule_CloseKey(key);
+                return REDISMODULE_ERR;
+            }
+        } else if (RMUtil_ArgIndex("WINDOW", argv + i, 1) == 0) {
+            if (RedisModule_StringToLongLong(argv[i + 1], &window) != REDISMODULE_OK ||
+                window <= 0) {
+                error = "ERR T-Digest: window needs to be a positive integer";
+            }
+        } else if (RMUtil_ArgIndex("BUCKETS", argv + i, 1) == 0) {
+            if (RedisModule_StringToLongLong(argv[i + 1], &n_buckets) != REDISMODULE_OK ||
+                n_buckets <= 0 || n_buckets > TD_MAX_WINDOW_BUCKETS) {
+                error = "ERR T-Digest: buckets needs to be an integer between 1 and 1024";
+            }
+        } else {
+            error = "ERR T-Digest: wrong keyword";
         }
-        if (_TDigest_ParseCompressionParameter(ctx, argv[3], &compression) != REDISMODULE_OK) {
+        if (error) {
             RedisModule_CloseKey(key);
-            return REDISMODULE_ERR;
+            return RedisModule_ReplyWithError(ctx, error);
         }
     }
+    if ((window == 0) != (n_buckets == 0)) {
+        RedisModule_CloseKey(key);
+        return RedisModule_ReplyWithError(ctx, "ERR T-Digest: WINDOW requires BUCKETS");
+    }
+    if (window < n_buckets) {
+        RedisModule_CloseKey(key);
+        return RedisModule_ReplyWithError(
+            ctx, "ERR T-Digest: window needs to be at least one millisecond per bucket");
+    }
     if (td_init(compression, &tdigest) != 0) {
         RedisModule_CloseKey(key);
         return RedisModule_ReplyWithError(ctx, "ERR T-Digest: allocation failed");
     }
-    if (RedisModule_ModuleTypeSetValue(key, TDigestSketchType, tdigest) != REDISMODULE_OK) {
+    TDigest *sketch = TDigest_Wrap(tdigest);
+    if (!sketch) {
+        td_free(tdigest);
+        RedisModule_CloseKey(key);
+        return RedisModule_ReplyWithError(ctx, "ERR T-Digest: allocation failed");
+    }
+    if (n_buckets && TDigest_InitWindow(sketch, window, n_buckets) != 0) {
+        TDigest_Free(sketch);
+        RedisModule_CloseKey(key);
+        return RedisModule_ReplyWithError(ctx, "ERR T-Digest: allocation failed");
+    }
+    // The sketch starts exact. The digest allocated above has shown that the compression is
+    // usable once the sketch grows into one, and is only needed again by then.
+    if (!n_buckets) {
+        td_histogram_t *exact = _TDigest_NewExact(compression, TD_EXACT_INITIAL_CAP);
+        if (!exact) {
+            TDigest_Free(sketch);
+            RedisModule_CloseKey(key);
+            return RedisModule_ReplyWithError(ctx, "ERR T-Digest: allocation failed");
+        }
+        td_free(sketch->td);
+        sketch->td = exact;
+        sketch->exact = true;
+    }
+    if (RedisModule_ModuleTypeSetValue(key, TDigestSketchType, sketch) != REDISMODULE_OK) {
+        TDigest_Free(sketch);
         RedisModule_CloseKey(key);
         return RedisModule_ReplyWithError(ctx, "ERR T-Digest: error setting value");
     }
@@ -159,18 +587,253 @@ int TDigestSketch_Reset(RedisModuleCtx *ctx, RedisModuleString **argv, int argc)
     if (_TDigest_KeyCheck(ctx, key) != REDISMODULE_OK)
         return REDISMODULE_ERR;
 
-    td_histogram_t *tdigest = RedisModule_ModuleTypeGetValue(key);
+    TDigest *sketch = RedisModule_ModuleTypeGetValue(key);
+    td_histogram_t *tdigest = sketch->td;
     td_reset(tdigest);
+    for (long long i = 0; i < sketch->nBuckets; i++) {
+        td_reset(sketch->buckets[i]);
+        sketch->bucketSlot[i] = LLONG_MIN;
+    }
+    TDigest_Touch(sketch);
     RedisModule_CloseKey(key);
     RedisModule_ReplicateVerbatim(ctx);
     RedisModule_ReplyWithSimpleString(ctx, "OK");
     return REDISMODULE_OK;
 }
 
+// Maps a double to a key whose unsigned order is the numeric order of the doubles.
+static inline uint64_t _TDigest_SortableBits(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof bits);
+    return (bits >> 63) ? ~bits : bits | (1ULL << 63);
+}
+
+static inline double _TDigest_FromSortableBits(uint64_t key) {
+    const uint64_t bits = (key >> 63) ? key & ~(1ULL << 63) : ~key;
+    double value;
+    memcpy(&value, &bits, sizeof value);
+    return value;
+}
+
+/**
+ * Sorts 'n' doubles in place with an LSD radix sort over their IEEE-754 bit patterns, one byte
+ * per pass. All byte histograms are gathered in a single pass, and bytes that are equal across all
+ * values (typically the sign and exponent bytes) are skipped. 'keys' and 'tmp' must hold 'n'
+ * elements each.
+ */
+static void _TDigest_RadixSort(double *values, uint64_t *keys, uint64_t *tmp, size_t n) {
+    size_t counts[8][256] = {{0}};
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t key = _TDigest_SortableBits(values[i]);
+        keys[i] = key;
+        for (int b = 0; b < 8; ++b) {
+            counts[b][(key >> (b * 8)) & 0xff]++;
+        }
+    }
+    for (int b = 0; b < 8; ++b) {
+        const int shift = b * 8;
+        if (counts[b][(keys[0] >> shift) & 0xff] == n) {
+            continue;
+        }
+        size_t offset = 0;
+        for (int d = 0; d < 256; ++d) {
+            const size_t count = counts[b][d];
+            counts[b][d] = offset;
+            offset += count;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            tmp[counts[b][(keys[i] >> shift) & 0xff]++] = keys[i];
+        }
+        uint64_t *swap = keys;
+        keys = tmp;
+        tmp = swap;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        values[i] = _TDigest_FromSortableBits(keys[i]);
+    }
+}
+
+/**
+ * Adds 'n' unit weight values to 'tdigest', the histogram writes to 'sketch' go to. Values are
+ * appended to the unmerged buffer one buffer fill at a time: each run is radix sorted and, when
+ * there are no unmerged nodes yet, merged into the sorted merged centroids so that the next
+ * compression sorts already ordered nodes. As with td_add, the buffer is compressed once it is
+ * full.
+ * Returns 0 on success, EDOM if the total weight would overflow, or ENOMEM.
+ */
+static int TDigest_AddBatch(TDigest *sketch, td_histogram_t *tdigest, const double *vals,
+                            size_t n) {
+    if ((long long)n > LLONG_MAX - tdigest->merged_weight - tdigest->unmerged_weight) {
+        return EDOM;
+    }
+    TDigest_Touch(sketch);
+    const size_t run_cap = n < (size_t)tdigest->cap ? n : (size_t)tdigest->cap;
+    double *run = td_malloc_(run_cap * sizeof(double));
+    uint64_t *keys = td_malloc_(run_cap * sizeof(uint64_t));
+    uint64_t *tmp = td_malloc_(run_cap * sizeof(uint64_t));
+    int res = (run && keys && tmp) ? 0 : ENOMEM;
+    size_t done = 0;
+    while (res == 0 && done < n) {
+        // td_add keeps one node free and compresses once the buffer reaches it
+        long long room = tdigest->cap - 1 - tdigest->merged_nodes - tdigest->unmerged_nodes;
+        if (room <= 0) {
+            if ((res = td_compress(tdigest)) != 0) {
+                break;
+            }
+            room = tdigest->cap - 1 - tdigest->merged_nodes - tdigest->unmerged_nodes;
+            if (room <= 0) {
+                res = EDOM;
+                break;
+            }
+        }
+        const size_t len = (size_t)room < n - done ? (size_t)room : n - done;
+        memcpy(run, vals + done, len * sizeof(double));
+        _TDigest_RadixSort(run, keys, tmp, len);
+
+        double *mean = tdigest->nodes_mean;
+        long long *weight = tdigest->nodes_weight;
+        long long end = tdigest->merged_nodes + tdigest->unmerged_nodes + len;
+        if (tdigest->unmerged_nodes == 0) {
+            // merge from the back so the merged centroids can be shifted in place
+            long long i = tdigest->merged_nodes - 1;
+            long long j = len - 1;
+            while (j >= 0) {
+                --end;
+                if (i >= 0 && mean[i] > run[j]) {
+                    mean[end] = mean[i];
+                    weight[end] = weight[i--];
+                } else {
+                    mean[end] = run[j--];
+                    weight[end] = 1;
+                }
+            }
+        } else {
+            const long long start = end - len;
+            for (size_t k = 0; k < len; ++k) {
+                mean[start + k] = run[k];
+                weight[start + k] = 1;
+            }
+        }
+        if (run[0] < tdigest->min) {
+            tdigest->min = run[0];
+        }
+        if (run[len - 1] > tdigest->max) {
+            tdigest->max = run[len - 1];
+        }
+        tdigest->unmerged_nodes += len;
+        tdigest->unmerged_weight += len;
+        done += len;
+    }
+    if (run) {
+        td_free_(run);
+    }
+    if (keys) {
+        td_free_(keys);
+    }
+    if (tmp) {
+        td_free_(tmp);
+    }
+    return res;
+}
+
+/**
+ * Adds 'n' samples, of unit weight if 'weights' is NULL, made at the Unix time 'now' in
+ * milliseconds, to the histogram writes go to, if any. An exact sketch that would grow past
+ * TD_EXACT_MAX_FACTOR samples per unit of compression is turned into a digest first.
+ * Returns 0 on success, EDOM if the total weight would overflow, or ENOMEM.
+ */
+static int TDigest_Add(TDigest *sketch, const double *vals, const long long *weights, size_t n,
+                       long long now) {
+    if (sketch->exact) {
+        int res = _TDigest_ExactAdd(sketch, vals, weights, n);
+        if (res != ERANGE) {
+            return res;
+        }
+        if ((res = TDigest_ToDigest(sketch)) != 0) {
+            return res;
+        }
+    }
+    td_histogram_t *tdigest = TDigest_WriteTarget(sketch, now);
+    if (!tdigest) {
+        return 0;
+    }
+    if (!weights && n >= TD_ADD_BATCH_MIN) {
+        return TDigest_AddBatch(sketch, tdigest, vals, n);
+    }
+    TDigest_Touch(sketch);
+    for (size_t i = 0; i < n; ++i) {
+        if (td_add(tdigest, vals[i], weights ? weights[i] : 1) != 0) {
+            return EDOM;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Parses the optional trailing AT {timestamp} of a write command into 'now', or sets it to the
+ * current Unix time in milliseconds, and drops it from 'argc'. AT follows at least 'min_argc'
+ * arguments.
+ * Returns REDISMODULE_OK, or replies with an error and returns REDISMODULE_ERR.
+ */
+static int _TDigest_ParseAt(RedisModuleCtx *ctx, RedisModuleString **argv, int *argc,
+                            int min_argc, long long *now) {
+    if (*argc < min_argc + 2 || RMUtil_ArgIndex("AT", argv + *argc - 2, 1) != 0) {
+        *now = RedisModule_Milliseconds();
+        return REDISMODULE_OK;
+    }
+    if (RedisModule_StringToLongLong(argv[*argc - 1], now) != REDISMODULE_OK || *now < 0) {
+        RedisModule_ReplyWithError(ctx, "ERR T-Digest: timestamp needs to be non negative");
+        return REDISMODULE_ERR;
+    }
+    *argc -= 2;
+    return REDISMODULE_OK;
+}
+
+/**
+ * Checks that samples made at 'now' can be added to 'sketch', replying with an error if not. A
+ * client may write at most one time slot ahead, so that it can't claim a bucket and have the writes
+ * made to it until then dropped. Replicated and AOF writes carry the master's time as is. Samples
+ * of a time slot whose bucket already holds a later one are refused.
+ */
+static int _TDigest_CheckTime(RedisModuleCtx *ctx, const TDigest *sketch, long long now) {
+    if (!sketch->nBuckets) {
+        return REDISMODULE_OK;
+    }
+    const long long slot = TDigest_Slot(sketch, now);
+    const int replayed = RedisModule_GetContextFlags(ctx) &
+                         (REDISMODULE_CTX_FLAGS_REPLICATED | REDISMODULE_CTX_FLAGS_LOADING);
+    if (!replayed && slot > TDigest_Slot(sketch, RedisModule_Milliseconds()) + 1) {
+        RedisModule_ReplyWithError(ctx, "ERR T-Digest: timestamp is too far in the future");
+        return REDISMODULE_ERR;
+    }
+    if (sketch->bucketSlot[slot % sketch->nBuckets] > slot) {
+        RedisModule_ReplyWithError(ctx, "ERR T-Digest: timestamp is older than the window");
+        return REDISMODULE_ERR;
+    }
+    return REDISMODULE_OK;
+}
+
+/**
+ * Replicates a write command made at 'now', without its AT argument in 'argc'. Writes to a sliding
+ * window digest are replicated with AT, like EXPIRE is with PEXPIREAT, so that replicas and the
+ * AOF add the samples to the same buckets.
+ */
+static void _TDigest_ReplicateWrite(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
+                                    bool windowed, long long now) {
+    if (!windowed) {
+        RedisModule_ReplicateVerbatim(ctx);
+        return;
+    }
+    RedisModule_Replicate(ctx, RedisModule_StringPtrLen(argv[0], NULL), "vcl", argv + 1,
+                          (size_t)(argc - 1), "AT", now);
+}
+
 /**
- * Command: TDIGEST.ADD {key} {val} [ {val} ] ...
+ * Command: TDIGEST.ADD {key} {val} [ {val} ] ... [AT {timestamp}]
  *
- * Adds one or more samples to a histogram.
+ * Adds one or more samples to a histogram. With AT the samples are added to a sliding window
+ * digest as if at that Unix time, in milliseconds, rather than now. It may be at most one time
+ * slot ahead of the current time.
  *
  * @param ctx Context in which Redis modules operate
  * @param argv Redis command arguments, as an array of strings
@@ -182,11 +845,19 @@ int TDigestSketch_Add(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
     if (argc < 3) {
         return RedisModule_WrongArity(ctx);
     }
+    long long now;
+    if (_TDigest_ParseAt(ctx, argv, &argc, 3, &now) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+    }
     RedisModuleString *keyName = argv[1];
     RedisModuleKey *key = RedisModule_OpenKey(ctx, keyName, REDISMODULE_READ | REDISMODULE_WRITE);
 
     if (_TDigest_KeyCheck(ctx, key) != REDISMODULE_OK)
         return REDISMODULE_ERR;
+    if (_TDigest_CheckTime(ctx, RedisModule_ModuleTypeGetValue(key), now) != REDISMODULE_OK) {
+        RedisModule_CloseKey(key);
+        return REDISMODULE_ERR;
+    }
     const size_t n_values = argc - 2;
     double *vals = (double *)td_calloc_(n_values, sizeof(double));
 
@@ -205,19 +876,276 @@ int TDigestSketch_Add(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
         }
     }
 
-    td_histogram_t *tdigest = RedisModule_ModuleTypeGetValue(key);
-    for (int i = 0; i < n_values; ++i) {
-        if (td_add(tdigest, vals[i], 1) != 0) {
-            RedisModule_CloseKey(key);
-            td_free_(vals);
-            return RedisModule_ReplyWithError(ctx, "ERR T-Digest: overflow detected");
+    TDigest *sketch = RedisModule_ModuleTypeGetValue(key);
+    const bool windowed = sketch->nBuckets != 0;
+    const int res = TDigest_Add(sketch, vals, NULL, n_values, now);
+    if (res != 0) {
+        RedisModule_CloseKey(key);
+        td_free_(vals);
+        return RedisModule_ReplyWithError(ctx, res == ENOMEM ? "ERR T-Digest: allocation failed"
+                                                             : "ERR T-Digest: overflow detected");
+    }
+    RedisModule_CloseKey(key);
+    td_free_(vals);
+    _TDigest_ReplicateWrite(ctx, argv, argc, windowed, now);
+    RedisModule_ReplyWithSimpleString(ctx, "OK");
+    return REDISMODULE_OK;
+}
+
+// Size of one (double value, uint64 weight) little-endian pair in a TDIGEST.ADDWEIGHTED payload.
+#define TD_PACKED_PAIR_SIZE 16
+
+// Decodes the pair at 'buf' of a packed TDIGEST.ADDWEIGHTED payload.
+static void _TDigest_UnpackPair(const unsigned char *buf, double *value, uint64_t *weight) {
+    uint64_t words[2] = {0, 0};
+    for (int w = 0; w < 2; ++w) {
+        for (int b = 0; b < 8; ++b) {
+            words[w] |= (uint64_t)buf[w * 8 + b] << (b * 8);
+        }
+    }
+    memcpy(value, &words[0], sizeof *value);
+    *weight = words[1];
+}
+
+/**
+ * Command: TDIGEST.ADDWEIGHTED {key} {value} {weight} [{value} {weight} ...] [AT {timestamp}]
+ *          TDIGEST.ADDWEIGHTED {key} PACKED {payload} [AT {timestamp}]
+ *
+ * Adds one or more samples, each with its own weight, to a histogram. With PACKED the samples
+ * are given as a binary payload of consecutive little-endian (double value, uint64 weight) pairs.
+ * Either all samples are added or, if any is invalid or the total weight would overflow, none.
+ * AT is as with TDIGEST.ADD.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int TDigestSketch_AddWeighted(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc < 4) {
+        return RedisModule_WrongArity(ctx);
+    }
+    long long now;
+    if (_TDigest_ParseAt(ctx, argv, &argc, 4, &now) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+    }
+    const bool packed = RMUtil_ArgIndex("PACKED", argv + 2, 1) == 0;
+    if ((packed && argc != 4) || (!packed && argc % 2 != 0)) {
+        return RedisModule_WrongArity(ctx);
+    }
+    size_t payload_len = 0;
+    const unsigned char *payload = NULL;
+    size_t n_values = (argc - 2) / 2;
+    if (packed) {
+        payload = (const unsigned char *)RedisModule_StringPtrLen(argv[3], &payload_len);
+        if (payload_len == 0 || payload_len % TD_PACKED_PAIR_SIZE != 0) {
+            return RedisModule_ReplyWithError(ctx, "ERR T-Digest: invalid packed payload length");
+        }
+        n_values = payload_len / TD_PACKED_PAIR_SIZE;
+    }
+
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ | REDISMODULE_WRITE);
+    if (_TDigest_KeyCheck(ctx, key) != REDISMODULE_OK)
+        return REDISMODULE_ERR;
+
+    TDigest *sketch = RedisModule_ModuleTypeGetValue(key);
+    if (_TDigest_CheckTime(ctx, sketch, now) != REDISMODULE_OK) {
+        RedisModule_CloseKey(key);
+        return REDISMODULE_ERR;
+    }
+    const td_histogram_t *tdigest = TDigest_WriteTarget(sketch, now);
+    double *vals = td_calloc_(n_values, sizeof(double));
+    long long *weights = td_calloc_(n_values, sizeof(long long));
+    const char *error = NULL;
+    long long total = tdigest ? tdigest->merged_weight + tdigest->unmerged_weight : 0;
+    for (size_t i = 0; i < n_values && !error; ++i) {
+        uint64_t weight = 0;
+        if (packed) {
+            _TDigest_UnpackPair(payload + i * TD_PACKED_PAIR_SIZE, &vals[i], &weight);
+        } else {
+            long long parsed = 0;
+            if (RedisModule_StringToDouble(argv[2 + 2 * i], &vals[i]) != REDISMODULE_OK ||
+                RedisModule_StringToLongLong(argv[3 + 2 * i], &parsed) != REDISMODULE_OK) {
+                error = "ERR T-Digest: error parsing value or weight";
+                break;
+            }
+            weight = parsed > 0 ? (uint64_t)parsed : 0;
+        }
+        if (!isfinite(vals[i])) {
+            error = "ERR T-Digest: val parameter needs to be a finite number";
+        } else if (weight == 0) {
+            error = "ERR T-Digest: weight needs to be a positive integer";
+        } else if (weight > (uint64_t)(LLONG_MAX - total)) {
+            error = "ERR T-Digest: overflow detected";
+        } else {
+            weights[i] = (long long)weight;
+            total += weights[i];
+        }
+    }
+    if (error) {
+        RedisModule_CloseKey(key);
+        td_free_(vals);
+        td_free_(weights);
+        return RedisModule_ReplyWithError(ctx, error);
+    }
+
+    const bool windowed = sketch->nBuckets != 0;
+    const int res = TDigest_Add(sketch, vals, weights, n_values, now);
+    if (res != 0) {
+        RedisModule_CloseKey(key);
+        td_free_(vals);
+        td_free_(weights);
+        return RedisModule_ReplyWithError(ctx, res == ENOMEM ? "ERR T-Digest: allocation failed"
+                                                             : "ERR T-Digest: overflow detected");
+    }
+    RedisModule_CloseKey(key);
+    td_free_(vals);
+    td_free_(weights);
+    _TDigest_ReplicateWrite(ctx, argv, argc, windowed, now);
+    RedisModule_ReplyWithSimpleString(ctx, "OK");
+    return REDISMODULE_OK;
+}
+
+// A sorted run of merged centroids taken from one merge source.
+typedef struct {
+    const double *mean;
+    const long long *weight;
+    int pos;
+    int len;
+} TDigestRun;
+
+// Restores the min-heap order of 'heap' (indices into 'runs', keyed by their current mean) below
+// slot 'i'.
+static void _TDigest_RunHeapDown(const TDigestRun *runs, int *heap, int n, int i) {
+    for (;;) {
+        int smallest = i;
+        const int left = 2 * i + 1, right = 2 * i + 2;
+        if (left < n && runs[heap[left]].mean[runs[heap[left]].pos] <
+                            runs[heap[smallest]].mean[runs[heap[smallest]].pos]) {
+            smallest = left;
+        }
+        if (right < n && runs[heap[right]].mean[runs[heap[right]].pos] <
+                             runs[heap[smallest]].mean[runs[heap[smallest]].pos]) {
+            smallest = right;
+        }
+        if (smallest == i) {
+            return;
+        }
+        const int tmp = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = tmp;
+        i = smallest;
+    }
+}
+
+/**
+ * Replaces the contents of 'into' with the union of 'sources', which may include 'into' itself.
+ * The sources' merged centroids are already sorted, so they are merged with a k-way heap and
+ * compressed in that same single pass, with the same size bound td_compress applies.
+ * 'into' is left untouched on failure.
+ * Returns 0 on success, EDOM if the total weight overflows, ENOMEM, or ERANGE if the merged
+ * centroids don't fit comfortably in the capacity of 'into'.
+ */
+static int _TDigest_MergeInto(td_histogram_t *into, td_histogram_t *const *sources,
+                              size_t n_sources) {
+    long long total = 0;
+    double min = __DBL_MAX__, max = -__DBL_MAX__;
+    for (size_t i = 0; i < n_sources; i++) {
+        td_histogram_t *src = sources[i];
+        if (td_compress(src) != 0 || src->merged_weight > LLONG_MAX - total) {
+            return EDOM;
+        }
+        total += src->merged_weight;
+        if (src->merged_nodes > 0) {
+            min = src->min < min ? src->min : min;
+            max = src->max > max ? src->max : max;
+        }
+    }
+    // td_compress keeps the merged centroids far below the capacity; stay in that range so the
+    // buffer still has room for td_add
+    const int out_cap = into->cap / 2;
+    double *mean = td_malloc_(out_cap * sizeof(double));
+    long long *weight = td_malloc_(out_cap * sizeof(long long));
+    TDigestRun *runs = td_malloc_(n_sources * sizeof(TDigestRun));
+    int *heap = td_malloc_(n_sources * sizeof(int));
+    int res = (mean && weight && runs && heap) ? 0 : ENOMEM;
+
+    int n_heap = 0;
+    for (size_t i = 0; res == 0 && i < n_sources; i++) {
+        if (sources[i]->merged_nodes > 0) {
+            runs[n_heap] = (TDigestRun){.mean = sources[i]->nodes_mean,
+                                        .weight = sources[i]->nodes_weight,
+                                        .pos = 0,
+                                        .len = sources[i]->merged_nodes};
+            heap[n_heap] = n_heap;
+            n_heap++;
+        }
+    }
+    for (int i = n_heap / 2 - 1; i >= 0; i--) {
+        _TDigest_RunHeapDown(runs, heap, n_heap, i);
+    }
+
+    const double total_weight = (double)total;
+    // normalizer of the scale function td_compress uses to bound the centroid sizes
+    const double normalizer = into->compression / (2 * M_PI * total_weight * log(total_weight));
+    int cur = -1;
+    double weightSoFar = 0;
+    while (res == 0 && n_heap > 0) {
+        TDigestRun *run = &runs[heap[0]];
+        const double m = run->mean[run->pos];
+        const long long w = run->weight[run->pos];
+        if (++run->pos == run->len) {
+            heap[0] = heap[--n_heap];
+        }
+        _TDigest_RunHeapDown(runs, heap, n_heap, 0);
+
+        if (cur >= 0) {
+            // same merge criterion as td_compress
+            const double proposed = (double)weight[cur] + (double)w;
+            const double z = proposed * normalizer;
+            const double q0 = weightSoFar / total_weight;
+            const double q2 = (weightSoFar + proposed) / total_weight;
+            if (z <= q0 * (1 - q0) && z <= q2 * (1 - q2)) {
+                weight[cur] += w;
+                mean[cur] += (m - mean[cur]) * w / weight[cur];
+                continue;
+            }
+            weightSoFar += (double)weight[cur];
+        }
+        if (++cur == out_cap) {
+            res = ERANGE;
+            break;
+        }
+        mean[cur] = m;
+        weight[cur] = w;
+    }
+
+    if (res == 0) {
+        memcpy(into->nodes_mean, mean, (cur + 1) * sizeof(double));
+        memcpy(into->nodes_weight, weight, (cur + 1) * sizeof(long long));
+        into->merged_nodes = cur + 1;
+        into->unmerged_nodes = 0;
+        into->merged_weight = total;
+        into->unmerged_weight = 0;
+        if (total > 0) {
+            into->min = min;
+            into->max = max;
         }
+        into->total_compressions++;
     }
-    RedisModule_CloseKey(key);
-    td_free_(vals);
-    RedisModule_ReplicateVerbatim(ctx);
-    RedisModule_ReplyWithSimpleString(ctx, "OK");
-    return REDISMODULE_OK;
+    if (mean) {
+        td_free_(mean);
+    }
+    if (weight) {
+        td_free_(weight);
+    }
+    if (runs) {
+        td_free_(runs);
+    }
+    if (heap) {
+        td_free_(heap);
+    }
+    return res;
 }
 
 /**
@@ -242,22 +1170,29 @@ int TDigestSketch_Merge(RedisModuleCtx *ctx, RedisModuleString **argv, int argc)
     RedisModuleString *keyNameDestination = argv[1];
     td_histogram_t *tdigestTo = NULL;
     td_histogram_t *tdigestToStart = NULL;
+    TDigest *sketchToStart = NULL;
+    td_histogram_t **sources = NULL;
     int current_pos = 0;
     int res = REDISMODULE_ERR;
     td_histogram_t **from_tdigests = NULL;
     bool to_exists = false;
-    RedisModuleKey *keyDestination = RedisModule_OpenKey(ctx, keyNameDestination, REDISMODULE_READ);
+    // the destination stays open until the end, since it may be merged into in place
+    RedisModuleKey *keyDestination =
+        RedisModule_OpenKey(ctx, keyNameDestination, REDISMODULE_READ | REDISMODULE_WRITE);
     // check if key existed already. If so, confirm it's of the proper type
     if (RedisModule_KeyType(keyDestination) != REDISMODULE_KEYTYPE_EMPTY) {
         if (RedisModule_ModuleTypeGetType(keyDestination) != TDigestSketchType) {
             RedisModule_ReplyWithError(ctx, REDISMODULE_ERRORMSG_WRONGTYPE);
-            RedisModule_CloseKey(keyDestination);
             goto cleanup;
         }
-        tdigestToStart = RedisModule_ModuleTypeGetValue(keyDestination);
+        sketchToStart = RedisModule_ModuleTypeGetValue(keyDestination);
+        tdigestToStart = TDigest_View(sketchToStart);
         to_exists = true;
     }
-    RedisModule_CloseKey(keyDestination);
+    if (to_exists && !tdigestToStart) {
+        RedisModule_ReplyWithError(ctx, "ERR T-Digest: overflow detected");
+        goto cleanup;
+    }
     // parse numkeys
     long long numkeys = 1;
     if (RedisModule_StringToLongLong(argv[2], &numkeys) != REDISMODULE_OK) {
@@ -309,6 +1244,12 @@ int TDigestSketch_Merge(RedisModuleCtx *ctx, RedisModuleString **argv, int argc)
             goto cleanup;
         }
     }
+    // the buckets of a sliding window destination can only be replaced as a whole
+    if (to_exists && sketchToStart->nBuckets && !override) {
+        RedisModule_ReplyWithError(
+            ctx, "ERR T-Digest: merging into a windowed sketch requires OVERRIDE");
+        goto cleanup;
+    }
     from_tdigests = (td_histogram_t **)td_calloc_(numkeys, sizeof(td_histogram_t *));
     for (current_pos = 0; current_pos < numkeys; current_pos++) {
         RedisModuleString *keyNameFrom = argv[current_pos + 3];
@@ -319,8 +1260,13 @@ int TDigestSketch_Merge(RedisModuleCtx *ctx, RedisModuleString **argv, int argc)
             if (_TDigest_KeyCheck(ctx, current_key)) {
                 goto cleanup;
             }
-            from_tdigests[current_pos] = RedisModule_ModuleTypeGetValue(current_key);
+            TDigest *from = RedisModule_ModuleTypeGetValue(current_key);
+            from_tdigests[current_pos] = TDigest_View(from);
             RedisModule_CloseKey(current_key);
+            if (!from_tdigests[current_pos]) {
+                RedisModule_ReplyWithError(ctx, "ERR T-Digest: overflow detected");
+                goto cleanup;
+            }
         } else {
             if (to_exists) {
                 from_tdigests[current_pos] = tdigestToStart;
@@ -336,37 +1282,75 @@ int TDigestSketch_Merge(RedisModuleCtx *ctx, RedisModuleString **argv, int argc)
             compression = td_compression > compression ? td_compression : compression;
         }
     }
+    // the existing destination is merged first, unless it is overridden
+    size_t n_sources = 0;
+    sources = (td_histogram_t **)td_calloc_(numkeys + 1, sizeof(td_histogram_t *));
+    if (tdigestToStart != NULL && override == false) {
+        sources[n_sources++] = tdigestToStart;
+    }
+    for (long long i = 0; i < numkeys; i++) {
+        if (from_tdigests[i] != NULL) {
+            sources[n_sources++] = from_tdigests[i];
+        }
+    }
+    // with an unchanged compression a digest destination is updated in place, while the samples of
+    // an exact one are merged into a new digest like any other source, so that the destination is
+    // left as it was if the merge fails
+    if (tdigestToStart != NULL && override == false && !sketchToStart->exact &&
+        compression == tdigestToStart->compression) {
+        const int merge_res = _TDigest_MergeInto(tdigestToStart, sources, n_sources);
+        if (merge_res == EDOM) {
+            RedisModule_ReplyWithError(ctx, "ERR T-Digest: overflow detected");
+            goto cleanup;
+        }
+        if (merge_res == 0) {
+            TDigest_Touch(sketchToStart);
+            res = REDISMODULE_OK;
+            RedisModule_ReplicateVerbatim(ctx);
+            RedisModule_ReplyWithSimpleString(ctx, "OK");
+            goto cleanup;
+        }
+        // otherwise merge into a new digest below
+    }
     if (td_init(compression, &tdigestTo) != 0) {
         RedisModule_ReplyWithError(ctx, "ERR T-Digest: allocation of destination digest failed");
         goto cleanup;
     }
-    if (tdigestToStart != NULL && override == false) {
-        td_merge(tdigestTo, tdigestToStart);
+    const int merge_res = _TDigest_MergeInto(tdigestTo, sources, n_sources);
+    if (merge_res == EDOM) {
+        td_free(tdigestTo);
+        RedisModule_ReplyWithError(ctx, "ERR T-Digest: overflow detected");
+        goto cleanup;
     }
-
-    for (long long i = 0; i < numkeys; i++) {
-        if (from_tdigests[i] != NULL) {
-            if (td_merge(tdigestTo, from_tdigests[i]) != 0) {
-                td_free(tdigestTo);
-                RedisModule_ReplyWithError(ctx, "ERR T-Digest: overflow detected");
-                goto cleanup;
-            }
+    // fall back to merging one source at a time, compressing whenever the buffer fills
+    for (size_t i = 0; merge_res != 0 && i < n_sources; i++) {
+        if (td_merge(tdigestTo, sources[i]) != 0) {
+            td_free(tdigestTo);
+            RedisModule_ReplyWithError(ctx, "ERR T-Digest: overflow detected");
+            goto cleanup;
         }
     }
-    keyDestination = RedisModule_OpenKey(ctx, keyNameDestination, REDISMODULE_WRITE);
-    if (RedisModule_ModuleTypeSetValue(keyDestination, TDigestSketchType, tdigestTo) !=
+    TDigest *sketchTo = TDigest_Wrap(tdigestTo);
+    if (!sketchTo) {
+        td_free(tdigestTo);
+        RedisModule_ReplyWithError(ctx, "ERR T-Digest: allocation of destination digest failed");
+        goto cleanup;
+    }
+    if (RedisModule_ModuleTypeSetValue(keyDestination, TDigestSketchType, sketchTo) !=
         REDISMODULE_OK) {
-        RedisModule_CloseKey(keyDestination);
+        TDigest_Free(sketchTo);
         RedisModule_ReplyWithError(ctx, "ERR T-Digest: error setting value");
         goto cleanup;
     }
-    RedisModule_CloseKey(keyDestination);
     res = REDISMODULE_OK;
     RedisModule_ReplicateVerbatim(ctx);
     RedisModule_ReplyWithSimpleString(ctx, "OK");
 cleanup:
+    RedisModule_CloseKey(keyDestination);
     if (from_tdigests)
         td_free_(from_tdigests);
+    if (sources)
+        td_free_(sources);
     return res;
 }
 
@@ -390,7 +1374,12 @@ int TDigestSketch_Min(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
     if (_TDigest_KeyCheck(ctx, key) != REDISMODULE_OK)
         return REDISMODULE_ERR;
 
-    td_histogram_t *tdigest = RedisModule_ModuleTypeGetValue(key);
+    TDigest *sketch = RedisModule_ModuleTypeGetValue(key);
+    td_histogram_t *tdigest = TDigest_View(sketch);
+    if (!tdigest) {
+        RedisModule_CloseKey(key);
+        return RedisModule_ReplyWithError(ctx, "ERR T-Digest: overflow detected");
+    }
     const double min = (td_size(tdigest) > 0) ? td_min(tdigest) : NAN;
     RedisModule_CloseKey(key);
     RedisModule_ReplyWithDouble(ctx, min);
@@ -417,14 +1406,18 @@ int TDigestSketch_Max(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
     if (_TDigest_KeyCheck(ctx, key) != REDISMODULE_OK)
         return REDISMODULE_ERR;
 
-    td_histogram_t *tdigest = RedisModule_ModuleTypeGetValue(key);
+    TDigest *sketch = RedisModule_ModuleTypeGetValue(key);
+    td_histogram_t *tdigest = TDigest_View(sketch);
+    if (!tdigest) {
+        RedisModule_CloseKey(key);
+        return RedisModule_ReplyWithError(ctx, "ERR T-Digest: overflow detected");
+    }
     const double max = (td_size(tdigest) > 0) ? td_max(tdigest) : NAN;
     RedisModule_CloseKey(key);
     RedisModule_ReplyWithDouble(ctx, max);
     return REDISMODULE_OK;
 }
 
-#if 0 // unused
 static int double_cmpfunc(const void *a, const void *b) {
     if (*(double *)a > *(double *)b)
         return 1;
@@ -433,7 +1426,253 @@ static int double_cmpfunc(const void *a, const void *b) {
     else
         return 0;
 }
-#endif
+
+// A query value together with its position in the request. 'value' must stay the first member so
+// that the points can be ordered with double_cmpfunc.
+typedef struct {
+    double value;
+    size_t pos;
+} TDigestQueryPoint;
+
+// Returns the 'n' values paired with their positions, in ascending order of value.
+static TDigestQueryPoint *_TDigest_SortQueries(const double *values, size_t n) {
+    TDigestQueryPoint *points = td_malloc_(n * sizeof *points);
+    for (size_t i = 0; i < n; ++i) {
+        points[i] = (TDigestQueryPoint){.value = values[i], .pos = i};
+    }
+    qsort(points, n, sizeof *points, double_cmpfunc);
+    return points;
+}
+
+/**
+ * Returns the weight below 'val', which lies between the centroids (mean, w) and
+ * (mean_next, w_next), given 'weightSoFar' before the first of them. Matches td_cdf interpolation.
+ */
+static double _TDigest_CdfBetween(double mean, double w, double mean_next, double w_next,
+                                  double val, double weightSoFar) {
+    if (mean_next - mean <= 0) {
+        // centroids too close together for a safe interpolation
+        return weightSoFar + (w + w_next) / 2;
+    }
+    // singleton centroids hold their whole weight at the mean and are kept out of the
+    // interpolation
+    double leftExcludedW = 0;
+    double rightExcludedW = 0;
+    if (w == 1) {
+        if (w_next == 1) {
+            // two singletons: the left one is in, the right one is out
+            return weightSoFar + 1;
+        }
+        leftExcludedW = 0.5;
+    } else if (w_next == 1) {
+        rightExcludedW = 0.5;
+    }
+    const double dw = (w + w_next) / 2;
+    const double dwNoSingleton = dw - leftExcludedW - rightExcludedW;
+    const double base = weightSoFar + w / 2 + leftExcludedW;
+    return base + dwNoSingleton * (val - mean) / (mean_next - mean);
+}
+
+/**
+ * Returns td_cdf(val) for a value between the first and the last merged centroid, given the first
+ * centroid 'it' equal to val or the last one below it, and the weight before that centroid.
+ */
+static double _TDigest_CdfAt(const td_histogram_t *tdigest, int it, double weightSoFar,
+                             double val) {
+    const int nodes = tdigest->merged_nodes;
+    const double *mean = tdigest->nodes_mean;
+    const long long *weight = tdigest->nodes_weight;
+    const double total = (double)tdigest->merged_weight;
+    if (it == nodes - 1) {
+        return 1 - 0.5 / total;
+    }
+    if (mean[it] == val) {
+        // one or more centroids exactly at val are treated as one
+        double dw = 0;
+        for (int j = it; j < nodes && mean[j] == val; j++) {
+            dw += (double)weight[j];
+        }
+        return (weightSoFar + dw / 2) / total;
+    }
+    return _TDigest_CdfBetween(mean[it], (double)weight[it], mean[it + 1], (double)weight[it + 1],
+                               val, weightSoFar) /
+           total;
+}
+
+/**
+ * Computes td_cdf for all of 'values' with a single pass over the merged centroids.
+ * The values are visited in ascending order, so the centroid cursor and the weight to its left
+ * only move forward. Values in the tails are left to td_cdf, which answers them without scanning.
+ * A single value is left to td_cdf as well, which keeps a path to the library's answers that the
+ * cached and swept ones are tested against.
+ */
+static void _TDigest_CdfSweep(td_histogram_t *tdigest, const double *values, double *cdfs,
+                              size_t n) {
+    td_compress(tdigest);
+    const int nodes = tdigest->merged_nodes;
+    if (nodes < 2 || n == 1) {
+        for (size_t i = 0; i < n; ++i) {
+            cdfs[i] = td_cdf(tdigest, values[i]);
+        }
+        return;
+    }
+    const double *mean = tdigest->nodes_mean;
+    TDigestQueryPoint *points = _TDigest_SortQueries(values, n);
+
+    int it = 0;
+    double weightSoFar = 0;
+    for (size_t q = 0; q < n; ++q) {
+        const double val = points[q].value;
+        if (val < mean[0] || val > mean[nodes - 1]) {
+            cdfs[points[q].pos] = td_cdf(tdigest, val);
+            continue;
+        }
+        // advance to the first centroid equal to val, or the last one below it
+        while (it < nodes - 1 && mean[it] != val && val >= mean[it + 1]) {
+            weightSoFar += (double)tdigest->nodes_weight[it];
+            it++;
+        }
+        cdfs[points[q].pos] = _TDigest_CdfAt(tdigest, it, weightSoFar, val);
+    }
+    td_free_(points);
+}
+
+/**
+ * Computes td_cdf for all of 'values'. When the prefix weights are cached each value is a binary
+ * search over the centroid means, otherwise all values share a single sweep.
+ */
+static void _TDigest_Cdfs(TDigest *sketch, const double *values, double *cdfs, size_t n) {
+    td_histogram_t *tdigest = sketch->td;
+    const double *prefix = TDigest_PrefixWeights(sketch);
+    const int nodes = tdigest->merged_nodes;
+    if (!prefix || nodes < 2) {
+        _TDigest_CdfSweep(tdigest, values, cdfs, n);
+        return;
+    }
+    const double *mean = tdigest->nodes_mean;
+    for (size_t i = 0; i < n; ++i) {
+        const double val = values[i];
+        if (val < mean[0] || val > mean[nodes - 1]) {
+            cdfs[i] = td_cdf(tdigest, val);
+            continue;
+        }
+        // first centroid whose mean is not below val
+        int lo = 0, hi = nodes - 1;
+        while (lo < hi) {
+            const int mid = lo + (hi - lo) / 2;
+            if (mean[mid] < val) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        const int it = mean[lo] == val ? lo : lo - 1;
+        cdfs[i] = _TDigest_CdfAt(tdigest, it, prefix[it], val);
+    }
+}
+
+/**
+ * Computes td_quantile for all of 'quantiles' with a single td_quantiles sweep over the merged
+ * centroids, whatever the order of the requested quantiles. A single quantile is left to
+ * td_quantile.
+ */
+static void _TDigest_QuantileSweep(td_histogram_t *tdigest, const double *quantiles,
+                                   double *values, size_t n) {
+    if (n <= 1) {
+        if (n == 1) {
+            values[0] = td_quantile(tdigest, quantiles[0]);
+        }
+        return;
+    }
+    TDigestQueryPoint *points = _TDigest_SortQueries(quantiles, n);
+    double *sorted = td_malloc_(n * sizeof *sorted);
+    double *results = td_malloc_(n * sizeof *results);
+    for (size_t i = 0; i < n; ++i) {
+        sorted[i] = points[i].value;
+    }
+    td_quantiles(tdigest, sorted, results, n);
+    for (size_t i = 0; i < n; ++i) {
+        values[points[i].pos] = results[i];
+    }
+    td_free_(results);
+    td_free_(sorted);
+    td_free_(points);
+}
+
+// Returns the average of x1 and x2 weighted by w1 and w2, kept between them. Matches td_quantile.
+static inline double _TDigest_WeightedAverage(double x1, double w1, double x2, double w2) {
+    if (x1 > x2) {
+        return _TDigest_WeightedAverage(x2, w2, x1, w1);
+    }
+    const double x = (x1 * w1 + x2 * w2) / (w1 + w2);
+    return fmax(x1, fmin(x, x2));
+}
+
+/**
+ * Computes td_quantile for all of 'quantiles'. When the prefix weights are cached each quantile is
+ * a binary search over them, otherwise all quantiles share a single sweep. Quantiles that fall in
+ * the outer half of the first or last centroid are left to td_quantile, which answers them without
+ * scanning.
+ */
+static void _TDigest_Quantiles(TDigest *sketch, const double *quantiles, double *values,
+                               size_t n) {
+    td_histogram_t *tdigest = sketch->td;
+    const double *prefix = TDigest_PrefixWeights(sketch);
+    const int nodes = tdigest->merged_nodes;
+    if (!prefix || nodes < 2) {
+        _TDigest_QuantileSweep(tdigest, quantiles, values, n);
+        return;
+    }
+    const double *mean = tdigest->nodes_mean;
+    const long long *weight = tdigest->nodes_weight;
+    const double total = (double)tdigest->merged_weight;
+    const double firstW = (double)weight[0];
+    const double lastW = (double)weight[nodes - 1];
+    for (size_t q = 0; q < n; ++q) {
+        const double index = quantiles[q] * total;
+        if (index < 1 || index > total - 1 || (firstW > 1 && index < firstW / 2) ||
+            (lastW > 1 && total - index <= lastW / 2) ||
+            prefix[nodes - 1] + lastW / 2 <= index) {
+            values[q] = td_quantile(tdigest, quantiles[q]);
+            continue;
+        }
+        // first pair of centroids (i, i + 1) whose midpoints bracket index
+        int lo = 0, hi = nodes - 2;
+        while (lo < hi) {
+            const int mid = lo + (hi - lo) / 2;
+            if (prefix[mid + 1] + (double)weight[mid + 1] / 2 > index) {
+                hi = mid;
+            } else {
+                lo = mid + 1;
+            }
+        }
+        const double w = (double)weight[lo];
+        const double w_next = (double)weight[lo + 1];
+        const double weightSoFar = prefix[lo] + w / 2;
+        const double dw = (w + w_next) / 2;
+        // singleton centroids hold their whole weight at the mean and are kept out of the
+        // interpolation
+        double leftUnit = 0;
+        double rightUnit = 0;
+        if (w == 1) {
+            if (index - weightSoFar < 0.5) {
+                values[q] = mean[lo];
+                continue;
+            }
+            leftUnit = 0.5;
+        }
+        if (w_next == 1) {
+            if (weightSoFar + dw - index <= 0.5) {
+                values[q] = mean[lo + 1];
+                continue;
+            }
+            rightUnit = 0.5;
+        }
+        const double z1 = index - weightSoFar - leftUnit;
+        const double z2 = weightSoFar + dw - index - rightUnit;
+        values[q] = _TDigest_WeightedAverage(mean[lo], z2, mean[lo + 1], z1);
+    }
+}
 
 /**
  * Helper method to utilize TDIGEST.RANK and TDIGEST.REVRANK common logic.
@@ -462,12 +1701,22 @@ static int _TDigest_Rank(RedisModuleCtx *ctx, RedisModuleString *const *argv, in
         }
     }
 
-    td_histogram_t *tdigest = RedisModule_ModuleTypeGetValue(key);
+    TDigest *sketch = RedisModule_ModuleTypeGetValue(key);
+    td_histogram_t *tdigest = TDigest_View(sketch);
+    if (!tdigest) {
+        RedisModule_CloseKey(key);
+        td_free_(vals);
+        return RedisModule_ReplyWithError(ctx, "ERR T-Digest: overflow detected");
+    }
     double *ranks = (double *)td_calloc_(n_values, sizeof(double));
 
     const double size = td_size(tdigest);
     const double min = td_min(tdigest);
     const double max = td_max(tdigest);
+    double *cdfs = (double *)td_calloc_(n_values, sizeof(double));
+    if (size != 0) {
+        _TDigest_Cdfs(sketch, vals, cdfs, n_values);
+    }
     for (int i = 0; i < n_values; ++i) {
         // -2 if the sketch is empty
         if (size == 0) {
@@ -483,8 +1732,7 @@ static int _TDigest_Rank(RedisModuleCtx *ctx, RedisModuleString *const *argv, in
         } else if (vals[i] > max) {
             ranks[i] = reverse ? -1 : size;
         } else {
-            const double cdf_val = td_cdf(tdigest, vals[i]);
-            const double cdf_val_prior_round = cdf_val * size;
+            const double cdf_val_prior_round = cdfs[i] * size;
             const double cdf_to_absolute =
                 reverse ? round(cdf_val_prior_round) : _halfRoundDown(cdf_val_prior_round);
             ranks[i] = reverse ? round(size - cdf_to_absolute) : cdf_to_absolute;
@@ -497,6 +1745,7 @@ static int _TDigest_Rank(RedisModuleCtx *ctx, RedisModuleString *const *argv, in
         RedisModule_ReplyWithLongLong(ctx, (long long)ranks[i]);
     }
     td_free_(vals);
+    td_free_(cdfs);
     td_free_(ranks);
     return REDISMODULE_OK;
 }
@@ -533,12 +1782,6 @@ int TDigestSketch_RevRank(RedisModuleCtx *ctx, RedisModuleString **argv, int arg
     return _TDigest_Rank(ctx, argv, argc, true);
 }
 
-static double _td_get_byrank(td_histogram_t *tdigest, const double total_observations,
-                             const double input_rank) {
-    const double input_p = input_rank / total_observations;
-    return td_quantile(tdigest, input_p);
-}
-
 /**
  * Helper method to utilize TDIGEST.BYRANK and TDIGEST.BYREVRANK common logic.
  */
@@ -570,12 +1813,30 @@ static int _TDigest_ByRank(RedisModuleCtx *ctx, RedisModuleString *const *argv,
         }
     }
 
-    td_histogram_t *tdigest = RedisModule_ModuleTypeGetValue(key);
+    TDigest *sketch = RedisModule_ModuleTypeGetValue(key);
+    td_histogram_t *tdigest = TDigest_View(sketch);
+    if (!tdigest) {
+        RedisModule_CloseKey(key);
+        td_free_(input_ranks);
+        return RedisModule_ReplyWithError(ctx, "ERR T-Digest: overflow detected");
+    }
     double *values = (double *)td_calloc_(n_values, sizeof(double));
 
     const double size = (double)td_size(tdigest);
     const double min = td_min(tdigest);
     const double max = td_max(tdigest);
+    // ranks strictly inside the sketch are answered together
+    double *quantiles = (double *)td_calloc_(n_values, sizeof(double));
+    double *swept = (double *)td_calloc_(n_values, sizeof(double));
+    size_t n_swept = 0;
+    for (int i = 0; i < n_values; ++i) {
+        const double input_rank = input_ranks[i];
+        if (size != 0 && input_rank != 0 && input_rank < size) {
+            quantiles[n_swept++] = (reverse ? (size - input_rank - 1) : input_rank) / size;
+        }
+    }
+    _TDigest_Quantiles(sketch, quantiles, swept, n_swept);
+    n_swept = 0;
     for (int i = 0; i < n_values; ++i) {
         const double input_rank = input_ranks[i];
         // Nan if the sketch is empty
@@ -592,8 +1853,7 @@ static int _TDigest_ByRank(RedisModuleCtx *ctx, RedisModuleString *const *argv,
         } else if (input_rank >= size) {
             values[i] = reverse ? -INFINITY : INFINITY;
         } else {
-            values[i] =
-                _td_get_byrank(tdigest, size, reverse ? (size - input_rank - 1) : input_rank);
+            values[i] = swept[n_swept++];
         }
     }
 
@@ -603,6 +1863,8 @@ static int _TDigest_ByRank(RedisModuleCtx *ctx, RedisModuleString *const *argv,
         RedisModule_ReplyWithDouble(ctx, values[i]);
     }
     td_free_(input_ranks);
+    td_free_(quantiles);
+    td_free_(swept);
     td_free_(values);
     return REDISMODULE_OK;
 }
@@ -658,7 +1920,12 @@ int TDigestSketch_Quantile(RedisModuleCtx *ctx, RedisModuleString **argv, int ar
     if (_TDigest_KeyCheck(ctx, key) != REDISMODULE_OK)
         return REDISMODULE_ERR;
 
-    td_histogram_t *tdigest = RedisModule_ModuleTypeGetValue(key);
+    TDigest *sketch = RedisModule_ModuleTypeGetValue(key);
+    td_histogram_t *tdigest = TDigest_View(sketch);
+    if (!tdigest) {
+        RedisModule_CloseKey(key);
+        return RedisModule_ReplyWithError(ctx, "ERR T-Digest: overflow detected");
+    }
 
     const size_t n_quantiles = argc - 2;
     double *quantiles = (double *)td_malloc_(n_quantiles * sizeof(double));
@@ -676,13 +1943,7 @@ int TDigestSketch_Quantile(RedisModuleCtx *ctx, RedisModuleString **argv, int ar
         }
     }
     double *values = (double *)td_malloc_(n_quantiles * sizeof(double));
-    for (int i = 0; i < n_quantiles; ++i) {
-        int start = i;
-        while (i < n_quantiles - 1 && quantiles[i] <= quantiles[i + 1]) {
-            ++i;
-        }
-        td_quantiles(tdigest, quantiles + start, values + start, i - start + 1);
-    }
+    _TDigest_Quantiles(sketch, quantiles, values, n_quantiles);
     RedisModule_CloseKey(key);
     RedisModule_ReplyWithArray(ctx, n_quantiles);
     for (int i = 0; i < n_quantiles; ++i) {
@@ -716,7 +1977,12 @@ int TDigestSketch_Cdf(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
     if (_TDigest_KeyCheck(ctx, key) != REDISMODULE_OK)
         return REDISMODULE_ERR;
 
-    td_histogram_t *tdigest = RedisModule_ModuleTypeGetValue(key);
+    TDigest *sketch = RedisModule_ModuleTypeGetValue(key);
+    td_histogram_t *tdigest = TDigest_View(sketch);
+    if (!tdigest) {
+        RedisModule_CloseKey(key);
+        return RedisModule_ReplyWithError(ctx, "ERR T-Digest: overflow detected");
+    }
 
     const size_t n_cdfs = argc - 2;
     double *cdfs = (double *)td_malloc_(n_cdfs * sizeof(double));
@@ -729,9 +1995,7 @@ int TDigestSketch_Cdf(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
         }
     }
     double *values = (double *)td_malloc_(n_cdfs * sizeof(double));
-    for (int i = 0; i < n_cdfs; ++i) {
-        values[i] = td_cdf(tdigest, cdfs[i]);
-    }
+    _TDigest_Cdfs(sketch, cdfs, values, n_cdfs);
     RedisModule_CloseKey(key);
     RedisModule_ReplyWithArray(ctx, n_cdfs);
     for (int i = 0; i < n_cdfs; ++i) {
@@ -743,6 +2007,129 @@ int TDigestSketch_Cdf(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
     return REDISMODULE_OK;
 }
 
+/**
+ * Helper method to utilize TDIGEST.MQUANTILE and TDIGEST.MCDF common logic.
+ * The input keys are merged into a scratch digest that only lives for the duration of the command,
+ * so nothing is written to the keyspace or replicated.
+ */
+static int _TDigest_MultiKeyQuery(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
+                                  int cdf) {
+    if (argc < 5) {
+        return RedisModule_WrongArity(ctx);
+    }
+    long long numkeys = 1;
+    if (RedisModule_StringToLongLong(argv[1], &numkeys) != REDISMODULE_OK) {
+        return RedisModule_ReplyWithError(ctx, "ERR T-Digest: error parsing numkeys");
+    }
+    if (numkeys <= 0) {
+        return RedisModule_ReplyWithError(ctx,
+                                          "ERR T-Digest: numkeys needs to be a positive integer");
+    }
+    if (numkeys > (argc - 4)) {
+        return RedisModule_WrongArity(ctx);
+    }
+    const int token_pos = numkeys + 2;
+    if (RMUtil_ArgIndex(cdf ? "VALUES" : "QUANTILES", argv + token_pos, 1) != 0) {
+        return RedisModule_ReplyWithError(ctx, "ERR T-Digest: wrong keyword");
+    }
+
+    const size_t n_inputs = argc - token_pos - 1;
+    double *inputs = (double *)td_malloc_(n_inputs * sizeof(double));
+    for (int i = 0; i < n_inputs; ++i) {
+        if (RedisModule_StringToDouble(argv[token_pos + 1 + i], &inputs[i]) != REDISMODULE_OK) {
+            td_free_(inputs);
+            return RedisModule_ReplyWithError(ctx, cdf ? "ERR T-Digest: error parsing cdf"
+                                                       : "ERR T-Digest: error parsing quantile");
+        }
+        if (!cdf && (inputs[i] < 0 || inputs[i] > 1.0)) {
+            td_free_(inputs);
+            return RedisModule_ReplyWithError(ctx, "ERR T-Digest: quantile should be in [0,1]");
+        }
+    }
+
+    td_histogram_t **sources = (td_histogram_t **)td_calloc_(numkeys, sizeof(td_histogram_t *));
+    td_histogram_t *merged = NULL;
+    long long compression = 0;
+    int res = REDISMODULE_ERR;
+    for (int i = 0; i < numkeys; ++i) {
+        RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[2 + i], REDISMODULE_READ);
+        if (_TDigest_KeyCheck(ctx, key) != REDISMODULE_OK) {
+            goto cleanup;
+        }
+        TDigest *sketch = RedisModule_ModuleTypeGetValue(key);
+        sources[i] = TDigest_View(sketch);
+        RedisModule_CloseKey(key);
+        if (!sources[i]) {
+            RedisModule_ReplyWithError(ctx, "ERR T-Digest: overflow detected");
+            goto cleanup;
+        }
+        compression = sources[i]->compression > compression ? sources[i]->compression : compression;
+    }
+    if (td_init(compression, &merged) != 0) {
+        RedisModule_ReplyWithError(ctx, "ERR T-Digest: allocation failed");
+        goto cleanup;
+    }
+    const int merge_res = _TDigest_MergeInto(merged, sources, numkeys);
+    bool overflow = merge_res == EDOM;
+    for (int i = 0; !overflow && merge_res != 0 && i < numkeys; ++i) {
+        overflow = td_merge(merged, sources[i]) != 0;
+    }
+    if (overflow) {
+        RedisModule_ReplyWithError(ctx, "ERR T-Digest: overflow detected");
+        goto cleanup;
+    }
+
+    double *results = (double *)td_malloc_(n_inputs * sizeof(double));
+    if (cdf) {
+        _TDigest_CdfSweep(merged, inputs, results, n_inputs);
+    } else {
+        _TDigest_QuantileSweep(merged, inputs, results, n_inputs);
+    }
+    RedisModule_ReplyWithArray(ctx, n_inputs);
+    for (int i = 0; i < n_inputs; ++i) {
+        RedisModule_ReplyWithDouble(ctx, results[i]);
+    }
+    td_free_(results);
+    res = REDISMODULE_OK;
+
+cleanup:
+    if (merged)
+        td_free(merged);
+    td_free_(sources);
+    td_free_(inputs);
+    return res;
+}
+
+/**
+ * Command: TDIGEST.MQUANTILE numkeys key [key ...] QUANTILES quantile [quantile ...]
+ *
+ * Returns, for each input fraction, an estimation of the value smaller than the given fraction of
+ * observations over the union of all input keys, as if they had been merged with TDIGEST.MERGE.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int TDigestSketch_MQuantile(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    return _TDigest_MultiKeyQuery(ctx, argv, argc, 0);
+}
+
+/**
+ * Command: TDIGEST.MCDF numkeys key [key ...] VALUES value [value ...]
+ *
+ * Returns, for each input value, the fraction of all points added to any of the input keys which
+ * are <= value, as if the keys had been merged with TDIGEST.MERGE.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int TDigestSketch_MCdf(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    return _TDigest_MultiKeyQuery(ctx, argv, argc, 1);
+}
+
 /**
  * Command: TDIGEST.TRIMMED_MEAN {key} {low_cut_percentile} {high_cut_percentile}
  *
@@ -763,7 +2150,12 @@ int TDigestSketch_TrimmedMean(RedisModuleCtx *ctx, RedisModuleString **argv, int
     if (_TDigest_KeyCheck(ctx, key) != REDISMODULE_OK)
         return REDISMODULE_ERR;
 
-    td_histogram_t *tdigest = RedisModule_ModuleTypeGetValue(key);
+    TDigest *sketch = RedisModule_ModuleTypeGetValue(key);
+    td_histogram_t *tdigest = TDigest_View(sketch);
+    if (!tdigest) {
+        RedisModule_CloseKey(key);
+        return RedisModule_ReplyWithError(ctx, "ERR T-Digest: overflow detected");
+    }
 
     double low_cut_percentile = 0.0;
     double high_cut_percentile = 0.0;
@@ -796,7 +2188,9 @@ int TDigestSketch_TrimmedMean(RedisModuleCtx *ctx, RedisModuleString **argv, int
  * Command: TDIGEST.INFO {key}
  *
  * Returns compression, capacity, total merged and unmerged nodes, the total compressions
- * made up to date on that key, and merged and unmerged weight.
+ * made up to date on that key, merged and unmerged weight, and whether the sketch still holds the
+ * exact samples or a digest. For a sliding window digest these describe the samples inside the
+ * window, followed by the window duration and number of buckets.
  *
  * @param ctx Context in which Redis modules operate
  * @param argv Redis command arguments, as an array of strings
@@ -813,9 +2207,14 @@ int TDigestSketch_Info(RedisModuleCtx *ctx, RedisModuleString **argv, int argc)
     if (_TDigest_KeyCheck(ctx, key) != REDISMODULE_OK)
         return REDISMODULE_ERR;
 
-    td_histogram_t *tdigest = RedisModule_ModuleTypeGetValue(key);
+    TDigest *sketch = RedisModule_ModuleTypeGetValue(key);
+    td_histogram_t *tdigest = TDigest_View(sketch);
+    if (!tdigest) {
+        RedisModule_CloseKey(key);
+        return RedisModule_ReplyWithError(ctx, "ERR T-Digest: overflow detected");
+    }
 
-    RedisModule_ReplyWithMapOrArray(ctx, 9 * 2, true);
+    RedisModule_ReplyWithMapOrArray(ctx, (sketch->nBuckets ? 12 : 10) * 2, true);
     RedisModule_ReplyWithSimpleString(ctx, "Compression");
     RedisModule_ReplyWithLongLong(ctx, tdigest->compression);
     RedisModule_ReplyWithSimpleString(ctx, "Capacity");
@@ -833,14 +2232,60 @@ int TDigestSketch_Info(RedisModuleCtx *ctx, RedisModuleString **argv, int argc)
     RedisModule_ReplyWithSimpleString(ctx, "Total compressions");
     RedisModule_ReplyWithLongLong(ctx, tdigest->total_compressions);
     RedisModule_ReplyWithSimpleString(ctx, "Memory usage");
-    const size_t size_b = TDigestMemUsage(tdigest);
+    const size_t size_b = TDigestMemUsage(sketch);
     RedisModule_ReplyWithLongLong(ctx, size_b);
+    RedisModule_ReplyWithSimpleString(ctx, "Mode");
+    RedisModule_ReplyWithSimpleString(ctx, sketch->exact ? "exact" : "digest");
+    if (sketch->nBuckets) {
+        RedisModule_ReplyWithSimpleString(ctx, "Window");
+        RedisModule_ReplyWithLongLong(ctx, sketch->window);
+        RedisModule_ReplyWithSimpleString(ctx, "Buckets");
+        RedisModule_ReplyWithLongLong(ctx, sketch->nBuckets);
+    }
     RedisModule_CloseKey(key);
     return REDISMODULE_OK;
 }
 
-void TDigestRdbSave(RedisModuleIO *rdb, void *value) {
-    td_histogram_t *tdigest = value;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define TDIGEST_BIG_ENDIAN 1
+#endif
+
+// Saves 'n' 8-byte words (doubles or long longs) as a single little-endian string buffer.
+static void _TDigest_SaveWords(RedisModuleIO *rdb, const void *words, size_t n) {
+#ifdef TDIGEST_BIG_ENDIAN
+    uint64_t *buf = RedisModule_Alloc(n * sizeof *buf);
+    memcpy(buf, words, n * sizeof *buf);
+    for (size_t i = 0; i < n; i++) {
+        buf[i] = __builtin_bswap64(buf[i]);
+    }
+    RedisModule_SaveStringBuffer(rdb, (const char *)buf, n * sizeof *buf);
+    RedisModule_Free(buf);
+#else
+    RedisModule_SaveStringBuffer(rdb, words, n * sizeof(uint64_t));
+#endif
+}
+
+// Loads 'n' 8-byte little-endian words saved by _TDigest_SaveWords into 'words'.
+static int _TDigest_LoadWords(RedisModuleIO *rdb, void *words, size_t n, bool *err) {
+    size_t len = 0;
+    char *buf = LoadStringBuffer_IOError(rdb, &len, *err, REDISMODULE_ERR);
+    if (len != n * sizeof(uint64_t)) {
+        RedisModule_Free(buf);
+        *err = true;
+        return REDISMODULE_ERR;
+    }
+    memcpy(words, buf, len);
+    RedisModule_Free(buf);
+#ifdef TDIGEST_BIG_ENDIAN
+    uint64_t *w = words;
+    for (size_t i = 0; i < n; i++) {
+        w[i] = __builtin_bswap64(w[i]);
+    }
+#endif
+    return REDISMODULE_OK;
+}
+
+static void _TDigest_SaveHistogram(RedisModuleIO *rdb, td_histogram_t *tdigest) {
     // ensure there is no unmerged node
     td_compress(tdigest);
     // compression is a setting used to configure the size of centroids when merged.
@@ -861,71 +2306,188 @@ void TDigestRdbSave(RedisModuleIO *rdb, void *value) {
     RedisModule_SaveDouble(rdb, tdigest->merged_weight);
     RedisModule_SaveDouble(rdb, tdigest->unmerged_weight);
 
-    for (size_t i = 0; i < tdigest->merged_nodes; i++) {
-        const double mean = tdigest->nodes_mean[i];
-        RedisModule_SaveDouble(rdb, mean);
-    }
-    for (size_t i = 0; i < tdigest->merged_nodes; i++) {
-        const double count = tdigest->nodes_weight[i];
-        RedisModule_SaveDouble(rdb, count);
-    }
+    // the centroids are stored as two contiguous little-endian buffers of 8-byte words
+    _TDigest_SaveWords(rdb, tdigest->nodes_mean, tdigest->merged_nodes);
+    _TDigest_SaveWords(rdb, tdigest->nodes_weight, tdigest->merged_nodes);
 }
 
-void *TDigestRdbLoad(RedisModuleIO *rdb, int encver) {
-    /* Load the network layout. */
-    bool err = false;
-    const double compression = LoadDouble_IOError(rdb, err, NULL);
-    td_histogram_t *tdigest = td_new(compression);
-    errdefer(err, td_free(tdigest));
-    tdigest->min = LoadDouble_IOError(rdb, err, NULL);
-    tdigest->max = LoadDouble_IOError(rdb, err, NULL);
+void TDigestRdbSave(RedisModuleIO *rdb, void *value) {
+    TDigest *sketch = value;
+    // the samples of an exact histogram are all merged nodes, which td_compress keeps as they are
+    RedisModule_SaveUnsigned(rdb, sketch->exact);
+    _TDigest_SaveHistogram(rdb, sketch->td);
+    // sliding window: the buckets and the time slot each one holds
+    RedisModule_SaveSigned(rdb, sketch->nBuckets);
+    if (sketch->nBuckets) {
+        RedisModule_SaveSigned(rdb, sketch->window);
+        for (long long i = 0; i < sketch->nBuckets; i++) {
+            RedisModule_SaveSigned(rdb, sketch->bucketSlot[i]);
+            _TDigest_SaveHistogram(rdb, sketch->buckets[i]);
+        }
+    }
+}
 
+static td_histogram_t *_TDigest_LoadHistogram(RedisModuleIO *rdb, int encver, bool exact,
+                                              bool *err) {
+    const double compression = LoadDouble_IOError(rdb, *err, NULL);
+    const double min = LoadDouble_IOError(rdb, *err, NULL);
+    const double max = LoadDouble_IOError(rdb, *err, NULL);
     // cap is the total size of nodes
-    tdigest->cap = LoadSigned_IOError(rdb, err, NULL);
+    const long long cap = LoadSigned_IOError(rdb, *err, NULL);
+
+    td_histogram_t *tdigest = NULL;
+    if (!exact) {
+        tdigest = td_new(compression);
+    } else if (compression > 0 && cap > 0 &&
+               cap <= 2 * TD_EXACT_MAX_FACTOR * compression + TD_EXACT_INITIAL_CAP) {
+        // exact histograms are sized to their samples
+        tdigest = _TDigest_NewExact(compression, cap);
+    }
+    if (!tdigest) {
+        *err = true;
+        return NULL;
+    }
+    errdefer(*err, td_free(tdigest));
+    // number of centroid slots actually allocated
+    const long long allocated = tdigest->cap;
+    tdigest->min = min;
+    tdigest->max = max;
+    tdigest->cap = cap;
 
     // merged_nodes is the number of merged nodes at the front of nodes.
-    tdigest->merged_nodes = LoadSigned_IOError(rdb, err, NULL);
+    tdigest->merged_nodes = LoadSigned_IOError(rdb, *err, NULL);
 
     // unmerged_nodes is the number of buffered nodes.
-    tdigest->unmerged_nodes = LoadSigned_IOError(rdb, err, NULL);
+    tdigest->unmerged_nodes = LoadSigned_IOError(rdb, *err, NULL);
 
     // we run the merge in reverse every other merge to avoid left-to-right bias in merging
-    tdigest->total_compressions = LoadSigned_IOError(rdb, err, NULL);
+    tdigest->total_compressions = LoadSigned_IOError(rdb, *err, NULL);
 
-    tdigest->merged_weight = LoadDouble_IOError(rdb, err, NULL);
-    tdigest->unmerged_weight = LoadDouble_IOError(rdb, err, NULL);
+    tdigest->merged_weight = LoadDouble_IOError(rdb, *err, NULL);
+    tdigest->unmerged_weight = LoadDouble_IOError(rdb, *err, NULL);
 
-    if (tdigest->merged_nodes < 0 || tdigest->merged_nodes > tdigest->cap) {
-        err = true;
+    if (tdigest->merged_nodes < 0 || tdigest->merged_nodes > tdigest->cap ||
+        tdigest->merged_nodes > allocated) {
+        *err = true;
         return NULL;
     }
 
-    for (size_t i = 0; i < tdigest->merged_nodes; i++) {
-        tdigest->nodes_mean[i] = LoadDouble_IOError(rdb, err, NULL);
+    if (encver >= TDIGEST_MIN_BULK_ENC) {
+        if (_TDigest_LoadWords(rdb, tdigest->nodes_mean, tdigest->merged_nodes, err) !=
+                REDISMODULE_OK ||
+            _TDigest_LoadWords(rdb, tdigest->nodes_weight, tdigest->merged_nodes, err) !=
+                REDISMODULE_OK) {
+            return NULL;
+        }
+    } else {
+        for (size_t i = 0; i < tdigest->merged_nodes; i++) {
+            tdigest->nodes_mean[i] = LoadDouble_IOError(rdb, *err, NULL);
+        }
+        for (size_t i = 0; i < tdigest->merged_nodes; i++) {
+            tdigest->nodes_weight[i] = LoadDouble_IOError(rdb, *err, NULL);
+        }
     }
-    for (size_t i = 0; i < tdigest->merged_nodes; i++) {
-        tdigest->nodes_weight[i] = LoadDouble_IOError(rdb, err, NULL);
+    // the samples of an exact histogram are kept in order by _TDigest_ExactAdd
+    for (long long i = 1; exact && i < tdigest->merged_nodes; i++) {
+        if (_TDigest_NodeLess(tdigest->nodes_mean, tdigest->nodes_weight, i, i - 1)) {
+            *err = true;
+            return NULL;
+        }
+    }
+    if (exact && tdigest->unmerged_nodes != 0) {
+        *err = true;
+        return NULL;
     }
     return tdigest;
 }
 
-void TDigestFree(void *value) {
-    td_histogram_t *tdigest = value;
-    td_free(tdigest);
+void *TDigestRdbLoad(RedisModuleIO *rdb, int encver) {
+    if (encver > TDIGEST_ENC_VER) {
+        return NULL;
+    }
+    /* Load the network layout. */
+    bool err = false;
+    bool exact = false;
+    if (encver >= TDIGEST_MIN_EXACT_ENC) {
+        exact = LoadUnsigned_IOError(rdb, err, NULL) != 0;
+    }
+    td_histogram_t *tdigest = _TDigest_LoadHistogram(rdb, encver, exact, &err);
+    if (!tdigest) {
+        return NULL;
+    }
+    TDigest *sketch = TDigest_Wrap(tdigest);
+    if (!sketch) {
+        td_free(tdigest);
+        return NULL;
+    }
+    sketch->exact = exact;
+    errdefer(err, TDigest_Free(sketch));
+    if (encver < TDIGEST_MIN_WINDOW_ENC) {
+        return sketch;
+    }
+    const long long n_buckets = LoadSigned_IOError(rdb, err, NULL);
+    if (n_buckets == 0) {
+        return sketch;
+    }
+    const long long window = LoadSigned_IOError(rdb, err, NULL);
+    if (n_buckets < 0 || n_buckets > TD_MAX_WINDOW_BUCKETS || window < n_buckets) {
+        err = true;
+        return NULL;
+    }
+    sketch->window = window;
+    sketch->nBuckets = n_buckets;
+    sketch->viewSlot = LLONG_MIN;
+    sketch->buckets = td_calloc_(n_buckets, sizeof *sketch->buckets);
+    sketch->bucketSlot = td_calloc_(n_buckets, sizeof *sketch->bucketSlot);
+    if (!sketch->buckets || !sketch->bucketSlot) {
+        err = true;
+        return NULL;
+    }
+    for (long long i = 0; i < n_buckets; i++) {
+        sketch->bucketSlot[i] = LoadSigned_IOError(rdb, err, NULL);
+        if (!(sketch->buckets[i] = _TDigest_LoadHistogram(rdb, encver, false, &err))) {
+            return NULL;
+        }
+    }
+    return sketch;
 }
 
+void TDigestFree(void *value) { TDigest_Free(value); }
+
 static int TDigestDefrag(RedisModuleDefragCtx *ctx, RedisModuleString *key, void **value) {
     *value = defragPtr(ctx, *value);
-    td_histogram_t *tdigest = *value;
+    TDigest *sketch = *value;
+    sketch->td = defragPtr(ctx, sketch->td);
+    td_histogram_t *tdigest = sketch->td;
     tdigest->nodes_mean = defragPtr(ctx, tdigest->nodes_mean);
     tdigest->nodes_weight = defragPtr(ctx, tdigest->nodes_weight);
+    if (sketch->prefix) {
+        sketch->prefix = defragPtr(ctx, sketch->prefix);
+    }
+    if (sketch->nBuckets) {
+        sketch->buckets = defragPtr(ctx, sketch->buckets);
+        sketch->bucketSlot = defragPtr(ctx, sketch->bucketSlot);
+        for (long long i = 0; i < sketch->nBuckets; i++) {
+            td_histogram_t *bucket = sketch->buckets[i] = defragPtr(ctx, sketch->buckets[i]);
+            bucket->nodes_mean = defragPtr(ctx, bucket->nodes_mean);
+            bucket->nodes_weight = defragPtr(ctx, bucket->nodes_weight);
+        }
+    }
+    return 0;
 }
 
 size_t TDigestMemUsage(const void *value) {
-    const td_histogram_t *tdigest = value;
-    size_t size = sizeof *tdigest;
+    const TDigest *sketch = value;
+    const td_histogram_t *tdigest = sketch->td;
+    size_t size = sizeof *sketch + sizeof *tdigest;
     size += sizeof *tdigest->nodes_mean * tdigest->cap;
     size += sizeof *tdigest->nodes_weight * tdigest->cap;
+    size += sizeof *sketch->prefix * sketch->prefixCap;
+    for (long long i = 0; i < sketch->nBuckets; i++) {
+        const td_histogram_t *bucket = sketch->buckets[i];
+        size += sizeof *sketch->buckets + sizeof *sketch->bucketSlot + sizeof *bucket;
+        size += (sizeof *bucket->nodes_mean + sizeof *bucket->nodes_weight) * bucket->cap;
+    }
     return size;
 }
 
@@ -952,6 +2514,8 @@ int TDigestModule_onLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc
     RegisterAclCategory(ctx, "tdigest");
     RegisterCommand(ctx, "tdigest.create", TDigestSketch_Create, "write deny-oom", "write fast");
     RegisterCommand(ctx, "tdigest.add", TDigestSketch_Add, "write deny-oom", "write");
+    RegisterCommand(ctx, "tdigest.addweighted", TDigestSketch_AddWeighted, "write deny-oom",
+                    "write");
     RegisterCommand(ctx, "tdigest.reset", TDigestSketch_Reset, "write deny-oom", "write fast");
     RegisterCommand(ctx, "tdigest.merge", TDigestSketch_Merge, "write deny-oom", "write");
     RegisterCommand(ctx, "tdigest.min", TDigestSketch_Min, "readonly", "read fast");
@@ -962,6 +2526,8 @@ int TDigestModule_onLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc
     RegisterCommand(ctx, "tdigest.rank", TDigestSketch_Rank, "readonly", "read fast");
     RegisterCommand(ctx, "tdigest.revrank", TDigestSketch_RevRank, "readonly", "read fast");
     RegisterCommand(ctx, "tdigest.cdf", TDigestSketch_Cdf, "readonly", "read fast");
+    RegisterCommand(ctx, "tdigest.mquantile", TDigestSketch_MQuantile, "readonly", "read");
+    RegisterCommand(ctx, "tdigest.mcdf", TDigestSketch_MCdf, "readonly", "read");
     RegisterCommand(ctx, "tdigest.trimmed_mean", TDigestSketch_TrimmedMean, "readonly", "read");
     RegisterCommand(ctx, "tdigest.info", TDigestSketch_Info, "readonly", "read fast");
 
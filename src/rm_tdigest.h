@@ -11,6 +11,12 @@
 
 #include "redismodule.h"
 
-#define TDIGEST_ENC_VER 0
+#define TDIGEST_ENC_VER 3
+// first encoding storing the centroids as two little-endian buffers
+#define TDIGEST_MIN_BULK_ENC 1
+// first encoding storing the sliding window buckets
+#define TDIGEST_MIN_WINDOW_ENC 2
+// first encoding storing whether the sketch holds exact samples
+#define TDIGEST_MIN_EXACT_ENC 3
 
 int TDigestModule_onLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc);
@@ -0,0 +1,376 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#include "theta.h"
+#include "rm_theta.h"
+#include "rm_cms.h"
+
+#include "rmutil/util.h"
+#include "version.h"
+#include "common.h"
+#include "cmd_info/command_info.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "load_io_error.h"
+
+RedisModuleType *ThetaType;
+
+static int _Theta_KeyCheck(RedisModuleCtx *ctx, RedisModuleKey *key) {
+    if (RedisModule_KeyType(key) == REDISMODULE_KEYTYPE_EMPTY) {
+        RedisModule_CloseKey(key);
+        RedisModule_ReplyWithError(ctx, "ERR THETA: key does not exist");
+        return REDISMODULE_ERR;
+    } else if (RedisModule_ModuleTypeGetType(key) != ThetaType) {
+        RedisModule_CloseKey(key);
+        RedisModule_ReplyWithError(ctx, REDISMODULE_ERRORMSG_WRONGTYPE);
+        return REDISMODULE_ERR;
+    }
+    return REDISMODULE_OK;
+}
+
+/**
+ * Command: THETA.CREATE {key} [K {k}]
+ *
+ * Creates an empty sketch of 'k' nominal entries, a power of two from 16 to 1048576, and 4096
+ * by default. Its estimates have a relative standard error of about 1 / sqrt(k), and it uses up
+ * to 16 * k bytes.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int Theta_CreateCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc != 2 && argc != 4) {
+        return RedisModule_WrongArity(ctx);
+    }
+    long long k = THETA_DEFAULT_K;
+    if (argc == 4) {
+        if (RMUtil_ArgIndex("K", argv + 2, 1) != 0) {
+            return RedisModule_ReplyWithError(ctx, "ERR THETA: wrong keyword");
+        } else if (RedisModule_StringToLongLong(argv[3], &k) != REDISMODULE_OK ||
+                   k < THETA_MIN_K || k > THETA_MAX_K || (k & (k - 1))) {
+            return RedisModule_ReplyWithError(
+                ctx, "ERR THETA: k needs to be a power of two between 16 and 1048576");
+        }
+    }
+
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ | REDISMODULE_WRITE);
+    if (RedisModule_KeyType(key) != REDISMODULE_KEYTYPE_EMPTY) {
+        RedisModule_CloseKey(key);
+        return RedisModule_ReplyWithError(ctx, "ERR THETA: key already exists");
+    }
+    RedisModule_ModuleTypeSetValue(key, ThetaType, Theta_New(k));
+    RedisModule_CloseKey(key);
+    RedisModule_ReplicateVerbatim(ctx);
+    return RedisModule_ReplyWithSimpleString(ctx, "OK");
+}
+
+/**
+ * Command: THETA.ADD {key} {item} [{item} ...]
+ *
+ * Adds one or more items to the sketch, which is created with the default k if it does not
+ * exist.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int Theta_AddCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc < 3) {
+        return RedisModule_WrongArity(ctx);
+    }
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ | REDISMODULE_WRITE);
+    ThetaSketch *ts;
+    if (RedisModule_KeyType(key) == REDISMODULE_KEYTYPE_EMPTY) {
+        ts = Theta_New(THETA_DEFAULT_K);
+        RedisModule_ModuleTypeSetValue(key, ThetaType, ts);
+    } else if (_Theta_KeyCheck(ctx, key) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+    } else {
+        ts = RedisModule_ModuleTypeGetValue(key);
+    }
+
+    for (int i = 2; i < argc; i++) {
+        size_t len;
+        const char *item = RedisModule_StringPtrLen(argv[i], &len);
+        Theta_Add(ts, Theta_Hash(item, len));
+    }
+    RedisModule_CloseKey(key);
+    RedisModule_ReplicateVerbatim(ctx);
+    return RedisModule_ReplyWithSimpleString(ctx, "OK");
+}
+
+/**
+ * Command: THETA.ESTIMATE {key}
+ *
+ * Returns the estimated number of distinct items added to the sketch, and 0 if it does not
+ * exist.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int Theta_EstimateCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc != 2) {
+        return RedisModule_WrongArity(ctx);
+    }
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
+    if (RedisModule_KeyType(key) == REDISMODULE_KEYTYPE_EMPTY) {
+        RedisModule_CloseKey(key);
+        return RedisModule_ReplyWithDouble(ctx, 0);
+    } else if (_Theta_KeyCheck(ctx, key) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+    }
+    const ThetaSketch *ts = RedisModule_ModuleTypeGetValue(key);
+    RedisModule_ReplyWithDouble(ctx, Theta_Estimate(ts));
+    RedisModule_CloseKey(key);
+    return REDISMODULE_OK;
+}
+
+// Replaces the destination key of a set operation with its result
+static int _Theta_StoreResult(RedisModuleCtx *ctx, RedisModuleString *dest, ThetaSketch *ts) {
+    if (!ts) {
+        return RedisModule_ReplyWithError(ctx, "ERR THETA: allocation failed");
+    }
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, dest, REDISMODULE_READ | REDISMODULE_WRITE);
+    RedisModule_ModuleTypeSetValue(key, ThetaType, ts);
+    RedisModule_CloseKey(key);
+    RedisModule_ReplicateVerbatim(ctx);
+    return RedisModule_ReplyWithSimpleString(ctx, "OK");
+}
+
+// Returns the sketches of the source keys of a set operation, or NULL after replying with an
+// error if one does not exist or the destination is of another type
+static const ThetaSketch **_Theta_GetSources(RedisModuleCtx *ctx, RedisModuleString *dest,
+                                             RedisModuleString **argv, long long n) {
+    RedisModuleKey *destKey = RedisModule_OpenKey(ctx, dest, REDISMODULE_READ);
+    if (RedisModule_KeyType(destKey) != REDISMODULE_KEYTYPE_EMPTY &&
+        RedisModule_ModuleTypeGetType(destKey) != ThetaType) {
+        RedisModule_CloseKey(destKey);
+        RedisModule_ReplyWithError(ctx, REDISMODULE_ERRORMSG_WRONGTYPE);
+        return NULL;
+    }
+    RedisModule_CloseKey(destKey);
+
+    const ThetaSketch **sources = RedisModule_Calloc(n, sizeof *sources);
+    for (long long i = 0; i < n; i++) {
+        RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[i], REDISMODULE_READ);
+        if (_Theta_KeyCheck(ctx, key) != REDISMODULE_OK) {
+            RedisModule_Free(sources);
+            return NULL;
+        }
+        sources[i] = RedisModule_ModuleTypeGetValue(key);
+        RedisModule_CloseKey(key);
+    }
+    return sources;
+}
+
+static int _Theta_SetOpCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
+                               bool intersect) {
+    if (argc < 4) {
+        return RedisModule_WrongArity(ctx);
+    }
+    long long numkeys = 0;
+    if (RedisModule_StringToLongLong(argv[2], &numkeys) != REDISMODULE_OK || numkeys <= 0) {
+        return RedisModule_ReplyWithError(ctx,
+                                          "ERR THETA: numkeys needs to be a positive integer");
+    }
+    if (numkeys != argc - 3) {
+        return RedisModule_WrongArity(ctx);
+    }
+    const ThetaSketch **sources = _Theta_GetSources(ctx, argv[1], argv + 3, numkeys);
+    if (!sources) {
+        return REDISMODULE_ERR;
+    }
+    // the result is built aside, so a destination that is also a source is read as it was
+    ThetaSketch *ts =
+        intersect ? Theta_Intersect(sources, numkeys) : Theta_Union(sources, numkeys);
+    RedisModule_Free(sources);
+    return _Theta_StoreResult(ctx, argv[1], ts);
+}
+
+/**
+ * Command: THETA.UNION {destination} {numkeys} {source} [{source} ...]
+ *
+ * Stores in 'destination' a sketch of the union of the sets of the sources, which replaces its
+ * value if it exists. Its k is the largest of theirs.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int Theta_UnionCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    return _Theta_SetOpCommand(ctx, argv, argc, false);
+}
+
+/**
+ * Command: THETA.INTERSECT {destination} {numkeys} {source} [{source} ...]
+ *
+ * Stores in 'destination' a sketch of the intersection of the sets of the sources, which
+ * replaces its value if it exists. Its k is the largest of theirs.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int Theta_IntersectCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    return _Theta_SetOpCommand(ctx, argv, argc, true);
+}
+
+/**
+ * Command: THETA.ANOTB {destination} {a} {b}
+ *
+ * Stores in 'destination' a sketch of the items of the set of 'a' that are not in the set of
+ * 'b', which replaces its value if it exists. Its k is that of 'a'.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int Theta_AnotBCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc != 4) {
+        return RedisModule_WrongArity(ctx);
+    }
+    const ThetaSketch **sources = _Theta_GetSources(ctx, argv[1], argv + 2, 2);
+    if (!sources) {
+        return REDISMODULE_ERR;
+    }
+    ThetaSketch *ts = Theta_AnotB(sources[0], sources[1]);
+    RedisModule_Free(sources);
+    return _Theta_StoreResult(ctx, argv[1], ts);
+}
+
+size_t ThetaMemUsage(const void *value) {
+    const ThetaSketch *ts = value;
+    return sizeof *ts + Theta_Bytes(ts);
+}
+
+/**
+ * Command: THETA.INFO {key}
+ *
+ * Returns the nominal entries, the fraction of the hash space retained, the number of retained
+ * hashes, and the memory usage of the sketch.
+ *
+ * @param ctx Context in which Redis modules operate
+ * @param argv Redis command arguments, as an array of strings
+ * @param argc Redis command number of arguments
+ * @return REDISMODULE_OK on success, or REDISMODULE_ERR  if the command failed
+ */
+int Theta_InfoCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc != 2) {
+        return RedisModule_WrongArity(ctx);
+    }
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, argv[1], REDISMODULE_READ);
+    if (_Theta_KeyCheck(ctx, key) != REDISMODULE_OK) {
+        return REDISMODULE_ERR;
+    }
+    const ThetaSketch *ts = RedisModule_ModuleTypeGetValue(key);
+    RedisModule_ReplyWithMapOrArray(ctx, 4 * 2, true);
+    RedisModule_ReplyWithSimpleString(ctx, "K");
+    RedisModule_ReplyWithLongLong(ctx, ts->k);
+    RedisModule_ReplyWithSimpleString(ctx, "Theta");
+    RedisModule_ReplyWithDouble(ctx, ts->theta == UINT64_MAX
+                                         ? 1
+                                         : (double)ts->theta / 18446744073709551616.0);
+    RedisModule_ReplyWithSimpleString(ctx, "Retained");
+    RedisModule_ReplyWithLongLong(ctx, ts->count);
+    RedisModule_ReplyWithSimpleString(ctx, "Size");
+    RedisModule_ReplyWithLongLong(ctx, ThetaMemUsage(ts));
+    RedisModule_CloseKey(key);
+    return REDISMODULE_OK;
+}
+
+// The retained hashes are saved sorted and without the empty slots of the table
+void ThetaRdbSave(RedisModuleIO *rdb, void *value) {
+    const ThetaSketch *ts = value;
+    uint64_t *hashes = RedisModule_Calloc(ts->count + 1, sizeof *hashes);
+    const size_t n = Theta_Sorted(ts, hashes);
+    RedisModule_SaveUnsigned(rdb, ts->k);
+    RedisModule_SaveUnsigned(rdb, ts->theta);
+    RedisModule_SaveStringBuffer(rdb, (const char *)hashes, n * sizeof *hashes);
+    RedisModule_Free(hashes);
+}
+
+void ThetaFree(void *value) { Theta_Free(value); }
+
+void *ThetaRdbLoad(RedisModuleIO *rdb, int encver) {
+    if (encver > THETA_ENC_VER) {
+        return NULL;
+    }
+    char *hashes = NULL;
+    bool err = false;
+    errdefer(err, if (hashes) RedisModule_Free(hashes));
+    const uint64_t k = LoadUnsigned_IOError(rdb, err, NULL);
+    const uint64_t theta = LoadUnsigned_IOError(rdb, err, NULL);
+    size_t len;
+    hashes = LoadStringBuffer_IOError(rdb, &len, err, NULL);
+    if (k > THETA_MAX_K || len % sizeof(uint64_t) != 0) {
+        err = true;
+        return NULL;
+    }
+    // the hashes are copied, as the buffer may not be aligned
+    uint64_t *sorted = RedisModule_Calloc(len / sizeof(uint64_t) + 1, sizeof *sorted);
+    memcpy(sorted, hashes, len);
+    RedisModule_Free(hashes);
+    hashes = NULL;
+    ThetaSketch *ts = Theta_FromSorted(k, theta, sorted, len / sizeof(uint64_t));
+    RedisModule_Free(sorted);
+    return ts;
+}
+
+static int ThetaDefrag(RedisModuleDefragCtx *ctx, RedisModuleString *key, void **value) {
+    *value = defragPtr(ctx, *value);
+    ThetaSketch *ts = *value;
+    ts->table = defragPtr(ctx, ts->table);
+    return 0;
+}
+
+int ThetaModule_onLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    RedisModuleTypeMethods tm = {
+        .version = REDISMODULE_TYPE_METHOD_VERSION,
+        .rdb_load = ThetaRdbLoad,
+        .rdb_save = ThetaRdbSave,
+        .aof_rewrite = RMUtil_DefaultAofRewrite,
+        .mem_usage = ThetaMemUsage,
+        .free = ThetaFree,
+        .defrag = ThetaDefrag,
+    };
+
+    ThetaType = RedisModule_CreateDataType(ctx, "MBbloomTH", THETA_ENC_VER, &tm);
+    if (ThetaType == NULL) {
+        return REDISMODULE_ERR;
+    }
+
+#define RegisterCommand(ctx, name, cmd, mode, acl)                                                 \
+    RegisterCommandWithModesAndAcls(ctx, name, cmd, mode, acl " theta")
+
+    RegisterAclCategory(ctx, "theta");
+    RegisterCommand(ctx, "theta.create", Theta_CreateCommand, "write deny-oom", "write fast");
+    RegisterCommand(ctx, "theta.add", Theta_AddCommand, "write deny-oom", "write");
+    RegisterCommand(ctx, "theta.estimate", Theta_EstimateCommand, "readonly", "read fast");
+    RegisterCommand(ctx, "theta.union", Theta_UnionCommand, "write deny-oom", "write");
+    RegisterCommand(ctx, "theta.intersect", Theta_IntersectCommand, "write deny-oom", "write");
+    RegisterCommand(ctx, "theta.anotb", Theta_AnotBCommand, "write deny-oom", "write");
+    RegisterCommand(ctx, "theta.info", Theta_InfoCommand, "readonly", "read fast");
+
+#undef RegisterCommand
+
+    if (RegisterThetaCommandInfos(ctx) != REDISMODULE_OK)
+        return REDISMODULE_ERR;
+
+    return REDISMODULE_OK;
+}
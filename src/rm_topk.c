@@ -50,7 +50,8 @@ static int GetTopKKey(RedisModuleCtx *ctx, RedisModuleString *keyName, TopK **to
     return REDISMODULE_OK;
 }
 
-static int createTopK(RedisModuleCtx *ctx, RedisModuleString **argv, int argc, TopK **topk) {
+static int createTopK(RedisModuleCtx *ctx, RedisModuleString **argv, int argc, TopKLayout layout,
+                      TopKAlgo algo, TopK **topk) {
     long long tmp_ll;
     uint32_t k, width, depth;
     double decay;
@@ -59,6 +60,16 @@ static int createTopK(RedisModuleCtx *ctx, RedisModuleString **argv, int argc, T
         INNER_ERROR("TopK: invalid k");
     }
     k = (uint32_t)tmp_ll;
+    if (algo == TOPK_ALGO_SPACESAVING) {
+        if (argc != 3 || layout != TOPK_LAYOUT_DEFAULT) {
+            INNER_ERROR("TopK: width/depth/decay/COMPACT do not apply to SPACESAVING");
+        }
+        *topk = TopK_CreateSpaceSaving(k);
+        if (!(*topk)) {
+            INNER_ERROR("ERR Insufficient memory to create topk data structure");
+        }
+        return REDISMODULE_OK;
+    }
     if (argc == 6) {
         if ((RedisModule_StringToLongLong(argv[3], &tmp_ll) != REDISMODULE_OK) ||
             tmp_ll > UINT32_MAX || tmp_ll < 1) {
@@ -79,7 +90,7 @@ static int createTopK(RedisModuleCtx *ctx, RedisModuleString **argv, int argc, T
         depth = TOPK_DEFAULT_DEPTH;
         decay = TOPK_DEFAULT_DECAY;
     }
-    *topk = TopK_Create(k, width, depth, decay);
+    *topk = TopK_CreateWithLayout(k, width, depth, decay, layout);
     if (!(*topk)) {
         INNER_ERROR("ERR Insufficient memory to create topk data structure");
     }
@@ -87,6 +98,20 @@ static int createTopK(RedisModuleCtx *ctx, RedisModuleString **argv, int argc, T
 }
 
 static int TopK_Create_Cmd(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    TopKAlgo algo = TOPK_ALGO_HEAVYKEEPER;
+    if (argc > 4 && RMUtil_ArgIndex("ALGO", argv + argc - 2, 1) == 0) {
+        if (RMUtil_ArgIndex("SPACESAVING", argv + argc - 1, 1) == 0) {
+            algo = TOPK_ALGO_SPACESAVING;
+        } else if (RMUtil_ArgIndex("HEAVYKEEPER", argv + argc - 1, 1) != 0) {
+            return RedisModule_ReplyWithError(ctx, "TopK: invalid algo");
+        }
+        argc -= 2;
+    }
+    TopKLayout layout = TOPK_LAYOUT_DEFAULT;
+    if (argc > 3 && RMUtil_ArgIndex("COMPACT", argv + argc - 1, 1) == 0) {
+        layout = TOPK_LAYOUT_COMPACT;
+        --argc;
+    }
     if (argc != 3 && argc != 6) {
         return RedisModule_WrongArity(ctx);
     }
@@ -98,7 +123,7 @@ static int TopK_Create_Cmd(RedisModuleCtx *ctx, RedisModuleString **argv, int ar
     }
 
     TopK *topk = NULL;
-    if (createTopK(ctx, argv, argc, &topk) != REDISMODULE_OK)
+    if (createTopK(ctx, argv, argc, layout, algo, &topk) != REDISMODULE_OK)
         goto final;
 
     if (RedisModule_ModuleTypeSetValue(key, TopKType, topk) == REDISMODULE_ERR) {
@@ -112,6 +137,17 @@ final:
     return REDISMODULE_OK;
 }
 
+static void replyWithExpelled(RedisModuleCtx *ctx, char **expelled, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (expelled[i] == NULL) {
+            RedisModule_ReplyWithNull(ctx);
+        } else {
+            RedisModule_ReplyWithCString(ctx, expelled[i]);
+            TOPK_FREE(expelled[i]);
+        }
+    }
+}
+
 static int TopK_Add_Cmd(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
 
     if (argc < 3)
@@ -123,20 +159,24 @@ static int TopK_Add_Cmd(RedisModuleCtx *ctx, RedisModuleString **argv, int argc)
     }
 
     int itemCount = argc - 2;
-    RedisModule_ReplyWithArray(ctx, itemCount);
+    const char **items = TOPK_CALLOC(itemCount, sizeof(*items));
+    size_t *itemlens = TOPK_CALLOC(itemCount, sizeof(*itemlens));
+    uint32_t *increments = TOPK_CALLOC(itemCount, sizeof(*increments));
+    char **expelled = TOPK_CALLOC(itemCount, sizeof(*expelled));
 
     for (int i = 0; i < itemCount; ++i) {
-        size_t itemlen;
-        const char *item = RedisModule_StringPtrLen(argv[i + 2], &itemlen);
-        char *expelledItem = TopK_Add(topk, item, itemlen, 1);
-
-        if (expelledItem == NULL) {
-            RedisModule_ReplyWithNull(ctx);
-        } else {
-            RedisModule_ReplyWithCString(ctx, expelledItem);
-            TOPK_FREE(expelledItem);
-        }
+        items[i] = RedisModule_StringPtrLen(argv[i + 2], &itemlens[i]);
+        increments[i] = 1;
     }
+    TopK_AddBatch(topk, items, itemlens, increments, itemCount, expelled);
+
+    RedisModule_ReplyWithArray(ctx, itemCount);
+    replyWithExpelled(ctx, expelled, itemCount);
+
+    TOPK_FREE(expelled);
+    TOPK_FREE(increments);
+    TOPK_FREE(itemlens);
+    TOPK_FREE(items);
     RedisModule_ReplicateVerbatim(ctx);
     return REDISMODULE_OK;
 }
@@ -152,30 +192,114 @@ static int TopK_Incrby_Cmd(RedisModuleCtx *ctx, RedisModuleString **argv, int ar
     }
 
     int itemCount = (argc - 2) / 2;
-    RedisModule_ReplyWithArray(ctx, itemCount);
-
-    for (int i = 0; i < itemCount; ++i) {
-        size_t itemlen;
-        const char *item = RedisModule_StringPtrLen(argv[2 + i * 2], &itemlen);
+    const char **items = TOPK_CALLOC(itemCount, sizeof(*items));
+    size_t *itemlens = TOPK_CALLOC(itemCount, sizeof(*itemlens));
+    uint32_t *increments = TOPK_CALLOC(itemCount, sizeof(*increments));
+    char **expelled = TOPK_CALLOC(itemCount, sizeof(*expelled));
+
+    // Items preceding an invalid increment are still added, as if added one by one.
+    int validCount = 0;
+    for (int i = 0; i < itemCount; ++i, ++validCount) {
         long long increment;
         if (RedisModule_StringToLongLong(argv[2 + i * 2 + 1], &increment) || increment < 0 ||
             increment > 100000) {
-            RedisModule_ReplyWithError(
-                ctx, "TopK: increment must be an integer greater or equal to 0    \
+            break;
+        }
+        items[i] = RedisModule_StringPtrLen(argv[2 + i * 2], &itemlens[i]);
+        increments[i] = (uint32_t)increment;
+    }
+    if (validCount > 0) {
+        TopK_AddBatch(topk, items, itemlens, increments, validCount, expelled);
+    }
+
+    RedisModule_ReplyWithArray(ctx, REDISMODULE_POSTPONED_ARRAY_LEN);
+    replyWithExpelled(ctx, expelled, validCount);
+    if (validCount < itemCount) {
+        RedisModule_ReplyWithError(
+            ctx, "TopK: increment must be an integer greater or equal to 0    \
                         and smaller or equal to 100,000");
-            goto final;
+        RedisModule_ReplySetArrayLength(ctx, validCount + 1);
+    } else {
+        RedisModule_ReplySetArrayLength(ctx, validCount);
+    }
+
+    TOPK_FREE(expelled);
+    TOPK_FREE(increments);
+    TOPK_FREE(itemlens);
+    TOPK_FREE(items);
+    RedisModule_ReplicateVerbatim(ctx);
+    return REDISMODULE_OK;
+}
+
+static int parseMergeArgs(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
+                          long long numKeys, const TopK *dest, const TopK **src,
+                          long long *weights) {
+    int pos = RMUtil_ArgIndex("WEIGHTS", argv, argc);
+    if (pos < 0) {
+        if (numKeys != argc) {
+            INNER_ERROR("TopK: wrong number of keys");
         }
-        char *expelledItem = TopK_Add(topk, item, itemlen, (uint32_t)increment);
+    } else if (pos != numKeys || argc != 1 + numKeys * 2) {
+        INNER_ERROR("TopK: wrong number of keys/weights");
+    }
 
-        if (expelledItem == NULL) {
-            RedisModule_ReplyWithNull(ctx);
-        } else {
-            RedisModule_ReplyWithCString(ctx, expelledItem);
-            TOPK_FREE(expelledItem);
+    for (int i = 0; i < numKeys; ++i) {
+        if (pos < 0) {
+            weights[i] = 1;
+        } else if (RedisModule_StringToLongLong(argv[numKeys + 1 + i], &weights[i]) !=
+                       REDISMODULE_OK ||
+                   weights[i] < 1 || weights[i] > UINT32_MAX) {
+            INNER_ERROR("TopK: invalid weight value");
+        }
+        if (GetTopKKey(ctx, argv[i], (TopK **)&src[i], REDISMODULE_READ) != REDISMODULE_OK) {
+            return REDISMODULE_ERR;
         }
+        if (src[i]->k != dest->k || src[i]->width != dest->width ||
+            src[i]->depth != dest->depth || src[i]->decay != dest->decay ||
+            src[i]->layout != dest->layout || src[i]->algo != dest->algo) {
+            INNER_ERROR("TopK: k/width/depth/decay/layout/algo is not equal");
+        }
+    }
+    return REDISMODULE_OK;
+}
+
+static int TopK_Merge_Cmd(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc < 4)
+        return RedisModule_WrongArity(ctx);
+
+    TopK *dest;
+    if (GetTopKKey(ctx, argv[1], &dest, REDISMODULE_READ | REDISMODULE_WRITE) != REDISMODULE_OK) {
+        return REDISMODULE_OK;
+    }
+
+    long long numKeys;
+    if (RedisModule_StringToLongLong(argv[2], &numKeys) != REDISMODULE_OK || numKeys < 1 ||
+        numKeys > argc - 3) {
+        return RedisModule_ReplyWithError(ctx, "TopK: invalid numkeys");
     }
+
+    const TopK **src = TOPK_CALLOC(numKeys, sizeof(*src));
+    long long *weights = TOPK_CALLOC(numKeys, sizeof(*weights));
+    if (parseMergeArgs(ctx, argv + 3, argc - 3, numKeys, dest, src, weights) != REDISMODULE_OK) {
+        goto final;
+    }
+
+    switch (TopK_Merge(dest, numKeys, src, weights)) {
+    case 0:
+        RedisModule_ReplicateVerbatim(ctx);
+        RedisModule_ReplyWithSimpleString(ctx, "OK");
+        break;
+    case -1:
+        RedisModule_ReplyWithError(ctx, "TopK: MERGE overflow");
+        break;
+    default:
+        RedisModule_ReplyWithError(ctx, "ERR Insufficient memory to merge topk data structures");
+        break;
+    }
+
 final:
-    RedisModule_ReplicateVerbatim(ctx);
+    TOPK_FREE(weights);
+    TOPK_FREE(src);
     return REDISMODULE_OK;
 }
 
@@ -272,7 +396,8 @@ static int TopK_Info_Cmd(RedisModuleCtx *ctx, RedisModuleString **argv, int argc
         return REDISMODULE_OK;
     }
 
-    RedisModule_ReplyWithMapOrArray(ctx, 4 * 2, true);
+    bool spaceSaving = topk->algo == TOPK_ALGO_SPACESAVING;
+    RedisModule_ReplyWithMapOrArray(ctx, (4 + spaceSaving) * 2, true);
     RedisModule_ReplyWithSimpleString(ctx, "k");
     RedisModule_ReplyWithLongLong(ctx, topk->k);
     RedisModule_ReplyWithSimpleString(ctx, "width");
@@ -281,20 +406,74 @@ static int TopK_Info_Cmd(RedisModuleCtx *ctx, RedisModuleString **argv, int argc
     RedisModule_ReplyWithLongLong(ctx, topk->depth);
     RedisModule_ReplyWithSimpleString(ctx, "decay");
     RedisModule_ReplyWithDouble(ctx, topk->decay);
+    if (spaceSaving) {
+        RedisModule_ReplyWithSimpleString(ctx, "algo");
+        RedisModule_ReplyWithSimpleString(ctx, "SPACESAVING");
+    }
 
     return REDISMODULE_OK;
 }
 
 /**************** Module functions *********************************/
 
+// The monitored items are saved by increasing count, so that they are appended when loaded
+static void TopKRdbSaveSummary(RedisModuleIO *io, const StreamSummary *ss) {
+    uint32_t *order = TOPK_CALLOC(ss->used + 1, sizeof(*order));
+    uint32_t n = SS_Sorted(ss, order);
+    RedisModule_SaveUnsigned(io, n);
+    for (uint32_t i = 0; i < n; ++i) {
+        const SSCounter *counter = ss->counters + order[i];
+        RedisModule_SaveUnsigned(io, SS_CounterCount(ss, order[i]));
+        RedisModule_SaveStringBuffer(io, counter->item, counter->itemlen);
+    }
+    TOPK_FREE(order);
+}
+
+// The cached items are saved as their heap index, with the increments still pending, as
+// applying them would modify the value being saved.
+static void TopKRdbSaveFrontCache(RedisModuleIO *io, const TopK *topk) {
+    const TopKFrontCache *cache = topk->frontCache;
+    uint32_t used = cache ? cache->used : 0;
+    RedisModule_SaveUnsigned(io, used);
+    if (used == 0) {
+        return;
+    }
+    RedisModule_SaveUnsigned(io, cache->hits);
+    for (uint32_t i = 0; i < used; ++i) {
+        uint32_t idx = 0;
+        while (topk->heap[idx].item != cache->item[i]) {
+            ++idx;
+            assert(idx < topk->k);
+        }
+        RedisModule_SaveUnsigned(io, idx);
+        RedisModule_SaveUnsigned(io, cache->pending[i]);
+    }
+}
+
 static void TopKRdbSave(RedisModuleIO *io, void *obj) {
     TopK *topk = obj;
     RedisModule_SaveUnsigned(io, topk->k);
     RedisModule_SaveUnsigned(io, topk->width);
     RedisModule_SaveUnsigned(io, topk->depth);
     RedisModule_SaveDouble(io, topk->decay);
-    RedisModule_SaveStringBuffer(io, (const char *)topk->data,
-                                 ((size_t)topk->width) * topk->depth * sizeof(Bucket));
+    RedisModule_SaveUnsigned(io, topk->layout);
+    RedisModule_SaveUnsigned(io, topk->algo);
+    if (topk->algo == TOPK_ALGO_SPACESAVING) {
+        TopKRdbSaveSummary(io, topk->summary);
+        return;
+    }
+    if (topk->layout == TOPK_LAYOUT_COMPACT) {
+        RedisModule_SaveStringBuffer(io, (const char *)topk->compactData,
+                                     ((size_t)topk->width) * topk->depth * sizeof(CompactBucket));
+        RedisModule_SaveUnsigned(io, topk->numEscalated);
+        for (size_t i = 0; i < topk->numEscalated; ++i) {
+            RedisModule_SaveUnsigned(io, topk->escalated[i].idx);
+            RedisModule_SaveUnsigned(io, topk->escalated[i].count);
+        }
+    } else {
+        RedisModule_SaveStringBuffer(io, (const char *)topk->data,
+                                     ((size_t)topk->width) * topk->depth * sizeof(Bucket));
+    }
     RedisModule_SaveStringBuffer(io, (const char *)topk->heap, topk->k * sizeof(HeapBucket));
     for (uint32_t i = 0; i < topk->k; ++i) {
         if (topk->heap[i].item != NULL) {
@@ -303,56 +482,190 @@ static void TopKRdbSave(RedisModuleIO *io, void *obj) {
             RedisModule_SaveStringBuffer(io, "", 1);
         }
     }
+    TopKRdbSaveFrontCache(io, topk);
+}
+
+static int TopKRdbLoadEscalated(RedisModuleIO *io, TopK *topk, bool *err) {
+    size_t numBuckets = ((size_t)topk->width) * topk->depth;
+    uint64_t numEscalated = LoadUnsigned_IOError(io, *err, REDISMODULE_ERR);
+    if (numEscalated > numBuckets) {
+        return REDISMODULE_ERR;
+    }
+    if (numEscalated > 0) {
+        topk->escalated = TOPK_TRYCALLOC(numEscalated, sizeof(*topk->escalated));
+        if (!topk->escalated) {
+            return REDISMODULE_ERR;
+        }
+        topk->escalatedCap = numEscalated;
+    }
+
+    for (size_t i = 0; i < numEscalated; ++i) {
+        uint64_t idx = LoadUnsigned_IOError(io, *err, REDISMODULE_ERR);
+        uint64_t count = LoadUnsigned_IOError(io, *err, REDISMODULE_ERR);
+        if (idx >= numBuckets || (i > 0 && idx <= topk->escalated[i - 1].idx) ||
+            count < TOPK_COMPACT_ESCALATED || count > UINT32_MAX ||
+            topk->compactData[idx].count != TOPK_COMPACT_ESCALATED) {
+            return REDISMODULE_ERR;
+        }
+        topk->escalated[i] = (EscalatedBucket){.idx = idx, .count = count};
+        topk->numEscalated = i + 1;
+    }
+
+    // every saturated bucket must have its count in the table
+    size_t saturated = 0;
+    for (size_t i = 0; i < numBuckets; ++i) {
+        saturated += topk->compactData[i].count == TOPK_COMPACT_ESCALATED;
+    }
+    return saturated == numEscalated ? REDISMODULE_OK : REDISMODULE_ERR;
+}
+
+static int TopKRdbLoadSummary(RedisModuleIO *io, StreamSummary *ss, bool *err) {
+    uint64_t n = LoadUnsigned_IOError(io, *err, REDISMODULE_ERR);
+    if (n > ss->k) {
+        return REDISMODULE_ERR;
+    }
+    for (uint64_t i = 0; i < n; ++i) {
+        uint64_t count = LoadUnsigned_IOError(io, *err, REDISMODULE_ERR);
+        size_t itemlen;
+        char *item = LoadStringBuffer_IOError(io, &itemlen, *err, REDISMODULE_ERR);
+        int rc = SS_Append(ss, item, itemlen, count);
+        RedisModule_Free(item);
+        if (rc != 0) {
+            return REDISMODULE_ERR;
+        }
+    }
+    return REDISMODULE_OK;
+}
+
+static int TopKRdbLoadFrontCache(RedisModuleIO *io, TopK *topk, bool *err) {
+    uint64_t used = LoadUnsigned_IOError(io, *err, REDISMODULE_ERR);
+    if (used == 0) {
+        return REDISMODULE_OK;
+    }
+    uint64_t hits = LoadUnsigned_IOError(io, *err, REDISMODULE_ERR);
+    if (used > TOPK_FRONT_CACHE_SIZE || hits >= TOPK_FRONT_CACHE_FLUSH_INTERVAL) {
+        return REDISMODULE_ERR;
+    }
+    TopKFrontCache *cache = topk->frontCache = TOPK_TRYCALLOC(1, sizeof(*cache));
+    if (!cache) {
+        return REDISMODULE_ERR;
+    }
+    cache->hits = hits;
+    for (uint64_t i = 0; i < used; ++i) {
+        uint64_t idx = LoadUnsigned_IOError(io, *err, REDISMODULE_ERR);
+        uint64_t pending = LoadUnsigned_IOError(io, *err, REDISMODULE_ERR);
+        if (idx >= topk->k || topk->heap[idx].item == NULL || pending > UINT32_MAX) {
+            return REDISMODULE_ERR;
+        }
+        // an item is cached at most once
+        for (uint32_t j = 0; j < cache->used; ++j) {
+            if (cache->item[j] == topk->heap[idx].item) {
+                return REDISMODULE_ERR;
+            }
+        }
+        cache->fp[i] = topk->heap[idx].fp;
+        cache->itemlen[i] = topk->heap[idx].itemlen;
+        cache->pending[i] = pending;
+        cache->item[i] = topk->heap[idx].item;
+        cache->used = i + 1;
+    }
+    return REDISMODULE_OK;
+}
+
+// Moves a loaded buffer into 'topk', whose own buffer is kept if it is part of a single
+// allocation.
+static void adoptBuffer(TopK *topk, void **dst, void *buf, size_t size) {
+    if (topk->singleAlloc) {
+        memcpy(*dst, buf, size);
+        RedisModule_Free(buf);
+    } else {
+        TOPK_FREE(*dst);
+        *dst = buf;
+    }
 }
 
 static void *TopKRdbLoad(RedisModuleIO *io, int encver) {
     if (encver > TOPK_ENC_VER) {
         return NULL;
     }
-    TopK *topk = TOPK_CALLOC(1, sizeof *topk);
+    TopK *topk = NULL;
     bool err = false;
     errdefer(err, TopK_Destroy(topk));
-    topk->k = LoadUnsigned_IOError(io, err, NULL);
-    topk->width = LoadUnsigned_IOError(io, err, NULL);
-    topk->depth = LoadUnsigned_IOError(io, err, NULL);
-    topk->decay = LoadDouble_IOError(io, err, NULL);
+    uint64_t k = LoadUnsigned_IOError(io, err, NULL);
+    uint64_t width = LoadUnsigned_IOError(io, err, NULL);
+    uint64_t depth = LoadUnsigned_IOError(io, err, NULL);
+    double decay = LoadDouble_IOError(io, err, NULL);
+    uint64_t layout = TOPK_LAYOUT_DEFAULT;
+    if (encver >= TOPK_MIN_LAYOUT_ENC) {
+        layout = LoadUnsigned_IOError(io, err, NULL);
+    }
+    uint64_t algo = TOPK_ALGO_HEAVYKEEPER;
+    if (encver >= TOPK_MIN_ALGO_ENC) {
+        algo = LoadUnsigned_IOError(io, err, NULL);
+    }
 
-    if (topk->width == 0 || topk->depth == 0 || topk->k == 0) {
-        err = true;
-        return NULL;
+    if (algo == TOPK_ALGO_SPACESAVING) {
+        if (k == 0 || k > UINT32_MAX || layout != TOPK_LAYOUT_DEFAULT) {
+            err = true;
+            return NULL;
+        }
+        topk = TopK_CreateSpaceSaving(k);
+        if (!topk || TopKRdbLoadSummary(io, topk->summary, &err) != REDISMODULE_OK) {
+            err = true;
+            return NULL;
+        }
+        return topk;
     }
 
-    if (topk->depth > SIZE_MAX / topk->width ||
-        (size_t)topk->depth * topk->width > SIZE_MAX / sizeof(Bucket)) {
+    if (width == 0 || depth == 0 || k == 0 || width > UINT32_MAX || depth > UINT32_MAX ||
+        k > UINT32_MAX || !(decay > 0 && decay <= 1) || layout > TOPK_LAYOUT_COMPACT ||
+        algo != TOPK_ALGO_HEAVYKEEPER) {
         err = true;
         return NULL;
     }
 
-    size_t dataSize, heapSize, itemSize;
-    size_t expectedDataSize = ((size_t)topk->width) * topk->depth * sizeof(Bucket);
-    topk->data = (Bucket *)LoadStringBuffer_IOError(io, &dataSize, err, NULL);
-    if (dataSize != expectedDataSize) {
+    topk = TopK_CreateWithLayout(k, width, depth, decay, layout);
+    if (!topk) {
         err = true;
         return NULL;
     }
-    if (topk->k > SIZE_MAX / sizeof(HeapBucket)) {
-        err = true;
-        return NULL;
+
+    size_t dataSize, heapSize, itemSize;
+    if (topk->layout == TOPK_LAYOUT_COMPACT) {
+        size_t expectedDataSize = ((size_t)topk->width) * topk->depth * sizeof(CompactBucket);
+        char *data = LoadStringBuffer_IOError(io, &dataSize, err, NULL);
+        if (dataSize != expectedDataSize) {
+            RedisModule_Free(data);
+            err = true;
+            return NULL;
+        }
+        adoptBuffer(topk, (void **)&topk->compactData, data, dataSize);
+        if (TopKRdbLoadEscalated(io, topk, &err) != REDISMODULE_OK) {
+            err = true;
+            return NULL;
+        }
+    } else {
+        size_t expectedDataSize = ((size_t)topk->width) * topk->depth * sizeof(Bucket);
+        char *data = LoadStringBuffer_IOError(io, &dataSize, err, NULL);
+        if (dataSize != expectedDataSize) {
+            RedisModule_Free(data);
+            err = true;
+            return NULL;
+        }
+        adoptBuffer(topk, (void **)&topk->data, data, dataSize);
     }
     size_t expectedHeapSize = topk->k * sizeof(HeapBucket);
-    topk->heap = (HeapBucket *)LoadStringBuffer_IOError(io, &heapSize, err, NULL);
+    char *heap = LoadStringBuffer_IOError(io, &heapSize, err, NULL);
     if (heapSize != expectedHeapSize) {
-        // Zero pointers to avoid freeing stale pointers if validation fails
-        if (topk->heap) {
-            uint32_t buckets = heapSize / sizeof(HeapBucket);
-            buckets = buckets < topk->k ? buckets : topk->k;
-            for (uint32_t i = 0; i < buckets; ++i) {
-                topk->heap[i].item = NULL;
-            }
-        }
+        RedisModule_Free(heap);
         err = true;
         return NULL;
     }
+    adoptBuffer(topk, (void **)&topk->heap, heap, heapSize);
+    // Zero pointers to avoid freeing stale pointers if loading the items fails
+    for (HeapBucket *bucket = topk->heap; bucket < topk->heap + topk->k; ++bucket) {
+        bucket->item = NULL;
+    }
 
     for (HeapBucket *bucket = topk->heap; bucket < topk->heap + topk->k; ++bucket) {
         char *it = LoadStringBuffer_IOError(io, &heapSize, err, NULL);
@@ -371,9 +684,10 @@ static void *TopKRdbLoad(RedisModuleIO *io, int encver) {
         }
     }
 
-    /* Initialize lookupTable */
-    for (uint32_t i = 0; i < TOPK_DECAY_LOOKUP_TABLE; ++i) {
-        topk->lookupTable[i] = i == 0 ? 1 : topk->lookupTable[i - 1] * topk->decay;
+    if (encver >= TOPK_MIN_FRONT_CACHE_ENC &&
+        TopKRdbLoadFrontCache(io, topk, &err) != REDISMODULE_OK) {
+        err = true;
+        return NULL;
     }
 
     return topk;
@@ -384,19 +698,63 @@ static void TopKFree(void *value) { TopK_Destroy(value); }
 static int TopKDefrag(RedisModuleDefragCtx *ctx, RedisModuleString *key, void **value) {
     *value = defragPtr(ctx, *value);
     TopK *topk = *value;
-    topk->data = defragPtr(ctx, topk->data);
-    topk->heap = defragPtr(ctx, topk->heap);
+    if (topk->algo == TOPK_ALGO_SPACESAVING) {
+        StreamSummary *ss = topk->summary = defragPtr(ctx, topk->summary);
+        ss->table = defragPtr(ctx, ss->table);
+        ss->counters = defragPtr(ctx, ss->counters);
+        ss->buckets = defragPtr(ctx, ss->buckets);
+        for (uint32_t i = 0; i < ss->used; ++i) {
+            ss->counters[i].item = defragPtr(ctx, ss->counters[i].item);
+        }
+        return 0;
+    }
+    if (topk->singleAlloc) {
+        TopK_RelocateSingleAlloc(topk);
+    } else {
+        if (topk->data)
+            topk->data = defragPtr(ctx, topk->data);
+        if (topk->compactData)
+            topk->compactData = defragPtr(ctx, topk->compactData);
+        topk->heap = defragPtr(ctx, topk->heap);
+    }
+    if (topk->escalated)
+        topk->escalated = defragPtr(ctx, topk->escalated);
+    TopKFrontCache *cache = topk->frontCache;
+    if (cache)
+        cache = topk->frontCache = defragPtr(ctx, cache);
     for (uint32_t i = 0; i < topk->k; ++i) {
-        if (topk->heap[i].item)
-            topk->heap[i].item = defragPtr(ctx, topk->heap[i].item);
+        if (!topk->heap[i].item)
+            continue;
+        // cached items point to the heap items, which may move
+        int cached = -1;
+        for (uint32_t j = 0; cache && j < cache->used; ++j) {
+            if (cache->item[j] == topk->heap[i].item) {
+                cached = j;
+            }
+        }
+        topk->heap[i].item = defragPtr(ctx, topk->heap[i].item);
+        if (cached >= 0)
+            cache->item[cached] = topk->heap[i].item;
     }
+    return 0;
 }
 
 static size_t TopKMemUsage(const void *value) {
     const TopK *topk = value;
     size_t size = sizeof *topk;
-    size += sizeof *topk->data * topk->width * topk->depth;
+    if (topk->algo == TOPK_ALGO_SPACESAVING) {
+        return size + SS_Bytes(topk->summary);
+    }
+    if (topk->layout == TOPK_LAYOUT_COMPACT) {
+        size += sizeof *topk->compactData * topk->width * topk->depth;
+        size += sizeof *topk->escalated * topk->escalatedCap;
+    } else {
+        size += sizeof *topk->data * topk->width * topk->depth;
+    }
     size += sizeof *topk->heap * topk->k;
+    if (topk->frontCache) {
+        size += sizeof *topk->frontCache;
+    }
     return size;
 }
 
@@ -427,6 +785,7 @@ int TopKModule_onLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
     RegisterCommand(ctx, "topk.query", TopK_Query_Cmd, "readonly", "read");
     RegisterCommand(ctx, "topk.count", TopK_Count_Cmd, "readonly", "read");
     RegisterCommand(ctx, "topk.list", TopK_List_Cmd, "readonly", "read");
+    RegisterCommand(ctx, "topk.merge", TopK_Merge_Cmd, "write deny-oom", "write");
     RegisterCommand(ctx, "topk.info", TopK_Info_Cmd, "readonly", "read fast");
 
 #undef RegisterCommand
@@ -11,6 +11,9 @@
 
 #include "redismodule.h"
 
-#define TOPK_ENC_VER 0
+#define TOPK_ENC_VER 3
+#define TOPK_MIN_LAYOUT_ENC 1
+#define TOPK_MIN_ALGO_ENC 2
+#define TOPK_MIN_FRONT_CACHE_ENC 3
 
 int TopKModule_onLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc);
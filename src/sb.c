@@ -72,7 +72,7 @@ static int SBChain_AddToLink(SBLink *lb, bloom_hashval hash) {
     }
 }
 
-static bloom_hashval SBChain_GetHash(const SBChain *chain, const void *buf, size_t len) {
+bloom_hashval SBChain_GetHash(const SBChain *chain, const void *buf, size_t len) {
     if (chain->options & BLOOM_OPT_FORCE64) {
         return bloom_calc_hash64(buf, len);
     } else {
@@ -81,12 +81,13 @@ static bloom_hashval SBChain_GetHash(const SBChain *chain, const void *buf, size
 }
 
 int SBChain_Add(SBChain *sb, const void *data, size_t len) {
+    return SBChain_AddHash(sb, SBChain_GetHash(sb, data, len));
+}
+
+int SBChain_AddHash(SBChain *sb, bloom_hashval h) {
     // Does it already exist?
-    bloom_hashval h = SBChain_GetHash(sb, data, len);
-    for (int ii = sb->nfilters - 1; ii >= 0; --ii) {
-        if (bloom_check_h(&sb->filters[ii].inner, h)) {
-            return 0;
-        }
+    if (SBChain_CheckHash(sb, h)) {
+        return 0;
     }
 
     // Determine if we need to add more items?
@@ -110,7 +111,10 @@ int SBChain_Add(SBChain *sb, const void *data, size_t len) {
 }
 
 int SBChain_Check(const SBChain *sb, const void *data, size_t len) {
-    bloom_hashval hv = SBChain_GetHash(sb, data, len);
+    return SBChain_CheckHash(sb, SBChain_GetHash(sb, data, len));
+}
+
+int SBChain_CheckHash(const SBChain *sb, bloom_hashval hv) {
     for (int ii = sb->nfilters - 1; ii >= 0; --ii) {
         if (bloom_check_h(&sb->filters[ii].inner, hv)) {
             return 1;
@@ -119,6 +123,23 @@ int SBChain_Check(const SBChain *sb, const void *data, size_t len) {
     return 0;
 }
 
+void SBChain_Clear(SBChain *sb) {
+    for (size_t ii = 1; ii < sb->nfilters; ++ii) {
+        RedisModule_Free(sb->filters[ii].inner.bf);
+    }
+    sb->nfilters = 1;
+    sb->filters = RedisModule_Realloc(sb->filters, sizeof(*sb->filters));
+    memset(sb->filters->inner.bf, 0, sb->filters->inner.bytes);
+    sb->filters->size = 0;
+    sb->size = 0;
+}
+
+uint64_t SB_NewChainId(void) {
+    // chains are only created on the main thread
+    static uint64_t lastId = 0;
+    return ++lastId;
+}
+
 SBChain *SB_NewChain(uint64_t initsize, double error_rate, unsigned options, unsigned growth,
                      int *err) {
     if (initsize == 0 || error_rate == 0 || error_rate >= 1) {
@@ -126,6 +147,7 @@ SBChain *SB_NewChain(uint64_t initsize, double error_rate, unsigned options, uns
         return NULL;
     }
     SBChain *sb = RedisModule_Calloc(1, sizeof(*sb));
+    sb->id = SB_NewChainId();
     sb->growth = growth;
     sb->options = options;
     double tightening = (options & BLOOM_OPT_NO_SCALING) ? 1 : ERROR_TIGHTENING_RATIO;
@@ -277,6 +299,7 @@ SBChain *SB_NewChainFromHeader(const char *buf, size_t bufLen, const char **errm
     }
 
     sb = RedisModule_Calloc(1, sizeof(*sb));
+    sb->id = SB_NewChainId();
     sb->filters = RedisModule_Calloc(header->nfilters, sizeof(*sb->filters));
     sb->nfilters = header->nfilters;
     sb->options = header->options;
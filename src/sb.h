@@ -29,6 +29,7 @@ typedef struct SBChain {
     size_t nfilters;  //< Number of links in chain
     unsigned options; //< Options passed directly to bloom_init
     unsigned growth;
+    uint64_t id; //< Unique among the chains created by the process, from SB_NewChainId
 } SBChain;
 
 enum sb_rc {
@@ -37,7 +38,12 @@ enum sb_rc {
     SB_FULL = -2,
     SB_OOM = -3,
     SB_INVALID = -4,
+    SB_STALE = -5, //< The time slot of a window write already left the window
 };
+
+/** Returns an id no chain was given before, for a chain allocated outside of this file */
+uint64_t SB_NewChainId(void);
+
 /**
  * Create a new chain
  * initsize: The initial desired capacity of the chain
@@ -71,6 +77,19 @@ int SBChain_Add(SBChain *sb, const void *data, size_t len);
  */
 int SBChain_Check(const SBChain *sb, const void *data, size_t len);
 
+/**
+ * Returns the hash of an item, as computed by SBChain_Add and SBChain_Check. Chains with the same
+ * options share it, so an item can be hashed once and looked up in many chains.
+ */
+bloom_hashval SBChain_GetHash(const SBChain *sb, const void *data, size_t len);
+
+/** SBChain_Add and SBChain_Check, given the hash of the item */
+int SBChain_AddHash(SBChain *sb, bloom_hashval h);
+int SBChain_CheckHash(const SBChain *sb, bloom_hashval h);
+
+/** Empty the chain, keeping only its first link */
+void SBChain_Clear(SBChain *sb);
+
 /**
  * Get an encoded header. This is the first step to serializing a bloom filter.
  * The length of the header will be written to in hdrlen.
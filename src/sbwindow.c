@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#include "sbwindow.h"
+
+#include "redismodule.h"
+
+#include <string.h>
+
+SBWindow *SBWindow_New(long long window, size_t nslices, uint64_t initsize, double error_rate,
+                       unsigned options, unsigned growth, int *err) {
+    if (nslices == 0 || nslices > SBWINDOW_MAX_SLICES || window < (long long)nslices) {
+        *err = SB_INVALID;
+        return NULL;
+    }
+    SBWindow *w = RedisModule_Calloc(1, sizeof(*w));
+    w->window = window;
+    w->nslices = nslices;
+    w->slices = RedisModule_Calloc(nslices, sizeof(*w->slices));
+    w->slots = RedisModule_Calloc(nslices, sizeof(*w->slots));
+    w->counts = RedisModule_Calloc(nslices, sizeof(*w->counts));
+    for (size_t ii = 0; ii < nslices; ++ii) {
+        w->slots[ii] = -1;
+        w->slices[ii] = SB_NewChain(initsize, error_rate / nslices, options, growth, err);
+        if (!w->slices[ii]) {
+            SBWindow_Free(w);
+            return NULL;
+        }
+    }
+    *err = SB_SUCCESS;
+    return w;
+}
+
+void SBWindow_Free(SBWindow *w) {
+    if (!w) {
+        return;
+    }
+    if (w->slices) {
+        for (size_t ii = 0; ii < w->nslices; ++ii) {
+            SBChain_Free(w->slices[ii]);
+        }
+        RedisModule_Free(w->slices);
+    }
+    if (w->slots) {
+        RedisModule_Free(w->slots);
+    }
+    if (w->counts) {
+        RedisModule_Free(w->counts);
+    }
+    RedisModule_Free(w);
+}
+
+long long SBWindow_Slot(const SBWindow *w, long long now) {
+    return now / (w->window / (long long)w->nslices);
+}
+
+int SBWindow_IsLive(const SBWindow *w, size_t ii, long long now) {
+    const long long slot = SBWindow_Slot(w, now);
+    return w->slots[ii] > slot - (long long)w->nslices && w->slots[ii] <= slot;
+}
+
+int SBWindow_IsStale(const SBWindow *w, long long now) {
+    const long long slot = SBWindow_Slot(w, now);
+    return w->slots[slot % w->nslices] > slot;
+}
+
+int SBWindow_Add(SBWindow *w, long long now, const void *data, size_t len) {
+    if (SBWindow_IsStale(w, now)) {
+        return SB_STALE;
+    }
+    const long long slot = SBWindow_Slot(w, now);
+    const size_t cur = slot % w->nslices;
+    const bloom_hashval h = SBChain_GetHash(w->slices[cur], data, len);
+
+    int seen = 0;
+    for (size_t ii = 0; ii < w->nslices && !seen; ++ii) {
+        seen = ii != cur && SBWindow_IsLive(w, ii, now) && SBChain_CheckHash(w->slices[ii], h);
+    }
+
+    // The slice still holds a slot that left the window
+    if (w->slots[cur] != slot) {
+        SBChain_Clear(w->slices[cur]);
+        w->slots[cur] = slot;
+        w->counts[cur] = 0;
+    }
+    // An item seen in an older slice is added again, so that it stays for another window
+    const int rv = SBChain_AddHash(w->slices[cur], h);
+    if (rv < 0) {
+        return rv;
+    }
+    const int added = rv && !seen;
+    w->counts[cur] += added;
+    return added;
+}
+
+int SBWindow_Check(const SBWindow *w, long long now, const void *data, size_t len) {
+    const bloom_hashval h = SBChain_GetHash(w->slices[0], data, len);
+    for (size_t ii = 0; ii < w->nslices; ++ii) {
+        if (SBWindow_IsLive(w, ii, now) && SBChain_CheckHash(w->slices[ii], h)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+size_t SBWindow_Size(const SBWindow *w, long long now) {
+    size_t size = 0;
+    for (size_t ii = 0; ii < w->nslices; ++ii) {
+        if (SBWindow_IsLive(w, ii, now)) {
+            size += w->counts[ii];
+        }
+    }
+    return size;
+}
+
+int SBWindow_ValidateIntegrity(const SBWindow *w) {
+    if (w->nslices == 0 || w->nslices > SBWINDOW_MAX_SLICES || w->window < (long long)w->nslices) {
+        return 1;
+    }
+    for (size_t ii = 0; ii < w->nslices; ++ii) {
+        if (w->slices[ii]->options != w->slices[0]->options) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+#define SBWINDOW_MAGIC "SBWINDOW"
+
+typedef struct __attribute__((packed)) {
+    char magic[8];
+    int64_t window;
+    uint32_t nslices;
+} dumpedWindowHeader;
+
+// Each slice is dumped as its slot and count, followed by its chain header of 'hdrlen' bytes
+typedef struct __attribute__((packed)) {
+    int64_t slot;
+    uint64_t count;
+    uint32_t hdrlen;
+} dumpedWindowSlice;
+
+static size_t chainBytes(const SBChain *sb) {
+    size_t bytes = 0;
+    for (size_t ii = 0; ii < sb->nfilters; ++ii) {
+        bytes += sb->filters[ii].inner.bytes;
+    }
+    return bytes;
+}
+
+char *SBWindow_GetEncodedHeader(const SBWindow *w, size_t *hdrlen) {
+    char *hdrs[SBWINDOW_MAX_SLICES];
+    size_t lens[SBWINDOW_MAX_SLICES];
+    *hdrlen = sizeof(dumpedWindowHeader);
+    for (size_t ii = 0; ii < w->nslices; ++ii) {
+        hdrs[ii] = SBChain_GetEncodedHeader(w->slices[ii], &lens[ii]);
+        *hdrlen += sizeof(dumpedWindowSlice) + lens[ii];
+    }
+
+    char *buf = RedisModule_Calloc(1, *hdrlen);
+    dumpedWindowHeader *hdr = (dumpedWindowHeader *)buf;
+    memcpy(hdr->magic, SBWINDOW_MAGIC, sizeof(hdr->magic));
+    hdr->window = w->window;
+    hdr->nslices = w->nslices;
+
+    char *pos = buf + sizeof(*hdr);
+    for (size_t ii = 0; ii < w->nslices; ++ii) {
+        dumpedWindowSlice slice = {
+            .slot = w->slots[ii], .count = w->counts[ii], .hdrlen = lens[ii]};
+        memcpy(pos, &slice, sizeof(slice));
+        memcpy(pos + sizeof(slice), hdrs[ii], lens[ii]);
+        pos += sizeof(slice) + lens[ii];
+        SB_FreeEncodedHeader(hdrs[ii]);
+    }
+    return buf;
+}
+
+void SBWindow_FreeEncodedHeader(char *s) { RedisModule_Free(s); }
+
+int SBWindow_IsEncodedHeader(const char *buf, size_t bufLen) {
+    return bufLen >= sizeof(dumpedWindowHeader) &&
+           memcmp(buf, SBWINDOW_MAGIC, strlen(SBWINDOW_MAGIC)) == 0;
+}
+
+// Returns the slice holding byte 'offset' of the concatenated slices, and the offset of the
+// slice in 'base'
+static SBChain *getSlicePos(const SBWindow *w, size_t offset, size_t *base) {
+    *base = 0;
+    for (size_t ii = 0; ii < w->nslices; ++ii) {
+        const size_t bytes = chainBytes(w->slices[ii]);
+        if (offset < *base + bytes) {
+            return w->slices[ii];
+        }
+        *base += bytes;
+    }
+    return NULL;
+}
+
+const char *SBWindow_GetEncodedChunk(const SBWindow *w, long long *curIter, size_t *len,
+                                     size_t maxChunkSize) {
+    size_t base;
+    SBChain *sb = *curIter < 1 ? NULL : getSlicePos(w, *curIter - 1, &base);
+    if (!sb) {
+        *curIter = 0;
+        return NULL;
+    }
+    // A chunk never spans two slices
+    long long iter = *curIter - base;
+    const char *chunk = SBChain_GetEncodedChunk(sb, &iter, len, maxChunkSize);
+    *curIter = base + iter;
+    return chunk;
+}
+
+SBWindow *SBWindow_NewFromHeader(const char *buf, size_t bufLen, const char **errmsg) {
+    dumpedWindowHeader header;
+    if (!SBWindow_IsEncodedHeader(buf, bufLen)) {
+        goto err;
+    }
+    memcpy(&header, buf, sizeof(header));
+    if (header.nslices == 0 || header.nslices > SBWINDOW_MAX_SLICES) {
+        goto err;
+    }
+
+    SBWindow *w = RedisModule_Calloc(1, sizeof(*w));
+    w->window = header.window;
+    w->nslices = header.nslices;
+    w->slices = RedisModule_Calloc(w->nslices, sizeof(*w->slices));
+    w->slots = RedisModule_Calloc(w->nslices, sizeof(*w->slots));
+    w->counts = RedisModule_Calloc(w->nslices, sizeof(*w->counts));
+
+    size_t pos = sizeof(header);
+    for (size_t ii = 0; ii < w->nslices; ++ii) {
+        dumpedWindowSlice slice;
+        if (bufLen - pos < sizeof(slice)) {
+            goto err_window;
+        }
+        memcpy(&slice, buf + pos, sizeof(slice));
+        pos += sizeof(slice);
+        if (bufLen - pos < slice.hdrlen) {
+            goto err_window;
+        }
+        w->slots[ii] = slice.slot;
+        w->counts[ii] = slice.count;
+        w->slices[ii] = SB_NewChainFromHeader(buf + pos, slice.hdrlen, errmsg);
+        if (!w->slices[ii]) {
+            goto err_window;
+        }
+        pos += slice.hdrlen;
+    }
+    if (pos != bufLen || SBWindow_ValidateIntegrity(w) != 0) {
+        goto err_window;
+    }
+    return w;
+
+err_window:
+    SBWindow_Free(w);
+err:
+    *errmsg = "ERR received bad data";
+    return NULL;
+}
+
+int SBWindow_LoadEncodedChunk(SBWindow *w, long long iter, const char *buf, size_t bufLen,
+                              const char **errmsg) {
+    if (!buf || iter <= 0 || iter <= bufLen) {
+        *errmsg = "ERR received bad data";
+        return -1;
+    }
+    size_t base;
+    SBChain *sb = getSlicePos(w, iter - bufLen - 1, &base);
+    if (!sb) {
+        *errmsg = "ERR invalid offset - no link found";
+        return -1;
+    }
+    return SBChain_LoadEncodedChunk(sb, iter - base, buf, bufLen, errmsg);
+}
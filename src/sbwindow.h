@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#pragma once
+
+#include "sb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Largest number of slices of a window
+#define SBWINDOW_MAX_SLICES 1024
+
+/**
+ * An age-partitioned Bloom filter, which holds the items added during the last 'window'
+ * milliseconds. Time is divided in slots of window / nslices milliseconds, and the items of a
+ * slot are added to its own chain, the slice at slot % nslices. The chain of a slot that left the
+ * window is emptied when the ring comes back to it, so that expiry needs no work per item.
+ *
+ * All the slices share the hash of an item, which is computed once per lookup.
+ */
+typedef struct SBWindow {
+    SBChain **slices;
+    long long *slots; //< The time slot each slice holds the items of, -1 if none
+    size_t *counts;   //< Items each slice added that were new to the window
+    size_t nslices;
+    long long window; //< Duration of the window in milliseconds
+} SBWindow;
+
+/**
+ * Create a new window of 'nslices' empty slices. The chain of every slice holds 'initsize'
+ * items before it scales, with an error rate of 'error_rate' / 'nslices' so that the error rate
+ * of the window as a whole is 'error_rate'.
+ *
+ * Free with SBWindow_Free when done.
+ */
+SBWindow *SBWindow_New(long long window, size_t nslices, uint64_t initsize, double error_rate,
+                       unsigned options, unsigned growth, int *err);
+
+/** Free a created window */
+void SBWindow_Free(SBWindow *w);
+
+/** Returns the time slot of 'now', in milliseconds */
+long long SBWindow_Slot(const SBWindow *w, long long now);
+
+/** Returns whether slice 'ii' holds items of a time slot inside the window at 'now' */
+int SBWindow_IsLive(const SBWindow *w, size_t ii, long long now);
+
+/**
+ * Returns whether the slice of the time slot of 'now' already holds a newer slot, so that items
+ * added at 'now' would be dropped.
+ */
+int SBWindow_IsStale(const SBWindow *w, long long now);
+
+/**
+ * Add an item to the slice of the time slot of 'now', emptying it first if it holds an older one.
+ * Returns 1 if the item is new to the whole window, 0 if it was seen inside it, SB_STALE if the
+ * slice already holds a newer slot, and the errors of SBChain_Add otherwise.
+ */
+int SBWindow_Add(SBWindow *w, long long now, const void *data, size_t len);
+
+/**
+ * Check if an item was seen during the window
+ * Return 0 if the item is unknown to the live slices, nonzero otherwise
+ */
+int SBWindow_Check(const SBWindow *w, long long now, const void *data, size_t len);
+
+/**
+ * Returns the number of items of the live slices that were new to the window when added. An item
+ * added again in a later slice is counted once, and stops being counted when the slice it was
+ * first added to leaves the window, even though the later slice still holds it.
+ */
+size_t SBWindow_Size(const SBWindow *w, long long now);
+
+/**
+ * Get an encoded header, the counterpart of SBChain_GetEncodedHeader. It starts with a magic
+ * string, followed by the chain header of every slice.
+ *
+ * The header should be freed with SBWindow_FreeEncodedHeader.
+ */
+char *SBWindow_GetEncodedHeader(const SBWindow *w, size_t *hdrlen);
+void SBWindow_FreeEncodedHeader(char *s);
+
+/** Returns whether 'buf' is a header from SBWindow_GetEncodedHeader. */
+int SBWindow_IsEncodedHeader(const char *buf, size_t bufLen);
+
+/**
+ * Get an encoded chunk of the slices, one after another, with the same iterator protocol as
+ * SBChain_GetEncodedChunk.
+ */
+const char *SBWindow_GetEncodedChunk(const SBWindow *w, long long *curIter, size_t *len,
+                                     size_t maxChunkSize);
+
+/**
+ * Creates a new window, with zeroed slices, from a header returned by
+ * SBWindow_GetEncodedHeader. Returns NULL and sets errmsg if the header is corrupt.
+ */
+SBWindow *SBWindow_NewFromHeader(const char *buf, size_t bufLen, const char **errmsg);
+
+/**
+ * Loads a chunk returned from SBWindow_GetEncodedChunk.
+ * Returns 0 on success, and nonzero on failure - in which case errmsg is populated.
+ */
+int SBWindow_LoadEncodedChunk(SBWindow *w, long long iter, const char *buf, size_t bufLen,
+                              const char **errmsg);
+
+/**
+ * Checks the window and slice count, and that all the slices hash items alike, as read from a
+ * dump. Returns 0 if they are consistent, nonzero otherwise.
+ */
+int SBWindow_ValidateIntegrity(const SBWindow *w);
+
+#ifdef __cplusplus
+}
+#endif
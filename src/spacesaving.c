@@ -0,0 +1,358 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#include "spacesaving.h"
+#include "murmur2/murmurhash2.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SS_HASH(item, itemlen) MurmurHash2(item, itemlen, 1919)
+
+StreamSummary *SS_New(uint32_t k) {
+    if (k == SS_NIL) {
+        return NULL;
+    }
+    uint64_t slots = 2;
+    while (slots < (uint64_t)k * 2) {
+        slots <<= 1;
+    }
+    StreamSummary *ss = SS_TRYCALLOC(1, sizeof *ss);
+    if (!ss) {
+        return NULL;
+    }
+    ss->k = k;
+    ss->min = ss->max = SS_NIL;
+    ss->mask = slots - 1;
+    ss->table = SS_TRYCALLOC(slots, sizeof *ss->table);
+    ss->counters = SS_TRYCALLOC(k, sizeof *ss->counters);
+    // a moving counter may take a new bucket before leaving its own, hence the extra one
+    ss->buckets = SS_TRYCALLOC((size_t)k + 1, sizeof *ss->buckets);
+    if (!ss->table || !ss->counters || !ss->buckets) {
+        SS_Free(ss);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < k; i++) {
+        ss->buckets[i].next = i + 1;
+    }
+    ss->buckets[k].next = SS_NIL;
+    return ss;
+}
+
+void SS_Free(StreamSummary *ss) {
+    if (!ss) {
+        return;
+    }
+    if (ss->counters) {
+        for (uint32_t i = 0; i < ss->used; i++) {
+            SS_FREE(ss->counters[i].item);
+        }
+        SS_FREE(ss->counters);
+    }
+    if (ss->buckets) {
+        SS_FREE(ss->buckets);
+    }
+    if (ss->table) {
+        SS_FREE(ss->table);
+    }
+    SS_FREE(ss);
+}
+
+size_t SS_Bytes(const StreamSummary *ss) {
+    return sizeof *ss + (ss->mask + 1) * sizeof *ss->table + ss->k * sizeof *ss->counters +
+           ((size_t)ss->k + 1) * sizeof *ss->buckets;
+}
+
+// Returns the counter of an item, or SS_NIL. 'slot' is set to its slot in the table, or to the
+// empty slot that ends its probe sequence.
+static uint32_t ssFind(const StreamSummary *ss, const char *item, size_t itemlen, uint32_t fp,
+                       uint64_t *slot) {
+    for (uint64_t i = fp & ss->mask;; i = (i + 1) & ss->mask) {
+        if (ss->table[i] == 0) {
+            *slot = i;
+            return SS_NIL;
+        }
+        const SSCounter *counter = ss->counters + ss->table[i] - 1;
+        if (counter->fp == fp && counter->itemlen == itemlen &&
+            memcmp(counter->item, item, itemlen) == 0) {
+            *slot = i;
+            return ss->table[i] - 1;
+        }
+    }
+}
+
+// Empties a slot of the table, shifting back the entries of its probe sequence that may take it
+static void ssUnlinkSlot(StreamSummary *ss, uint64_t slot) {
+    uint64_t hole = slot;
+    for (uint64_t i = (slot + 1) & ss->mask; ss->table[i]; i = (i + 1) & ss->mask) {
+        uint64_t home = ss->counters[ss->table[i] - 1].fp & ss->mask;
+        if (((i - home) & ss->mask) >= ((i - hole) & ss->mask)) {
+            ss->table[hole] = ss->table[i];
+            hole = i;
+        }
+    }
+    ss->table[hole] = 0;
+}
+
+static void ssSetItem(StreamSummary *ss, uint32_t c, const char *item, size_t itemlen,
+                      uint32_t fp, uint64_t slot) {
+    SSCounter *counter = ss->counters + c;
+    counter->item = SS_CALLOC(itemlen + 1, sizeof(char));
+    memcpy(counter->item, item, itemlen);
+    counter->itemlen = itemlen;
+    counter->fp = fp;
+    ss->table[slot] = c + 1;
+}
+
+// Takes an unused bucket of 'count', and links it after 'prev', or first if it is SS_NIL
+static uint32_t ssNewBucket(StreamSummary *ss, uint64_t count, uint32_t prev) {
+    uint32_t b = ss->free;
+    SSBucket *bucket = ss->buckets + b;
+    ss->free = bucket->next;
+    bucket->count = count;
+    bucket->head = SS_NIL;
+    bucket->prev = prev;
+    bucket->next = prev == SS_NIL ? ss->min : ss->buckets[prev].next;
+    if (bucket->next != SS_NIL) {
+        ss->buckets[bucket->next].prev = b;
+    } else {
+        ss->max = b;
+    }
+    if (prev != SS_NIL) {
+        ss->buckets[prev].next = b;
+    } else {
+        ss->min = b;
+    }
+    return b;
+}
+
+static void ssFreeBucket(StreamSummary *ss, uint32_t b) {
+    SSBucket *bucket = ss->buckets + b;
+    if (bucket->prev != SS_NIL) {
+        ss->buckets[bucket->prev].next = bucket->next;
+    } else {
+        ss->min = bucket->next;
+    }
+    if (bucket->next != SS_NIL) {
+        ss->buckets[bucket->next].prev = bucket->prev;
+    } else {
+        ss->max = bucket->prev;
+    }
+    bucket->next = ss->free;
+    ss->free = b;
+}
+
+// Returns the bucket of 'count', searching upwards from 'next', which is preceded by 'prev'.
+// It is created if there is none.
+static uint32_t ssBucketOf(StreamSummary *ss, uint32_t prev, uint32_t next, uint64_t count) {
+    while (next != SS_NIL && ss->buckets[next].count < count) {
+        prev = next;
+        next = ss->buckets[next].next;
+    }
+    if (next != SS_NIL && ss->buckets[next].count == count) {
+        return next;
+    }
+    return ssNewBucket(ss, count, prev);
+}
+
+static void ssAttach(StreamSummary *ss, uint32_t c, uint32_t b) {
+    SSCounter *counter = ss->counters + c;
+    SSBucket *bucket = ss->buckets + b;
+    counter->bucket = b;
+    counter->prev = SS_NIL;
+    counter->next = bucket->head;
+    if (bucket->head != SS_NIL) {
+        ss->counters[bucket->head].prev = c;
+    }
+    bucket->head = c;
+}
+
+// Removes a counter from its bucket, which is released if it is left empty
+static void ssDetach(StreamSummary *ss, uint32_t c) {
+    SSCounter *counter = ss->counters + c;
+    SSBucket *bucket = ss->buckets + counter->bucket;
+    if (counter->prev != SS_NIL) {
+        ss->counters[counter->prev].next = counter->next;
+    } else {
+        bucket->head = counter->next;
+    }
+    if (counter->next != SS_NIL) {
+        ss->counters[counter->next].prev = counter->prev;
+    }
+    if (bucket->head == SS_NIL) {
+        ssFreeBucket(ss, counter->bucket);
+    }
+}
+
+static void ssIncrement(StreamSummary *ss, uint32_t c, uint64_t increment) {
+    const uint32_t b = ss->counters[c].bucket;
+    SSBucket *bucket = ss->buckets + b;
+    const uint64_t count =
+        bucket->count > UINT64_MAX - increment ? UINT64_MAX : bucket->count + increment;
+    if (count == bucket->count) {
+        return;
+    }
+    // a counter alone in its bucket keeps it while it stays below the next count
+    if (bucket->head == c && ss->counters[c].next == SS_NIL &&
+        (bucket->next == SS_NIL || ss->buckets[bucket->next].count > count)) {
+        bucket->count = count;
+        return;
+    }
+    const uint32_t target = ssBucketOf(ss, b, bucket->next, count);
+    ssDetach(ss, c);
+    ssAttach(ss, c, target);
+}
+
+char *SS_Add(StreamSummary *ss, const char *item, size_t itemlen, uint64_t increment) {
+    const uint32_t fp = SS_HASH(item, itemlen);
+    uint64_t slot;
+    uint32_t c = ssFind(ss, item, itemlen, fp, &slot);
+    if (c != SS_NIL) {
+        ssIncrement(ss, c, increment);
+        return NULL;
+    } else if (increment == 0) {
+        return NULL;
+    }
+
+    if (ss->used < ss->k) {
+        c = ss->used++;
+        ssSetItem(ss, c, item, itemlen, fp, slot);
+        ssAttach(ss, c, ssBucketOf(ss, SS_NIL, ss->min, increment));
+        return NULL;
+    }
+
+    // the item takes over a counter of the smallest count
+    c = ss->buckets[ss->min].head;
+    SSCounter *counter = ss->counters + c;
+    char *expelled = counter->item;
+    uint64_t oldSlot;
+    ssFind(ss, counter->item, counter->itemlen, counter->fp, &oldSlot);
+    ssUnlinkSlot(ss, oldSlot);
+    // unlinking may have shifted the end of the probe sequence of the item
+    ssFind(ss, item, itemlen, fp, &slot);
+    ssSetItem(ss, c, item, itemlen, fp, slot);
+    ssIncrement(ss, c, increment);
+    return expelled;
+}
+
+uint64_t SS_Count(const StreamSummary *ss, const char *item, size_t itemlen) {
+    uint64_t slot;
+    const uint32_t c = ssFind(ss, item, itemlen, SS_HASH(item, itemlen), &slot);
+    return c == SS_NIL ? 0 : SS_CounterCount(ss, c);
+}
+
+int SS_Append(StreamSummary *ss, const char *item, size_t itemlen, uint64_t count) {
+    const uint32_t fp = SS_HASH(item, itemlen);
+    uint64_t slot;
+    if (ss->used == ss->k || count == 0 ||
+        (ss->max != SS_NIL && count < ss->buckets[ss->max].count) ||
+        ssFind(ss, item, itemlen, fp, &slot) != SS_NIL) {
+        return -1;
+    }
+    const uint32_t c = ss->used++;
+    ssSetItem(ss, c, item, itemlen, fp, slot);
+    if (ss->max != SS_NIL && ss->buckets[ss->max].count == count) {
+        ssAttach(ss, c, ss->max);
+    } else {
+        ssAttach(ss, c, ssNewBucket(ss, count, ss->max));
+    }
+    return 0;
+}
+
+uint32_t SS_Sorted(const StreamSummary *ss, uint32_t *order) {
+    uint32_t n = 0;
+    for (uint32_t b = ss->min; b != SS_NIL; b = ss->buckets[b].next) {
+        for (uint32_t c = ss->buckets[b].head; c != SS_NIL; c = ss->counters[c].next) {
+            order[n++] = c;
+        }
+    }
+    return n;
+}
+
+typedef struct {
+    const SSCounter *counter;
+    uint64_t count;
+} SSMergeItem;
+
+static int cmpMergeItem(const void *tmp1, const void *tmp2) {
+    const SSCounter *c1 = ((const SSMergeItem *)tmp1)->counter;
+    const SSCounter *c2 = ((const SSMergeItem *)tmp2)->counter;
+    if (c1->fp != c2->fp) {
+        return c1->fp < c2->fp ? -1 : 1;
+    }
+    if (c1->itemlen != c2->itemlen) {
+        return c1->itemlen < c2->itemlen ? -1 : 1;
+    }
+    return memcmp(c1->item, c2->item, c1->itemlen);
+}
+
+static int cmpMergeCount(const void *tmp1, const void *tmp2) {
+    const uint64_t count1 = ((const SSMergeItem *)tmp1)->count;
+    const uint64_t count2 = ((const SSMergeItem *)tmp2)->count;
+    return count1 < count2 ? 1 : count1 > count2 ? -1 : 0;
+}
+
+StreamSummary *SS_Merge(uint32_t k, size_t quantity, const StreamSummary **src,
+                        const long long *weights, bool *overflow) {
+    *overflow = false;
+    size_t total = 0;
+    for (size_t i = 0; i < quantity; i++) {
+        total += src[i]->used;
+    }
+    SSMergeItem *items = SS_TRYCALLOC(total + 1, sizeof *items);
+    StreamSummary *merged = SS_New(k);
+    if (!items || !merged) {
+        goto fail;
+    }
+
+    // collect the distinct items of all summaries
+    size_t n = 0;
+    for (size_t i = 0; i < quantity; i++) {
+        for (uint32_t c = 0; c < src[i]->used; c++) {
+            items[n++].counter = src[i]->counters + c;
+        }
+    }
+    qsort(items, n, sizeof *items, cmpMergeItem);
+    size_t ndistinct = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (ndistinct > 0 && cmpMergeItem(items + ndistinct - 1, items + i) == 0) {
+            continue;
+        }
+        SSMergeItem *entry = items + ndistinct++;
+        entry->counter = items[i].counter;
+        entry->count = 0;
+        for (size_t j = 0; j < quantity; j++) {
+            uint64_t count = SS_Count(src[j], entry->counter->item, entry->counter->itemlen);
+            if (count == 0 && src[j]->used == src[j]->k) {
+                count = src[j]->buckets[src[j]->min].count;
+            }
+            if (count > UINT64_MAX / (uint64_t)weights[j] ||
+                count * weights[j] > UINT64_MAX - entry->count) {
+                *overflow = true;
+                goto fail;
+            }
+            entry->count += count * weights[j];
+        }
+    }
+
+    // keep the 'k' largest counts, appended in increasing order
+    qsort(items, ndistinct, sizeof *items, cmpMergeCount);
+    for (size_t i = ndistinct < k ? ndistinct : k; i-- > 0;) {
+        SS_Append(merged, items[i].counter->item, items[i].counter->itemlen, items[i].count);
+    }
+    SS_FREE(items);
+    return merged;
+
+fail:
+    if (items) {
+        SS_FREE(items);
+    }
+    SS_Free(merged);
+    return NULL;
+}
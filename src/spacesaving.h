@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef REDIS_MODULE_TARGET
+#include "redismodule.h"
+#define SS_CALLOC(count, size) RedisModule_Calloc(count, size)
+#define SS_TRYCALLOC(...)                                                                          \
+    RedisModule_TryCalloc ? RedisModule_TryCalloc(__VA_ARGS__) : RedisModule_Calloc(__VA_ARGS__)
+#define SS_FREE(ptr) RedisModule_Free(ptr)
+#endif
+
+#define SS_NIL UINT32_MAX
+
+typedef struct SSCounter {
+    char *item; //  NUL terminated
+    uint32_t itemlen;
+    uint32_t fp; //  hash of the item
+    uint32_t bucket;
+    uint32_t prev, next; //  counters of the same bucket
+} SSCounter;
+
+typedef struct SSBucket {
+    uint64_t count;
+    uint32_t head;       //  first counter
+    uint32_t prev, next; //  buckets of the next lower and higher counts
+} SSBucket;
+
+/*  A Space-Saving stream summary, after Metwally et al.: it monitors up to 'k' items with exact
+    counters. An item that is not monitored takes over the counter of the smallest count, and
+    adds its own count to it, so counts are overestimated by at most the total count divided by
+    k, and any item of a larger count is monitored.
+
+    Counters are grouped in buckets of equal count, themselves linked in increasing order of
+    count, and found by a hash table, so that an add of 1 is O(1). An add of a larger increment
+    walks the buckets it skips. */
+typedef struct StreamSummary {
+    uint32_t k;
+    uint32_t used;   //  monitored items, in the first counters
+    uint32_t min;    //  bucket of the smallest count, SS_NIL while empty
+    uint32_t max;    //  bucket of the largest count
+    uint32_t free;   //  unused buckets, linked by 'next'
+    uint64_t mask;   //  slots of the table - 1
+    uint32_t *table; //  index of the counter + 1, 0 is empty
+    SSCounter *counters;
+    SSBucket *buckets;
+} StreamSummary;
+
+/*  Returns a new empty summary of 'k' counters, or NULL if it cannot be allocated or 'k' is
+    SS_NIL.
+    Complexity - O(k) */
+StreamSummary *SS_New(uint32_t k);
+
+/*  Releases resources of a summary, including its items.
+    Complexity - O(k) */
+void SS_Free(StreamSummary *ss);
+
+/*  Returns the memory usage of a summary, without its items.
+    Complexity - O(1) */
+size_t SS_Bytes(const StreamSummary *ss);
+
+/*  Adds 'increment' to the count of an item.
+    Returns the item whose counter was taken over, if any, which should be freed.
+    Complexity - O(1) for an increment of 1, and O(skipped buckets) otherwise */
+char *SS_Add(StreamSummary *ss, const char *item, size_t itemlen, uint64_t increment);
+
+/*  Returns the count of a counter.
+    Complexity - O(1) */
+static inline uint64_t SS_CounterCount(const StreamSummary *ss, uint32_t c) {
+    return ss->buckets[ss->counters[c].bucket].count;
+}
+
+/*  Returns the count of an item, or 0 if it is not monitored.
+    Complexity - O(1) */
+uint64_t SS_Count(const StreamSummary *ss, const char *item, size_t itemlen);
+
+/*  Appends an item to a summary, with a count not lower than those of the appended ones.
+    Returns -1 if the summary is full, the count is lower or the item is already monitored.
+    Complexity - O(1) */
+int SS_Append(StreamSummary *ss, const char *item, size_t itemlen, uint64_t count);
+
+/*  Writes the indexes of the counters of the monitored items to 'order', in increasing order of
+    count, and returns their number.
+    Complexity - O(k) */
+uint32_t SS_Sorted(const StreamSummary *ss, uint32_t *order);
+
+/*  Returns a new summary of 'k' counters merging 'quantity' summaries, whose counts are
+    multiplied by 'weights'. An item missing from a full summary counts as its smallest count,
+    so that the merged counts remain upper bounds.
+    Returns NULL on counter overflow or allocation failure, with 'overflow' set on overflow.
+    Complexity - O(quantity ^ 2 * k + quantity * k * log(quantity * k)) */
+StreamSummary *SS_Merge(uint32_t k, size_t quantity, const StreamSummary **src,
+                        const long long *weights, bool *overflow);
@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#include "theta.h"
+#include "bloom/bloom.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+bloom_hashval bloom_calc_hash64(const void *buffer, int len);
+
+// The number of retained hashes past which the sketch is rebuilt with the k smallest
+#define THETA_REBUILD(k) ((uint64_t)(k) + (k) / 2)
+#define THETA_SLOTS(k) ((uint64_t)(k) * 2)
+
+uint64_t Theta_Hash(const void *data, size_t len) { return bloom_calc_hash64(data, len).a; }
+
+ThetaSketch *Theta_New(uint32_t k) {
+    if (k < THETA_MIN_K || k > THETA_MAX_K || (k & (k - 1))) {
+        return NULL;
+    }
+    ThetaSketch *ts = THETA_CALLOC(1, sizeof *ts);
+    ts->k = k;
+    ts->theta = UINT64_MAX;
+    ts->table = THETA_CALLOC(THETA_SLOTS(k), sizeof *ts->table);
+    return ts;
+}
+
+void Theta_Free(ThetaSketch *ts) {
+    if (!ts) {
+        return;
+    }
+    if (ts->table) {
+        THETA_FREE(ts->table);
+    }
+    THETA_FREE(ts);
+}
+
+size_t Theta_Bytes(const ThetaSketch *ts) { return THETA_SLOTS(ts->k) * sizeof *ts->table; }
+
+// Inserts a hash below theta, by linear probing from the slot of its low bits, which stay
+// uniform however low theta is
+static int _Theta_Insert(ThetaSketch *ts, uint64_t h) {
+    const uint64_t mask = THETA_SLOTS(ts->k) - 1;
+    for (uint64_t i = h & mask;; i = (i + 1) & mask) {
+        if (ts->table[i] == h) {
+            return 0;
+        } else if (!ts->table[i]) {
+            ts->table[i] = h;
+            ts->count++;
+            return 1;
+        }
+    }
+}
+
+static int _Theta_Compare(const void *a, const void *b) {
+    const uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+size_t Theta_Sorted(const ThetaSketch *ts, uint64_t *hashes) {
+    size_t n = 0;
+    for (uint64_t i = 0; i < THETA_SLOTS(ts->k); i++) {
+        if (ts->table[i]) {
+            hashes[n++] = ts->table[i];
+        }
+    }
+    qsort(hashes, n, sizeof *hashes, _Theta_Compare);
+    return n;
+}
+
+// Keeps the k smallest hashes, and lowers theta to the next one
+static void _Theta_Rebuild(ThetaSketch *ts) {
+    uint64_t *hashes = THETA_CALLOC(ts->count, sizeof *hashes);
+    Theta_Sorted(ts, hashes);
+    ts->theta = hashes[ts->k];
+    memset(ts->table, 0, Theta_Bytes(ts));
+    ts->count = 0;
+    for (uint32_t i = 0; i < ts->k; i++) {
+        _Theta_Insert(ts, hashes[i]);
+    }
+    THETA_FREE(hashes);
+}
+
+int Theta_Add(ThetaSketch *ts, uint64_t h) {
+    if (!h || h >= ts->theta || !_Theta_Insert(ts, h)) {
+        return 0;
+    }
+    if (ts->count > THETA_REBUILD(ts->k)) {
+        _Theta_Rebuild(ts);
+        return h < ts->theta;
+    }
+    return 1;
+}
+
+double Theta_Estimate(const ThetaSketch *ts) {
+    if (ts->theta == UINT64_MAX) {
+        return ts->count;
+    }
+    return ts->count / ((double)ts->theta / 18446744073709551616.0);
+}
+
+ThetaSketch *Theta_FromSorted(uint32_t k, uint64_t theta, const uint64_t *hashes, size_t n) {
+    ThetaSketch *ts = Theta_New(k);
+    if (!ts || n > THETA_REBUILD(k)) {
+        Theta_Free(ts);
+        return NULL;
+    }
+    ts->theta = theta;
+    for (size_t i = 0; i < n; i++) {
+        if (!hashes[i] || hashes[i] >= theta || (i && hashes[i] <= hashes[i - 1])) {
+            Theta_Free(ts);
+            return NULL;
+        }
+        _Theta_Insert(ts, hashes[i]);
+    }
+    return ts;
+}
+
+// Writes the sorted hashes of a sketch below 'theta' to 'hashes', and returns their number
+static size_t _Theta_SortedBelow(const ThetaSketch *ts, uint64_t theta, uint64_t *hashes) {
+    size_t n = Theta_Sorted(ts, hashes);
+    while (n && hashes[n - 1] >= theta) {
+        n--;
+    }
+    return n;
+}
+
+// Returns the smallest theta of the sketches, and their largest k in 'k', which also bounds the
+// number of hashes of each
+static uint64_t _Theta_MinTheta(const ThetaSketch **sketches, size_t n, uint32_t *k) {
+    uint64_t theta = UINT64_MAX;
+    *k = 0;
+    for (size_t i = 0; i < n; i++) {
+        theta = sketches[i]->theta < theta ? sketches[i]->theta : theta;
+        *k = sketches[i]->k > *k ? sketches[i]->k : *k;
+    }
+    return theta;
+}
+
+ThetaSketch *Theta_Union(const ThetaSketch **sketches, size_t n) {
+    uint32_t k;
+    uint64_t theta = _Theta_MinTheta(sketches, n, &k);
+    // the merge keeps at most k + 1 hashes, the k smallest and the next one for theta
+    uint64_t *acc = THETA_CALLOC(k + 1, sizeof *acc);
+    uint64_t *merged = THETA_CALLOC(k + 1, sizeof *merged);
+    uint64_t *hashes = THETA_CALLOC(THETA_REBUILD(k), sizeof *hashes);
+    size_t nacc = 0;
+    for (size_t s = 0; s < n; s++) {
+        const size_t nh = _Theta_SortedBelow(sketches[s], theta, hashes);
+        size_t i = 0, j = 0, m = 0;
+        while (m <= k && (i < nacc || j < nh)) {
+            if (j == nh || (i < nacc && acc[i] < hashes[j])) {
+                merged[m++] = acc[i++];
+            } else if (i == nacc || hashes[j] < acc[i]) {
+                merged[m++] = hashes[j++];
+            } else {
+                merged[m++] = acc[i++];
+                j++;
+            }
+        }
+        uint64_t *tmp = acc;
+        acc = merged;
+        merged = tmp;
+        nacc = m;
+    }
+    if (nacc > k) {
+        theta = acc[k];
+        nacc = k;
+    }
+    ThetaSketch *ts = Theta_FromSorted(k, theta, acc, nacc);
+    THETA_FREE(hashes);
+    THETA_FREE(merged);
+    THETA_FREE(acc);
+    return ts;
+}
+
+ThetaSketch *Theta_Intersect(const ThetaSketch **sketches, size_t n) {
+    uint32_t k;
+    const uint64_t theta = _Theta_MinTheta(sketches, n, &k);
+    uint64_t *acc = THETA_CALLOC(THETA_REBUILD(k), sizeof *acc);
+    uint64_t *hashes = THETA_CALLOC(THETA_REBUILD(k), sizeof *hashes);
+    size_t nacc = _Theta_SortedBelow(sketches[0], theta, acc);
+    for (size_t s = 1; s < n && nacc; s++) {
+        const size_t nh = _Theta_SortedBelow(sketches[s], theta, hashes);
+        size_t i = 0, j = 0, m = 0;
+        while (i < nacc && j < nh) {
+            if (acc[i] < hashes[j]) {
+                i++;
+            } else if (hashes[j] < acc[i]) {
+                j++;
+            } else {
+                acc[m++] = acc[i++];
+                j++;
+            }
+        }
+        nacc = m;
+    }
+    ThetaSketch *ts = Theta_FromSorted(k, theta, acc, nacc);
+    THETA_FREE(hashes);
+    THETA_FREE(acc);
+    return ts;
+}
+
+ThetaSketch *Theta_AnotB(const ThetaSketch *a, const ThetaSketch *b) {
+    const uint64_t theta = a->theta < b->theta ? a->theta : b->theta;
+    uint64_t *acc = THETA_CALLOC(THETA_REBUILD(a->k), sizeof *acc);
+    uint64_t *hashes = THETA_CALLOC(THETA_REBUILD(b->k), sizeof *hashes);
+    const size_t na = _Theta_SortedBelow(a, theta, acc);
+    const size_t nb = _Theta_SortedBelow(b, theta, hashes);
+    size_t i = 0, j = 0, m = 0;
+    while (i < na) {
+        if (j == nb || acc[i] < hashes[j]) {
+            acc[m++] = acc[i++];
+        } else if (hashes[j] < acc[i]) {
+            j++;
+        } else {
+            i++;
+            j++;
+        }
+    }
+    ThetaSketch *ts = Theta_FromSorted(a->k, theta, acc, m);
+    THETA_FREE(hashes);
+    THETA_FREE(acc);
+    return ts;
+}
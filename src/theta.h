@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef REDIS_MODULE_TARGET
+#include "redismodule.h"
+#define THETA_CALLOC(count, size) RedisModule_Calloc(count, size)
+#define THETA_FREE(ptr) RedisModule_Free(ptr)
+#endif
+
+#define THETA_DEFAULT_K 4096
+#define THETA_MIN_K 16
+#define THETA_MAX_K (1 << 20)
+
+/*  A Theta sketch, after the KMV sketch of DataSketches: it retains the 64-bit hashes of the
+    items that are below 'theta', a fraction of the hash space, and estimates the number of
+    distinct items as the retained ones divided by that fraction. While it retains fewer than
+    1.5 * k hashes theta is left as it is, and it is exact until it first reaches them. It then
+    keeps the k smallest hashes and lowers theta to the next one, for a relative standard error
+    of about 1 / sqrt(k).
+
+    Since the retained hashes are a uniform sample of the hash space below theta, sketches are
+    unioned, intersected and subtracted by taking the smallest theta of the operands and applying
+    the set operation to their hashes below it.
+
+    The hashes are kept in an open-addressed table of 2 * k slots, in which 0 is an empty slot,
+    so that an item costs a probe. The set operations sort them, and then merge the operands
+    linearly. */
+typedef struct ThetaSketch {
+    uint32_t k;
+    uint64_t theta; //  retained hashes are below theta, UINT64_MAX while the sketch is exact
+    uint64_t count; //  retained hashes
+    uint64_t *table;
+} ThetaSketch;
+
+/*  Returns the hash of an item, the same as that of the Bloom filters.
+    Complexity - O(len) */
+uint64_t Theta_Hash(const void *data, size_t len);
+
+/*  Returns a new empty sketch of 'k' nominal entries, a power of two between THETA_MIN_K and
+    THETA_MAX_K, or NULL if it is not.
+    Complexity - O(k) */
+ThetaSketch *Theta_New(uint32_t k);
+
+/*  Releases resources of a sketch.
+    Complexity - O(1) */
+void Theta_Free(ThetaSketch *ts);
+
+/*  Returns the size of the table in bytes.
+    Complexity - O(1) */
+size_t Theta_Bytes(const ThetaSketch *ts);
+
+/*  Adds an item of hash 'h'.
+    Returns 1 if its hash was retained, 0 if it was already or is above theta.
+    Complexity - O(1) amortized */
+int Theta_Add(ThetaSketch *ts, uint64_t h);
+
+/*  Returns the estimated number of distinct items.
+    Complexity - O(1) */
+double Theta_Estimate(const ThetaSketch *ts);
+
+/*  Writes the retained hashes to 'hashes', sorted, and returns their number.
+    Complexity - O(k * log(k)) */
+size_t Theta_Sorted(const ThetaSketch *ts, uint64_t *hashes);
+
+/*  Returns a new sketch of 'k' nominal entries, of theta 'theta' and with the sorted hashes
+    'hashes', or NULL if they are not all distinct, nonzero and below theta, or are too many.
+    Complexity - O(n) */
+ThetaSketch *Theta_FromSorted(uint32_t k, uint64_t theta, const uint64_t *hashes, size_t n);
+
+/*  Returns a new sketch of the union of the sets of 'n' sketches, of the largest k among them.
+    Complexity - O(n * k * log(k)) */
+ThetaSketch *Theta_Union(const ThetaSketch **sketches, size_t n);
+
+/*  Returns a new sketch of the intersection of the sets of 'n' sketches, of the largest k among
+    them.
+    Complexity - O(n * k * log(k)) */
+ThetaSketch *Theta_Intersect(const ThetaSketch **sketches, size_t n);
+
+/*  Returns a new sketch of the set of 'a' without the items of the set of 'b', of the k of 'a'.
+    Complexity - O(k * log(k)) */
+ThetaSketch *Theta_AnotB(const ThetaSketch *a, const ThetaSketch *b);
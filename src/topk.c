@@ -15,6 +15,8 @@
 
 #include <assert.h>
 #include <math.h>
+#include <pthread.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
@@ -66,6 +68,75 @@ void heapifyDown(HeapBucket *array, size_t len, size_t start) {
 }
 
 TopK *TopK_Create(uint32_t k, uint32_t width, uint32_t depth, double decay) {
+    return TopK_CreateWithLayout(k, width, depth, decay, TOPK_LAYOUT_DEFAULT);
+}
+
+// Decay lookup tables are interned by decay value, as most keys share few decays.
+// The lock is needed since keys may be released by a lazy free thread.
+typedef struct DecayTable {
+    double decay;
+    size_t refcount;
+    struct DecayTable *next;
+    double table[TOPK_DECAY_LOOKUP_TABLE];
+} DecayTable;
+
+static DecayTable *decayTables = NULL;
+static pthread_mutex_t decayTablesLock = PTHREAD_MUTEX_INITIALIZER;
+
+static const double *acquireDecayTable(double decay) {
+    pthread_mutex_lock(&decayTablesLock);
+    DecayTable *entry = decayTables;
+    while (entry && entry->decay != decay) {
+        entry = entry->next;
+    }
+    if (!entry) {
+        entry = TOPK_TRYCALLOC(1, sizeof(*entry));
+        if (entry) {
+            entry->decay = decay;
+            for (uint32_t i = 0; i < TOPK_DECAY_LOOKUP_TABLE; ++i) {
+                entry->table[i] = pow(decay, i);
+            }
+            entry->next = decayTables;
+            decayTables = entry;
+        }
+    }
+    if (entry) {
+        ++entry->refcount;
+    }
+    pthread_mutex_unlock(&decayTablesLock);
+    return entry ? entry->table : NULL;
+}
+
+static void releaseDecayTable(const double *table) {
+    DecayTable *entry = (DecayTable *)((char *)table - offsetof(DecayTable, table));
+    pthread_mutex_lock(&decayTablesLock);
+    if (--entry->refcount == 0) {
+        DecayTable **link = &decayTables;
+        while (*link != entry) {
+            link = &(*link)->next;
+        }
+        *link = entry->next;
+        TOPK_FREE(entry);
+    }
+    pthread_mutex_unlock(&decayTablesLock);
+}
+
+static inline size_t bucketSize(TopKLayout layout) {
+    return layout == TOPK_LAYOUT_COMPACT ? sizeof(CompactBucket) : sizeof(Bucket);
+}
+
+void TopK_RelocateSingleAlloc(TopK *topk) {
+    topk->heap = (HeapBucket *)(topk + 1);
+    void *buckets = topk->heap + topk->k;
+    if (topk->layout == TOPK_LAYOUT_COMPACT) {
+        topk->compactData = buckets;
+    } else {
+        topk->data = buckets;
+    }
+}
+
+TopK *TopK_CreateWithLayout(uint32_t k, uint32_t width, uint32_t depth, double decay,
+                            TopKLayout layout) {
     assert(k > 0);
     assert(width > 0);
     assert(depth > 0);
@@ -75,28 +146,62 @@ TopK *TopK_Create(uint32_t k, uint32_t width, uint32_t depth, double decay) {
         return NULL;
     }
 
-    TopK *topk = (TopK *)TOPK_CALLOC(1, sizeof(TopK));
-    topk->k = k;
+    size_t heapSize = (size_t)k * sizeof(HeapBucket);
+    size_t dataSize = (size_t)width * depth * bucketSize(layout);
+    TopK *topk;
+    if (heapSize + dataSize <= TOPK_SINGLE_ALLOC_MAX_SIZE - sizeof(TopK)) {
+        topk = TOPK_TRYCALLOC(1, sizeof(TopK) + heapSize + dataSize);
+        if (!topk) {
+            return NULL;
+        }
+        topk->k = k;
+        topk->layout = layout;
+        topk->singleAlloc = true;
+        TopK_RelocateSingleAlloc(topk);
+    } else {
+        topk = (TopK *)TOPK_CALLOC(1, sizeof(TopK));
+        topk->k = k;
+        topk->layout = layout;
+        if (layout == TOPK_LAYOUT_COMPACT) {
+            topk->compactData = TOPK_TRYCALLOC(((size_t)width) * depth, sizeof(CompactBucket));
+        } else {
+            topk->data = TOPK_TRYCALLOC(((size_t)width) * depth, sizeof(Bucket));
+        }
+        if (!topk->data && !topk->compactData) {
+            TOPK_FREE(topk);
+            return NULL;
+        }
+
+        topk->heap = TOPK_TRYCALLOC(k, sizeof(HeapBucket));
+        if (!topk->heap) {
+            TopK_Destroy(topk);
+            return NULL;
+        }
+    }
     topk->width = width;
     topk->depth = depth;
     topk->decay = decay;
-    topk->data = TOPK_TRYCALLOC(((size_t)width) * depth, sizeof(Bucket));
-    if (!topk->data) {
-        TOPK_FREE(topk);
-        return NULL;
-    }
 
-    topk->heap = TOPK_TRYCALLOC(k, sizeof(HeapBucket));
-    if (!topk->heap) {
-        TOPK_FREE(topk->data);
-        TOPK_FREE(topk);
+    topk->lookupTable = acquireDecayTable(decay);
+    if (!topk->lookupTable) {
+        TopK_Destroy(topk);
         return NULL;
     }
 
-    for (uint32_t i = 0; i < TOPK_DECAY_LOOKUP_TABLE; ++i) {
-        topk->lookupTable[i] = pow(decay, i);
-    }
+    return topk;
+}
+
+TopK *TopK_CreateSpaceSaving(uint32_t k) {
+    assert(k > 0);
 
+    StreamSummary *summary = SS_New(k);
+    if (!summary) {
+        return NULL;
+    }
+    TopK *topk = TOPK_CALLOC(1, sizeof(TopK));
+    topk->k = k;
+    topk->algo = TOPK_ALGO_SPACESAVING;
+    topk->summary = summary;
     return topk;
 }
 
@@ -105,6 +210,7 @@ void TopK_Destroy(TopK *topk) {
         return;
     }
 
+    bool singleAlloc = topk->singleAlloc;
     if (topk->heap) {
         for (uint32_t i = 0; i < topk->k; ++i) {
             if (topk->heap[i].item) {
@@ -112,19 +218,40 @@ void TopK_Destroy(TopK *topk) {
             }
         }
 
-        TOPK_FREE(topk->heap);
+        if (!singleAlloc) {
+            TOPK_FREE(topk->heap);
+        }
         topk->heap = NULL;
     }
-    if (topk->data) {
+    if (topk->data && !singleAlloc) {
         TOPK_FREE(topk->data);
         topk->data = NULL;
     }
+    if (topk->compactData && !singleAlloc) {
+        TOPK_FREE(topk->compactData);
+        topk->compactData = NULL;
+    }
+    if (topk->escalated) {
+        TOPK_FREE(topk->escalated);
+        topk->escalated = NULL;
+    }
+    if (topk->frontCache) {
+        TOPK_FREE(topk->frontCache);
+        topk->frontCache = NULL;
+    }
+    if (topk->lookupTable) {
+        releaseDecayTable(topk->lookupTable);
+        topk->lookupTable = NULL;
+    }
+    if (topk->summary) {
+        SS_Free(topk->summary);
+        topk->summary = NULL;
+    }
     TOPK_FREE(topk);
 }
 
 // Complexity O(k + strlen)
-static HeapBucket *checkExistInHeap(TopK *topk, const char *item, size_t itemlen) {
-    uint32_t fp = TOPK_HASH(item, itemlen, GA);
+static HeapBucket *checkExistInHeap(TopK *topk, const char *item, size_t itemlen, uint32_t fp) {
     HeapBucket *runner = topk->heap;
 
     for (int32_t i = topk->k - 1; i >= 0; --i)
@@ -135,27 +262,98 @@ static HeapBucket *checkExistInHeap(TopK *topk, const char *item, size_t itemlen
     return NULL;
 }
 
-char *TopK_Add(TopK *topk, const char *item, size_t itemlen, uint32_t increment) {
-    assert(topk);
-    assert(item);
+// Returns the fingerprint as stored in the buckets of 'topk'
+static inline uint32_t bucketFp(const TopK *topk, uint32_t fp) {
+    return topk->layout == TOPK_LAYOUT_COMPACT ? (uint16_t)fp : fp;
+}
 
-    Bucket *runner;
-    counter_t *countPtr;
-    counter_t maxCount = 0;
-    uint32_t fp = TOPK_HASH(item, itemlen, GA);
+// Returns the first escalated bucket whose index is not lower than 'idx'
+static EscalatedBucket *findEscalated(const TopK *topk, size_t idx) {
+    size_t lo = 0, hi = topk->numEscalated;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (topk->escalated[mid].idx < idx) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return topk->escalated + lo;
+}
 
-    counter_t heapMin = topk->heap->count;
+static inline Bucket loadBucket(const TopK *topk, size_t idx) {
+    if (topk->layout != TOPK_LAYOUT_COMPACT) {
+        return topk->data[idx];
+    }
+    CompactBucket compact = topk->compactData[idx];
+    Bucket bucket = {.fp = compact.fp, .count = compact.count};
+    if (compact.count == TOPK_COMPACT_ESCALATED) {
+        bucket.count = findEscalated(topk, idx)->count;
+    }
+    return bucket;
+}
+
+static void storeCompactBucket(TopK *topk, size_t idx, Bucket bucket) {
+    CompactBucket *compact = topk->compactData + idx;
+    bool wasEscalated = compact->count == TOPK_COMPACT_ESCALATED;
+    compact->fp = (uint16_t)bucket.fp;
+
+    if (bucket.count < TOPK_COMPACT_ESCALATED) {
+        compact->count = bucket.count;
+        if (wasEscalated) {
+            EscalatedBucket *esc = findEscalated(topk, idx);
+            size_t tail = topk->escalated + topk->numEscalated - (esc + 1);
+            memmove(esc, esc + 1, tail * sizeof(*esc));
+            --topk->numEscalated;
+        }
+        return;
+    }
+
+    compact->count = TOPK_COMPACT_ESCALATED;
+    EscalatedBucket *esc = findEscalated(topk, idx);
+    if (wasEscalated) {
+        esc->count = bucket.count;
+        return;
+    }
+    if (topk->numEscalated == topk->escalatedCap) {
+        size_t pos = esc - topk->escalated;
+        topk->escalatedCap = topk->escalatedCap ? topk->escalatedCap * 2 : 4;
+        topk->escalated =
+            TOPK_REALLOC(topk->escalated, topk->escalatedCap * sizeof(*topk->escalated));
+        esc = topk->escalated + pos;
+    }
+    size_t tail = topk->escalated + topk->numEscalated - esc;
+    memmove(esc + 1, esc, tail * sizeof(*esc));
+    *esc = (EscalatedBucket){.idx = idx, .count = bucket.count};
+    ++topk->numEscalated;
+}
+
+static inline void storeBucket(TopK *topk, size_t idx, Bucket bucket) {
+    if (topk->layout != TOPK_LAYOUT_COMPACT) {
+        topk->data[idx] = bucket;
+    } else {
+        storeCompactBucket(topk, idx, bucket);
+    }
+}
+
+// Updates the item's counters in all 'depth' arrays and returns the largest one.
+// 'owned' is set if the item holds its bucket in every array.
+static counter_t updateBuckets(TopK *topk, const char *item, size_t itemlen, uint32_t fp,
+                               uint32_t increment, bool *owned) {
+    counter_t maxCount = 0;
+    fp = bucketFp(topk, fp);
+    *owned = true;
 
-    // get max item count
     for (uint32_t i = 0; i < topk->depth; ++i) {
         uint32_t loc = TOPK_HASH(item, itemlen, i) % topk->width;
-        runner = topk->data + i * topk->width + loc;
-        countPtr = &runner->count;
+        size_t idx = (size_t)i * topk->width + loc;
+        Bucket runner = loadBucket(topk, idx);
+        counter_t *countPtr = &runner.count;
         if (*countPtr == 0) {
-            runner->fp = fp;
+            runner.fp = fp;
             *countPtr = increment;
             maxCount = max(maxCount, *countPtr);
-        } else if (runner->fp == fp) {
+        } else if (runner.fp == fp) {
             *countPtr += increment;
             maxCount = max(maxCount, *countPtr);
         } else {
@@ -174,60 +372,343 @@ char *TopK_Add(TopK *topk, const char *item, size_t itemlen, uint32_t increment)
                 if (chance < decay) {
                     --*countPtr;
                     if (*countPtr == 0) {
-                        runner->fp = fp;
+                        runner.fp = fp;
                         *countPtr = local_incr;
                         maxCount = max(maxCount, *countPtr);
                         break;
                     }
                 }
             }
+            *owned = *owned && runner.fp == fp;
+        }
+        storeBucket(topk, idx, runner);
+    }
+    return maxCount;
+}
+
+static int frontCacheFind(const TopKFrontCache *cache, const char *item, size_t itemlen,
+                          uint32_t fp) {
+    for (uint32_t i = 0; i < cache->used; ++i) {
+        if (cache->fp[i] == fp && cache->itemlen[i] == itemlen &&
+            memcmp(cache->item[i], item, itemlen) == 0) {
+            return i;
         }
     }
+    return -1;
+}
+
+static char *updateHeap(TopK *topk, const char *item, size_t itemlen, uint32_t fp,
+                        counter_t maxCount, bool *entered);
+
+// Applies the pending increments of a cached item. Cached items are always in the heap.
+static void frontCacheApply(TopK *topk, uint32_t i) {
+    TopKFrontCache *cache = topk->frontCache;
+    counter_t pending = cache->pending[i];
+    if (pending == 0) {
+        return;
+    }
+    cache->pending[i] = 0;
+    bool owned, entered;
+    counter_t maxCount =
+        updateBuckets(topk, cache->item[i], cache->itemlen[i], cache->fp[i], pending, &owned);
+    updateHeap(topk, cache->item[i], cache->itemlen[i], cache->fp[i], maxCount, &entered);
+    assert(!entered);
+}
+
+static void frontCacheRemove(TopKFrontCache *cache, uint32_t i) {
+    uint32_t last = --cache->used;
+    cache->fp[i] = cache->fp[last];
+    cache->itemlen[i] = cache->itemlen[last];
+    cache->pending[i] = cache->pending[last];
+    cache->item[i] = cache->item[last];
+}
+
+// Flushes and evicts the heap root while it is cached, so that a cached item is never
+// expelled. Returns true if the root changed.
+static bool frontCacheEvictRoot(TopK *topk) {
+    bool changed = false;
+    int i;
+    while ((i = frontCacheFind(topk->frontCache, topk->heap[0].item, topk->heap[0].itemlen,
+                               topk->heap[0].fp)) >= 0) {
+        frontCacheApply(topk, i);
+        frontCacheRemove(topk->frontCache, i);
+        changed = true;
+    }
+    return changed;
+}
+
+// Adds an item to the cache if it is well above the heap minimum and holds all its buckets,
+// so that its increments are plain additions.
+static void frontCacheAdmit(TopK *topk, const char *item, size_t itemlen, uint32_t fp,
+                            counter_t count, bool owned) {
+    counter_t heapMin = topk->heap[0].count;
+    if (!owned || heapMin == 0 || count < 2 * (uint64_t)heapMin) {
+        return;
+    }
+    if (!topk->frontCache) {
+        topk->frontCache = TOPK_TRYCALLOC(1, sizeof(*topk->frontCache));
+        if (!topk->frontCache) {
+            return;
+        }
+    }
+    TopKFrontCache *cache = topk->frontCache;
+    if (cache->used == TOPK_FRONT_CACHE_SIZE || frontCacheFind(cache, item, itemlen, fp) >= 0) {
+        return;
+    }
+    HeapBucket *heapItem = checkExistInHeap(topk, item, itemlen, fp);
+    if (heapItem == NULL) {
+        return;
+    }
+    uint32_t i = cache->used++;
+    cache->fp[i] = fp;
+    cache->itemlen[i] = itemlen;
+    cache->pending[i] = 0;
+    cache->item[i] = heapItem->item;
+}
+
+static void frontCacheFlush(TopK *topk);
+
+// Accumulates 'increment' for a cached item. Returns false if the item is not cached.
+static bool frontCacheAdd(TopK *topk, const char *item, size_t itemlen, uint32_t fp,
+                          uint64_t increment) {
+    TopKFrontCache *cache = topk->frontCache;
+    int i = frontCacheFind(cache, item, itemlen, fp);
+    if (i < 0) {
+        return false;
+    }
+    if (cache->pending[i] + increment > UINT32_MAX) {
+        frontCacheApply(topk, i);
+        if (increment > UINT32_MAX) {
+            return false;
+        }
+    }
+    cache->pending[i] += increment;
+    if (++cache->hits >= TOPK_FRONT_CACHE_FLUSH_INTERVAL) {
+        frontCacheFlush(topk);
+    }
+    return true;
+}
+
+// Applies the pending increments of all entries and evicts those that were not hit since the
+// previous flush
+static void frontCacheFlush(TopK *topk) {
+    TopKFrontCache *cache = topk->frontCache;
+    for (uint32_t i = cache->used; i-- > 0;) {
+        bool cold = cache->pending[i] == 0;
+        frontCacheApply(topk, i);
+        if (cold) {
+            frontCacheRemove(cache, i);
+        }
+    }
+    cache->hits = 0;
+}
+
+// Returns the increments pending in the front cache for an item
+static counter_t frontCachePending(const TopK *topk, const char *item, size_t itemlen,
+                                   uint32_t fp) {
+    if (!topk->frontCache) {
+        return 0;
+    }
+    int i = frontCacheFind(topk->frontCache, item, itemlen, fp);
+    return i < 0 ? 0 : topk->frontCache->pending[i];
+}
+
+// Updates the heap with the item's new count. Returns the expelled item, if any.
+static char *updateHeap(TopK *topk, const char *item, size_t itemlen, uint32_t fp,
+                        counter_t maxCount, bool *entered) {
+    HeapBucket *itemHeapPtr = checkExistInHeap(topk, item, itemlen, fp);
+    if (itemHeapPtr != NULL) {
+        itemHeapPtr->count = maxCount; // Not max of the two, as it might have been decayed
+        heapifyDown(topk->heap, topk->k, itemHeapPtr - topk->heap);
+        *entered = false;
+        return NULL;
+    }
+
+    // the count of a cached root is stale, apply it before choosing whom to expel
+    if (topk->frontCache && frontCacheEvictRoot(topk) && maxCount < topk->heap[0].count) {
+        *entered = false;
+        return NULL;
+    }
+
+    char *expelled = topk->heap[0].item;
+
+    topk->heap[0].count = maxCount;
+    topk->heap[0].fp = fp;
+    topk->heap[0].item = topKStrndup(item, itemlen);
+    topk->heap[0].itemlen = itemlen;
+    heapifyDown(topk->heap, topk->k, 0);
+    *entered = true;
+    return expelled;
+}
+
+char *TopK_Add(TopK *topk, const char *item, size_t itemlen, uint32_t increment) {
+    assert(topk);
+    assert(item);
+
+    if (topk->algo == TOPK_ALGO_SPACESAVING) {
+        return SS_Add(topk->summary, item, itemlen, increment);
+    }
+    uint32_t fp = TOPK_HASH(item, itemlen, GA);
+    if (topk->frontCache && frontCacheAdd(topk, item, itemlen, fp, increment)) {
+        return NULL;
+    }
+    counter_t heapMin = topk->heap->count;
+
+    // get max item count
+    bool owned;
+    counter_t maxCount = updateBuckets(topk, item, itemlen, fp, increment, &owned);
 
     // update heap
     if (maxCount >= heapMin) {
-        HeapBucket *itemHeapPtr = checkExistInHeap(topk, item, itemlen);
-        if (itemHeapPtr != NULL) {
-            itemHeapPtr->count = maxCount; // Not max of the two, as it might have been decayed
-            heapifyDown(topk->heap, topk->k, itemHeapPtr - topk->heap);
+        bool entered;
+        char *expelled = updateHeap(topk, item, itemlen, fp, maxCount, &entered);
+        frontCacheAdmit(topk, item, itemlen, fp, maxCount, owned);
+        return expelled;
+    }
+    return NULL;
+}
+
+typedef struct {
+    const char *item;
+    size_t itemlen;
+    uint32_t fp;
+    uint64_t increment; // sum of the increments of all occurrences in the batch
+    size_t first;       // position of the first occurrence
+} BatchEntry;
+
+void TopK_AddBatch(TopK *topk, const char *const *items, const size_t *itemlens,
+                   const uint32_t *increments, size_t count, char **expelled) {
+    assert(topk);
+    assert(items);
+
+    // a Space-Saving add is O(1), so there is nothing to gain from aggregating
+    if (topk->algo == TOPK_ALGO_SPACESAVING) {
+        for (size_t i = 0; i < count; ++i) {
+            expelled[i] = SS_Add(topk->summary, items[i], itemlens[i], increments[i]);
+        }
+        return;
+    }
+
+    if (count == 1) {
+        expelled[0] = TopK_Add(topk, items[0], itemlens[0], increments[0]);
+        return;
+    }
+
+    size_t tableSize = 2;
+    while (tableSize < count * 2) {
+        tableSize <<= 1;
+    }
+    size_t *table = TOPK_CALLOC(tableSize, sizeof(*table)); // entry index + 1, 0 is empty
+    BatchEntry *entries = TOPK_CALLOC(count, sizeof(*entries));
+    size_t *nextPos = TOPK_CALLOC(count, sizeof(*nextPos)); // next occurrence of the same item
+    size_t *lastPos = TOPK_CALLOC(count, sizeof(*lastPos));
+    size_t nentries = 0;
+
+    // aggregate repeated items
+    for (size_t i = 0; i < count; ++i) {
+        expelled[i] = NULL;
+        nextPos[i] = SIZE_MAX;
+        uint32_t fp = TOPK_HASH(items[i], itemlens[i], GA);
+        size_t slot = fp & (tableSize - 1);
+        BatchEntry *entry = NULL;
+        while (table[slot] != 0) {
+            BatchEntry *cur = entries + table[slot] - 1;
+            if (cur->fp == fp && cur->itemlen == itemlens[i] &&
+                memcmp(cur->item, items[i], itemlens[i]) == 0) {
+                entry = cur;
+                break;
+            }
+            slot = (slot + 1) & (tableSize - 1);
+        }
+        if (entry == NULL) {
+            entry = entries + nentries;
+            *entry = (BatchEntry){.item = items[i], .itemlen = itemlens[i], .fp = fp, .first = i};
+            table[slot] = ++nentries;
         } else {
-            // TOPK_FREE(topk->heap[0].item);
-            char *expelled = topk->heap[0].item;
+            nextPos[lastPos[entry - entries]] = i;
+        }
+        lastPos[entry - entries] = i;
+        entry->increment += increments[i];
+    }
 
-            topk->heap[0].count = maxCount;
-            topk->heap[0].fp = fp;
-            topk->heap[0].item = topKStrndup(item, itemlen);
-            topk->heap[0].itemlen = itemlen;
-            heapifyDown(topk->heap, topk->k, 0);
-            return expelled;
+    // apply the counters once per distinct item and reconcile the heap
+    for (BatchEntry *entry = entries; entry < entries + nentries; ++entry) {
+        if (topk->frontCache &&
+            frontCacheAdd(topk, entry->item, entry->itemlen, entry->fp, entry->increment)) {
+            continue;
         }
+        counter_t maxCount = 0;
+        bool owned;
+        uint64_t remaining = entry->increment;
+        do {
+            uint32_t incr = remaining > UINT32_MAX ? UINT32_MAX : (uint32_t)remaining;
+            maxCount = updateBuckets(topk, entry->item, entry->itemlen, entry->fp, incr, &owned);
+            remaining -= incr;
+        } while (remaining > 0);
+
+        counter_t heapMin = topk->heap->count;
+        if (maxCount < heapMin) {
+            continue;
+        }
+        bool entered;
+        char *out = updateHeap(topk, entry->item, entry->itemlen, entry->fp, maxCount, &entered);
+        frontCacheAdmit(topk, entry->item, entry->itemlen, entry->fp, maxCount, owned);
+        if (!entered) {
+            continue;
+        }
+
+        // Report the expelled item at the occurrence whose running count would have
+        // first reached the heap minimum, had the items been added one by one.
+        int64_t running = (int64_t)maxCount - (int64_t)entry->increment;
+        size_t pos = entry->first;
+        for (size_t i = entry->first; i != SIZE_MAX; i = nextPos[i]) {
+            running += increments[i];
+            pos = i;
+            if (running >= (int64_t)heapMin) {
+                break;
+            }
+        }
+        expelled[pos] = out;
     }
-    return NULL;
+
+    TOPK_FREE(lastPos);
+    TOPK_FREE(nextPos);
+    TOPK_FREE(entries);
+    TOPK_FREE(table);
 }
 
 bool TopK_Query(TopK *topk, const char *item, size_t itemlen) {
-    return checkExistInHeap(topk, item, itemlen) != NULL;
+    if (topk->algo == TOPK_ALGO_SPACESAVING) {
+        return SS_Count(topk->summary, item, itemlen) != 0;
+    }
+    return checkExistInHeap(topk, item, itemlen, TOPK_HASH(item, itemlen, GA)) != NULL;
 }
 
 size_t TopK_Count(TopK *topk, const char *item, size_t itemlen) {
     assert(topk);
     assert(item);
 
-    Bucket *runner = NULL;
+    if (topk->algo == TOPK_ALGO_SPACESAVING) {
+        return SS_Count(topk->summary, item, itemlen);
+    }
     uint32_t fp = TOPK_HASH(item, itemlen, GA);
     // TODO: The optimization of >heapMin should be revisited for performance
     counter_t heapMin = topk->heap->count;
-    HeapBucket *heapPtr = checkExistInHeap(topk, item, itemlen);
+    HeapBucket *heapPtr = checkExistInHeap(topk, item, itemlen, fp);
     counter_t res = 0;
 
+    fp = bucketFp(topk, fp);
     for (uint32_t i = 0; i < topk->depth; ++i) {
         uint32_t loc = TOPK_HASH(item, itemlen, i) % topk->width;
-        runner = topk->data + i * topk->width + loc;
-        if (runner->fp == fp && (heapPtr == NULL || runner->count >= heapMin)) {
-            res = max(res, runner->count);
+        Bucket runner = loadBucket(topk, (size_t)i * topk->width + loc);
+        if (runner.fp == fp && (heapPtr == NULL || runner.count >= heapMin)) {
+            res = max(res, runner.count);
         }
     }
-    return res;
+    // cached items are in the heap, and their pending increments are added to their buckets when
+    // applied
+    counter_t pending = heapPtr ? frontCachePending(topk, item, itemlen, heapPtr->fp) : 0;
+    return (size_t)res + pending;
 }
 
 int cmpHeapBucket(const void *tmp1, const void *tmp2) {
@@ -236,9 +717,291 @@ int cmpHeapBucket(const void *tmp1, const void *tmp2) {
     return res1->count < res2->count ? 1 : res1->count > res2->count ? -1 : 0;
 }
 
+// Lists the items of a Space-Saving summary by decreasing count
+static HeapBucket *listSummary(TopK *topk, HeapBucket *heapList) {
+    const StreamSummary *ss = topk->summary;
+    uint32_t *order = TOPK_CALLOC(ss->used + 1, sizeof(*order));
+    uint32_t n = SS_Sorted(ss, order);
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t c = order[n - 1 - i];
+        uint64_t count = SS_CounterCount(ss, c);
+        heapList[i] = (HeapBucket){
+            .fp = ss->counters[c].fp,
+            .itemlen = ss->counters[c].itemlen,
+            .item = ss->counters[c].item,
+            .count = count > UINT32_MAX ? UINT32_MAX : (counter_t)count,
+        };
+    }
+    TOPK_FREE(order);
+    return heapList;
+}
+
 HeapBucket *TopK_List(TopK *topk) {
     HeapBucket *heapList = TOPK_CALLOC(topk->k, (sizeof(*heapList)));
+    if (topk->algo == TOPK_ALGO_SPACESAVING) {
+        return listSummary(topk, heapList);
+    }
     memcpy(heapList, topk->heap, topk->k * sizeof(HeapBucket));
+    // cached items are listed with their pending increments, which are left pending
+    for (uint32_t i = 0; i < topk->k; ++i) {
+        if (heapList[i].item) {
+            heapList[i].count += frontCachePending(topk, heapList[i].item, heapList[i].itemlen,
+                                                   heapList[i].fp);
+        }
+    }
     qsort(heapList, topk->k, sizeof(*heapList), cmpHeapBucket);
     return heapList;
 }
+
+// A cell of a cached item, with the increments pending for it
+typedef struct PendingCell {
+    size_t idx;
+    uint32_t fp; //  as stored in the buckets
+    counter_t count;
+} PendingCell;
+
+// The pending cells of a merge source, sorted by index and consumed as the cells are merged
+typedef struct PendingCells {
+    PendingCell *cells;
+    size_t n;
+    size_t next;
+} PendingCells;
+
+static int cmpPendingCell(const void *tmp1, const void *tmp2) {
+    const PendingCell *res1 = tmp1;
+    const PendingCell *res2 = tmp2;
+    return res1->idx < res2->idx ? -1 : res1->idx > res2->idx ? 1 : 0;
+}
+
+// Lists the cells the pending increments of the front cache of 'topk' would be added to
+static void pendingCells(const TopK *topk, PendingCells *pending) {
+    const TopKFrontCache *cache = topk->frontCache;
+    *pending = (PendingCells){0};
+    if (!cache || cache->used == 0) {
+        return;
+    }
+    pending->cells = TOPK_CALLOC((size_t)cache->used * topk->depth, sizeof(*pending->cells));
+    for (uint32_t i = 0; i < cache->used; ++i) {
+        if (cache->pending[i] == 0) {
+            continue;
+        }
+        for (uint32_t d = 0; d < topk->depth; ++d) {
+            uint32_t loc = TOPK_HASH(cache->item[i], cache->itemlen[i], d) % topk->width;
+            pending->cells[pending->n++] = (PendingCell){
+                .idx = (size_t)d * topk->width + loc,
+                .fp = bucketFp(topk, cache->fp[i]),
+                .count = cache->pending[i],
+            };
+        }
+    }
+    qsort(pending->cells, pending->n, sizeof(*pending->cells), cmpPendingCell);
+}
+
+// Returns the count of the bucket at 'idx' with the pending increments of the items it holds,
+// which are left pending in the source. Cells must be visited by increasing index.
+static uint64_t loadPendingBucket(const TopK *topk, PendingCells *pending, size_t idx,
+                                  Bucket *bucket) {
+    *bucket = loadBucket(topk, idx);
+    uint64_t count = bucket->count;
+    for (; pending->next < pending->n && pending->cells[pending->next].idx == idx;
+         ++pending->next) {
+        const PendingCell *cell = pending->cells + pending->next;
+        if (count == 0 || cell->fp == bucket->fp) {
+            bucket->fp = cell->fp;
+            count += cell->count;
+        }
+    }
+    return count;
+}
+
+// Resolves the weighted buckets of the same cell: counts of equal fingerprints are summed
+// and the strongest fingerprint is kept, decremented by the counts of all the others.
+static int mergeBucket(Bucket *dest, size_t quantity, const TopK **src, const long long *weights,
+                       PendingCells *pending, size_t idx, uint32_t *fps, uint64_t *sums) {
+    size_t groups = 0;
+    for (size_t i = 0; i < quantity; ++i) {
+        Bucket bucket;
+        uint64_t raw = loadPendingBucket(src[i], pending + i, idx, &bucket);
+        if (raw == 0) {
+            continue;
+        }
+        if (raw > UINT32_MAX) {
+            return -1;
+        }
+        uint64_t count = raw * (uint64_t)weights[i];
+        size_t g = 0;
+        while (g < groups && fps[g] != bucket.fp) {
+            ++g;
+        }
+        if (g == groups) {
+            fps[groups] = bucket.fp;
+            sums[groups++] = 0;
+        }
+        sums[g] += count;
+        if (count > UINT32_MAX || sums[g] > UINT32_MAX) {
+            return -1;
+        }
+    }
+
+    uint64_t total = 0;
+    size_t best = 0;
+    for (size_t g = 0; g < groups; ++g) {
+        total += sums[g];
+        if (sums[g] > sums[best]) {
+            best = g;
+        }
+    }
+    *dest = (Bucket){0};
+    if (groups > 0 && sums[best] > total - sums[best]) {
+        dest->fp = fps[best];
+        dest->count = sums[best] - (total - sums[best]);
+    }
+    return 0;
+}
+
+static int cmpHeapItem(const void *tmp1, const void *tmp2) {
+    const HeapBucket *res1 = tmp1;
+    const HeapBucket *res2 = tmp2;
+    if (res1->fp != res2->fp) {
+        return res1->fp < res2->fp ? -1 : 1;
+    }
+    if (res1->itemlen != res2->itemlen) {
+        return res1->itemlen < res2->itemlen ? -1 : 1;
+    }
+    return memcmp(res1->item, res2->item, res1->itemlen);
+}
+
+// Replaces the summary of 'dest' with the merge of those of 'src'
+static int mergeSummaries(TopK *dest, size_t quantity, const TopK **src,
+                          const long long *weights) {
+    const StreamSummary **summaries = TOPK_CALLOC(quantity, sizeof(*summaries));
+    for (size_t i = 0; i < quantity; ++i) {
+        summaries[i] = src[i]->summary;
+    }
+    bool overflow;
+    StreamSummary *merged = SS_Merge(dest->k, quantity, summaries, weights, &overflow);
+    TOPK_FREE(summaries);
+    if (!merged) {
+        return overflow ? -1 : -2;
+    }
+    SS_Free(dest->summary);
+    dest->summary = merged;
+    return 0;
+}
+
+int TopK_Merge(TopK *dest, size_t quantity, const TopK **src, const long long *weights) {
+    assert(dest);
+    assert(src);
+    assert(weights);
+
+    if (dest->algo == TOPK_ALGO_SPACESAVING) {
+        return mergeSummaries(dest, quantity, src, weights);
+    }
+
+    size_t size = (size_t)dest->width * dest->depth;
+    TopK *merged =
+        TopK_CreateWithLayout(dest->k, dest->width, dest->depth, dest->decay, dest->layout);
+    HeapBucket *candidates = TOPK_TRYCALLOC(quantity * dest->k, sizeof(*candidates));
+    uint32_t *fps = TOPK_CALLOC(quantity, sizeof(*fps));
+    uint64_t *sums = TOPK_CALLOC(quantity, sizeof(*sums));
+    PendingCells *pending = TOPK_CALLOC(quantity, sizeof(*pending));
+    int ret = -2;
+    if (!merged || !candidates) {
+        goto done;
+    }
+
+    // the increments pending in the front caches of the sources are merged without applying
+    // them, as the sources are only read
+    for (size_t i = 0; i < quantity; ++i) {
+        pendingCells(src[i], pending + i);
+    }
+
+    for (size_t idx = 0; idx < size; ++idx) {
+        Bucket bucket;
+        if (mergeBucket(&bucket, quantity, src, weights, pending, idx, fps, sums) != 0) {
+            ret = -1;
+            goto done;
+        }
+        if (bucket.count != 0) {
+            storeBucket(merged, idx, bucket);
+        }
+    }
+
+    // collect the distinct heap items of all sketches
+    size_t ncandidates = 0;
+    for (size_t i = 0; i < quantity; ++i) {
+        for (uint32_t j = 0; j < src[i]->k; ++j) {
+            if (src[i]->heap[j].item != NULL) {
+                candidates[ncandidates++] = src[i]->heap[j];
+            }
+        }
+    }
+    qsort(candidates, ncandidates, sizeof(*candidates), cmpHeapItem);
+    size_t ndistinct = 0;
+    for (size_t i = 0; i < ncandidates; ++i) {
+        if (ndistinct > 0 && cmpHeapItem(candidates + ndistinct - 1, candidates + i) == 0) {
+            continue;
+        }
+        HeapBucket *cand = candidates + ndistinct++;
+        *cand = candidates[i];
+        cand->count = 0;
+        for (uint32_t d = 0; d < merged->depth; ++d) {
+            uint32_t loc = TOPK_HASH(cand->item, cand->itemlen, d) % merged->width;
+            Bucket bucket = loadBucket(merged, (size_t)d * merged->width + loc);
+            if (bucket.fp == bucketFp(merged, cand->fp)) {
+                cand->count = max(cand->count, bucket.count);
+            }
+        }
+    }
+
+    // keep the 'k' strongest candidates, an ascending array being a valid min-heap
+    qsort(candidates, ndistinct, sizeof(*candidates), cmpHeapBucket);
+    for (size_t i = 0; i < ndistinct && i < merged->k && candidates[i].count > 0; ++i) {
+        HeapBucket *bucket = merged->heap + merged->k - 1 - i;
+        *bucket = candidates[i];
+        bucket->item = topKStrndup(candidates[i].item, candidates[i].itemlen);
+    }
+
+    // the replaced content of 'dest' is discarded along with its cached increments
+    if (dest->frontCache) {
+        TOPK_FREE(dest->frontCache);
+        dest->frontCache = NULL;
+    }
+
+    // copy the result rather than swapping allocations, as 'dest' may be a single allocation
+    if (dest->layout == TOPK_LAYOUT_COMPACT) {
+        memcpy(dest->compactData, merged->compactData, size * sizeof(CompactBucket));
+        EscalatedBucket *escalated = dest->escalated;
+        size_t escalatedCap = dest->escalatedCap;
+        dest->escalated = merged->escalated;
+        dest->numEscalated = merged->numEscalated;
+        dest->escalatedCap = merged->escalatedCap;
+        merged->escalated = escalated;
+        merged->escalatedCap = escalatedCap;
+    } else {
+        memcpy(dest->data, merged->data, size * sizeof(Bucket));
+    }
+    for (uint32_t i = 0; i < dest->k; ++i) {
+        if (dest->heap[i].item) {
+            TOPK_FREE(dest->heap[i].item);
+        }
+    }
+    memcpy(dest->heap, merged->heap, dest->k * sizeof(HeapBucket));
+    memset(merged->heap, 0, merged->k * sizeof(HeapBucket));
+    ret = 0;
+
+done:
+    for (size_t i = 0; i < quantity; ++i) {
+        if (pending[i].cells) {
+            TOPK_FREE(pending[i].cells);
+        }
+    }
+    TOPK_FREE(pending);
+    TOPK_FREE(sums);
+    TOPK_FREE(fps);
+    if (candidates) {
+        TOPK_FREE(candidates);
+    }
+    TopK_Destroy(merged);
+    return ret;
+}
@@ -18,10 +18,13 @@
 #include <string.h>
 #include <stdlib.h>
 
+#include "spacesaving.h"
+
 #ifdef REDIS_MODULE_TARGET
 #include "redismodule.h"
 
 #define TOPK_CALLOC(count, size) RedisModule_Calloc(count, size)
+#define TOPK_REALLOC(ptr, size) RedisModule_Realloc(ptr, size)
 #define TOPK_TRYCALLOC(...)                                                                        \
     RedisModule_TryCalloc ? RedisModule_TryCalloc(__VA_ARGS__) : RedisModule_Calloc(__VA_ARGS__)
 #define TOPK_FREE(ptr) RedisModule_Free(ptr)
@@ -32,6 +35,9 @@
 
 #define TOPK_DECAY_LOOKUP_TABLE 256
 
+// Sketches up to this size keep header, heap and buckets in a single allocation
+#define TOPK_SINGLE_ALLOC_MAX_SIZE 4096
+
 typedef uint32_t counter_t;
 
 typedef struct HeapBucket {
@@ -46,6 +52,44 @@ typedef struct Bucket {
     counter_t count;
 } Bucket;
 
+// Compact layout bucket. A count of TOPK_COMPACT_ESCALATED means the actual count
+// is kept in the escalation table.
+typedef struct CompactBucket {
+    uint16_t fp; //  low 16 bits of the fingerprint
+    uint16_t count;
+} CompactBucket;
+
+#define TOPK_COMPACT_ESCALATED UINT16_MAX
+
+typedef struct EscalatedBucket {
+    uint64_t idx; //  index of the bucket in 'compactData'
+    counter_t count;
+} EscalatedBucket;
+
+// Exact counters in front of the sketch for items firmly in the heap. Their increments are
+// accumulated in 'pending' and applied to the buckets and heap when flushed.
+#define TOPK_FRONT_CACHE_SIZE 64
+#define TOPK_FRONT_CACHE_FLUSH_INTERVAL 1024 //  cached increments between flushes
+
+typedef struct TopKFrontCache {
+    uint32_t used;
+    uint32_t hits; //  since the last flush
+    uint32_t fp[TOPK_FRONT_CACHE_SIZE];
+    uint32_t itemlen[TOPK_FRONT_CACHE_SIZE];
+    counter_t pending[TOPK_FRONT_CACHE_SIZE];
+    const char *item[TOPK_FRONT_CACHE_SIZE]; //  owned by the heap
+} TopKFrontCache;
+
+typedef enum {
+    TOPK_LAYOUT_DEFAULT = 0,
+    TOPK_LAYOUT_COMPACT = 1,
+} TopKLayout;
+
+typedef enum {
+    TOPK_ALGO_HEAVYKEEPER = 0,
+    TOPK_ALGO_SPACESAVING = 1,
+} TopKAlgo;
+
 typedef struct topk {
     uint32_t k;
     uint32_t width;
@@ -54,8 +98,24 @@ typedef struct topk {
 
     Bucket *data;
     HeapBucket *heap;
-    double lookupTable[TOPK_DECAY_LOOKUP_TABLE];
+    const double *lookupTable; //  shared by all the DSs with the same decay
+    bool singleAlloc;          //  heap and buckets are allocated along with the header
     //  TODO: add function pointers for fast vs accurate
+
+    TopKLayout layout;
+    // TOPK_LAYOUT_COMPACT replaces 'data' with 4 byte buckets and a table, sorted by index,
+    // of the buckets whose count does not fit 16 bits.
+    CompactBucket *compactData;
+    EscalatedBucket *escalated;
+    size_t numEscalated;
+    size_t escalatedCap;
+
+    TopKFrontCache *frontCache; //  allocated once an item qualifies
+
+    TopKAlgo algo;
+    // TOPK_ALGO_SPACESAVING keeps the items in 'summary' instead of the buckets and heap, and
+    // leaves width, depth and decay at 0.
+    StreamSummary *summary;
 } TopK;
 
 /*  Returns a new Top-K DS which will keep to 'k' heavyhitter, using
@@ -63,6 +123,21 @@ typedef struct topk {
     Complexity - O(1) */
 TopK *TopK_Create(uint32_t k, uint32_t width, uint32_t depth, double decay);
 
+/*  Same as TopK_Create, with the buckets stored in the given 'layout'.
+    Complexity - O(1) */
+TopK *TopK_CreateWithLayout(uint32_t k, uint32_t width, uint32_t depth, double decay,
+                            TopKLayout layout);
+
+/*  Returns a new Top-K DS which will keep 'k' heavyhitters in a Space-Saving stream summary,
+    or NULL if it cannot be allocated.
+    Complexity - O(k) */
+TopK *TopK_CreateSpaceSaving(uint32_t k);
+
+/*  Points the heap and buckets of a single allocation 'topk' into its block, after the
+    block was moved.
+    Complexity - O(1) */
+void TopK_RelocateSingleAlloc(TopK *topk);
+
 /*  Releases resources of a Top-K DS.
     Complexity - O(k) */
 void TopK_Destroy(TopK *topk);
@@ -74,14 +149,35 @@ void TopK_Destroy(TopK *topk);
     Complexity - O(k) */
 char *TopK_Add(TopK *topk, const char *item, size_t itemlen, uint32_t increment);
 
+/*  Inserts 'count' items into 'topk' DS. Repeated items are aggregated so the
+    counters and the heap are updated once per distinct item.
+    'expelled[i]' is set to the item expelled from list by the i-th item, or NULL.
+    Non-NULL entries should be free()d.
+    Complexity - O(count + distinct * k) */
+void TopK_AddBatch(TopK *topk, const char *const *items, const size_t *itemlens,
+                   const uint32_t *increments, size_t count, char **expelled);
+
 /*  Checks whether an 'item' is in Top-K list of 'topk'.
     Complexity - O(k) */
 bool TopK_Query(TopK *topk, const char *item, size_t itemlen);
 
 /*  Returns count for an 'item' in 'topk' DS.
-    This number can be significantly lower than real count.
+    This number can be significantly lower than real count. It includes the increments
+    pending in the front cache, which are left pending, so that reads do not modify 'topk'.
     Complexity - O(k) */
 size_t TopK_Count(TopK *topk, const char *item, size_t itemlen);
 
-/*  Returns full 'heapList' of items in 'topk' DS. */
+/*  Returns full 'heapList' of items in 'topk' DS, including the increments pending in the
+    front cache, without applying them. */
 HeapBucket *TopK_List(TopK *topk);
+
+/*  Merges 'quantity' Top-K DSs from 'src' into 'dest', multiplying their counters by 'weights'.
+    All DSs must have the same k, width, depth, decay, layout and algo. 'dest' may be one of
+    'src'. Counters sharing a fingerprint are summed, otherwise the largest is kept, reduced by
+    the others. The heap is rebuilt from the items listed by any of 'src'. The increments
+    pending in the front caches of 'src' are merged without being applied. Space-Saving
+    summaries are merged by SS_Merge.
+    Returns 0 on success, -1 on counter overflow and -2 on allocation failure. On failure,
+    'dest' is not modified.
+    Complexity - O(quantity * (width * depth + k * (depth + log(quantity * k)))) */
+int TopK_Merge(TopK *dest, size_t quantity, const TopK **src, const long long *weights);
@@ -54,4 +54,7 @@ def server_version_at_least(env, ver):
     return server_ver >= ver
 
 def server_version_less_than(env, ver):
-    return not server_version_at_least(env, ver)
\ No newline at end of file
+    return not server_version_at_least(env, ver)
+
+def parse_info(array_reply):
+    return {array_reply[i]: array_reply[i + 1] for i in range(0, len(array_reply), 2)}
@@ -8,7 +8,8 @@ class testACL():
       """Test that the various `bloom` categories was added appropriately in module load"""
       env = self.env
       res = env.cmd('ACL', 'CAT')
-      [env.assertTrue(cat in res) for cat in ['bloom', 'cuckoo', 'topk', 'cms', 'tdigest']]
+      [env.assertTrue(cat in res) for cat in ['bloom', 'cuckoo', 'topk', 'cms', 'tdigest', 'ddsketch',
+                                              'hdr', 'cbf', 'rf', 'mh', 'theta']]
 
   def test_acl_json_commands(self):
       """Tests that the RedisBloom commands are registered to the various `bloom` ACL categories"""
@@ -20,7 +21,7 @@ class testACL():
       # Use a set since the order of the response is not consistent.
       BLOOM_COMMANDS = set([
         "bf.reserve", "bf.add", "bf.madd", "bf.insert", "bf.exists",  "bf.mexists", 
-        "bf.info", "bf.card", "bf.debug",  "bf.scandump",  "bf.loadchunk",
+        "bf.info", "bf.card", "bf.debug",  "bf.scandump",  "bf.loadchunk", "bf.freeze",
       ])
       CUCKOO_COMMANDS = set([
         "cf.reserve", "cf.add", "cf.addnx", "cf.insert", "cf.insertnx", "cf.exists", "cf.mexists",
@@ -31,11 +32,32 @@ class testACL():
       ])
       TOPK_COMMANDS = set([
         "topk.reserve", "topk.add", "topk.incrby", "topk.query", "topk.count", "topk.list", "topk.info",
+        "topk.merge",
       ])
       TDIGEST_COMMANDS = set([
         "tdigest.create", "tdigest.add", "tdigest.reset", "tdigest.merge", "tdigest.min", "tdigest.max",
         "tdigest.quantile", "tdigest.byrank", "tdigest.byrevrank", "tdigest.rank", "tdigest.revrank",
         "tdigest.cdf", "tdigest.trimmed_mean", "tdigest.info",
+        "tdigest.addweighted", "tdigest.mquantile", "tdigest.mcdf",
+      ])
+      DDSKETCH_COMMANDS = set([
+        "ddsketch.create", "ddsketch.add", "ddsketch.merge", "ddsketch.quantile", "ddsketch.cdf",
+        "ddsketch.info",
+      ])
+      HDR_COMMANDS = set([
+        "hdr.create", "hdr.add", "hdr.reset", "hdr.merge", "hdr.min", "hdr.max", "hdr.quantile",
+        "hdr.cdf", "hdr.buckets", "hdr.info",
+      ])
+      CBF_COMMANDS = set([
+        "cbf.reserve", "cbf.add", "cbf.madd", "cbf.exists", "cbf.mexists", "cbf.del", "cbf.info",
+      ])
+      RF_COMMANDS = set([
+        "rf.reserve", "rf.add", "rf.exists", "rf.range", "rf.info", "rf.scandump", "rf.loadchunk",
+      ])
+      MH_COMMANDS = set(["mh.add", "mh.similarity", "mh.info"])
+      THETA_COMMANDS = set([
+        "theta.create", "theta.add", "theta.estimate", "theta.union", "theta.intersect",
+        "theta.anotb", "theta.info",
       ])
 
       res = env.cmd('ACL', 'CAT', 'bloom')
@@ -48,6 +70,18 @@ class testACL():
       env.assertEqual(set(res), TOPK_COMMANDS)
       res = env.cmd('ACL', 'CAT', 'tdigest')
       env.assertEqual(set(res), TDIGEST_COMMANDS)
+      res = env.cmd('ACL', 'CAT', 'ddsketch')
+      env.assertEqual(set(res), DDSKETCH_COMMANDS)
+      res = env.cmd('ACL', 'CAT', 'hdr')
+      env.assertEqual(set(res), HDR_COMMANDS)
+      res = env.cmd('ACL', 'CAT', 'cbf')
+      env.assertEqual(set(res), CBF_COMMANDS)
+      res = env.cmd('ACL', 'CAT', 'rf')
+      env.assertEqual(set(res), RF_COMMANDS)
+      res = env.cmd('ACL', 'CAT', 'mh')
+      env.assertEqual(set(res), MH_COMMANDS)
+      res = env.cmd('ACL', 'CAT', 'theta')
+      env.assertEqual(set(res), THETA_COMMANDS)
 
       # Check that one of our commands is listed in a non-bloom category
       res = env.cmd('ACL', 'CAT', 'read')
@@ -0,0 +1,224 @@
+
+from common import *
+import threading
+import time
+
+
+class testBloomFreeze():
+    def __init__(self):
+        self.env = Env(decodeResponses=True)
+
+    def test_freeze_items(self):
+        env = self.env
+        env.cmd('FLUSHALL')
+        items = [str(x) for x in range(10000)]
+        env.assertOk(env.cmd('bf.freeze', 'ff', 'ITEMS', *items, *items[:100]))
+        env.assertEqual([1] * len(items), env.cmd('bf.mexists', 'ff', *items))
+        env.assertEqual(1, env.cmd('bf.exists', 'ff', '42'))
+
+        # 8-bit fingerprints give a false positive rate of about 1/256
+        others = [str(x) for x in range(10000, 30000)]
+        false_positives = sum(env.cmd('bf.mexists', 'ff', *others))
+        env.assertTrue(false_positives < len(others) * 0.008, message=false_positives)
+
+        env.assertEqual(10000, env.cmd('bf.card', 'ff'))
+        info = parse_info(env.cmd('bf.info', 'ff'))
+        env.assertEqual(10000, info['Capacity'])
+        env.assertEqual(10000, info['Number of items inserted'])
+        env.assertEqual(1, info['Number of filters'])
+        env.assertEqual(None, info['Expansion rate'])
+        # about 9 bits per item
+        env.assertTrue(info['Size'] < 10000 * 10 / 8, message=info['Size'])
+        env.assertEqual([10000], env.cmd('bf.info', 'ff', 'items'))
+        env.assertEqual('size:10000', env.cmd('bf.debug', 'ff')[0])
+
+    def test_freeze_hashes(self):
+        env = self.env
+        env.cmd('FLUSHALL')
+        hashes = [x * 0x9e3779b97f4a7c15 % 2 ** 64 for x in range(1, 1001)]
+        env.assertOk(env.cmd('bf.freeze', 'ff', 'hashes', *hashes))
+        env.assertEqual(1000, env.cmd('bf.card', 'ff'))
+        env.expect('bf.freeze', 'bad', 'HASHES', 1, -1).error().contains('bad hash')
+        env.expect('bf.freeze', 'bad', 'HASHES', 2 ** 64).error().contains('bad hash')
+        env.expect('bf.freeze', 'bad', 'HASHES', 'abc').error().contains('bad hash')
+        env.assertEqual(0, env.cmd('EXISTS', 'bad'))
+
+    def test_freeze_bloom(self):
+        env = self.env
+        env.cmd('FLUSHALL')
+        env.assertOk(env.cmd('bf.reserve', 'bf', 0.0001, 1000))
+        items = ['item%d' % x for x in range(2000)]
+        env.cmd('bf.madd', 'bf', *items)
+        added = env.cmd('bf.card', 'bf')
+
+        # all the items of the Bloom filter must be given
+        env.expect('bf.freeze', 'bf', 'ITEMS', *items[:1000]).error() \
+            .contains('fewer items than in the filter')
+        env.expect('bf.freeze', 'bf', 'ITEMS', *items, 'other').error() \
+            .contains('not in the filter')
+        env.assertEqual(added, env.cmd('bf.card', 'bf'))
+
+        env.assertOk(env.cmd('bf.freeze', 'bf', 'ITEMS', *items))
+        env.assertEqual([1] * len(items), env.cmd('bf.mexists', 'bf', *items))
+        env.assertEqual(2000, env.cmd('bf.card', 'bf'))
+        env.expect('bf.add', 'bf', 'new').error().contains('frozen')
+        env.expect('bf.insert', 'bf', 'ITEMS', 'new').error().contains('frozen')
+        env.expect('bf.freeze', 'bf', 'ITEMS', 'new').error().contains('already frozen')
+
+    def test_freeze_reload(self):
+        env = self.env
+        env.cmd('FLUSHALL')
+        items = [str(x) for x in range(5000)]
+        env.assertOk(env.cmd('bf.freeze', 'ff', 'ITEMS', *items))
+        others = [str(x) for x in range(5000, 10000)]
+        expected = env.cmd('bf.mexists', 'ff', *others)
+        env.dumpAndReload()
+        env.assertEqual([1] * len(items), env.cmd('bf.mexists', 'ff', *items))
+        env.assertEqual(expected, env.cmd('bf.mexists', 'ff', *others))
+        env.assertEqual(5000, env.cmd('bf.card', 'ff'))
+
+    def test_freeze_ribbon(self):
+        env = self.env
+        env.cmd('FLUSHALL')
+        items = [str(x) for x in range(20000)]
+        env.assertOk(env.cmd('bf.freeze', 'fuse', 'ITEMS', *items))
+        env.assertOk(env.cmd('bf.freeze', 'ribbon', 'RIBBON', 'ITEMS', *items))
+        env.assertEqual([1] * len(items), env.cmd('bf.mexists', 'ribbon', *items))
+        env.assertEqual(20000, env.cmd('bf.card', 'ribbon'))
+        others = [str(x) for x in range(20000, 40000)]
+        false_positives = sum(env.cmd('bf.mexists', 'ribbon', *others))
+        env.assertTrue(false_positives < len(others) * 0.008, message=false_positives)
+        # the same error rate in less memory
+        fuse_size = env.cmd('bf.info', 'fuse', 'size')[0]
+        ribbon_size = env.cmd('bf.info', 'ribbon', 'size')[0]
+        env.assertTrue(ribbon_size < fuse_size * 0.95, message=(ribbon_size, fuse_size))
+        env.assertTrue(env.cmd('bf.debug', 'ribbon')[1].startswith('bytes:'))
+
+        # any error rate, rounded to a power of two
+        env.assertOk(env.cmd('bf.freeze', 'precise', 'RIBBON', 'ERROR', 0.0001, 'ITEMS', *items))
+        env.assertTrue(' bits:14 ' in env.cmd('bf.debug', 'precise')[1])
+        env.assertEqual([1] * len(items), env.cmd('bf.mexists', 'precise', *items))
+        env.assertTrue(sum(env.cmd('bf.mexists', 'precise', *others)) < 10)
+        env.assertOk(env.cmd('bf.freeze', 'coarse', 'RIBBON', 'ERROR', 0.5, 'ITEMS', *items))
+        env.assertTrue(' bits:1 ' in env.cmd('bf.debug', 'coarse')[1])
+
+        env.expect('bf.add', 'ribbon', 'new').error().contains('frozen')
+        env.expect('bf.freeze', 'ribbon', 'ITEMS', 'new').error().contains('already frozen')
+        env.expect('bf.freeze', 'bad', 'RIBBON', 'ERROR', 0, 'ITEMS', 'a').error() \
+            .contains('error rate')
+        env.expect('bf.freeze', 'bad', 'RIBBON', 'ERROR', 1, 'ITEMS', 'a').error() \
+            .contains('error rate')
+        env.expect('bf.freeze', 'bad', 'RIBBON', 'ERROR', 'a', 'ITEMS', 'a').error() \
+            .contains('bad error rate')
+        env.expect('bf.freeze', 'bad', 'RIBBON', 'ITEMS').error()
+        env.assertEqual(0, env.cmd('EXISTS', 'bad'))
+
+        env.dumpAndReload()
+        env.assertEqual([1] * len(items), env.cmd('bf.mexists', 'ribbon', *items))
+        env.assertEqual(false_positives, sum(env.cmd('bf.mexists', 'ribbon', *others)))
+        env.assertEqual(20000, env.cmd('bf.card', 'precise'))
+
+    def test_negative_freeze(self):
+        env = self.env
+        env.cmd('FLUSHALL')
+        env.cmd('SET', 'string', 'B')
+        env.expect('bf.freeze', 'string', 'ITEMS', 'a').error().contains('WRONGTYPE')
+        env.expect('bf.freeze', 'ff', 'ITEMS').error()
+        env.expect('bf.freeze', 'ff', 'VALUES', 'a').error().contains('Unknown argument')
+        env.assertEqual(0, env.cmd('EXISTS', 'ff'))
+        env.assertEqual(0, env.cmd('bf.exists', 'ff', 'a'))
+
+
+class testBloomFreezeNoCodec():
+    def __init__(self):
+        self.env = Env(decodeResponses=False)
+
+    def test_freeze_scandump(self):
+        env = self.env
+        env.cmd('FLUSHALL')
+        items = [str(x) for x in range(5000)]
+        env.assertOk(env.cmd('bf.freeze', 'ff', 'ITEMS', *items))
+        chunks = []
+        while True:
+            last_pos = chunks[-1][0] if chunks else 0
+            chunk = env.cmd('bf.scandump', 'ff', last_pos)
+            if not chunk[0]:
+                break
+            chunks.append(chunk)
+        env.cmd('del', 'ff')
+        for chunk in chunks:
+            env.assertOk(env.cmd('bf.loadchunk', 'ff', *chunk))
+        env.assertEqual([1] * len(items), env.cmd('bf.mexists', 'ff', *items))
+        env.assertEqual(5000, env.cmd('bf.card', 'ff'))
+        env.expect('bf.loadchunk', 'ff', chunks[-1][0] + 10, chunks[-1][1]).error()
+
+    def test_ribbon_scandump(self):
+        env = self.env
+        env.cmd('FLUSHALL')
+        items = [str(x) for x in range(5000)]
+        env.assertOk(env.cmd('bf.freeze', 'rb', 'RIBBON', 'ERROR', 0.001, 'ITEMS', *items))
+        chunks = []
+        while True:
+            last_pos = chunks[-1][0] if chunks else 0
+            chunk = env.cmd('bf.scandump', 'rb', last_pos)
+            if not chunk[0]:
+                break
+            chunks.append(chunk)
+        env.cmd('del', 'rb')
+        for chunk in chunks:
+            env.assertOk(env.cmd('bf.loadchunk', 'rb', *chunk))
+        env.assertEqual([1] * len(items), env.cmd('bf.mexists', 'rb', *items))
+        env.assertEqual(5000, env.cmd('bf.card', 'rb'))
+
+    def test_freeze_multi(self):
+        # a client inside MULTI cannot be blocked, so the filter is built on the main thread
+        env = self.env
+        env.cmd('FLUSHALL')
+        items = [str(x) for x in range(1000)]
+        conn = env.getConnection()
+        pipe = conn.pipeline(transaction=True)
+        pipe.execute_command('bf.freeze', 'ff', 'ITEMS', *items)
+        pipe.execute_command('bf.card', 'ff')
+        env.assertEqual(['OK', 1000], pipe.execute())
+        env.assertEqual([1] * len(items), env.cmd('bf.mexists', 'ff', *items))
+
+    def test_freeze_concurrent(self):
+        # more filters than there are workers are built at once, and queue for them
+        env = self.env
+        env.cmd('FLUSHALL')
+        items = [str(x) for x in range(20000)]
+        conn = env.getConnection()
+        results = [None] * 12
+
+        def freeze(i):
+            results[i] = conn.execute_command('bf.freeze', 'ff%d' % i, 'ITEMS', *items)
+
+        threads = [threading.Thread(target=freeze, args=(i,)) for i in range(len(results))]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        env.assertEqual(['OK'] * len(results), results)
+        for i in range(len(results)):
+            env.assertEqual(20000, env.cmd('bf.card', 'ff%d' % i))
+
+
+def test_freeze_replication():
+    env = Env(useSlaves=True, decodeResponses=True, freshEnv=True)
+    if env.isCluster():
+        env.skip()
+    master = env.getConnection()
+    slave = env.getSlaveConnection()
+    items = [str(x) for x in range(100000)]
+    env.assertOk(master.execute_command('bf.freeze', 'rb', 'RIBBON', 'ITEMS', *items))
+    env.assertEqual(100000, master.execute_command('bf.card', 'rb'))
+    acked = 0
+    deadline = time.time() + 15
+    while time.time() < deadline:
+        acked = master.execute_command('WAIT', 1, 1000)
+        if acked >= 1:
+            break
+    env.assertEqual(1, acked)
+    env.assertEqual(100000, slave.execute_command('bf.card', 'rb'))
+    env.assertEqual(master.execute_command('bf.mexists', 'rb', *items[:1000]),
+                    slave.execute_command('bf.mexists', 'rb', *items[:1000]))
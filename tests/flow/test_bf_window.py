@@ -0,0 +1,199 @@
+
+import time
+from common import *
+
+
+class testBloomWindow():
+    def __init__(self):
+        self.env = Env(decodeResponses=True)
+
+    def test_window_dedup(self):
+        env = self.env
+        env.cmd('FLUSHALL')
+        env.assertOk(env.cmd('bf.reserve', 'win', 0.01, 1000, 'WINDOW', 3600000, 'SLICES', 6))
+        items = ['item%d' % x for x in range(1000)]
+        env.cmd('bf.madd', 'win', *items)
+        added = env.cmd('bf.card', 'win')
+        env.assertTrue(added > 990, message=added)
+        env.assertEqual([0] * len(items), env.cmd('bf.madd', 'win', *items))
+        env.assertEqual([1] * len(items), env.cmd('bf.mexists', 'win', *items))
+        env.assertEqual(0, env.cmd('bf.add', 'win', 'item1'))
+
+        others = ['other%d' % x for x in range(10000)]
+        false_positives = sum(env.cmd('bf.mexists', 'win', *others))
+        env.assertTrue(false_positives < len(others) * 0.01, message=false_positives)
+
+        info = parse_info(env.cmd('bf.info', 'win'))
+        env.assertEqual(added, info['Number of items inserted'])
+        env.assertEqual(3600000, info['Window'])
+        env.assertEqual(6, info['Slices'])
+        env.assertEqual(2, info['Expansion rate'])
+        env.assertEqual(7, len(env.cmd('bf.debug', 'win')))
+        env.assertEqual([added], env.cmd('bf.info', 'win', 'items'))
+
+        env.dumpAndReload()
+        env.assertEqual([1] * len(items), env.cmd('bf.mexists', 'win', *items))
+        env.assertEqual(false_positives, sum(env.cmd('bf.mexists', 'win', *others)))
+        env.assertEqual(added, env.cmd('bf.card', 'win'))
+
+    def test_window_expiry(self):
+        env = self.env
+        env.cmd('FLUSHALL')
+        env.assertOk(env.cmd('bf.reserve', 'win', 0.01, 100, 'WINDOW', 1000, 'SLICES', 4))
+        # start at the beginning of a slice of 250ms
+        time.sleep((250 - time.time() * 1000 % 250 + 10) / 1000)
+        env.assertEqual(1, env.cmd('bf.add', 'win', 'old'))
+        time.sleep(0.5)
+        env.assertEqual(1, env.cmd('bf.add', 'win', 'new'))
+        env.assertEqual([1, 1], env.cmd('bf.mexists', 'win', 'old', 'new'))
+        # the slice of 'old' leaves the window before that of 'new'
+        time.sleep(0.6)
+        env.assertEqual([0, 1], env.cmd('bf.mexists', 'win', 'old', 'new'))
+        env.assertEqual(1, env.cmd('bf.card', 'win'))
+        time.sleep(1)
+        env.assertEqual([0, 0], env.cmd('bf.mexists', 'win', 'old', 'new'))
+        env.assertEqual(0, env.cmd('bf.card', 'win'))
+        env.assertEqual(1, env.cmd('bf.add', 'win', 'old'))
+
+    def test_window_readd_card(self):
+        env = self.env
+        env.cmd('FLUSHALL')
+        env.assertOk(env.cmd('bf.reserve', 'win', 0.01, 100, 'WINDOW', 3600000, 'SLICES', 6))
+        # the previous and the current slices of 10 minutes
+        now = int(time.time() * 1000)
+        cur = now - now % 600000
+        prev = cur - 600000
+        items = ['item%d' % x for x in range(10)]
+        env.assertEqual([1] * 10, env.cmd('bf.insert', 'win', 'AT', prev, 'ITEMS', *items))
+        env.assertEqual(10, env.cmd('bf.card', 'win'))
+        # items seen in the previous slice are added again, but counted once
+        more = items + ['more%d' % x for x in range(5)]
+        env.assertEqual([0] * 10 + [1] * 5,
+                        env.cmd('bf.insert', 'win', 'AT', cur, 'ITEMS', *more))
+        env.assertEqual(15, env.cmd('bf.card', 'win'))
+        env.assertEqual([15], env.cmd('bf.info', 'win', 'items'))
+        env.assertEqual(0, env.cmd('bf.add', 'win', 'more1'))
+        env.assertEqual(15, env.cmd('bf.card', 'win'))
+
+        # a slot older than the one its slice holds is dropped
+        env.expect('bf.insert', 'win', 'AT', prev - 3600000, 'ITEMS', 'stale').error() \
+            .contains('older than the window')
+        env.expect('bf.add', 'win', 'stale').equal(1)
+        env.assertEqual(16, env.cmd('bf.card', 'win'))
+        # and slots may be claimed at most one slice ahead
+        env.assertEqual([1], env.cmd('bf.insert', 'win', 'AT', cur + 600000, 'ITEMS', 'next'))
+        env.expect('bf.insert', 'win', 'AT', cur + 1200000, 'ITEMS', 'later').error() \
+            .contains('too far in the future')
+        env.assertEqual(0, env.cmd('bf.exists', 'win', 'later'))
+        env.assertEqual(16, env.cmd('bf.card', 'win'))
+
+        env.dumpAndReload()
+        env.assertEqual(16, env.cmd('bf.card', 'win'))
+        env.expect('bf.insert', 'win', 'AT', -1, 'ITEMS', 'a').error().contains('Bad timestamp')
+        env.expect('bf.insert', 'win', 'AT', 'a', 'ITEMS', 'a').error() \
+            .contains('Bad timestamp')
+
+    def test_window_nonscaling(self):
+        env = self.env
+        env.cmd('FLUSHALL')
+        env.assertOk(env.cmd('bf.reserve', 'win', 0.01, 20, 'NONSCALING',
+                             'WINDOW', 3600000, 'SLICES', 2))
+        # each slice holds half of the capacity
+        resp = env.cmd('bf.madd', 'win', *['item%d' % x for x in range(20)])
+        env.assertEqual('non scaling filter is full', str(resp[-1]))
+        env.assertEqual(None, env.cmd('bf.info', 'win', 'expansion')[0])
+
+    def test_negative_window(self):
+        env = self.env
+        env.cmd('FLUSHALL')
+        env.expect('bf.reserve', 'win', 0.01, 100, 'WINDOW', 1000).error() \
+            .contains('WINDOW requires SLICES')
+        env.expect('bf.reserve', 'win', 0.01, 100, 'SLICES', 4).error() \
+            .contains('WINDOW requires SLICES')
+        env.expect('bf.reserve', 'win', 0.01, 100, 'WINDOW', 0, 'SLICES', 4).error() \
+            .contains('window needs to be a positive integer')
+        env.expect('bf.reserve', 'win', 0.01, 100, 'WINDOW', 'a', 'SLICES', 4).error() \
+            .contains('window needs to be a positive integer')
+        env.expect('bf.reserve', 'win', 0.01, 100, 'WINDOW', 1000, 'SLICES', 0).error() \
+            .contains('slices must be in the range')
+        env.expect('bf.reserve', 'win', 0.01, 100, 'WINDOW', 1000, 'SLICES', 1025).error() \
+            .contains('slices must be in the range')
+        env.expect('bf.reserve', 'win', 0.01, 100, 'WINDOW', 10, 'SLICES', 20).error() \
+            .contains('one millisecond per slice')
+        env.assertEqual(0, env.cmd('EXISTS', 'win'))
+
+        env.assertOk(env.cmd('bf.reserve', 'win', 0.01, 100, 'WINDOW', 1000, 'SLICES', 4))
+        env.expect('bf.reserve', 'win', 0.01, 100).error().contains('WRONGTYPE')
+        env.expect('bf.freeze', 'win', 'ITEMS', 'a').error().contains('WRONGTYPE')
+        env.expect('cf.add', 'win', 'a').error().contains('WRONGTYPE')
+
+
+def test_window_aof():
+    # writes to a window are logged with the time they were made at, so replaying them adds the
+    # items to the same slices
+    env = Env(useAof=True, decodeResponses=True, freshEnv=True)
+    if env.isCluster():
+        env.skip()
+    env.assertOk(env.cmd('bf.reserve', 'win', 0.01, 100, 'WINDOW', 1000, 'SLICES', 4))
+    # start at the beginning of a slice of 250ms
+    time.sleep((250 - time.time() * 1000 % 250 + 10) / 1000)
+    env.assertEqual([1, 1], env.cmd('bf.madd', 'win', 'old', 'both'))
+    time.sleep(0.5)
+    env.assertEqual([1, 0], env.cmd('bf.insert', 'win', 'ITEMS', 'new', 'both'))
+    debug = env.cmd('bf.debug', 'win')
+    env.expect('DEBUG', 'LOADAOF').ok()
+    env.assertEqual(debug, env.cmd('bf.debug', 'win'))
+    env.assertEqual(3, env.cmd('bf.card', 'win'))
+    # the slice of 'old' leaves the window before that of 'new'
+    time.sleep(0.6)
+    env.assertEqual([0, 1, 1], env.cmd('bf.mexists', 'win', 'old', 'new', 'both'))
+
+
+def test_window_replication():
+    # the replica adds the items to the slices of the time they were added at on the master
+    env = Env(useSlaves=True, decodeResponses=True, freshEnv=True)
+    if env.isCluster():
+        env.skip()
+    master = env.getConnection()
+    slave = env.getSlaveConnection()
+    env.assertOk(master.execute_command('bf.reserve', 'win', 0.01, 100,
+                                        'WINDOW', 3600000, 'SLICES', 6))
+    master.execute_command('bf.madd', 'win', *['item%d' % x for x in range(100)])
+    master.execute_command('bf.add', 'win', 'item1')
+    master.execute_command('bf.insert', 'win', 'ITEMS', 'item2', 'other')
+    acked = 0
+    deadline = time.time() + 15
+    while time.time() < deadline:
+        acked = master.execute_command('WAIT', 1, 1000)
+        if acked >= 1:
+            break
+    env.assertEqual(1, acked)
+    env.assertEqual(master.execute_command('bf.debug', 'win'),
+                    slave.execute_command('bf.debug', 'win'))
+
+
+class testBloomWindowNoCodec():
+    def __init__(self):
+        self.env = Env(decodeResponses=False)
+
+    def test_window_scandump(self):
+        env = self.env
+        env.cmd('FLUSHALL')
+        env.assertOk(env.cmd('bf.reserve', 'win', 0.001, 1000, 'WINDOW', 3600000, 'SLICES', 4))
+        items = [str(x) for x in range(5000)]
+        env.cmd('bf.madd', 'win', *items)
+        added = env.cmd('bf.card', 'win')
+        chunks = []
+        while True:
+            last_pos = chunks[-1][0] if chunks else 0
+            chunk = env.cmd('bf.scandump', 'win', last_pos)
+            if not chunk[0]:
+                break
+            chunks.append(chunk)
+        env.cmd('del', 'win')
+        for chunk in chunks:
+            env.assertOk(env.cmd('bf.loadchunk', 'win', *chunk))
+        env.assertEqual([1] * len(items), env.cmd('bf.mexists', 'win', *items))
+        env.assertEqual(added, env.cmd('bf.card', 'win'))
+        env.assertEqual(3600000, env.cmd('bf.info', 'win')[11])
+        env.expect('bf.loadchunk', 'win', chunks[-1][0] + 10, chunks[-1][1]).error()
@@ -0,0 +1,113 @@
+
+from common import *
+
+
+class testCountingBloom:
+    def __init__(self):
+        self.env = Env(decodeResponses=True)
+
+    def test_cbf_reserve(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.assertTrue(env.cmd("cbf.reserve", "cbf", 0.01, 1000))
+        info = parse_info(env.cmd("cbf.info", "cbf"))
+        env.assertTrue(info["Capacity"] >= 1000, message=info)
+        env.assertEqual(16384, info["Counters"])
+        env.assertEqual(7, info["Hash functions"])
+        env.assertEqual(0, info["Number of items inserted"])
+        env.assertTrue(info["Size"] >= 16384 // 2, message=info)
+        env.expect("cbf.reserve", "cbf", 0.01, 1000).error().contains("key already exists")
+        env.expect("cbf.reserve", "bad", "a", 1000).error().contains("bad error rate")
+        env.expect("cbf.reserve", "bad", 1, 1000).error().contains("error rate must be")
+        env.expect("cbf.reserve", "bad", 0.01, "a").error().contains("bad capacity")
+        env.expect("cbf.reserve", "bad", 0.01, 0).error().contains("capacity must be")
+        env.expect("cbf.reserve", "bad", 0.01).error().contains("wrong number")
+        env.assertEqual(0, env.cmd("EXISTS", "bad"))
+
+    def test_cbf_add_delete(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.assertTrue(env.cmd("cbf.reserve", "cbf", 0.01, 1000))
+        items = ["item%d" % x for x in range(1000)]
+        added = sum(env.cmd("cbf.madd", "cbf", *items))
+        env.assertTrue(added > 990, message=added)
+        env.assertEqual([1] * len(items), env.cmd("cbf.mexists", "cbf", *items))
+        info = parse_info(env.cmd("cbf.info", "cbf"))
+        env.assertEqual(len(items), info["Number of items inserted"])
+
+        others = ["other%d" % x for x in range(10000)]
+        false_positives = sum(env.cmd("cbf.mexists", "cbf", *others))
+        env.assertTrue(false_positives < len(others) * 0.02, message=false_positives)
+
+        # the deleted items are gone, and the others are still there
+        for item in items[:500]:
+            env.assertEqual(1, env.cmd("cbf.del", "cbf", item))
+        env.assertEqual(500, parse_info(env.cmd("cbf.info", "cbf"))["Number of items inserted"])
+        env.assertEqual([1] * 500, env.cmd("cbf.mexists", "cbf", *items[500:]))
+        env.assertTrue(sum(env.cmd("cbf.mexists", "cbf", *items[:500])) < 25)
+
+        # an item added twice is deleted twice
+        env.assertEqual(1, env.cmd("cbf.add", "cbf", "twice"))
+        env.assertEqual(0, env.cmd("cbf.add", "cbf", "twice"))
+        env.assertEqual(1, env.cmd("cbf.del", "cbf", "twice"))
+        env.assertEqual(1, env.cmd("cbf.exists", "cbf", "twice"))
+        env.assertEqual(1, env.cmd("cbf.del", "cbf", "twice"))
+        env.assertEqual(0, env.cmd("cbf.exists", "cbf", "twice"))
+        env.assertEqual(0, env.cmd("cbf.del", "cbf", "twice"))
+        env.assertEqual(500, parse_info(env.cmd("cbf.info", "cbf"))["Number of items inserted"])
+
+    def test_cbf_saturation(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.assertTrue(env.cmd("cbf.reserve", "cbf", 0.01, 100))
+        # saturated counters are never decremented, so the item is never lost
+        env.cmd("cbf.madd", "cbf", *["same"] * 20)
+        for _ in range(20):
+            env.assertEqual(1, env.cmd("cbf.del", "cbf", "same"))
+        env.assertEqual(1, env.cmd("cbf.exists", "cbf", "same"))
+
+    def test_cbf_autocreate(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.assertEqual(0, env.cmd("cbf.exists", "cbf", "a"))
+        env.assertEqual([0, 0], env.cmd("cbf.mexists", "cbf", "a", "b"))
+        env.assertEqual(1, env.cmd("cbf.add", "cbf", "a"))
+        info = parse_info(env.cmd("cbf.info", "cbf"))
+        env.assertTrue(info["Capacity"] >= 100, message=info)
+        env.assertEqual(1, info["Number of items inserted"])
+        env.expect("cbf.del", "missing", "a").error().contains("key does not exist")
+        env.expect("cbf.info", "missing").error().contains("key does not exist")
+
+    def test_cbf_reload(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.assertTrue(env.cmd("cbf.reserve", "cbf", 0.001, 5000))
+        items = ["item%d" % x for x in range(5000)]
+        env.cmd("cbf.madd", "cbf", *items)
+        env.cmd("cbf.del", "cbf", "item0")
+        info = env.cmd("cbf.info", "cbf")
+        others = ["other%d" % x for x in range(5000)]
+        false_positives = env.cmd("cbf.mexists", "cbf", *others)
+        env.dumpAndReload()
+        env.assertEqual(info, env.cmd("cbf.info", "cbf"))
+        env.assertEqual([1] * 4999, env.cmd("cbf.mexists", "cbf", *items[1:]))
+        env.assertEqual(false_positives, env.cmd("cbf.mexists", "cbf", *others))
+
+    def test_cbf_wrong_type(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.cmd("SET", "str", "a")
+        env.assertTrue(env.cmd("bf.add", "bf", "a"))
+        for key in ["str", "bf"]:
+            env.expect("cbf.add", key, "a").error().contains("WRONGTYPE")
+            env.expect("cbf.exists", key, "a").error().contains("WRONGTYPE")
+            env.expect("cbf.del", key, "a").error().contains("WRONGTYPE")
+            env.expect("cbf.info", key).error().contains("WRONGTYPE")
+        env.assertTrue(env.cmd("cbf.add", "cbf", "a"))
+        env.expect("bf.add", "cbf", "a").error().contains("WRONGTYPE")
+        env.expect("cbf.add", "cbf").error().contains("wrong number")
+        env.expect("cbf.add", "cbf", "a", "b").error().contains("wrong number")
+        env.expect("cbf.madd", "cbf").error().contains("wrong number")
+        env.expect("cbf.exists", "cbf", "a", "b").error().contains("wrong number")
+        env.expect("cbf.del", "cbf").error().contains("wrong number")
+        env.expect("cbf.info", "cbf", "a").error().contains("wrong number")
@@ -23,6 +23,8 @@ class testConfigs():
       env.assertEqual(res[1], '1')
       res = env.cmd('CONFIG', 'GET', 'cf-max-expansions')
       env.assertEqual(res[1], '32')
+      res = env.cmd('CONFIG', 'GET', 'tdigest-cache-max-nodes')
+      env.assertEqual(res[1], '8192')
 
   def test_config_set(self):
     """Test that the various `bloom` config parameters may be set"""
@@ -102,6 +104,9 @@ class testConfigs():
     env.expect('CONFIG', 'SET', 'cf-max-expansions', 0).error().contains('must be in the range')
     env.expect('CONFIG', 'SET', 'cf-max-expansions', 65537).error().contains('must be in the range')
     env.expect('CONFIG', 'SET', 'cf-max-expansions', 32).ok()
+    env.expect('CONFIG', 'SET', 'tdigest-cache-max-nodes', -1).error().contains('must be in the range')
+    env.expect('CONFIG', 'SET', 'tdigest-cache-max-nodes', 2**24 + 1).error().contains('must be in the range')
+    env.expect('CONFIG', 'SET', 'tdigest-cache-max-nodes', 8192).ok()
 
   def test_config_bf_debug_stats(self):
     """Test that `bf.debug` and `cf.debug` config values reflect the current config values"""
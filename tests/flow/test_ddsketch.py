@@ -0,0 +1,151 @@
+
+from common import *
+import redis
+import math
+import random
+
+
+class testDDSketch:
+    def __init__(self):
+        self.env = Env(decodeResponses=True)
+
+    def assertRelative(self, expected, actual, accuracy):
+        self.env.assertTrue(abs(actual - expected) <= accuracy * abs(expected) + 1e-9,
+                            message="%s is not within %s of %s" % (actual, accuracy, expected))
+
+    def test_ddsketch_create(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.assertTrue(env.cmd("ddsketch.create", "default"))
+        info = parse_info(env.cmd("ddsketch.info", "default"))
+        env.assertEqual(0.01, float(info["Accuracy"]))
+        env.assertEqual(2048, info["Max bins"])
+        env.assertEqual(0, info["Observations"])
+        env.assertTrue(env.cmd("ddsketch.create", "custom", "accuracy", 0.05, "maxbins", 128))
+        info = parse_info(env.cmd("ddsketch.info", "custom"))
+        env.assertEqual(0.05, float(info["Accuracy"]))
+        env.assertEqual(128, info["Max bins"])
+        env.expect("ddsketch.create", "custom").error().contains("key already exists")
+        env.expect("ddsketch.quantile", "default", 0.5).equal(["nan"])
+
+    def test_ddsketch_quantile(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.assertTrue(env.cmd("ddsketch.create", "dds", "accuracy", 0.01))
+        values = [random.lognormvariate(3, 2) for _ in range(5000)] + \
+                 [-random.lognormvariate(1, 1) for _ in range(1000)] + [0] * 10
+        for i in range(0, len(values), 1000):
+            env.assertTrue(env.cmd("ddsketch.add", "dds", *values[i:i + 1000]))
+        values.sort()
+        env.assertEqual(len(values), parse_info(env.cmd("ddsketch.info", "dds"))["Observations"])
+
+        quantiles = [0, 0.01, 0.1, 0.16, 0.5, 0.9, 0.99, 0.999, 1]
+        res = env.cmd("ddsketch.quantile", "dds", *quantiles)
+        for q, r in zip(quantiles, res):
+            self.assertRelative(values[int(q * (len(values) - 1))], float(r), 0.01)
+        env.assertEqual(values[0], float(res[0]))
+        env.assertEqual(values[-1], float(res[-1]))
+
+        cdf = [float(c) for c in env.cmd("ddsketch.cdf", "dds", values[0] - 1, values[3000],
+                                         values[-1] + 1)]
+        env.assertEqual(0, cdf[0])
+        env.assertTrue(abs(cdf[1] - 3000 / len(values)) < 0.02)
+        env.assertEqual(1, cdf[2])
+
+    def test_ddsketch_collapse(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.assertTrue(env.cmd("ddsketch.create", "dds", "accuracy", 0.01, "maxbins", 64))
+        values = list(range(1, 100001))
+        for i in range(0, len(values), 10000):
+            env.assertTrue(env.cmd("ddsketch.add", "dds", *values[i:i + 10000]))
+        info = parse_info(env.cmd("ddsketch.info", "dds"))
+        env.assertEqual(64, info["Bins used"])
+        env.assertEqual(64, info["Capacity"])
+        # the lowest bins are collapsed, the tail keeps its accuracy
+        for q in [0.9, 0.99, 0.999]:
+            res = float(env.cmd("ddsketch.quantile", "dds", q)[0])
+            self.assertRelative(q * 99999 + 1, res, 0.011)
+
+    def test_ddsketch_merge(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.assertTrue(env.cmd("ddsketch.create", "a"))
+        env.assertTrue(env.cmd("ddsketch.create", "b", "maxbins", 4096))
+        env.assertTrue(env.cmd("ddsketch.add", "a", *range(1, 1001)))
+        env.assertTrue(env.cmd("ddsketch.add", "b", *range(1001, 2001)))
+
+        # merging is exact: the result has the bins of a sketch of all the values
+        env.assertTrue(env.cmd("ddsketch.create", "all"))
+        env.assertTrue(env.cmd("ddsketch.add", "all", *range(1, 2001)))
+        env.assertTrue(env.cmd("ddsketch.merge", "merged", 2, "a", "b"))
+        quantiles = [0, 0.1, 0.25, 0.5, 0.75, 0.9, 1]
+        env.assertEqual(env.cmd("ddsketch.quantile", "all", *quantiles),
+                        env.cmd("ddsketch.quantile", "merged", *quantiles))
+        info = parse_info(env.cmd("ddsketch.info", "merged"))
+        env.assertEqual(2000, info["Observations"])
+        env.assertEqual(4096, info["Max bins"])
+
+        # into an existing destination, which may also be a source
+        env.assertTrue(env.cmd("ddsketch.merge", "a", 2, "a", "b"))
+        env.assertEqual(3000, parse_info(env.cmd("ddsketch.info", "a"))["Observations"])
+        env.assertTrue(env.cmd("ddsketch.merge", "a", 1, "b", "OVERRIDE"))
+        env.assertEqual(1000, parse_info(env.cmd("ddsketch.info", "a"))["Observations"])
+        env.assertEqual("1001", env.cmd("ddsketch.quantile", "a", 0)[0])
+
+        env.assertTrue(env.cmd("ddsketch.create", "coarse", "accuracy", 0.05))
+        env.expect("ddsketch.merge", "a", 1, "coarse").error().contains("same accuracy")
+        env.expect("ddsketch.merge", "a", 1, "missing").error().contains("does not exist")
+        env.expect("ddsketch.merge", "a", 1, "b", "KEEP").error().contains("wrong keyword")
+        env.expect("ddsketch.merge", "a", 0, "b").error()
+        env.expect("ddsketch.merge", "a", 3, "b").error()
+
+    def test_ddsketch_reload(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.assertTrue(env.cmd("ddsketch.create", "dds", "accuracy", 0.02, "maxbins", 256))
+        values = [random.uniform(-1000, 1000) for _ in range(2000)]
+        env.assertTrue(env.cmd("ddsketch.add", "dds", *values))
+        env.assertTrue(env.cmd("ddsketch.add", "dds", 0))
+        env.assertTrue(env.cmd("ddsketch.create", "empty"))
+        quantiles = [0, 0.01, 0.5, 0.99, 1]
+        expected = env.cmd("ddsketch.quantile", "dds", *quantiles)
+        info = parse_info(env.cmd("ddsketch.info", "dds"))
+        env.dumpAndReload()
+        env.assertEqual(expected, env.cmd("ddsketch.quantile", "dds", *quantiles))
+        reloaded = parse_info(env.cmd("ddsketch.info", "dds"))
+        env.assertEqual(info["Observations"], reloaded["Observations"])
+        env.assertEqual(info["Bins used"], reloaded["Bins used"])
+        env.assertEqual(0, parse_info(env.cmd("ddsketch.info", "empty"))["Observations"])
+        # a reloaded sketch keeps growing
+        env.assertTrue(env.cmd("ddsketch.add", "dds", 1e6, -1e6))
+        env.assertEqual(["-1000000", "1000000"], env.cmd("ddsketch.quantile", "dds", 0, 1))
+
+    def test_negative_ddsketch(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.cmd("SET", "string", "B")
+        env.expect("ddsketch.create", "string").error().contains("key already exists")
+        env.expect("ddsketch.add", "string", 1).error().contains("WRONGTYPE")
+        env.expect("ddsketch.quantile", "string", 0.5).error().contains("WRONGTYPE")
+        env.expect("ddsketch.add", "missing", 1).error().contains("does not exist")
+        env.expect("ddsketch.info", "missing").error().contains("does not exist")
+
+        env.expect("ddsketch.create", "dds", "accuracy", 0).error().contains("accuracy")
+        env.expect("ddsketch.create", "dds", "accuracy", 0.9).error().contains("accuracy")
+        env.expect("ddsketch.create", "dds", "maxbins", 8).error().contains("maxbins")
+        env.expect("ddsketch.create", "dds", "maxbins", "a").error().contains("maxbins")
+        env.expect("ddsketch.create", "dds", "bins", 100).error().contains("wrong keyword")
+        env.expect("ddsketch.create", "dds", "accuracy").error()
+        env.assertEqual(0, env.cmd("EXISTS", "dds"))
+
+        env.assertTrue(env.cmd("ddsketch.create", "dds"))
+        env.expect("ddsketch.add", "dds").error()
+        env.expect("ddsketch.add", "dds", "a").error().contains("finite")
+        env.expect("ddsketch.add", "dds", "inf").error().contains("finite")
+        env.expect("ddsketch.add", "dds", "nan").error().contains("finite")
+        env.expect("ddsketch.quantile", "dds", 1.1).error().contains("[0,1]")
+        env.expect("ddsketch.quantile", "dds", "a").error().contains("parsing")
+        env.expect("ddsketch.cdf", "dds", "a").error().contains("parsing")
+        env.expect("ddsketch.info", "dds", "extra").error()
+        env.assertEqual(0, parse_info(env.cmd("ddsketch.info", "dds"))["Observations"])
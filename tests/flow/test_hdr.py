@@ -0,0 +1,164 @@
+
+from common import *
+import redis
+import random
+
+
+class testHDR:
+    def __init__(self):
+        self.env = Env(decodeResponses=True)
+
+    def assertSigfigs(self, expected, actual, sigfigs):
+        self.env.assertTrue(abs(actual - expected) <= expected * 2 * 10 ** -sigfigs + 1,
+                            message="%s is not within %s figures of %s" %
+                            (actual, sigfigs, expected))
+
+    def test_hdr_create(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.assertTrue(env.cmd("hdr.create", "default"))
+        info = parse_info(env.cmd("hdr.info", "default"))
+        env.assertEqual(3600000000, info["Highest trackable value"])
+        env.assertEqual(2, info["Significant figures"])
+        env.assertEqual(3328, info["Counters"])
+        env.assertEqual(0, info["Observations"])
+        env.assertTrue(env.cmd("hdr.create", "custom", "highest", 1000000, "sigfigs", 3))
+        info = parse_info(env.cmd("hdr.info", "custom"))
+        env.assertEqual(1000000, info["Highest trackable value"])
+        env.assertEqual(3, info["Significant figures"])
+        env.expect("hdr.create", "custom").error().contains("key already exists")
+        env.expect("hdr.quantile", "default", 0.5).equal(["nan"])
+        env.expect("hdr.min", "default").equal("nan")
+        env.expect("hdr.buckets", "default").equal([])
+
+    def test_hdr_quantile(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.assertTrue(env.cmd("hdr.create", "hdr", "highest", 10000000, "sigfigs", 3))
+        values = [int(random.lognormvariate(8, 1.5)) % 10000000 for _ in range(10000)]
+        for i in range(0, len(values), 1000):
+            env.assertTrue(env.cmd("hdr.add", "hdr", *values[i:i + 1000]))
+        values.sort()
+        env.assertEqual(len(values), parse_info(env.cmd("hdr.info", "hdr"))["Observations"])
+        env.assertEqual(values[0], float(env.cmd("hdr.min", "hdr")))
+        env.assertEqual(values[-1], float(env.cmd("hdr.max", "hdr")))
+
+        quantiles = [0, 0.01, 0.1, 0.5, 0.9, 0.99, 0.999, 1]
+        res = env.cmd("hdr.quantile", "hdr", *quantiles)
+        for q, r in zip(quantiles, res):
+            self.assertSigfigs(values[max(0, int(q * len(values) + 0.5) - 1)], float(r), 3)
+        env.assertEqual(values[0], float(res[0]))
+        env.assertEqual(values[-1], float(res[-1]))
+
+        cdf = [float(c) for c in env.cmd("hdr.cdf", "hdr", values[0] - 1, values[5000],
+                                         values[-1])]
+        env.assertEqual(0, cdf[0])
+        env.assertTrue(abs(cdf[1] - 0.5) < 0.01)
+        env.assertEqual(1, cdf[2])
+
+        env.assertTrue(env.cmd("hdr.reset", "hdr"))
+        env.assertEqual(0, parse_info(env.cmd("hdr.info", "hdr"))["Observations"])
+        env.expect("hdr.max", "hdr").equal("nan")
+
+    def test_hdr_buckets(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.assertTrue(env.cmd("hdr.create", "hdr", "highest", 100000, "sigfigs", 1))
+        # with one significant figure the values up to 31 have their own counter, then each
+        # counter covers twice as many values with every doubling
+        env.assertTrue(env.cmd("hdr.add", "hdr", 5, 5, 31, 32, 33, 1000, 1001))
+        env.assertEqual([5, 31, 33, 1023], env.cmd("hdr.buckets", "hdr"))
+        env.assertEqual([5, 2, 31, 1, 33, 2, 1023, 2],
+                        env.cmd("hdr.buckets", "hdr", "WITHCOUNTS"))
+        env.expect("hdr.buckets", "hdr", "WITHVALUES").error().contains("wrong keyword")
+
+    def test_hdr_merge(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.assertTrue(env.cmd("hdr.create", "a", "highest", 100000))
+        env.assertTrue(env.cmd("hdr.create", "b", "highest", 1000000))
+        env.assertTrue(env.cmd("hdr.add", "a", *range(0, 1000)))
+        env.assertTrue(env.cmd("hdr.add", "b", *range(1000, 200000, 100)))
+
+        # merging is exact: the result has the counters of a histogram of all the values
+        env.assertTrue(env.cmd("hdr.create", "all", "highest", 1000000))
+        env.assertTrue(env.cmd("hdr.add", "all", *range(0, 1000)))
+        env.assertTrue(env.cmd("hdr.add", "all", *range(1000, 200000, 100)))
+        env.assertTrue(env.cmd("hdr.merge", "merged", 2, "a", "b"))
+        env.assertEqual(env.cmd("hdr.buckets", "all", "WITHCOUNTS"),
+                        env.cmd("hdr.buckets", "merged", "WITHCOUNTS"))
+        info = parse_info(env.cmd("hdr.info", "merged"))
+        env.assertEqual(2990, info["Observations"])
+        env.assertEqual(1000000, info["Highest trackable value"])
+
+        # into an existing destination, which may also be a source
+        env.assertTrue(env.cmd("hdr.merge", "b", 2, "b", "a"))
+        env.assertEqual(4980, parse_info(env.cmd("hdr.info", "b"))["Observations"])
+        env.assertTrue(env.cmd("hdr.merge", "b", 1, "a", "OVERRIDE"))
+        env.assertEqual(1000, parse_info(env.cmd("hdr.info", "b"))["Observations"])
+        env.assertEqual("999", env.cmd("hdr.max", "b"))
+
+        # histograms of other significant figures are recorded again
+        env.assertTrue(env.cmd("hdr.create", "fine", "highest", 1000000, "sigfigs", 4))
+        env.assertTrue(env.cmd("hdr.merge", "fine", 1, "all"))
+        env.assertEqual(2990, parse_info(env.cmd("hdr.info", "fine"))["Observations"])
+        env.assertEqual(["0", "199900"], env.cmd("hdr.quantile", "fine", 0, 1))
+
+        env.expect("hdr.merge", "a", 1, "all").error().contains("highest trackable")
+        env.assertEqual(1000, parse_info(env.cmd("hdr.info", "a"))["Observations"])
+        env.expect("hdr.merge", "a", 1, "missing").error().contains("does not exist")
+        env.expect("hdr.merge", "a", 1, "b", "KEEP").error().contains("wrong keyword")
+        env.expect("hdr.merge", "a", 0, "b").error()
+        env.expect("hdr.merge", "a", 3, "b").error()
+
+    def test_hdr_reload(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.assertTrue(env.cmd("hdr.create", "hdr", "sigfigs", 3))
+        values = [random.randint(0, 3600000000) for _ in range(2000)] + [0, 3600000000]
+        env.assertTrue(env.cmd("hdr.add", "hdr", *values))
+        env.assertTrue(env.cmd("hdr.create", "empty"))
+        quantiles = [0, 0.01, 0.5, 0.99, 1]
+        expected = env.cmd("hdr.quantile", "hdr", *quantiles)
+        buckets = env.cmd("hdr.buckets", "hdr", "WITHCOUNTS")
+        env.dumpAndReload()
+        env.assertEqual(expected, env.cmd("hdr.quantile", "hdr", *quantiles))
+        env.assertEqual(buckets, env.cmd("hdr.buckets", "hdr", "WITHCOUNTS"))
+        env.assertEqual(len(values), parse_info(env.cmd("hdr.info", "hdr"))["Observations"])
+        env.assertEqual(0, parse_info(env.cmd("hdr.info", "empty"))["Observations"])
+        env.expect("hdr.min", "empty").equal("nan")
+        env.assertTrue(env.cmd("hdr.add", "empty", 7))
+        env.assertEqual(["7", "7"], env.cmd("hdr.quantile", "empty", 0, 1))
+
+    def test_negative_hdr(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.cmd("SET", "string", "B")
+        env.expect("hdr.create", "string").error().contains("key already exists")
+        env.expect("hdr.add", "string", 1).error().contains("WRONGTYPE")
+        env.expect("hdr.quantile", "string", 0.5).error().contains("WRONGTYPE")
+        env.expect("hdr.add", "missing", 1).error().contains("does not exist")
+        env.expect("hdr.info", "missing").error().contains("does not exist")
+
+        env.expect("hdr.create", "hdr", "highest", 1).error().contains("highest")
+        env.expect("hdr.create", "hdr", "highest", "a").error().contains("highest")
+        env.expect("hdr.create", "hdr", "sigfigs", 0).error().contains("sigfigs")
+        env.expect("hdr.create", "hdr", "sigfigs", 6).error().contains("sigfigs")
+        env.expect("hdr.create", "hdr", "highest", 2 ** 62, "sigfigs", 5).error() \
+            .contains("too many counters")
+        env.expect("hdr.create", "hdr", "lowest", 1).error().contains("wrong keyword")
+        env.expect("hdr.create", "hdr", "sigfigs").error()
+        env.assertEqual(0, env.cmd("EXISTS", "hdr"))
+
+        env.assertTrue(env.cmd("hdr.create", "hdr", "highest", 1000))
+        env.expect("hdr.add", "hdr").error()
+        env.expect("hdr.add", "hdr", 1.5).error().contains("non-negative integer")
+        env.expect("hdr.add", "hdr", -1).error().contains("non-negative integer")
+        # no value is added when one of them is out of range
+        env.expect("hdr.add", "hdr", 1, 1001).error().contains("highest trackable")
+        env.assertEqual(0, parse_info(env.cmd("hdr.info", "hdr"))["Observations"])
+        env.expect("hdr.quantile", "hdr", 1.1).error().contains("[0,1]")
+        env.expect("hdr.quantile", "hdr", "a").error().contains("parsing")
+        env.expect("hdr.cdf", "hdr", "a").error().contains("parsing")
+        env.expect("hdr.info", "hdr", "extra").error()
+        env.expect("hdr.reset", "hdr", "extra").error()
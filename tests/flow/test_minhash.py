@@ -0,0 +1,68 @@
+
+from common import *
+
+
+class testMinHash:
+    def __init__(self):
+        self.env = Env(decodeResponses=True)
+
+    def add_set(self, key, items):
+        for i in range(0, len(items), 1000):
+            self.env.assertOk(self.env.cmd("mh.add", key, *items[i:i + 1000]))
+
+    def test_mh_similarity(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        # Jaccard similarities of 1, 1/3, 1/8 and 0 with 'a'
+        self.add_set("a", ["item%d" % x for x in range(2000)])
+        self.add_set("same", ["item%d" % x for x in range(2000)])
+        self.add_set("half", ["item%d" % x for x in range(1000, 3000)])
+        self.add_set("quarter", ["item%d" % x for x in range(1500, 4000)])
+        self.add_set("other", ["other%d" % x for x in range(2000)])
+        res = [float(s) for s in env.cmd("mh.similarity", "a", "same", "half", "quarter",
+                                           "other", "a")]
+        env.assertEqual(1, res[0])
+        env.assertTrue(abs(res[1] - 1 / 3) < 0.1, message=res)
+        env.assertTrue(abs(res[2] - 1 / 8) < 0.1, message=res)
+        env.assertTrue(res[3] < 0.05, message=res)
+        env.assertEqual(1, res[4])
+        env.assertEqual(res[1], float(env.cmd("mh.similarity", "half", "a")[0]))
+
+        # duplicates do not change the signature
+        self.add_set("half", ["item%d" % x for x in range(1000, 2000)])
+        env.assertEqual(res[1], float(env.cmd("mh.similarity", "a", "half")[0]))
+        info = parse_info(env.cmd("mh.info", "half"))
+        env.assertEqual(256, info["Lanes"])
+        env.assertEqual(3000, info["Number of items inserted"])
+        env.assertTrue(info["Size"] >= 1024, message=info)
+
+    def test_mh_reload(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        self.add_set("a", ["item%d" % x for x in range(1000)])
+        self.add_set("b", ["item%d" % x for x in range(500, 1500)])
+        similarity = env.cmd("mh.similarity", "a", "b")
+        info = env.cmd("mh.info", "a")
+        env.dumpAndReload()
+        env.assertEqual(similarity, env.cmd("mh.similarity", "a", "b"))
+        env.assertEqual(info, env.cmd("mh.info", "a"))
+        # the lanes hash the same after a reload
+        self.add_set("c", ["item%d" % x for x in range(1000)])
+        env.assertEqual(1, float(env.cmd("mh.similarity", "a", "c")[0]))
+
+    def test_mh_errors(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.cmd("SET", "str", "a")
+        env.assertOk(env.cmd("mh.add", "mh", "a"))
+        env.expect("mh.add", "str", "a").error().contains("WRONGTYPE")
+        env.expect("mh.info", "str").error().contains("WRONGTYPE")
+        env.expect("mh.similarity", "str", "mh").error().contains("WRONGTYPE")
+        env.expect("mh.similarity", "mh", "str").error().contains("WRONGTYPE")
+        env.expect("mh.similarity", "mh", "missing").error().contains("key does not exist")
+        env.expect("mh.similarity", "missing", "mh").error().contains("key does not exist")
+        env.expect("mh.info", "missing").error().contains("key does not exist")
+        env.expect("bf.add", "mh", "a").error().contains("WRONGTYPE")
+        env.expect("mh.add", "mh").error().contains("wrong number")
+        env.expect("mh.similarity", "mh").error().contains("wrong number")
+        env.expect("mh.info", "mh", "a").error().contains("wrong number")
@@ -0,0 +1,154 @@
+
+from common import *
+import random
+
+
+class testRangeFilter:
+    def __init__(self):
+        self.env = Env(decodeResponses=True)
+
+    def test_rf_reserve(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.assertTrue(env.cmd("rf.reserve", "rf", 0.01, 1000))
+        info = parse_info(env.cmd("rf.info", "rf"))
+        env.assertTrue(info["Capacity"] >= 1000, message=info)
+        env.assertEqual(16, info["Levels"])
+        env.assertEqual(65536, info["Max range"])
+        env.assertEqual(7, info["Hash functions"])
+        env.assertEqual(0, info["Number of items inserted"])
+        env.assertTrue(info["Size"] >= 32768, message=info)
+        env.assertTrue(env.cmd("rf.reserve", "short", 0.01, 1000, "levels", 4))
+        info = parse_info(env.cmd("rf.info", "short"))
+        env.assertEqual(16, info["Max range"])
+        env.assertTrue(info["Size"] < 32768, message=info)
+
+        env.expect("rf.reserve", "rf", 0.01, 1000).error().contains("key already exists")
+        env.expect("rf.reserve", "bad", "a", 1000).error().contains("bad error rate")
+        env.expect("rf.reserve", "bad", 1, 1000).error().contains("error rate must be")
+        env.expect("rf.reserve", "bad", 0.01, "a").error().contains("bad capacity")
+        env.expect("rf.reserve", "bad", 0.01, 0).error().contains("capacity must be")
+        env.expect("rf.reserve", "bad", 0.01, 100, "levels", 0).error() \
+            .contains("levels must be in the range")
+        env.expect("rf.reserve", "bad", 0.01, 100, "levels", 33).error() \
+            .contains("levels must be in the range")
+        env.expect("rf.reserve", "bad", 0.01, 100, "slices", 4).error() \
+            .contains("wrong keyword")
+        env.expect("rf.reserve", "bad", 0.01, 100, "levels").error().contains("wrong number")
+        env.assertEqual(0, env.cmd("EXISTS", "bad"))
+
+    def test_rf_range(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.assertTrue(env.cmd("rf.reserve", "rf", 0.01, 1000))
+        keys = sorted(random.sample(range(2 ** 40), 1000))
+        env.assertOk(env.cmd("rf.add", "rf", *keys))
+        env.assertEqual(1000, parse_info(env.cmd("rf.info", "rf"))["Number of items inserted"])
+        for k in keys[:100]:
+            env.assertEqual(1, env.cmd("rf.exists", "rf", k))
+            env.assertEqual(1, env.cmd("rf.range", "rf", k, k))
+            env.assertEqual(1, env.cmd("rf.range", "rf", max(0, k - 1000), k + 7))
+            env.assertEqual(1, env.cmd("rf.range", "rf", k, k + 60000))
+        env.assertEqual(1, env.cmd("rf.range", "rf", 0, 2 ** 64 - 1))
+
+        # ranges between the keys are empty
+        false_positives = 0
+        queries = 0
+        for lo, hi in zip(keys, keys[1:]):
+            if hi - lo < 2:
+                continue
+            length = random.randint(1, min(hi - lo - 2, 65536))
+            start = random.randint(lo + 1, hi - length)
+            false_positives += env.cmd("rf.range", "rf", start, start + length - 1)
+            queries += 1
+        env.assertTrue(false_positives < queries * 0.05, message=(false_positives, queries))
+
+    def test_rf_bounds(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.assertTrue(env.cmd("rf.add", "rf", 0, 2 ** 64 - 1))
+        env.assertEqual(1, env.cmd("rf.exists", "rf", 0))
+        env.assertEqual(1, env.cmd("rf.exists", "rf", 2 ** 64 - 1))
+        env.assertEqual(1, env.cmd("rf.range", "rf", 0, 0))
+        env.assertEqual(1, env.cmd("rf.range", "rf", 2 ** 64 - 10, 2 ** 64 - 1))
+        env.assertEqual(0, env.cmd("rf.range", "rf", 1, 1000))
+        env.assertEqual(0, env.cmd("rf.range", "rf", 2 ** 64 - 1000, 2 ** 64 - 2))
+        info = parse_info(env.cmd("rf.info", "rf"))
+        env.assertEqual(2, info["Number of items inserted"])
+        env.assertEqual(16, info["Levels"])
+
+        env.assertEqual(0, env.cmd("rf.exists", "missing", 1))
+        env.assertEqual(0, env.cmd("rf.range", "missing", 1, 2))
+        env.expect("rf.info", "missing").error().contains("key does not exist")
+        env.expect("rf.range", "rf", 2, 1).error().contains("lo must not be greater")
+        for bad in [-1, 2 ** 64, "a", "1.5", ""]:
+            env.expect("rf.add", "rf", 1, bad).error().contains("not an unsigned integer")
+            env.expect("rf.exists", "rf", bad).error().contains("not an unsigned integer")
+            env.expect("rf.range", "rf", 0, bad).error().contains("not an unsigned integer")
+        # a value is only added when all are valid
+        env.assertEqual(2, parse_info(env.cmd("rf.info", "rf"))["Number of items inserted"])
+
+    def test_rf_reload(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.assertTrue(env.cmd("rf.reserve", "rf", 0.001, 5000, "levels", 20))
+        keys = random.sample(range(2 ** 48), 5000)
+        env.cmd("rf.add", "rf", *keys)
+        info = env.cmd("rf.info", "rf")
+        ranges = [(k, k + 1000) for k in random.sample(range(2 ** 48), 500)]
+        replies = [env.cmd("rf.range", "rf", lo, hi) for lo, hi in ranges]
+        env.dumpAndReload()
+        env.assertEqual(info, env.cmd("rf.info", "rf"))
+        for k in keys[:100]:
+            env.assertEqual(1, env.cmd("rf.exists", "rf", k))
+        env.assertEqual(replies, [env.cmd("rf.range", "rf", lo, hi) for lo, hi in ranges])
+
+    def test_rf_wrong_type(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.cmd("SET", "str", "a")
+        env.assertTrue(env.cmd("bf.add", "bf", "a"))
+        for key in ["str", "bf"]:
+            env.expect("rf.add", key, 1).error().contains("WRONGTYPE")
+            env.expect("rf.exists", key, 1).error().contains("WRONGTYPE")
+            env.expect("rf.range", key, 1, 2).error().contains("WRONGTYPE")
+            env.expect("rf.info", key).error().contains("WRONGTYPE")
+            env.expect("rf.scandump", key, 0).error().contains("WRONGTYPE")
+        env.assertTrue(env.cmd("rf.add", "rf", 1))
+        env.expect("bf.add", "rf", "a").error().contains("WRONGTYPE")
+        env.expect("rf.add", "rf").error().contains("wrong number")
+        env.expect("rf.exists", "rf", 1, 2).error().contains("wrong number")
+        env.expect("rf.range", "rf", 1).error().contains("wrong number")
+        env.expect("rf.info", "rf", 1).error().contains("wrong number")
+
+
+class testRangeFilterNoCodec:
+    def __init__(self):
+        self.env = Env(decodeResponses=False)
+
+    def test_rf_scandump(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.assertOk(env.cmd("rf.reserve", "rf", 0.001, 100000))
+        keys = random.sample(range(2 ** 32), 10000)
+        env.assertOk(env.cmd("rf.add", "rf", *keys))
+        info = env.cmd("rf.info", "rf")
+        chunks = []
+        while True:
+            last_pos = chunks[-1][0] if chunks else 0
+            chunk = env.cmd("rf.scandump", "rf", last_pos)
+            if not chunk[0]:
+                break
+            chunks.append(chunk)
+        env.cmd("del", "rf")
+        for chunk in chunks:
+            env.assertOk(env.cmd("rf.loadchunk", "rf", *chunk))
+        env.assertEqual(info, env.cmd("rf.info", "rf"))
+        for k in keys[:100]:
+            env.assertEqual(1, env.cmd("rf.range", "rf", k - 10 if k > 10 else 0, k))
+
+        env.expect("rf.loadchunk", "rf", chunks[-1][0] + 10, chunks[-1][1]).error()
+        env.expect("rf.loadchunk", "other", 2, chunks[1][1]).error().contains("does not exist")
+        env.expect("rf.loadchunk", "other", 1, b"bad").error().contains("bad data")
+        env.expect("rf.scandump", "rf", -1).error().contains("invalid iterator")
+        env.assertEqual(0, env.cmd("EXISTS", "other"))
@@ -4,6 +4,8 @@ from common import *
 import numpy as np
 import redis
 import math
+import struct
+import time
 import random
 from random import randint
 
@@ -51,6 +53,130 @@ class testTDigest:
         self.assertRaises(
             redis.exceptions.ResponseError, self.cmd, "tdigest.create", "tdigest")
 
+    def test_tdigest_exact(self):
+        self.cmd('FLUSHALL')
+        self.assertOk(self.cmd("tdigest.create", "tdigest", "compression", 100))
+        values = [random.uniform(-1000, 1000) for _ in range(150)]
+        for i in range(0, len(values), 10):
+            self.assertOk(self.cmd("tdigest.add", "tdigest", *values[i:i + 10]))
+        info = parse_tdigest_info(self.cmd("tdigest.info", "tdigest"))
+        self.assertEqual("exact", info["Mode"])
+        # the samples are kept in order as they are added
+        self.assertEqual(150, info["Merged nodes"])
+        self.assertEqual(0, info["Unmerged nodes"])
+        self.assertEqual(0, info["Total compressions"])
+        # every sample is its own centroid, so quantiles are samples
+        quantiles = [0, 0.1, 0.25, 0.5, 0.75, 0.9, 1]
+        res = [float(v) for v in self.cmd("tdigest.quantile", "tdigest", *quantiles)]
+        for v in res:
+            self.assertTrue(v in values)
+        self.assertEqual(min(values), res[0])
+        self.assertEqual(max(values), res[-1])
+        info = parse_tdigest_info(self.cmd("tdigest.info", "tdigest"))
+        self.assertEqual(150, info["Merged nodes"])
+        self.assertEqual(150, info["Merged weight"])
+
+        self.assertEqual(True, self.cmd("SAVE"))
+        self.restart_and_reload()
+        info = parse_tdigest_info(self.cmd("tdigest.info", "tdigest"))
+        self.assertEqual("exact", info["Mode"])
+        self.assertEqual(150, info["Observations"])
+        self.assertEqual(res, [float(v) for v in self.cmd("tdigest.quantile", "tdigest", *quantiles)])
+
+        # past 2 * compression samples the sketch turns into a digest
+        self.assertOk(self.cmd("tdigest.addweighted", "tdigest", *[1.0, 2] * 50))
+        self.assertEqual("exact", parse_tdigest_info(self.cmd("tdigest.info", "tdigest"))["Mode"])
+        self.assertOk(self.cmd("tdigest.add", "tdigest", 2.0))
+        info = parse_tdigest_info(self.cmd("tdigest.info", "tdigest"))
+        self.assertEqual("digest", info["Mode"])
+        self.assertEqual(251, info["Observations"])
+        self.assertEqual(min(values), float(self.cmd("tdigest.min", "tdigest")))
+        self.assertEqual(max(values), float(self.cmd("tdigest.max", "tdigest")))
+
+    def test_tdigest_exact_order(self):
+        # an exact sketch turns into the same digest whatever order its samples arrived in, and
+        # whether or not it was read before
+        self.cmd('FLUSHALL')
+        values = [float(random.randint(0, 50)) for _ in range(200)]
+        weights = [random.randint(1, 3) for _ in range(200)]
+        pairs = [x for pair in zip(values, weights) for x in pair]
+        shuffled = list(zip(values, weights))
+        random.shuffle(shuffled)
+        self.assertOk(self.cmd("tdigest.create", "a", "compression", 100))
+        self.assertOk(self.cmd("tdigest.create", "b", "compression", 100))
+        for i in range(0, len(pairs), 20):
+            self.assertOk(self.cmd("tdigest.addweighted", "a", *pairs[i:i + 20]))
+            self.cmd("tdigest.quantile", "a", 0.5)
+        for v, w in shuffled:
+            self.assertOk(self.cmd("tdigest.addweighted", "b", v, w))
+        self.assertEqual("exact", parse_tdigest_info(self.cmd("tdigest.info", "a"))["Mode"])
+        self.assertOk(self.cmd("tdigest.add", "a", *range(100)))
+        self.assertOk(self.cmd("tdigest.add", "b", *range(100)))
+        info = parse_tdigest_info(self.cmd("tdigest.info", "a"))
+        self.assertEqual("digest", info["Mode"])
+        self.assertEqual(info, parse_tdigest_info(self.cmd("tdigest.info", "b")))
+        quantiles = [i / 100 for i in range(101)]
+        self.assertEqual(self.cmd("tdigest.quantile", "a", *quantiles),
+                         self.cmd("tdigest.quantile", "b", *quantiles))
+
+    def test_tdigest_window(self):
+        self.cmd("FLUSHALL")
+        self.assertOk(self.cmd("tdigest.create", "win", "compression", 100, "window", 1000, "buckets", 4))
+        info = parse_tdigest_info(self.cmd("tdigest.info", "win"))
+        self.assertEqual(1000, info["Window"])
+        self.assertEqual(4, info["Buckets"])
+        self.assertOk(self.cmd("tdigest.add", "win", *range(100)))
+        self.assertOk(self.cmd("tdigest.addweighted", "win", 1000, 10))
+        self.assertEqual(110, parse_tdigest_info(self.cmd("tdigest.info", "win"))["Observations"])
+        self.assertEqual("1000", self.cmd("tdigest.max", "win"))
+        self.assertEqual(["0"], self.cmd("tdigest.quantile", "win", 0))
+
+        # the window survives a reload
+        self.env.dumpAndReload()
+        self.assertEqual(110, parse_tdigest_info(self.cmd("tdigest.info", "win"))["Observations"])
+        self.assertEqual(4, parse_tdigest_info(self.cmd("tdigest.info", "win"))["Buckets"])
+
+        # the samples expire once the window has passed them
+        time.sleep(1.3)
+        self.assertEqual(0, parse_tdigest_info(self.cmd("tdigest.info", "win"))["Observations"])
+        self.assertEqual("nan", self.cmd("tdigest.min", "win"))
+        self.assertOk(self.cmd("tdigest.add", "win", 5, 6))
+        self.assertEqual(2, parse_tdigest_info(self.cmd("tdigest.info", "win"))["Observations"])
+        self.assertEqual("5", self.cmd("tdigest.min", "win"))
+
+        # AT adds the samples as of that time
+        now = int(time.time() * 1000)
+        self.assertOk(self.cmd("tdigest.add", "win", 7, "AT", now))
+        self.assertEqual(3, parse_tdigest_info(self.cmd("tdigest.info", "win"))["Observations"])
+        # samples of a time slot whose bucket was reused since are refused
+        self.env.expect("tdigest.add", "win", 1, 2, 3, "at", now - 5000).error() \
+            .contains("older than the window")
+        self.env.expect("tdigest.addweighted", "win", 1, 5, "AT", now - 5000).error() \
+            .contains("older than the window")
+        # and clients may not write more than one time slot ahead
+        self.env.expect("tdigest.add", "win", 9, "AT", now + 2000).error() \
+            .contains("too far in the future")
+        self.assertEqual(3, parse_tdigest_info(self.cmd("tdigest.info", "win"))["Observations"])
+        self.env.expect("tdigest.add", "win", 1, "AT", -1).error().contains("timestamp")
+        self.env.expect("tdigest.add", "win", 1, "AT", "x").error().contains("timestamp")
+        self.env.expect("tdigest.add", "win", "AT", now).error().contains("val")
+
+        # windowed keys can be merged from, but only replaced as a destination
+        self.assertOk(self.cmd("tdigest.merge", "plain", 1, "win"))
+        self.assertEqual(3, parse_tdigest_info(self.cmd("tdigest.info", "plain"))["Observations"])
+        self.env.expect("tdigest.merge", "win", 1, "plain").error().contains("OVERRIDE")
+        self.assertOk(self.cmd("tdigest.reset", "win"))
+        self.assertEqual(0, parse_tdigest_info(self.cmd("tdigest.info", "win"))["Observations"])
+        self.assertOk(self.cmd("tdigest.add", "win", 8, "AT", int(time.time() * 1000) + 250))
+
+        self.env.expect("tdigest.create", "bad", "window", 1000).error().contains("BUCKETS")
+        self.env.expect("tdigest.create", "bad", "buckets", 4).error().contains("BUCKETS")
+        self.env.expect("tdigest.create", "bad", "window", 0, "buckets", 4).error()
+        self.env.expect("tdigest.create", "bad", "window", 1000, "buckets", 0).error()
+        self.env.expect("tdigest.create", "bad", "window", 1000, "buckets", 1025).error()
+        self.env.expect("tdigest.create", "bad", "window", 3, "buckets", 4).error()
+        self.assertEqual(0, self.cmd("EXISTS", "bad"))
+
     def test_negative_tdigest_create(self):
         self.cmd('FLUSHALL')
         self.cmd("SET", "tdigest", "B")
@@ -169,6 +295,26 @@ class testTDigest:
                 int(td_info["Observations"]),
             )
 
+    def test_tdigest_add_bulk(self):
+        self.cmd('FLUSHALL')
+        self.assertOk(self.cmd("tdigest.create", "bulk", "compression", 100))
+        self.assertOk(self.cmd("tdigest.create", "single", "compression", 100))
+        values = [random.uniform(-1000, 1000) for _ in range(5000)]
+        self.assertOk(self.cmd("tdigest.add", "bulk", *values))
+        self.assertOk(self.cmd("tdigest.add", "bulk", *values[:10]))
+        for i in range(0, len(values), 50):
+            self.assertOk(self.cmd("tdigest.add", "single", *values[i:i + 50]))
+        self.assertOk(self.cmd("tdigest.add", "single", *values[:10]))
+        bulk_info = parse_tdigest_info(self.cmd("tdigest.info", "bulk"))
+        self.assertEqual(5010, bulk_info["Observations"])
+        self.assertGreater(bulk_info["Total compressions"], 1)
+        self.assertEqual(float(self.cmd("tdigest.min", "single")), float(self.cmd("tdigest.min", "bulk")))
+        self.assertEqual(float(self.cmd("tdigest.max", "single")), float(self.cmd("tdigest.max", "bulk")))
+        quantiles = [0.01, 0.1, 0.5, 0.9, 0.99]
+        for bulk, single in zip(self.cmd("tdigest.quantile", "bulk", *quantiles),
+                                self.cmd("tdigest.quantile", "single", *quantiles)):
+            self.assertAlmostEqual(float(single), float(bulk), 20)
+
     def test_negative_tdigest_add(self):
         self.cmd('FLUSHALL')
         self.cmd("SET", "tdigest", "B")
@@ -208,6 +354,44 @@ class testTDigest:
             redis.exceptions.ResponseError, self.cmd, "tdigest.add", "tdigest", "+inf",
         )
 
+    def test_tdigest_addweighted(self):
+        self.cmd('FLUSHALL')
+        samples = [(1.5, 3), (-2.0, 1), (10.0, 5), (4.25, 2)]
+        self.assertOk(self.cmd("tdigest.create", "weighted", "compression", 1000))
+        self.assertOk(self.cmd("tdigest.create", "repeated", "compression", 1000))
+        self.assertOk(self.cmd("tdigest.create", "packed", "compression", 1000))
+        self.assertOk(self.cmd("tdigest.addweighted", "weighted",
+                               *[x for sample in samples for x in sample]))
+        for value, weight in samples:
+            self.assertOk(self.cmd("tdigest.add", "repeated", *([value] * weight)))
+        payload = b''.join(struct.pack('<dQ', value, weight) for value, weight in samples)
+        self.assertOk(self.cmd("tdigest.addweighted", "packed", "PACKED", payload))
+
+        values = [-3, -2, 1.5, 4.25, 11]
+        expected = self.cmd("tdigest.cdf", "repeated", *values)
+        for key in ["weighted", "packed"]:
+            info = parse_tdigest_info(self.cmd("tdigest.info", key))
+            self.assertEqual(11, info["Observations"])
+            self.assertEqual(-2, float(self.cmd("tdigest.min", key)))
+            self.assertEqual(10, float(self.cmd("tdigest.max", key)))
+            self.assertEqual(expected, self.cmd("tdigest.cdf", key, *values))
+
+        # invalid samples leave the sketch untouched
+        self.env.expect("tdigest.addweighted", "weighted", 1).error().contains("wrong number")
+        self.env.expect("tdigest.addweighted", "weighted", 1, 2, 3).error().contains("wrong number")
+        self.env.expect("tdigest.addweighted", "weighted", 1, 2, 3, 0).error().contains("positive")
+        self.env.expect("tdigest.addweighted", "weighted", 1, 2, 3, -1).error().contains("positive")
+        self.env.expect("tdigest.addweighted", "weighted", 1, 'a').error().contains("parsing")
+        self.env.expect("tdigest.addweighted", "weighted", 'inf', 1).error().contains("finite")
+        self.env.expect("tdigest.addweighted", "weighted", 1, 2**63 - 1).error().contains("overflow")
+        self.env.expect("tdigest.addweighted", "weighted", "PACKED", payload[:-1]).error().contains("payload")
+        self.env.expect("tdigest.addweighted", "weighted", "PACKED",
+                        struct.pack('<dQ', 1.0, 0)).error().contains("positive")
+        self.env.expect("tdigest.addweighted", "weighted", "PACKED",
+                        struct.pack('<dQ', float('nan'), 1)).error().contains("finite")
+        self.env.expect("tdigest.addweighted", "dont-exist", 1, 1).error().contains("does not exist")
+        self.assertEqual(11, parse_tdigest_info(self.cmd("tdigest.info", "weighted"))["Observations"])
+
     def test_tdigest_merge_to_empty(self):
         self.cmd("FLUSHALL")
         self.assertOk(self.cmd("tdigest.create", "to-tdigest{1}", "compression", 100))
@@ -352,6 +536,101 @@ class testTDigest:
         for i in range(len(res)):
             self.assertAlmostEqual(expected[i], float(res[i]), 0.01)
 
+    def test_tdigest_merge_many(self):
+        self.cmd("FLUSHALL")
+        random.seed(36)
+        keys = []
+        values = []
+        for i in range(50):
+            key = "src-{}{{1}}".format(i)
+            keys.append(key)
+            self.assertOk(self.cmd("tdigest.create", key, "compression", 100))
+            batch = [random.uniform(i, i + 100) for _ in range(40)]
+            values.extend(batch)
+            self.assertOk(self.cmd("tdigest.add", key, *batch))
+        self.assertOk(self.cmd("tdigest.create", "all{1}", "compression", 100))
+        self.assertOk(self.cmd("tdigest.add", "all{1}", *values))
+        self.assertOk(self.cmd("tdigest.merge", "dest{1}", len(keys), *keys, "COMPRESSION", 100))
+        info = parse_tdigest_info(self.cmd("tdigest.info", "dest{1}"))
+        self.assertEqual(len(values), info["Observations"])
+        self.assertEqual(min(values), float(self.cmd("tdigest.min", "dest{1}")))
+        self.assertEqual(max(values), float(self.cmd("tdigest.max", "dest{1}")))
+        quantiles = [0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99]
+        merged = self.cmd("tdigest.quantile", "dest{1}", *quantiles)
+        direct = self.cmd("tdigest.quantile", "all{1}", *quantiles)
+        for i in range(len(quantiles)):
+            self.assertAlmostEqual(float(direct[i]), float(merged[i]), delta=1.5)
+
+        # merging into an existing destination with the same compression keeps its samples
+        self.assertOk(self.cmd("tdigest.merge", "dest{1}", 2, keys[0], keys[1]))
+        info = parse_tdigest_info(self.cmd("tdigest.info", "dest{1}"))
+        self.assertEqual(len(values) + 80, info["Observations"])
+        self.assertEqual(min(values), float(self.cmd("tdigest.min", "dest{1}")))
+
+    def test_tdigest_merge_exact_destination(self):
+        self.cmd("FLUSHALL")
+        self.assertOk(self.cmd("tdigest.create", "dest{1}"))
+        self.assertOk(self.cmd("tdigest.add", "dest{1}", *range(10)))
+        self.assertOk(self.cmd("tdigest.create", "src{1}"))
+        self.assertOk(self.cmd("tdigest.add", "src{1}", *range(10, 20)))
+        # a failed merge leaves the destination as it was
+        self.env.expect("tdigest.merge", "dest{1}", 2, "src{1}", "none{1}").error()
+        info = parse_tdigest_info(self.cmd("tdigest.info", "dest{1}"))
+        self.assertEqual("exact", info["Mode"])
+        self.assertEqual(10, info["Observations"])
+
+        self.assertOk(self.cmd("tdigest.merge", "dest{1}", 1, "src{1}"))
+        info = parse_tdigest_info(self.cmd("tdigest.info", "dest{1}"))
+        self.assertEqual(20, info["Observations"])
+        self.assertEqual("0", self.cmd("tdigest.min", "dest{1}"))
+        self.assertEqual("19", self.cmd("tdigest.max", "dest{1}"))
+
+    def test_tdigest_mquantile_mcdf(self):
+        self.cmd("FLUSHALL")
+        random.seed(37)
+        keys = []
+        for i in range(20):
+            key = "minute-{}{{1}}".format(i)
+            keys.append(key)
+            self.assertOk(self.cmd("tdigest.create", key, "compression", 100))
+            self.assertOk(self.cmd("tdigest.add", key, *[random.uniform(0, 1000) for _ in range(50)]))
+        self.assertOk(self.cmd("tdigest.merge", "merged{1}", len(keys), *keys))
+        quantiles = [0.99, 0, 0.5, 1, 0.01]
+        expected = self.cmd("tdigest.quantile", "merged{1}", *quantiles)
+        res = self.cmd("tdigest.mquantile", len(keys), *keys, "QUANTILES", *quantiles)
+        self.assertEqual(len(quantiles), len(res))
+        for i in range(len(quantiles)):
+            self.assertAlmostEqual(float(expected[i]), float(res[i]), delta=0.01)
+        values = [500, -1, 1001, 250]
+        expected = self.cmd("tdigest.cdf", "merged{1}", *values)
+        res = self.cmd("tdigest.mcdf", len(keys), *keys, "VALUES", *values)
+        for i in range(len(values)):
+            self.assertAlmostEqual(float(expected[i]), float(res[i]), delta=0.0001)
+
+        # nothing is written to the keyspace
+        self.assertEqual(len(keys) + 1, self.cmd("DBSIZE"))
+        # the keyword is case insensitive
+        res = self.cmd("tdigest.mquantile", 1, keys[0], "quantiles", 0)
+        self.assertEqual(float(self.cmd("tdigest.min", keys[0])), float(res[0]))
+        self.assertOk(self.cmd("tdigest.create", "empty{1}"))
+        res = self.cmd("tdigest.mquantile", 1, "empty{1}", "QUANTILES", 0.5)
+        self.assertEqual("nan", res[0])
+
+    def test_negative_tdigest_mquantile_mcdf(self):
+        self.cmd("FLUSHALL")
+        self.assertOk(self.cmd("tdigest.create", "td{1}"))
+        self.cmd("SET", "str{1}", "x")
+        self.assertRaises(redis.exceptions.ResponseError, self.cmd, "tdigest.mquantile", 1, "td{1}", "QUANTILES")
+        self.assertRaises(redis.exceptions.ResponseError, self.cmd, "tdigest.mquantile", 0, "td{1}", "QUANTILES", 0.5)
+        self.assertRaises(redis.exceptions.ResponseError, self.cmd, "tdigest.mquantile", "a", "td{1}", "QUANTILES", 0.5)
+        self.assertRaises(redis.exceptions.ResponseError, self.cmd, "tdigest.mquantile", 3, "td{1}", "QUANTILES", 0.5)
+        self.assertRaises(redis.exceptions.ResponseError, self.cmd, "tdigest.mquantile", 1, "td{1}", "VALUES", 0.5)
+        self.assertRaises(redis.exceptions.ResponseError, self.cmd, "tdigest.mquantile", 1, "td{1}", "QUANTILES", 1.5)
+        self.assertRaises(redis.exceptions.ResponseError, self.cmd, "tdigest.mquantile", 1, "td{1}", "QUANTILES", "x")
+        self.assertRaises(redis.exceptions.ResponseError, self.cmd, "tdigest.mquantile", 2, "td{1}", "none{1}", "QUANTILES", 0.5)
+        self.assertRaises(redis.exceptions.ResponseError, self.cmd, "tdigest.mcdf", 2, "td{1}", "str{1}", "VALUES", 1)
+        self.assertRaises(redis.exceptions.ResponseError, self.cmd, "tdigest.mcdf", 1, "td{1}", "VALUES", "x")
+
     def test_negative_tdigest_merge(self):
         self.cmd('FLUSHALL')
         self.cmd("SET", "to-tdigest", "B")
@@ -686,6 +965,105 @@ class testTDigest:
         self.assertEqual([-1, 0, 1, 2, 3, 4, 5, 6], self.cmd('TDIGEST.RANK', 's', '0', '10', '20', '30', '40', '50', '60', '70'))
 
 
+    def test_tdigest_batched_queries(self):
+        # answering many values at once must match answering them one by one
+        self.cmd('FLUSHALL')
+        self.assertOk(self.cmd("tdigest.create", "t", "compression", "100"))
+        for _ in range(10):
+            self.assertOk(self.cmd("tdigest.add", "t", *[randint(0, 500) for _ in range(500)]))
+        values = [randint(-10, 510) for _ in range(200)] + [0, 0, 250, 500]
+        random.shuffle(values)
+        for cmd in ["tdigest.cdf", "tdigest.rank", "tdigest.revrank"]:
+            batched = self.cmd(cmd, "t", *values)
+            self.assertEqual([self.cmd(cmd, "t", v)[0] for v in values], batched)
+        ranks = [randint(0, 5100) for _ in range(200)]
+        for cmd in ["tdigest.byrank", "tdigest.byrevrank"]:
+            batched = self.cmd(cmd, "t", *ranks)
+            self.assertEqual([self.cmd(cmd, "t", r)[0] for r in ranks], batched)
+
+    def test_tdigest_cached_queries(self):
+        # answers must not depend on whether the prefix weights are cached
+        self.cmd('FLUSHALL')
+        self.assertOk(self.cmd("tdigest.create", "t", "compression", "100"))
+        self.assertOk(self.cmd("tdigest.add", "t", *[randint(0, 500) for _ in range(2000)]))
+        values = [randint(-10, 510) for _ in range(50)]
+        mem_before = self.cmd("MEMORY", "USAGE", "t")
+        cached = self.cmd("tdigest.cdf", "t", *values)
+        self.assertGreater(self.cmd("MEMORY", "USAGE", "t"), mem_before)
+        self.assertEqual(cached, self.cmd("tdigest.cdf", "t", *values))
+        self.env.expect('CONFIG', 'SET', 'tdigest-cache-max-nodes', 0).ok()
+        self.assertEqual(cached, self.cmd("tdigest.cdf", "t", *values))
+        self.env.expect('CONFIG', 'SET', 'tdigest-cache-max-nodes', 8192).ok()
+
+        # quantiles are binary searches over the same prefix weights
+        quantiles = [random.random() for _ in range(50)] + [0, 0.0001, 0.5, 0.9999, 1]
+        ranks = [randint(0, 2000) for _ in range(50)] + [0, 1, 1999, 2000]
+        cached = [self.cmd("tdigest.quantile", "t", *quantiles),
+                  self.cmd("tdigest.byrank", "t", *ranks),
+                  self.cmd("tdigest.byrevrank", "t", *ranks)]
+        self.env.expect('CONFIG', 'SET', 'tdigest-cache-max-nodes', 0).ok()
+        self.assertEqual(cached, [self.cmd("tdigest.quantile", "t", *quantiles),
+                                  self.cmd("tdigest.byrank", "t", *ranks),
+                                  self.cmd("tdigest.byrevrank", "t", *ranks)])
+        self.env.expect('CONFIG', 'SET', 'tdigest-cache-max-nodes', 8192).ok()
+
+        # writes invalidate the cache
+        self.assertOk(self.cmd("tdigest.add", "t", *[randint(500, 1000) for _ in range(2000)]))
+        cached = self.cmd("tdigest.rank", "t", *values)
+        self.env.expect('CONFIG', 'SET', 'tdigest-cache-max-nodes', 0).ok()
+        self.assertEqual(cached, self.cmd("tdigest.rank", "t", *values))
+        self.env.expect('CONFIG', 'SET', 'tdigest-cache-max-nodes', 8192).ok()
+        self.assertOk(self.cmd("tdigest.reset", "t"))
+        self.assertEqual([-2] * len(values), self.cmd("tdigest.rank", "t", *values))
+
+    def test_tdigest_cached_match_library(self):
+        # the cached and swept answers re-implement the interpolation of td_cdf and td_quantile,
+        # which answer the single-value queries made with the cache disabled
+        self.cmd('FLUSHALL')
+        self.assertOk(self.cmd("tdigest.create", "digest", "compression", 100))
+        self.assertOk(self.cmd("tdigest.add", "digest", *[randint(0, 500) for _ in range(3000)]))
+        self.assertOk(self.cmd("tdigest.create", "small", "compression", 10))
+        self.assertOk(self.cmd("tdigest.add", "small",
+                               *[random.gauss(0, 100) for _ in range(1000)]))
+        self.assertOk(self.cmd("tdigest.create", "weighted", "compression", 50))
+        self.assertOk(self.cmd("tdigest.addweighted", "weighted",
+                               *[v for i in range(500) for v in (randint(0, 50), 1 + i % 4)]))
+        self.assertOk(self.cmd("tdigest.create", "singletons", "compression", 1000))
+        self.assertOk(self.cmd("tdigest.add", "singletons", *range(40)))
+        self.assertOk(self.cmd("tdigest.create", "equal", "compression", 1000))
+        self.assertOk(self.cmd("tdigest.add", "equal", *([5] * 30 + [7] * 30 + [9, 11] + [11] * 3)))
+        self.assertOk(self.cmd("tdigest.create", "single", "compression", 100))
+        self.assertOk(self.cmd("tdigest.add", "single", 3))
+
+        def each(args, inputs):
+            return [self.cmd(*args, a)[0] for a in inputs]
+
+        for key in ("digest", "small", "weighted", "singletons", "equal", "single"):
+            low, high = float(self.cmd("tdigest.min", key)), float(self.cmd("tdigest.max", key))
+            size = int(parse_tdigest_info(self.cmd("tdigest.info", key))["Observations"])
+            values = [random.uniform(low - 1, high + 1) for _ in range(60)] + \
+                     [randint(int(low) - 1, int(high) + 1) for _ in range(60)] + [low, high]
+            quantiles = [random.random() for _ in range(100)] + \
+                        [0, 1 / size, 0.5 / size, 0.5, 1 - 1 / size, 1 - 0.5 / size, 1]
+            ranks = list(range(0, size + 1)) if size <= 100 else \
+                [randint(0, size) for _ in range(100)] + [0, 1, size - 1, size]
+
+            self.env.expect('CONFIG', 'SET', 'tdigest-cache-max-nodes', 0).ok()
+            queries = [(("tdigest.cdf", key), values),
+                       (("tdigest.rank", key), values),
+                       (("tdigest.revrank", key), values),
+                       (("tdigest.quantile", key), quantiles),
+                       (("tdigest.byrank", key), ranks),
+                       (("tdigest.byrevrank", key), ranks),
+                       (("tdigest.mcdf", 1, key, "VALUES"), values),
+                       (("tdigest.mquantile", 1, key, "QUANTILES"), quantiles)]
+            self.env.expect('CONFIG', 'SET', 'tdigest-cache-max-nodes', 0).ok()
+            library = [each(args, inputs) for args, inputs in queries]
+            for cache in (0, 8192):
+                self.env.expect('CONFIG', 'SET', 'tdigest-cache-max-nodes', cache).ok()
+                self.assertEqual(library, [self.cmd(*args, *inputs) for args, inputs in queries],
+                                 message=key)
+
     def test_negative_tdigest_rank(self):
         self.cmd('FLUSHALL')
         self.cmd("SET", "tdigest", "B")
@@ -896,12 +1274,20 @@ class testTDigest:
                 100,
                 int(td_info["Observations"]),
             )
+        # up to 2 * compression samples are kept exactly, in memory sized to them
+        self.assertEqual("exact", td_info["Mode"])
+        exact_mem_usage = td_info["Memory usage"]
+        for x in range(1, 102):
+            self.assertOk(self.cmd("tdigest.add", "tdigest", x))
+        td_info = parse_tdigest_info(self.cmd("tdigest.info", "tdigest"))
+        self.assertEqual("digest", td_info["Mode"])
         init_mem_usage = td_info["Memory usage"]
+        self.assertGreater(init_mem_usage, exact_mem_usage)
         # memory usage check
         self.assertTrue(
                 init_mem_usage <= self.cmd("MEMORY", "USAGE", "tdigest"),
             )
-        # independent of the datapoints this sketch has an invariant size after creation
+        # independent of the datapoints this sketch has an invariant size once it is a digest
         for x in range(1, 10001):
             self.assertOk(self.cmd("tdigest.add", "tdigest", x))
         td_info = parse_tdigest_info(self.cmd("tdigest.info", "tdigest"))
@@ -913,6 +1299,7 @@ class testTDigest:
         for compression in [100,200,300,400,500]:
             self.cmd('FLUSHALL')
             self.assertOk(self.cmd("tdigest.create", "tdigest", "compression", compression))
+            self.assertOk(self.cmd("tdigest.add", "tdigest", *range(2 * compression + 1)))
             td_info = parse_tdigest_info(self.cmd("tdigest.info", "tdigest"))
             current_mem_usage = td_info["Memory usage"]
             self.assertTrue(
@@ -964,6 +1351,25 @@ class testTDigest:
         self.assertEqual(tdigest_min, self.cmd("tdigest.min", "tdigest"))
         self.assertEqual(tdigest_max, self.cmd("tdigest.max", "tdigest"))
 
+    def test_save_load_centroids(self):
+        self.cmd('FLUSHALL')
+        self.assertOk(self.cmd("tdigest.create", "tdigest", "compression", 1000))
+        values = [random.uniform(-1000, 1000) for _ in range(5000)]
+        for i in range(0, len(values), 500):
+            self.assertOk(self.cmd("tdigest.add", "tdigest", *values[i:i + 500]))
+        quantiles = [0, 0.01, 0.25, 0.5, 0.75, 0.99, 1]
+        quantiles_prior_restart = self.cmd("tdigest.quantile", "tdigest", *quantiles)
+        cdfs_prior_restart = self.cmd("tdigest.cdf", "tdigest", -500, 0, 500)
+        self.assertEqual(True, self.cmd("SAVE"))
+        info_prior_restart = parse_tdigest_info(self.cmd("tdigest.info", "tdigest"))
+        self.restart_and_reload()
+        info_after_restart = parse_tdigest_info(self.cmd("tdigest.info", "tdigest"))
+        self.assertEqual(info_prior_restart["Merged nodes"], info_after_restart["Merged nodes"])
+        self.assertEqual(5000, info_after_restart["Merged weight"])
+        self.assertEqual(quantiles_prior_restart,
+                         self.cmd("tdigest.quantile", "tdigest", *quantiles))
+        self.assertEqual(cdfs_prior_restart, self.cmd("tdigest.cdf", "tdigest", -500, 0, 500))
+
     def test_insufficient_memory(self):
         if os.environ.get('SANITIZER') != None:
             self.env.skip()
@@ -974,3 +1380,22 @@ class testTDigest:
         self.cmd('FLUSHALL')
         rdb_payload = b'\x07\x81L2\x12\xf96\x0f\x10\x00\x04\x00\x00\x00\x00\x00\x00(@\x04\x00\x00\x00\x00\x00\x00\xf0?\x04\x00\x00\x00\x00\x00\x00\xf0?\x02\x01\x02@a\x02\x01\x02\x01\x04\x00\x00\x00\x00\x00\x00\xf0?\x04\x00\x00\x00\x00\x00\x00\xf0?\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04CCCCCCCC\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x04AAAAAAAA\x00\xff\x0c\x008\x9c\x969\x91:\xcc5'
         self.env.expect('RESTORE', "key", 0, rdb_payload, 'REPLACE').error().contains('Bad data format')
+
+
+def test_tdigest_window_aof():
+    # writes to a window are logged with the time they were made at, so replaying them after the
+    # window has passed does not bring the samples back
+    env = Env(useAof=True, decodeResponses=True, freshEnv=True)
+    if env.isCluster():
+        env.skip()
+    env.expect("tdigest.create", "win", "window", 1000, "buckets", 4).ok()
+    env.expect("tdigest.add", "win", *range(100)).ok()
+    env.expect("tdigest.addweighted", "win", 1000, 10).ok()
+    env.expect("tdigest.create", "plain").ok()
+    env.expect("tdigest.add", "plain", 1, 2, 3).ok()
+    time.sleep(1.3)
+    env.expect("tdigest.add", "win", 5, 6).ok()
+    env.expect("DEBUG", "LOADAOF").ok()
+    env.assertEqual(2, parse_tdigest_info(env.cmd("tdigest.info", "win"))["Observations"])
+    env.assertEqual("5", env.cmd("tdigest.min", "win"))
+    env.assertEqual(3, parse_tdigest_info(env.cmd("tdigest.info", "plain"))["Observations"])
@@ -0,0 +1,108 @@
+
+from common import *
+
+
+class testTheta:
+    def __init__(self):
+        self.env = Env(decodeResponses=True)
+
+    def add_set(self, key, items):
+        for i in range(0, len(items), 1000):
+            self.env.assertOk(self.env.cmd("theta.add", key, *items[i:i + 1000]))
+
+    def estimate(self, key):
+        return float(self.env.cmd("theta.estimate", key))
+
+    def assertClose(self, expected, actual, error):
+        self.env.assertTrue(abs(actual - expected) <= expected * error, message=(expected, actual))
+
+    def test_theta_exact(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.assertEqual(0, self.estimate("a"))
+        self.add_set("a", ["item%d" % x for x in range(1000)])
+        self.add_set("a", ["item%d" % x for x in range(500)])
+        self.add_set("b", ["item%d" % x for x in range(500, 1500)])
+        env.assertEqual(1000, self.estimate("a"))
+
+        # below k the sketches are exact, and so are their set operations
+        env.assertOk(env.cmd("theta.union", "u", 2, "a", "b"))
+        env.assertEqual(1500, self.estimate("u"))
+        env.assertOk(env.cmd("theta.intersect", "i", 2, "a", "b"))
+        env.assertEqual(500, self.estimate("i"))
+        env.assertOk(env.cmd("theta.anotb", "d", "a", "b"))
+        env.assertEqual(500, self.estimate("d"))
+        env.assertOk(env.cmd("theta.anotb", "d", "a", "a"))
+        env.assertEqual(0, self.estimate("d"))
+
+        info = parse_info(env.cmd("theta.info", "a"))
+        env.assertEqual(4096, info["K"])
+        env.assertEqual(1, float(info["Theta"]))
+        env.assertEqual(1000, info["Retained"])
+        env.assertTrue(info["Size"] >= 4096 * 16, message=info)
+
+    def test_theta_estimate(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.assertOk(env.cmd("theta.create", "a", "K", 1024))
+        env.assertOk(env.cmd("theta.create", "b", "K", 1024))
+        self.add_set("a", ["item%d" % x for x in range(30000)])
+        self.add_set("b", ["item%d" % x for x in range(15000, 45000)])
+        self.assertClose(30000, self.estimate("a"), 0.15)
+
+        info = parse_info(env.cmd("theta.info", "a"))
+        env.assertEqual(1024, info["K"])
+        env.assertTrue(float(info["Theta"]) < 1, message=info)
+        env.assertTrue(1024 <= info["Retained"] <= 1536, message=info)
+
+        env.assertOk(env.cmd("theta.union", "u", 2, "a", "b"))
+        self.assertClose(45000, self.estimate("u"), 0.15)
+        env.assertOk(env.cmd("theta.intersect", "i", 2, "a", "b"))
+        self.assertClose(15000, self.estimate("i"), 0.25)
+        env.assertOk(env.cmd("theta.anotb", "d", "a", "b"))
+        self.assertClose(15000, self.estimate("d"), 0.25)
+
+        # the destination may be one of the sources
+        env.assertOk(env.cmd("theta.union", "a", 1, "a"))
+        self.assertClose(30000, self.estimate("a"), 0.15)
+
+    def test_theta_reload(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        self.add_set("a", ["item%d" % x for x in range(10000)])
+        self.add_set("b", ["item%d" % x for x in range(100)])
+        estimate = env.cmd("theta.estimate", "a")
+        info = env.cmd("theta.info", "a")
+        env.dumpAndReload()
+        env.assertEqual(estimate, env.cmd("theta.estimate", "a"))
+        env.assertEqual(info, env.cmd("theta.info", "a"))
+        env.assertEqual(100, self.estimate("b"))
+        # the items hash the same after a reload
+        self.add_set("a", ["item%d" % x for x in range(10000)])
+        env.assertEqual(info, env.cmd("theta.info", "a"))
+
+    def test_theta_errors(self):
+        env = self.env
+        env.cmd("FLUSHALL")
+        env.cmd("SET", "str", "a")
+        env.assertOk(env.cmd("theta.add", "th", "a"))
+        env.expect("theta.create", "th").error().contains("key already exists")
+        env.expect("theta.create", "x", "K", 1000).error().contains("power of two")
+        env.expect("theta.create", "x", "K", 8).error().contains("power of two")
+        env.expect("theta.create", "x", "K", 1 << 21).error().contains("power of two")
+        env.expect("theta.create", "x", "KK", 1024).error().contains("wrong keyword")
+        env.expect("theta.add", "str", "a").error().contains("WRONGTYPE")
+        env.expect("theta.estimate", "str").error().contains("WRONGTYPE")
+        env.expect("theta.info", "str").error().contains("WRONGTYPE")
+        env.expect("theta.info", "missing").error().contains("key does not exist")
+        env.expect("theta.union", "str", 1, "th").error().contains("WRONGTYPE")
+        env.expect("theta.union", "u", 1, "str").error().contains("WRONGTYPE")
+        env.expect("theta.union", "u", 2, "th", "missing").error().contains(
+            "key does not exist")
+        env.expect("theta.intersect", "u", 0, "th").error().contains("numkeys")
+        env.expect("theta.intersect", "u", "x", "th").error().contains("numkeys")
+        env.expect("theta.intersect", "u", 2, "th").error().contains("wrong number")
+        env.expect("theta.anotb", "u", "missing", "th").error().contains("key does not exist")
+        env.expect("theta.anotb", "u", "th").error().contains("wrong number")
+        env.assertEqual(0, env.cmd("EXISTS", "u"))
+        env.expect("bf.add", "th", "a").error().contains("WRONGTYPE")
@@ -97,6 +97,194 @@ class testTopK():
         self.assertTrue(isinstance(self.cmd('topk.incrby', 'topk', 'foo', -5)[0], ResponseError))
         self.assertTrue(isinstance(self.cmd('topk.incrby', 'topk', 'foo', 123456)[0], ResponseError))
 
+    def test_batch_duplicates(self):
+        self.cmd('FLUSHALL')
+        self.assertTrue(self.cmd('topk.reserve', 'topk', '2', '50', '5', '1'))
+        self.assertEqual([None] * 5, self.cmd('topk.add', 'topk', 'a', 'b', 'a', 'b', 'a'))
+        self.assertEqual(['a', 3, 'b', 2], self.cmd('topk.list', 'topk', 'WITHCOUNT'))
+        # 'c' reaches the heap minimum on its second occurrence
+        self.assertEqual([None, 'b', None, None],
+                         self.cmd('topk.add', 'topk', 'c', 'c', 'c', 'c'))
+        self.assertEqual(['c', 4, 'a', 3], self.cmd('topk.list', 'topk', 'WITHCOUNT'))
+        self.assertEqual([None, 'a', None], self.cmd('topk.incrby', 'topk', 'd', 1, 'd', 2, 'd', 3))
+        self.assertEqual(['d', 6, 'c', 4], self.cmd('topk.list', 'topk', 'WITHCOUNT'))
+
+        # items preceding an invalid increment are added
+        res = self.cmd('topk.incrby', 'topk', 'e', 1, 'f', -1, 'g', 1)
+        self.assertEqual(2, len(res))
+        self.assertEqual(None, res[0])
+        self.assertTrue(isinstance(res[1], ResponseError))
+        self.assertEqual([1, 0, 0], self.cmd('topk.count', 'topk', 'e', 'f', 'g'))
+
+    def test_merge(self):
+        self.cmd('FLUSHALL')
+        for key in ('a{t}', 'b{t}', 'c{t}'):
+            self.assertOk(self.cmd('topk.reserve', key, 3, 1000, 5, 0.9))
+        self.cmd('topk.incrby', 'a{t}', 'x', 5, 'y', 3)
+        self.cmd('topk.incrby', 'b{t}', 'x', 2, 'z', 6, 'w', 1)
+
+        self.assertOk(self.cmd('topk.merge', 'c{t}', 2, 'a{t}', 'b{t}'))
+        self.assertEqual(['x', 7, 'z', 6, 'y', 3], self.cmd('topk.list', 'c{t}', 'WITHCOUNT'))
+        self.assertEqual([7, 6, 3, 1], self.cmd('topk.count', 'c{t}', 'x', 'z', 'y', 'w'))
+
+        self.assertOk(self.cmd('topk.merge', 'c{t}', 2, 'a{t}', 'b{t}', 'WEIGHTS', 1, 2))
+        self.assertEqual(['z', 12, 'x', 9, 'y', 3], self.cmd('topk.list', 'c{t}', 'WITHCOUNT'))
+
+        # destination is one of the sources
+        self.assertOk(self.cmd('topk.merge', 'a{t}', 2, 'a{t}', 'b{t}'))
+        self.assertEqual(['x', 7, 'z', 6, 'y', 3], self.cmd('topk.list', 'a{t}', 'WITHCOUNT'))
+        self.assertEqual([None, None], self.cmd('topk.add', 'a{t}', 'z', 'z'))
+        self.assertEqual(['z', 8], self.cmd('topk.list', 'a{t}', 'WITHCOUNT')[:2])
+
+        self.env.dumpAndReload()
+        self.assertEqual(['z', 12, 'x', 9, 'y', 3], self.cmd('topk.list', 'c{t}', 'WITHCOUNT'))
+
+        self.cmd('SET', 's{t}', 'v')
+        self.assertOk(self.cmd('topk.reserve', 'd{t}', 3, 1000, 5, 0.8))
+        self.assertOk(self.cmd('topk.reserve', 'e{t}', 4, 1000, 5, 0.9))
+        for args in (('c{t}', 2, 'a{t}'),
+                     ('c{t}', 0, 'a{t}'),
+                     ('c{t}', 'x', 'a{t}'),
+                     ('c{t}', 1, 'a{t}', 'WEIGHTS'),
+                     ('c{t}', 1, 'a{t}', 'WEIGHTS', 0),
+                     ('c{t}', 1, 'a{t}', 'WEIGHTS', 'x'),
+                     ('c{t}', 1, 'a{t}', 'WEIGHTS', 1, 1),
+                     ('c{t}', 1, 'a{t}', 'WEIGHTS', 4294967296),
+                     ('c{t}', 1, 'a{t}', 'WEIGHTS', 4294967295),
+                     ('c{t}', 1, 'd{t}'),
+                     ('c{t}', 1, 'e{t}'),
+                     ('c{t}', 1, 'none{t}'),
+                     ('c{t}', 1, 's{t}'),
+                     ('none{t}', 1, 'a{t}'),
+                     ('s{t}', 1, 'a{t}')):
+            self.assertRaises(ResponseError, self.cmd, 'topk.merge', *args)
+        # failed merges leave the destination untouched
+        self.assertEqual(['z', 12, 'x', 9, 'y', 3], self.cmd('topk.list', 'c{t}', 'WITHCOUNT'))
+
+    def test_compact_layout(self):
+        self.cmd('FLUSHALL')
+        self.assertOk(self.cmd('topk.reserve', 'std{t}', 3, 1000, 5, 0.9))
+        self.assertOk(self.cmd('topk.reserve', 'cmp{t}', 3, 1000, 5, 0.9, 'COMPACT'))
+        self.assertOk(self.cmd('topk.reserve', 'cmp_default{t}', 3, 'compact'))
+        self.assertGreater(self.cmd('MEMORY USAGE', 'std{t}'), self.cmd('MEMORY USAGE', 'cmp{t}'))
+        for args in (('foo', 'COMPACT'),
+                     ('foo', '20', 'COMPACT', '5'),
+                     ('foo', '20', '50', '5', 'COMPACT'),
+                     ('foo', '20', '50', '5', '0.9', 'COMPACT', 'COMPACT')):
+            self.assertRaises(ResponseError, self.cmd, 'topk.reserve', *args)
+
+        # counters beyond 16 bits are escalated
+        for key in ('std{t}', 'cmp{t}'):
+            self.cmd('topk.incrby', key, 'a', 100000, 'a', 100000, 'a', 100000, 'b', 70000)
+            self.cmd('topk.add', key, 'c', 'c', 'c', 'c', 'c')
+        expected = ['a', 300000, 'b', 70000, 'c', 5]
+        self.assertEqual(expected, self.cmd('topk.list', 'cmp{t}', 'WITHCOUNT'))
+        self.assertEqual(expected, self.cmd('topk.list', 'std{t}', 'WITHCOUNT'))
+        self.assertEqual([300000, 70000, 5, 0],
+                         self.cmd('topk.count', 'cmp{t}', 'a', 'b', 'c', 'd'))
+
+        self.env.dumpAndReload()
+        self.assertEqual(expected, self.cmd('topk.list', 'cmp{t}', 'WITHCOUNT'))
+        self.assertEqual([300000, 70000, 5, 0],
+                         self.cmd('topk.count', 'cmp{t}', 'a', 'b', 'c', 'd'))
+        self.assertEqual([None], self.cmd('topk.incrby', 'cmp{t}', 'a', 1))
+        self.assertEqual(['a', 300001], self.cmd('topk.list', 'cmp{t}', 'WITHCOUNT')[:2])
+
+        self.assertOk(self.cmd('topk.reserve', 'cmp_merged{t}', 3, 1000, 5, 0.9, 'COMPACT'))
+        self.assertOk(self.cmd('topk.merge', 'cmp_merged{t}', 1, 'cmp{t}', 'WEIGHTS', 2))
+        self.assertEqual(['a', 600002, 'b', 140000, 'c', 10],
+                         self.cmd('topk.list', 'cmp_merged{t}', 'WITHCOUNT'))
+        self.assertRaises(ResponseError, self.cmd, 'topk.merge', 'cmp_merged{t}', 1, 'std{t}')
+
+    def test_space_saving(self):
+        self.cmd('FLUSHALL')
+        self.assertOk(self.cmd('topk.reserve', 'ss{t}', 3, 'ALGO', 'SPACESAVING'))
+        self.assertOk(self.cmd('topk.reserve', 'hk{t}', 3, 'algo', 'heavykeeper'))
+        for args in (('foo', 3, 'ALGO'),
+                     ('foo', 3, 'ALGO', 'FOO'),
+                     ('foo', 0, 'ALGO', 'SPACESAVING'),
+                     ('foo', 3, 50, 5, 0.9, 'ALGO', 'SPACESAVING'),
+                     ('foo', 3, 'COMPACT', 'ALGO', 'SPACESAVING')):
+            self.assertRaises(ResponseError, self.cmd, 'topk.reserve', *args)
+
+        self.assertEqual([None, None, None], self.cmd('topk.add', 'ss{t}', 'a', 'b', 'c'))
+        self.assertEqual([None, None], self.cmd('topk.incrby', 'ss{t}', 'a', 10, 'b', 5))
+        # a new item takes over the counter of the smallest count, and adds to it
+        self.assertEqual(['c'], self.cmd('topk.add', 'ss{t}', 'd'))
+        expected = ['a', 11, 'b', 6, 'd', 2]
+        self.assertEqual(expected, self.cmd('topk.list', 'ss{t}', 'WITHCOUNT'))
+        self.assertEqual([11, 6, 0, 2], self.cmd('topk.count', 'ss{t}', 'a', 'b', 'c', 'd'))
+        self.assertEqual([1, 1, 0, 1], self.cmd('topk.query', 'ss{t}', 'a', 'b', 'c', 'd'))
+        info = self.cmd('topk.info', 'ss{t}')
+        self.assertEqual(['k', 3, 'width', 0, 'depth', 0, 'decay'], info[:7])
+        self.assertEqual(0, float(info[7]))
+        self.assertEqual(['algo', 'SPACESAVING'], info[8:])
+        self.assertGreater(self.cmd('MEMORY USAGE', 'ss{t}'), 0)
+
+        self.env.dumpAndReload()
+        self.assertEqual(expected, self.cmd('topk.list', 'ss{t}', 'WITHCOUNT'))
+        self.assertEqual(['d'], self.cmd('topk.list', 'ss{t}')[2:])
+        self.assertEqual([None], self.cmd('topk.add', 'ss{t}', 'd'))
+        self.assertEqual([11, 6, 3], self.cmd('topk.count', 'ss{t}', 'a', 'b', 'd'))
+
+        # items missing from a full summary count as its smallest count
+        self.assertOk(self.cmd('topk.reserve', 'ss2{t}', 3, 'ALGO', 'SPACESAVING'))
+        self.cmd('topk.add', 'ss2{t}', 'a', 'e')
+        self.assertOk(self.cmd('topk.merge', 'ss2{t}', 2, 'ss{t}', 'ss2{t}', 'WEIGHTS', 1, 2))
+        self.assertEqual(['a', 13, 'b', 6, 'e', 5],
+                         self.cmd('topk.list', 'ss2{t}', 'WITHCOUNT'))
+        self.assertRaises(ResponseError, self.cmd, 'topk.merge', 'ss{t}', 1, 'hk{t}')
+        self.assertRaises(ResponseError, self.cmd, 'topk.merge', 'hk{t}', 1, 'ss{t}')
+
+    def test_small_keys(self):
+        self.cmd('FLUSHALL')
+        for i in range(100):
+            self.assertOk(self.cmd('topk.reserve', 'small%d' % i, 10, 8, 7, 0.9 if i % 2 else 0.8))
+            self.cmd('topk.incrby', 'small%d' % i, 'a', i + 2, 'b', 1)
+        # the decay lookup table is shared, so the key is smaller than the table alone
+        self.assertGreater(2048, self.cmd('MEMORY USAGE', 'small0'))
+        self.env.dumpAndReload()
+        self.assertGreater(2048, self.cmd('MEMORY USAGE', 'small0'))
+        for i in range(100):
+            self.assertEqual(['a', i + 2, 'b', 1],
+                             self.cmd('topk.list', 'small%d' % i, 'WITHCOUNT'))
+        self.assertOk(self.cmd('topk.merge', 'small1', 2, 'small1', 'small3'))
+        self.assertEqual(['a', 8, 'b', 2], self.cmd('topk.list', 'small1', 'WITHCOUNT'))
+        for i in range(0, 100, 2):
+            self.cmd('DEL', 'small%d' % i)
+        self.assertEqual([None], self.cmd('topk.add', 'small99', 'a'))
+        self.assertEqual(['a', 102, 'b', 1], self.cmd('topk.list', 'small99', 'WITHCOUNT'))
+
+    def test_front_cache(self):
+        self.cmd('FLUSHALL')
+        self.assertOk(self.cmd('topk.reserve', 'topk', 5, 2000, 5, 0.9))
+        for i in range(1, 11):
+            self.cmd('topk.incrby', 'topk', 'item%d' % i, i)
+        # items far above the heap minimum are counted by the front cache
+        for i in range(1500):
+            self.cmd('topk.add', 'topk', 'hot1')
+            self.cmd('topk.add', 'topk', 'hot2', 'hot2', *(['cold'] if i < 1000 else []))
+        self.assertEqual(['hot2', 3000, 'hot1', 1500, 'cold', 1000],
+                         self.cmd('topk.list', 'topk', 'WITHCOUNT')[:6])
+        # reads count the cached increments without applying them
+        for _ in range(3):
+            self.assertEqual([1500, 3000, 1000], self.cmd('topk.count', 'topk', 'hot1', 'hot2',
+                                                          'cold'))
+        self.cmd('topk.incrby', 'topk', 'hot1', 2000)
+        self.assertEqual([3500, 3000], self.cmd('topk.count', 'topk', 'hot1', 'hot2'))
+        # merges include the cached increments, and leave them pending in the source
+        self.assertOk(self.cmd('topk.reserve', 'merged', 5, 2000, 5, 0.9))
+        self.assertOk(self.cmd('topk.merge', 'merged', 1, 'topk'))
+        self.assertEqual(self.cmd('topk.list', 'topk', 'WITHCOUNT'),
+                         self.cmd('topk.list', 'merged', 'WITHCOUNT'))
+
+        self.cmd('topk.add', 'topk', 'hot1', 'hot2', 'hot2')
+        self.env.dumpAndReload()
+        self.assertEqual([3501, 3002], self.cmd('topk.count', 'topk', 'hot1', 'hot2'))
+        self.assertEqual(['item9'], self.cmd('topk.incrby', 'topk', 'new', 5000))
+        self.assertEqual(['new', 5000, 'hot1', 3501, 'hot2', 3002, 'cold', 1000, 'item10', 10],
+                         self.cmd('topk.list', 'topk', 'WITHCOUNT'))
+
     def test_lookup_table(self):
         self.cmd('FLUSHALL')
         self.assertTrue(self.cmd('topk.reserve', 'topk', '1', '3', '3', '.9'))